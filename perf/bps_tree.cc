@@ -223,6 +223,7 @@ public: \
 	static constexpr auto build = ::tree##_t_build; \
 	static constexpr auto destroy = ::tree##_t_destroy; \
 	static constexpr auto find = ::tree##_t_find; \
+	static constexpr auto find_batch = ::tree##_t_find_batch; \
 	static constexpr auto insert = ::tree##_t_insert; \
 	static constexpr auto delete_ = ::tree##_t_delete; \
 }
@@ -424,6 +425,37 @@ generate_benchmarks_height(find_rand, 2);
 generate_benchmarks_height(find_rand, 3);
 generate_benchmarks_height(find_rand, 4);
 
+/*
+ * Looks up random keys in batches of BPS_TREE_FIND_BATCH_SIZE, so the
+ * result is comparable with find_rand per item processed.
+ */
+template<class tree>
+static void
+test_find_batch_rand(benchmark::State &state, size_t count)
+{
+	constexpr size_t batch_size = BPS_TREE_FIND_BATCH_SIZE;
+	typename tree::tree_t t;
+	typename tree::Allocator allocator(count);
+	create<tree>(t, count, allocator);
+	RandomKey kg(count);
+	typename tree::key_t keys[batch_size];
+	typename tree::elem_t *results[batch_size];
+	for (auto _ : state) {
+		for (size_t i = 0; i < batch_size; i++)
+			keys[i] = kg();
+		tree::find_batch(&t, keys, batch_size, results);
+		benchmark::DoNotOptimize(results);
+	}
+	tree::destroy(&t);
+}
+
+generate_benchmarks_size(find_batch_rand, 1000000);
+
+generate_benchmarks_height(find_batch_rand, 1);
+generate_benchmarks_height(find_batch_rand, 2);
+generate_benchmarks_height(find_batch_rand, 3);
+generate_benchmarks_height(find_batch_rand, 4);
+
 /*
  * The following functions test performance of insertion and deletion without
  * reballancing. This is done by performing the two opposite operations in a
@@ -0,0 +1,167 @@
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+#include "core/cbus.h"
+#include "core/fiber.h"
+#include "core/memory.h"
+
+#include <benchmark/benchmark.h>
+
+/**
+ * This suite measures the throughput of cbus when many threads send
+ * messages to one endpoint, like IPROTO threads and relays sending
+ * requests to the TX thread.
+ *
+ * In every iteration, the producer threads are started and each of
+ * them sends MSG_COUNT messages to the consumer endpoint hosted by
+ * the benchmark thread.
+ */
+
+/** Number of messages sent by each producer thread in one iteration. */
+constexpr static int MSG_COUNT = 100000;
+
+/** Number of messages pushed by a producer thread between yields. */
+constexpr static int BATCH_SIZE = 64;
+
+/** Name of the consumer endpoint. */
+constexpr static const char *CONSUMER_NAME = "consumer";
+
+class Cbus {
+public:
+	Cbus(const Cbus &other) = delete;
+	Cbus &operator=(Cbus &other) = delete;
+
+	static Cbus &
+	instance()
+	{
+		static Cbus singleton;
+		return singleton;
+	}
+
+private:
+	Cbus()
+	{
+		::memory_init();
+		::fiber_init(fiber_c_invoke);
+		::cbus_init();
+	}
+
+	~Cbus()
+	{
+		::cbus_free();
+		::fiber_free();
+		::memory_free();
+	}
+};
+
+/** Thread sending messages to the consumer endpoint. */
+struct Producer {
+	/** Name of the cord. */
+	char name[32];
+	/** Cord corresponding to this thread. */
+	struct cord cord;
+	/** Messages sent by this thread. */
+	std::vector<struct cmsg> msgs;
+};
+
+/** Number of producer threads started in one iteration. */
+static int producer_count;
+
+/** Number of messages received by the consumer. */
+static int received;
+
+static void
+msg_received_cb(struct cmsg *msg)
+{
+	(void)msg;
+	received++;
+}
+
+static int
+producer_func(va_list ap)
+{
+	Producer *p = va_arg(ap, Producer *);
+	static struct cmsg_hop route[] = {
+		{ msg_received_cb, nullptr }
+	};
+	struct cpipe pipe;
+	::cpipe_create(&pipe, CONSUMER_NAME);
+	::cpipe_set_max_input(&pipe, BATCH_SIZE);
+	for (int i = 0; i < MSG_COUNT; i++) {
+		::cmsg_init(&p->msgs[i], route);
+		::cpipe_push(&pipe, &p->msgs[i]);
+		if ((i + 1) % BATCH_SIZE == 0)
+			::fiber_sleep(0);
+	}
+	::cpipe_destroy(&pipe);
+	return 0;
+}
+
+/** Start the producer threads and receive all their messages. */
+static int
+consumer_func(va_list ap)
+{
+	(void)ap;
+
+	struct cbus_endpoint endpoint;
+	::cbus_endpoint_create(&endpoint, CONSUMER_NAME, fiber_schedule_cb,
+			       fiber());
+
+	std::vector<Producer> producers(producer_count);
+	received = 0;
+	for (int i = 0; i < producer_count; i++) {
+		Producer &p = producers[i];
+		snprintf(p.name, sizeof(p.name), "producer_%d", i);
+		p.msgs.resize(MSG_COUNT);
+		if (::cord_costart(&p.cord, p.name, producer_func, &p) != 0)
+			panic("failed to start producer thread");
+	}
+	int total = producer_count * MSG_COUNT;
+	while (received < total) {
+		::cbus_process(&endpoint);
+		if (received < total)
+			::fiber_yield();
+	}
+	for (Producer &p : producers) {
+		if (::cord_join(&p.cord) != 0)
+			panic("failed to join producer thread");
+	}
+	::cbus_endpoint_destroy(&endpoint, cbus_process);
+
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+/**
+ * Benchmark many producer threads sending messages to one endpoint.
+ * The argument is the number of the producer threads.
+ */
+static void
+CbusManyToOne(benchmark::State &state)
+{
+	Cbus::instance();
+	producer_count = state.range(0);
+	int64_t counter = 0;
+	for (MAYBE_UNUSED auto _ : state) {
+		struct fiber *f = ::fiber_new("consumer", consumer_func);
+		if (f == nullptr)
+			panic("failed to create consumer fiber");
+		::fiber_wakeup(f);
+		ev_run(loop(), 0);
+		counter += producer_count * MSG_COUNT;
+	}
+	state.SetItemsProcessed(counter);
+}
+
+BENCHMARK(CbusManyToOne)
+	->Arg(1)
+	->Arg(2)
+	->Arg(4)
+	->Arg(8)
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
+#include "debug_warning.h"
@@ -125,6 +125,8 @@ class Memtx final {
 					   memtx_tuple_arena_max_size,
 					   memtx_objsize_min,
 					   /*dontdump=*/true,
+					   /*huge_pages=*/false,
+					   /*numa_node=*/-1,
 					   memtx_granularity, "small",
 					   memtx_alloc_factor,
 					   /*threads_num=*/0,
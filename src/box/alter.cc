@@ -56,6 +56,7 @@
 #include "version.h"
 #include "sequence.h"
 #include "sql.h"
+#include "sql/matview.h"
 #include "space_upgrade.h"
 #include "box.h"
 #include "authentication.h"
@@ -328,6 +329,42 @@ func_index_check_func(struct func *func) {
 	return 0;
 }
 
+/**
+ * Check that the partial index predicate function exists and can
+ * be used to filter tuples of the index. During initial recovery
+ * the function cache is not loaded yet, so the function is looked
+ * up by the engine when the index is built.
+ */
+static int
+index_filter_check_def(struct index_def *index_def)
+{
+	if (index_def->iid == 0) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 "filter is allowed only for secondary index");
+		return -1;
+	}
+	struct func *func = func_by_id(index_def->opts.filter_func_id);
+	if (func == NULL) {
+		if (recovery_state <= INITIAL_RECOVERY)
+			return 0;
+		diag_set(ClientError, ER_NO_SUCH_FUNCTION,
+			 int2str(index_def->opts.filter_func_id));
+		return -1;
+	}
+	if (func_access_check(func) != 0)
+		return -1;
+	if (func->def->language != FUNC_LANGUAGE_LUA ||
+	    func->def->body == NULL || !func->def->is_deterministic) {
+		const char *errmsg = tt_sprintf(
+			"function '%s' doesn't meet index filter "
+			"function criteria (stored, deterministic, written in Lua)",
+			func->def->name);
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS, errmsg);
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * Create a index_def object from a record in _index
  * system space.
@@ -468,6 +505,9 @@ index_def_new_from_tuple(struct tuple *tuple, struct space *space)
 			return NULL;
 		index_def_set_func(index_def, func);
 	}
+	if (opts.filter_func_id > 0 &&
+	    index_filter_check_def(index_def) != 0)
+		return NULL;
 	index_def_guard.is_active = false;
 	return index_def;
 }
@@ -590,10 +630,15 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 			 int2str(opts.group_id));
 		return NULL;
 	}
-	if (opts.is_view && opts.sql == NULL) {
+	if ((opts.is_view || opts.is_materialized) && opts.sql == NULL) {
 		diag_set(ClientError, ER_VIEW_MISSING_SQL);
 		return NULL;
 	}
+	if (opts.is_view && opts.is_materialized) {
+		diag_set(ClientError, errcode, tt_cstr(name, name_len),
+			 "view can't be materialized");
+		return NULL;
+	}
 	if (opts.is_sync && opts.group_id == GROUP_LOCAL) {
 		diag_set(ClientError, errcode, tt_cstr(name, name_len),
 			 "local space can't be synchronous");
@@ -798,6 +843,17 @@ struct alter_space {
  */
 static FIBER_COND(alter_space_delete_cond);
 
+bool
+space_is_being_altered(uint32_t space_id)
+{
+	struct alter_space *alter;
+	rlist_foreach_entry(alter, &alter_space_list, in_list) {
+		if (alter->old_space->def->id == space_id)
+			return true;
+	}
+	return false;
+}
+
 static struct alter_space *
 alter_space_new(struct space *old_space)
 {
@@ -2008,6 +2064,46 @@ on_drop_view_rollback(struct trigger *trigger, void *event)
 	return 0;
 }
 
+/**
+ * Trigger which is fired to rollback creation of a materialized
+ * view. Stops maintaining the view and releases it.
+ */
+static int
+on_create_matview_rollback(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct sql_matview *view = (struct sql_matview *)trigger->data;
+	sql_matview_detach(view);
+	sql_matview_delete(view);
+	return 0;
+}
+
+/**
+ * Trigger which is fired to commit drop of a materialized view.
+ * Releases the view detached in on_replace_dd_space trigger.
+ */
+static int
+on_drop_matview_commit(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct sql_matview *view = (struct sql_matview *)trigger->data;
+	sql_matview_delete(view);
+	return 0;
+}
+
+/**
+ * Trigger which is fired to rollback drop of a materialized view.
+ * Resumes maintaining the view.
+ */
+static int
+on_drop_matview_rollback(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct sql_matview *view = (struct sql_matview *)trigger->data;
+	sql_matview_attach(view);
+	return 0;
+}
+
 /**
  * Return -1 and set diag if the space is pinned by someone.
  */
@@ -2281,6 +2377,20 @@ on_replace_dd_space(struct trigger * /* trigger */, void *event)
 			txn_stmt_on_rollback(stmt, on_rollback_view);
 			select_guard.is_active = false;
 		}
+		if (def->opts.is_materialized) {
+			struct sql_matview *view = sql_matview_new(def);
+			if (view == NULL)
+				return -1;
+			struct trigger *on_rollback_view =
+				txn_alter_trigger_new(on_create_matview_rollback,
+						      view);
+			if (on_rollback_view == NULL) {
+				sql_matview_delete(view);
+				return -1;
+			}
+			txn_stmt_on_rollback(stmt, on_rollback_view);
+			sql_matview_attach(view);
+		}
 	} else if (new_tuple == NULL) { /* DELETE */
 		if (access_check_ddl(old_space->def->name, old_space->def->uid,
 				     old_space->access, SC_SPACE, PRIV_D) != 0)
@@ -2381,9 +2491,28 @@ on_replace_dd_space(struct trigger * /* trigger */, void *event)
 			assert(rc == 0); (void)rc;
 			select_guard.is_active = false;
 		}
+		if (old_space->def->opts.is_materialized) {
+			struct sql_matview *view =
+				sql_matview_by_id(old_space->def->id);
+			assert(view != NULL);
+			struct trigger *on_commit_view =
+				txn_alter_trigger_new(on_drop_matview_commit,
+						      view);
+			if (on_commit_view == NULL)
+				return -1;
+			struct trigger *on_rollback_view =
+				txn_alter_trigger_new(on_drop_matview_rollback,
+						      view);
+			if (on_rollback_view == NULL)
+				return -1;
+			txn_stmt_on_commit(stmt, on_commit_view);
+			txn_stmt_on_rollback(stmt, on_rollback_view);
+			sql_matview_detach(view);
+		}
 	} else { /* UPDATE, REPLACE */
 		assert(old_space != NULL && new_tuple != NULL);
-		if (old_space->def->opts.is_view) {
+		if (old_space->def->opts.is_view ||
+		    old_space->def->opts.is_materialized) {
 			diag_set(ClientError, ER_ALTER_SPACE,
 				 space_name(old_space),
 				 "view can not be altered");
@@ -2835,6 +2964,26 @@ on_replace_dd_truncate(struct trigger * /* trigger */, void *event)
 		return -1;
 	}
 
+	/*
+	 * Rows of a materialized view may only be changed by the view.
+	 * Truncation of a view received from a remote master or recovered
+	 * from the WAL is applied as is.
+	 */
+	if (stmt->row->replica_id == 0 &&
+	    sql_matview_check_write(old_space->def) != 0)
+		return -1;
+
+	/*
+	 * Truncation doesn't invoke triggers either, so it would leave
+	 * materialized views over the space stale.
+	 */
+	if (sql_matview_space_is_base(space_id)) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(old_space),
+			 "can not truncate a space read by a materialized "
+			 "view");
+		return -1;
+	}
+
 	/* Check space's holders. */
 	if (space_check_truncate(old_space) != 0)
 		return -1;
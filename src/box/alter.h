@@ -49,4 +49,11 @@ extern struct trigger on_replace_space_sequence;
 extern struct trigger on_replace_trigger;
 extern struct trigger on_replace_func_index;
 
+/**
+ * Returns true if the space with the given id is being altered, i.e. there's
+ * an alter operation on it that hasn't been committed or rolled back yet.
+ */
+bool
+space_is_being_altered(uint32_t space_id);
+
 #endif /* INCLUDES_TARANTOOL_BOX_ALTER_H */
@@ -85,6 +85,7 @@
 #include "func.h"
 #include "sequence.h"
 #include "sql_stmt_cache.h"
+#include "sql/matview.h"
 #include "msgpack.h"
 #include "raft.h"
 #include "watcher.h"
@@ -102,6 +103,7 @@
 #include "event.h"
 #include "tweaks.h"
 #include "memtx_tx.h"
+#include "info/info.h"
 
 static char status[64] = "unconfigured";
 
@@ -277,6 +279,27 @@ TWEAK_DOUBLE(box_shutdown_timeout);
 static double box_fiber_pool_idle_timeout = FIBER_POOL_IDLE_TIMEOUT;
 TWEAK_DOUBLE(box_fiber_pool_idle_timeout);
 
+static_assert(iproto_sched_class_MAX <= FIBER_POOL_CLASS_MAX,
+	      "Too many request scheduling classes");
+
+/** Max weight of a request scheduling class in the box fiber pool. */
+enum { BOX_FIBER_POOL_WEIGHT_MAX = 1000 };
+
+void
+box_fiber_pool_stat(struct info_handler *h)
+{
+	info_begin(h);
+	for (int i = 0; i < iproto_sched_class_MAX; i++) {
+		struct fiber_pool_class *c = &tx_fiber_pool.classes[i];
+		info_table_begin(h, iproto_sched_class_strs[i]);
+		info_append_int(h, "current", c->queue_len);
+		info_append_int(h, "total", c->processed);
+		info_append_double(h, "wait_time", c->wait_time);
+		info_table_end(h);
+	}
+	info_end(h);
+}
+
 static int
 box_run_on_recovery_state(enum box_recovery_state state)
 {
@@ -1743,6 +1766,76 @@ box_check_readahead(int readahead)
 	}
 }
 
+static void
+box_check_iproto_admission_target(double target)
+{
+	if (target < 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_admission_target",
+			  "must be non-negative");
+	}
+}
+
+static void
+box_check_iproto_admission_interval(double interval)
+{
+	if (interval <= 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_admission_interval",
+			  "must be greater than 0");
+	}
+}
+
+static void
+box_check_iproto_cursor_max(int64_t max)
+{
+	if (max < 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_cursor_max",
+			  "must be non-negative");
+	}
+}
+
+static void
+box_check_iproto_compression_min_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_compression_min_size",
+			  "must be non-negative");
+	}
+}
+
+static void
+box_check_iproto_tuple_ref_min_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_tuple_ref_min_size",
+			  "must be non-negative");
+	}
+}
+
+static void
+box_check_iproto_sched_weight(const char *name, int64_t weight)
+{
+	if (weight < 1 || weight > BOX_FIBER_POOL_WEIGHT_MAX) {
+		tnt_raise(ClientError, ER_CFG, name,
+			  tt_sprintf("must be in range [1, %d]",
+				     BOX_FIBER_POOL_WEIGHT_MAX));
+	}
+}
+
+static void
+box_check_iproto_sched_batch_users(void)
+{
+	int count = cfg_getarr_size("iproto_sched_batch_users");
+	for (int i = 0; i < count; i++) {
+		const char *name = cfg_getarr_elem("iproto_sched_batch_users",
+						   i);
+		if (name == NULL || *name == '\0') {
+			tnt_raise(ClientError, ER_CFG,
+				  "iproto_sched_batch_users",
+				  "must be an array of user names");
+		}
+	}
+}
+
 static void
 box_check_checkpoint_count(int checkpoint_count)
 {
@@ -1850,6 +1943,17 @@ box_check_sql_cache_size(int size)
 	return 0;
 }
 
+static int
+box_check_sql_plan_cache_size(int64_t size)
+{
+	if (size < 0) {
+		diag_set(ClientError, ER_CFG, "sql_plan_cache_size",
+			 "must be non-negative");
+		return -1;
+	}
+	return 0;
+}
+
 static int
 box_check_allocator(void)
 {
@@ -1973,6 +2077,26 @@ box_init_say()
 	return 0;
 }
 
+/**
+ * Checks whether memtx_numa_node configuration parameter is correct.
+ */
+static void
+box_check_memtx_numa_node(void)
+{
+	/*
+	 * After high level checks this parameter is either nil or has
+	 * type 'number'.
+	 */
+	if (!cfg_isnumber("memtx_numa_node"))
+		return;
+	int node = cfg_geti("memtx_numa_node");
+	if (node < 0 || node > TUPLE_ARENA_NUMA_NODE_MAX)
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_node",
+			  tt_sprintf("must be greater than or equal to 0 and "
+				     "less than or equal to %d",
+				     TUPLE_ARENA_NUMA_NODE_MAX));
+}
+
 /**
  * Checks whether memtx_sort_threads configuration parameter is correct.
  */
@@ -2043,6 +2167,25 @@ box_check_config(void)
 		diag_raise();
 	uri_destroy(&uri);
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_admission_target(
+		cfg_getd("iproto_admission_target"));
+	box_check_iproto_admission_interval(
+		cfg_getd("iproto_admission_interval"));
+	box_check_iproto_cursor_max(cfg_geti64("iproto_cursor_max"));
+	box_check_iproto_compression_min_size(
+		cfg_geti64("iproto_compression_min_size"));
+	box_check_iproto_tuple_ref_min_size(
+		cfg_geti64("iproto_tuple_ref_min_size"));
+	const char *sched_weights[] = {
+		"iproto_sched_weight_system",
+		"iproto_sched_weight_interactive",
+		"iproto_sched_weight_batch",
+	};
+	for (size_t i = 0; i < lengthof(sched_weights); i++) {
+		box_check_iproto_sched_weight(sched_weights[i],
+					      cfg_geti64(sched_weights[i]));
+	}
+	box_check_iproto_sched_batch_users();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
@@ -2065,11 +2208,15 @@ box_check_config(void)
 		diag_raise();
 	if (box_check_sql_cache_size(cfg_geti("sql_cache_size")) != 0)
 		diag_raise();
+	if (box_check_sql_plan_cache_size(
+			cfg_geti64("sql_plan_cache_size")) != 0)
+		diag_raise();
 	if (box_check_txn_timeout() < 0)
 		diag_raise();
 	if (box_check_txn_isolation() == txn_isolation_level_MAX)
 		diag_raise();
 	box_check_memtx_sort_threads();
+	box_check_memtx_numa_node();
 }
 
 int
@@ -3368,6 +3515,100 @@ box_set_readahead(void)
 	iproto_readahead = readahead;
 }
 
+void
+box_set_iproto_admission_target(void)
+{
+	double target = cfg_getd("iproto_admission_target");
+	box_check_iproto_admission_target(target);
+	iproto_admission_target = target;
+}
+
+void
+box_set_iproto_admission_interval(void)
+{
+	double interval = cfg_getd("iproto_admission_interval");
+	box_check_iproto_admission_interval(interval);
+	iproto_admission_interval = interval;
+}
+
+void
+box_set_iproto_cursor_max(void)
+{
+	int64_t max = cfg_geti64("iproto_cursor_max");
+	box_check_iproto_cursor_max(max);
+	iproto_cursor_max = max;
+}
+
+void
+box_set_iproto_compression_min_size(void)
+{
+	int64_t size = cfg_geti64("iproto_compression_min_size");
+	box_check_iproto_compression_min_size(size);
+	iproto_compression_min_size = size;
+}
+
+void
+box_set_iproto_tuple_ref_min_size(void)
+{
+	int64_t size = cfg_geti64("iproto_tuple_ref_min_size");
+	box_check_iproto_tuple_ref_min_size(size);
+	iproto_tuple_ref_min_size = size;
+}
+
+void
+box_set_iproto_sched_classes(void)
+{
+	iproto_sched_classes = cfg_getb("iproto_sched_classes");
+}
+
+/**
+ * Set the weight of a request scheduling class in the tx fiber pool
+ * from the given configuration option.
+ */
+static void
+box_set_iproto_sched_weight(const char *name, enum iproto_sched_class cls)
+{
+	int64_t weight = cfg_geti64(name);
+	box_check_iproto_sched_weight(name, weight);
+	fiber_pool_set_class_weight(&tx_fiber_pool, cls, weight);
+}
+
+void
+box_set_iproto_sched_weight_system(void)
+{
+	box_set_iproto_sched_weight("iproto_sched_weight_system",
+				    IPROTO_SCHED_SYSTEM);
+}
+
+void
+box_set_iproto_sched_weight_interactive(void)
+{
+	box_set_iproto_sched_weight("iproto_sched_weight_interactive",
+				    IPROTO_SCHED_INTERACTIVE);
+}
+
+void
+box_set_iproto_sched_weight_batch(void)
+{
+	box_set_iproto_sched_weight("iproto_sched_weight_batch",
+				    IPROTO_SCHED_BATCH);
+}
+
+void
+box_set_iproto_sched_batch_users(void)
+{
+	box_check_iproto_sched_batch_users();
+	int count = cfg_getarr_size("iproto_sched_batch_users");
+	char **names = NULL;
+	if (count > 0)
+		names = (char **)xcalloc(count, sizeof(*names));
+	for (int i = 0; i < count; i++) {
+		names[i] = xstrdup(cfg_getarr_elem("iproto_sched_batch_users",
+						   i));
+	}
+	iproto_set_sched_batch_users(names, count);
+}
+
 void
 box_set_checkpoint_count(void)
 {
@@ -3507,6 +3748,16 @@ box_set_prepared_stmt_cache_size(void)
 	return 0;
 }
 
+int
+box_set_sql_plan_cache_size(void)
+{
+	int64_t size = cfg_geti64("sql_plan_cache_size");
+	if (box_check_sql_plan_cache_size(size) != 0)
+		return -1;
+	sql_plan_cache_set_size(size);
+	return 0;
+}
+
 /**
  * Report crash information to the feedback daemon
  * (ie send it to feedback daemon).
@@ -3906,6 +4157,8 @@ box_process1(struct request *request, box_tuple_t **result)
 	    !space_is_local(space) &&
 	    box_check_writable() != 0)
 		return -1;
+	if (sql_matview_check_write(space->def) != 0)
+		return -1;
 	if (space_is_memtx(space)) {
 		/*
 		 * Due to on_init_schema triggers set on system spaces,
@@ -5265,6 +5518,9 @@ engine_init()
 				    cfg_getd("memtx_memory"),
 				    cfg_geti("memtx_min_tuple_size"),
 				    cfg_geti("strip_core"),
+				    cfg_geti("memtx_huge_pages"),
+				    cfg_isnumber("memtx_numa_node") ?
+				    cfg_geti("memtx_numa_node") : -1,
 				    cfg_geti("slab_alloc_granularity"),
 				    cfg_gets("memtx_allocator"),
 				    cfg_getd("slab_alloc_factor"),
@@ -5917,8 +6173,20 @@ box_cfg_xc(void)
 
 	if (box_set_prepared_stmt_cache_size() != 0)
 		diag_raise();
+	if (box_set_sql_plan_cache_size() != 0)
+		diag_raise();
 	box_set_net_msg_max();
 	box_set_readahead();
+	box_set_iproto_admission_target();
+	box_set_iproto_admission_interval();
+	box_set_iproto_cursor_max();
+	box_set_iproto_compression_min_size();
+	box_set_iproto_tuple_ref_min_size();
+	box_set_iproto_sched_classes();
+	box_set_iproto_sched_weight_system();
+	box_set_iproto_sched_weight_interactive();
+	box_set_iproto_sched_weight_batch();
+	box_set_iproto_sched_batch_users();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
 	box_set_replication_reconnect_timeout();
@@ -6424,7 +6692,8 @@ box_storage_init(void)
 	schema_init();
 	txn_limbo_init();
 	replication_init(cfg_geti_default("replication_threads", 1));
-	iproto_init(cfg_geti("iproto_threads"));
+	iproto_init(cfg_geti("iproto_threads"),
+		    cfg_geti("iproto_listen_reuseport"));
 	sql_init();
 	audit_log_init();
 	security_cfg();
@@ -54,6 +54,7 @@ struct space;
 struct vclock;
 struct key_def;
 struct ballot;
+struct info_handler;
 
 /**
  * Pointer to TX thread local vclock.
@@ -159,6 +160,13 @@ box_is_configured(void);
 int
 box_check_configured(void);
 
+/**
+ * Report statistics of the request queues of the tx fiber pool by
+ * scheduling class (box.stat.tx_queue()).
+ */
+void
+box_fiber_pool_stat(struct info_handler *h);
+
 /** Check if the slice of main cord has expired. */
 int
 box_check_slice_slow(void);
@@ -353,6 +361,16 @@ void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
+void box_set_iproto_admission_target(void);
+void box_set_iproto_admission_interval(void);
+void box_set_iproto_cursor_max(void);
+void box_set_iproto_compression_min_size(void);
+void box_set_iproto_tuple_ref_min_size(void);
+void box_set_iproto_sched_classes(void);
+void box_set_iproto_sched_weight_system(void);
+void box_set_iproto_sched_weight_interactive(void);
+void box_set_iproto_sched_weight_batch(void);
+void box_set_iproto_sched_batch_users(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
@@ -386,6 +404,7 @@ void box_set_replicaset_name(void);
 void box_set_cluster_name(void);
 void box_set_net_msg_max(void);
 int box_set_prepared_stmt_cache_size(void);
+int box_set_sql_plan_cache_size(void);
 int box_set_feedback(void);
 int box_set_txn_timeout(void);
 int box_set_txn_isolation(void);
@@ -439,6 +439,11 @@ struct errcode_record {
 	_(ER_ALIEN_ENGINE, 292,			"Snapshot contains alien space engine row", "engine", STRING) \
 	_(ER_MVCC_UNAVAILABLE, 293,		"MVCC is unavailable for storage engine '%s' so it cannot be used in the same transaction with '%s', which supports MVCC", "engine_without_mvcc", STRING, "engine_with_mvcc", STRING) \
 	_(ER_CANT_UPGRADE_INDEXED_FIELD, 294,	"Space upgrade doesn't support changing indexed fields", "space", STRING, "space_id", UINT, "index", STRING, "old_tuple", TUPLE, "new_tuple", TUPLE) \
+	_(ER_INDEX_FILTER_FUNC, 295,		"Failed to evaluate filter function of partial index '%s' of space '%s': %s", "index", STRING, "space", STRING, "details", STRING) \
+	_(ER_NO_SUCH_CURSOR, 296,		"Cursor %llu does not exist", "cursor_id", ULLONG) \
+	_(ER_CURSOR_BUSY, 297,			"Cursor %llu is busy", "cursor_id", ULLONG) \
+	_(ER_OVERLOADED, 298,			"Request rejected because the server is overloaded, retry later") \
+	_(ER_CURSOR_LIMIT, 299,			"Too many open cursors, the limit is %u", "limit", UINT) \
 	TEST_ERROR_CODES(_) /** This one should be last. */
 
 /*
@@ -110,7 +110,7 @@ sql_row_to_port(struct Vdbe *stmt, struct region *region, struct port *port)
 	return -1;
 }
 
-static bool
+bool
 sql_stmt_schema_version_is_valid(struct Vdbe *stmt)
 {
 	return sql_stmt_schema_version(stmt) == box_schema_version();
@@ -266,11 +266,197 @@ sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
 	return 0;
 }
 
+/** Check if the token is a comparison operator. */
+static bool
+sql_token_is_comparison(int type)
+{
+	return type == TK_EQ || type == TK_NE || type == TK_LT ||
+	       type == TK_LE || type == TK_GT || type == TK_GE;
+}
+
+/**
+ * Replace the integer or string literal token with a parameter and
+ * store its value to @a bind.
+ *
+ * @retval false if the literal can't be replaced.
+ */
+static bool
+sql_literal_to_bind(const char *z, int len, int type, struct sql_bind *bind,
+		    struct region *region)
+{
+	memset(bind, 0, sizeof(*bind));
+	if (type == TK_INTEGER) {
+		int64_t value;
+		bool is_neg;
+		if ((z[0] == '0' && (z[1] == 'x' || z[1] == 'X')) ||
+		    sql_atoi64(z, &value, &is_neg, len) != 0 || is_neg)
+			return false;
+		bind->type = MP_UINT;
+		bind->u64 = (uint64_t)value;
+		return true;
+	}
+	assert(type == TK_STRING);
+	char *str = xregion_alloc(region, len);
+	uint32_t size = 0;
+	for (int i = 1; i < len - 1; i++) {
+		/* Quotes in the literal are doubled. */
+		if (z[i] == '\'' && z[i + 1] == '\'')
+			i++;
+		str[size++] = z[i];
+	}
+	bind->type = MP_STR;
+	bind->s = str;
+	bind->bytes = size;
+	return true;
+}
+
+/**
+ * Normalize the SQL statement to be used as a key of the plan cache:
+ * comments and runs of spaces are replaced with a single space and, if
+ * @a is_parameterized is set, integer and string literals that follow
+ * comparison operators are replaced with parameters. The values of the
+ * replaced literals are returned in @a bind. The results are allocated
+ * on the region.
+ *
+ * @retval false if the statement shouldn't be cached: it is not a query
+ *         or a DML statement, or it can't be tokenized.
+ */
+static bool
+sql_normalize(const char *sql, uint32_t len, bool is_parameterized,
+	      struct region *region, const char **out, uint32_t *out_len,
+	      struct sql_bind **bind, uint32_t *bind_count)
+{
+	char *z = xregion_alloc(region, len + 1);
+	memcpy(z, sql, len);
+	z[len] = '\0';
+	int type;
+	bool is_reserved;
+	bool is_first = true;
+	for (uint32_t i = 0; i < len; ) {
+		i += sql_token(&z[i], &type, &is_reserved);
+		if (type == TK_SPACE || type == TK_LINEFEED)
+			continue;
+		if (type == TK_ILLEGAL)
+			return false;
+		if (is_first && type != TK_SELECT && type != TK_INSERT &&
+		    type != TK_REPLACE && type != TK_UPDATE &&
+		    type != TK_DELETE && type != TK_VALUES && type != TK_WITH)
+			return false;
+		is_first = false;
+		/* Literals are not mixed with the parameters of the user. */
+		if (type == TK_VARNUM || type == TK_COLON ||
+		    type == TK_VARIABLE)
+			is_parameterized = false;
+	}
+	if (is_first)
+		return false;
+	char *buf = xregion_alloc(region, len + 1);
+	uint32_t buf_len = 0;
+	uint32_t bind_max = is_parameterized ?
+			    MIN(len / 2 + 1, SQL_BIND_PARAMETER_MAX) : 0;
+	*bind = bind_max > 0 ?
+		xregion_alloc_array(region, struct sql_bind, bind_max) : NULL;
+	*bind_count = 0;
+	int prev_type = TK_SPACE;
+	for (uint32_t i = 0; i < len; ) {
+		int size = sql_token(&z[i], &type, &is_reserved);
+		if (type == TK_SPACE || type == TK_LINEFEED) {
+			if (buf_len > 0 && buf[buf_len - 1] != ' ')
+				buf[buf_len++] = ' ';
+		} else if ((type == TK_INTEGER || type == TK_STRING) &&
+			   *bind_count < bind_max &&
+			   sql_token_is_comparison(prev_type) &&
+			   sql_literal_to_bind(&z[i], size, type,
+					       &(*bind)[*bind_count], region)) {
+			(*bind)[*bind_count].pos = *bind_count + 1;
+			++*bind_count;
+			buf[buf_len++] = '?';
+		} else {
+			memcpy(&buf[buf_len], &z[i], size);
+			buf_len += size;
+		}
+		if (type != TK_SPACE && type != TK_LINEFEED)
+			prev_type = type;
+		i += size;
+	}
+	if (buf_len > 0 && buf[buf_len - 1] == ' ')
+		buf_len--;
+	buf[buf_len] = '\0';
+	*out = buf;
+	*out_len = buf_len;
+	return true;
+}
+
+/**
+ * Execute the SQL statement using the plan cache: the statement is
+ * normalized and looked up in the cache, and compiled and added to the
+ * cache if it isn't there.
+ *
+ * @retval false if the statement can't be executed using the cache and
+ *         should be compiled as usual.
+ */
+static bool
+sql_execute_with_plan_cache(const char *sql, int len,
+			    const struct sql_bind *bind, uint32_t bind_count,
+			    struct port *port, struct region *region, int *rc)
+{
+	uint32_t sql_flags = current_session()->sql_flags;
+	/*
+	 * The text of expressions is a part of the full metadata, so the
+	 * literals are not replaced in this case.
+	 */
+	bool is_parameterized = bind_count == 0 &&
+				(sql_flags & SQL_FullMetadata) == 0;
+	const char *norm;
+	uint32_t norm_len;
+	struct sql_bind *auto_bind;
+	uint32_t auto_bind_count;
+	if (!sql_normalize(sql, len, is_parameterized, region, &norm,
+			   &norm_len, &auto_bind, &auto_bind_count))
+		return false;
+	if (auto_bind_count > 0) {
+		bind = auto_bind;
+		bind_count = auto_bind_count;
+	}
+	struct Vdbe *stmt = sql_plan_cache_find(norm, norm_len, sql_flags);
+	/* The statement must be finalized after execution. */
+	bool is_owned = false;
+	if (stmt == NULL || sql_stmt_busy(stmt)) {
+		if (sql_stmt_compile(norm, norm_len, NULL, &stmt, NULL) != 0) {
+			/* Let the original statement report the error. */
+			diag_clear(diag_get());
+			return false;
+		}
+		is_owned = sql_plan_cache_insert(stmt, sql_flags) != 0;
+	} else {
+		sql_unbind(stmt);
+		sql_reset_autoinc_id_list(stmt);
+	}
+	enum sql_serialization_format format = sql_column_count(stmt) > 0 ?
+					       DQL_EXECUTE : DML_EXECUTE;
+	port_sql_create(port, stmt, format, is_owned);
+	if (sql_bind(stmt, bind, bind_count) == 0 &&
+	    sql_execute(stmt, port, region) == 0) {
+		*rc = 0;
+	} else {
+		port_destroy(port);
+		*rc = -1;
+	}
+	if (!is_owned)
+		sql_stmt_reset(stmt);
+	return true;
+}
+
 int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct port *port,
 			struct region *region)
 {
+	int rc;
+	if (sql_plan_cache_is_enabled() &&
+	    sql_execute_with_plan_cache(sql, len, bind, bind_count, port,
+					region, &rc))
+		return rc;
 	struct Vdbe *stmt;
 	if (sql_stmt_compile(sql, len, NULL, &stmt, NULL) != 0)
 		return -1;
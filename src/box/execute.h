@@ -104,6 +104,13 @@ sql_stmt_query_str(const struct Vdbe *stmt);
 int
 sql_stmt_busy(const struct Vdbe *stmt);
 
+/**
+ * Return true if the statement was compiled for the current schema
+ * version.
+ */
+bool
+sql_stmt_schema_version_is_valid(struct Vdbe *stmt);
+
 /**
  * Prepare (compile into VDBE byte-code) statement.
  *
@@ -19,6 +19,7 @@ const char *func_cache_holder_type_strs[FUNC_HOLDER_MAX] = {
 	[FUNC_HOLDER_SPACE_UPGRADE] = "space upgrade",
 	[FUNC_HOLDER_FIELD_DEFAULT] = "field default value",
 	[FUNC_HOLDER_TRIGGER] = "trigger",
+	[FUNC_HOLDER_INDEX_FILTER] = "index filter",
 };
 
 void
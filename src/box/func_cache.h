@@ -23,6 +23,7 @@ enum func_holder_type {
 	FUNC_HOLDER_SPACE_UPGRADE,
 	FUNC_HOLDER_FIELD_DEFAULT,
 	FUNC_HOLDER_TRIGGER,
+	FUNC_HOLDER_INDEX_FILTER,
 	FUNC_HOLDER_MAX,
 };
 
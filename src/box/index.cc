@@ -42,6 +42,7 @@
 #include "box.h"
 #include "base64.h"
 #include "scoped_guard.h"
+#include "port.h"
 
 struct rlist box_on_select = RLIST_HEAD_INITIALIZER(box_on_select);
 
@@ -527,6 +528,62 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	return 0;
 }
 
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char *keys,
+		   const char *keys_end, box_tuple_t **results)
+{
+	assert(keys != NULL && keys_end != NULL && results != NULL);
+	mp_tuple_assert(keys, keys_end);
+	if (box_check_slice() != 0)
+		return -1;
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	struct region *region = &fiber()->gc;
+	RegionGuard region_guard(region);
+	uint32_t key_count = mp_decode_array(&keys);
+	if (key_count == 0)
+		return 0;
+	uint32_t part_count = index->def->key_def->part_count;
+	size_t size;
+	const char **key_parts =
+		region_alloc_array(region, typeof(*key_parts), key_count,
+				   &size);
+	if (key_parts == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "keys");
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key_array = keys;
+		if (mp_typeof(*keys) != MP_ARRAY) {
+			diag_set(IllegalParams, "key must be an array");
+			return -1;
+		}
+		uint32_t key_part_count = mp_decode_array(&keys);
+		if (exact_key_validate(index->def, keys, key_part_count) != 0)
+			return -1;
+		box_run_on_select(space, index, ITER_EQ, key_array);
+		key_parts[i] = keys;
+		for (uint32_t j = 0; j < key_part_count; j++)
+			mp_next(&keys);
+	}
+	assert(keys == keys_end);
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	struct txn_ro_savepoint svp;
+	if (txn_begin_ro_stmt(space, &txn, &svp) != 0)
+		return -1;
+	int rc = index_get_many(index, key_parts, key_count, part_count,
+				results);
+	txn_end_ro_stmt(txn, &svp);
+	if (rc != 0)
+		return -1;
+	/* Count statistics. */
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+	return 0;
+}
+
 int
 box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result)
@@ -924,6 +981,7 @@ index_create(struct index *index, struct engine *engine,
 	/* Unusable until set to proper value during space creation. */
 	index->dense_id = UINT32_MAX;
 	rlist_create(&index->read_gaps);
+	index->sql_stat = NULL;
 }
 
 void
@@ -937,6 +995,7 @@ index_delete(struct index *index)
 	 * the index is primary or secondary.
 	 */
 	struct index_def *def = index->def;
+	free(index->sql_stat);
 	index->vtab->destroy(index);
 	index_def_delete(def);
 }
@@ -1135,6 +1194,29 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_many(struct index *index, const char **keys,
+		       uint32_t key_count, uint32_t part_count,
+		       struct tuple **results)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (index_get(index, keys[i], part_count, &results[i]) != 0) {
+			for (uint32_t j = 0; j < i; j++) {
+				if (results[j] != NULL)
+					tuple_unref(results[j]);
+			}
+			return -1;
+		}
+		/*
+		 * A tuple returned by get() may be kept alive only until
+		 * the next call, see tuple_bless().
+		 */
+		if (results[i] != NULL)
+			tuple_ref(results[i]);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
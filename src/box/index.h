@@ -49,9 +49,11 @@ struct space_read_view;
 struct index;
 struct index_read_view;
 struct index_read_view_iterator;
+struct sql_index_stat;
 struct index_def;
 struct key_def;
 struct info_handler;
+struct port;
 struct arrow_options;
 struct ArrowArrayStream;
 
@@ -287,6 +289,30 @@ char *
 box_tuple_extract_key(box_tuple_t *tuple, uint32_t space_id,
 		      uint32_t index_id, uint32_t *key_size);
 
+/**
+ * Get tuples from index by a batch of keys. Works like a sequence of
+ * box_index_get() calls, but lets the engine interleave the lookups
+ * to hide memory access latency.
+ *
+ * Unlike box_index_get(), the found tuples are referenced, the caller
+ * must unreference them with box_tuple_unref().
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param keys encoded array of keys, each in MsgPack Array format
+ *        ([[part1, part2, ...], ...]).
+ * \param keys_end the end of encoded \a keys
+ * \param[out] results array with an element per key, the i-th element
+ *        is set to the tuple matched by the i-th key or NULL
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \pre keys != NULL
+ * \sa \code box.space[space_id].index[index_id]:get_many(keys) \endcode
+ */
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char *keys,
+		   const char *keys_end, box_tuple_t **results);
+
 /** \endcond public */
 
 /**
@@ -629,6 +655,16 @@ struct index_vtab {
 			    uint32_t part_count, struct tuple **result);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Same as get() called for each of @a key_count keys having
+	 * @a part_count parts each, but the engine is free to interleave
+	 * the lookups. A key is passed without the MsgPack array header.
+	 * The found tuples are referenced, the caller must unreference
+	 * them.
+	 */
+	int (*get_many)(struct index *index, const char **keys,
+			uint32_t key_count, uint32_t part_count,
+			struct tuple **results);
 	/**
 	 * Main entrance point for changing data in index. Once built and
 	 * before deletion this is the only way to insert, replace and delete
@@ -715,6 +751,12 @@ struct index {
 	 * @sa struct gap_item_base.
 	 */
 	struct rlist read_gaps;
+	/**
+	 * Statistics of the index collected by the SQL ANALYZE
+	 * statement or NULL. Allocated with malloc() as a single
+	 * chunk of memory.
+	 */
+	struct sql_index_stat *sql_stat;
 };
 
 /**
@@ -1027,6 +1069,14 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_many(struct index *index, const char **keys, uint32_t key_count,
+	       uint32_t part_count, struct tuple **results)
+{
+	return index->vtab->get_many(index, keys, key_count, part_count,
+				     results);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -1242,6 +1292,10 @@ int
 generic_index_get_internal(struct index *index, const char *key,
 			   uint32_t part_count, struct tuple **result);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int
+generic_index_get_many(struct index *index, const char **keys,
+		       uint32_t key_count, uint32_t part_count,
+		       struct tuple **results);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode,
 			  struct tuple **, struct tuple **);
@@ -51,6 +51,7 @@ const struct index_opts index_opts_default = {
 	/* .bloom_fpr           = */ 0.05,
 	/* .lsn                 = */ 0,
 	/* .func                = */ 0,
+	/* .filter              = */ 0,
 	/* .hint                = */ INDEX_HINT_DEFAULT,
 	/* .covered_fields      = */ NULL,
 	/* .covered_field_count = */ 0,
@@ -145,6 +146,7 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
+	OPT_DEF("filter", OPT_UINT32, struct index_opts, filter_func_id),
 	OPT_DEF_LEGACY("sql"),
 	OPT_DEF_CUSTOM("hint", index_opts_parse_hint),
 	OPT_DEF_CUSTOM("covers", index_opts_parse_covered_fields),
@@ -105,6 +105,12 @@ struct index_opts {
 	int64_t lsn;
 	/** Identifier of the functional index function. */
 	uint32_t func_id;
+	/**
+	 * Identifier of the partial index predicate function.
+	 * A tuple is stored in the index only if the function
+	 * returns true for it. Zero if the index is not partial.
+	 */
+	uint32_t filter_func_id;
 	/**
 	 * Use hint optimization for tree index.
 	 */
@@ -171,6 +177,8 @@ index_opts_is_equal(const struct index_opts *o1, const struct index_opts *o2)
 		return false;
 	if (o1->func_id != o2->func_id)
 		return false;
+	if (o1->filter_func_id != o2->filter_func_id)
+		return false;
 	if (o1->hint != o2->hint)
 		return false;
 	if (o1->covered_field_count != o2->covered_field_count)
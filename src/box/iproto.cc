@@ -53,6 +53,7 @@
 #include "scoped_guard.h"
 #include "memory.h"
 #include "random.h"
+#include "clock.h"
 
 #include "bind.h"
 #include "port.h"
@@ -60,6 +61,7 @@
 #include "call.h"
 #include "tuple_convert.h"
 #include "session.h"
+#include "user.h"
 #include "xrow.h"
 #include "schema.h" /* schema_version */
 #include "replication.h" /* instance_uuid */
@@ -78,12 +80,18 @@
 #include "watcher.h"
 #include "box/mp_box_ctx.h"
 #include "box/tuple.h"
+#include "box/index.h"
 #include "mpstream/mpstream.h"
 
 enum {
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
 };
 
+enum {
+	/** Initial size of the buffer for results of a BATCH request. */
+	IPROTO_BATCH_BUF_SIZE = 16384,
+};
+
 enum {
 	 ENDPOINT_NAME_MAX = 10
 };
@@ -125,15 +133,106 @@ struct iproto_stream {
 struct iproto_wpos {
 	struct obuf *obuf;
 	struct obuf_svp svp;
+	/**
+	 * Number of tuples referenced by the output buffer before
+	 * the position, see struct iproto_tuple_ref.
+	 */
+	uint32_t ref_count;
+	/**
+	 * Number of bytes of the next referenced tuple that are
+	 * already written. Used only by the write position.
+	 */
+	uint32_t ref_offset;
+	/**
+	 * The last referenced tuple before the position or NULL.
+	 * Used only by the write position.
+	 */
+	struct iproto_tuple_ref *ref;
+};
+
+/**
+ * A tuple sent to the client right from the tuple memory instead of
+ * being copied to the output buffer. The tuple data is written to the
+ * socket at the position of the output buffer it would be copied to.
+ * The tuple is referenced until the output buffer is flushed and reset
+ * in the tx thread.
+ */
+struct iproto_tuple_ref {
+	/** Position of the output buffer the tuple data is written at. */
+	struct obuf_svp svp;
+	/** The referenced tuple. */
+	struct tuple *tuple;
+	/** MsgPack data of the tuple. */
+	const char *data;
+	/** Size of the tuple data. */
+	uint32_t size;
+	/** Next tuple referenced by the same output buffer. */
+	struct iproto_tuple_ref *next;
+};
+
+/** Tuples referenced by an output buffer in the order of positions. */
+struct iproto_tuple_refs {
+	/** The first referenced tuple or NULL. */
+	struct iproto_tuple_ref *first;
+	/** The last referenced tuple or NULL. */
+	struct iproto_tuple_ref *last;
+	/** Number of referenced tuples. */
+	uint32_t count;
+};
+
+/**
+ * A reply compressed by the iproto thread. The compressed reply is
+ * written to the socket instead of the output buffer data between
+ * the begin and end positions, see iproto_flush(). The data of the
+ * reply never contains referenced tuples.
+ */
+struct iproto_compressed_reply {
+	/** Position of the output buffer the reply starts at. */
+	struct iproto_wpos begin;
+	/** Position of the output buffer the reply ends at. */
+	struct iproto_wpos end;
+	/** Number of already written bytes of the compressed reply. */
+	size_t offset;
+	/** Size of the compressed reply. */
+	size_t size;
+	/** Link in iproto_connection::compressed_replies. */
+	struct stailq_entry in_compressed_replies;
+	/** The compressed reply. */
+	char data[0];
+};
+
+/**
+ * Server-side cursor opened by IPROTO_CURSOR_OPEN. Cursors belong to
+ * the connection and are accessed only by the tx thread.
+ */
+struct iproto_cursor {
+	/** Cursor ID, unique within the connection. */
+	uint64_t id;
+	/** Iterator over the tuples of the cursor. */
+	box_iterator_t *it;
+	/** Set while a fetch from the cursor is in progress. */
+	bool is_busy;
+	/**
+	 * Set if the cursor was closed while a fetch was in progress.
+	 * Such a cursor is freed by the fetch.
+	 */
+	bool is_closed;
+	/** Link in iproto_connection::tx::cursors. */
+	struct rlist in_cursors;
 };
 
+/** Free a cursor. */
 static void
-iproto_wpos_create(struct iproto_wpos *wpos, struct obuf *out)
+tx_cursor_delete(struct iproto_cursor *cursor)
 {
-	wpos->obuf = out;
-	wpos->svp = obuf_create_svp(out);
+	box_iterator_free(cursor->it);
+	free(cursor);
 }
 
+
+/** Memory pool for struct iproto_tuple_ref, used by the tx thread. */
+static struct mempool iproto_tuple_ref_pool;
+
 /**
  * Message sent when iproto thread dropped all connections that requested
  * to be dropped.
@@ -182,6 +281,8 @@ struct iproto_thread {
 	struct cmsg_hop begin_route[2];
 	struct cmsg_hop commit_route[2];
 	struct cmsg_hop rollback_route[2];
+	struct cmsg_hop batch_route[2];
+	struct cmsg_hop cursor_route[2];
 	struct cmsg_hop rollback_on_disconnect_route[2];
 	struct cmsg_hop destroy_route[2];
 	struct cmsg_hop disconnect_route[2];
@@ -278,6 +379,41 @@ int iproto_threads_count;
  */
 static struct evio_service tx_binary;
 
+/**
+ * If set, every IPROTO thread but the first one listens on its own
+ * socket bound with SO_REUSEPORT to each TCP listen address so that
+ * the kernel distributes incoming connections between the threads
+ * evenly instead of waking up all of them on every connection. The
+ * first thread listens on the socket bound by the tx thread.
+ */
+static bool iproto_listen_reuseport = false;
+
+const char *iproto_sched_class_strs[] = {
+	"system",
+	"interactive",
+	"batch",
+};
+
+static_assert(lengthof(iproto_sched_class_strs) == iproto_sched_class_MAX,
+	      "iproto_sched_class_strs must match iproto_sched_class");
+
+/**
+ * If set, requests are queued in the tx thread separately by their
+ * scheduling class (see iproto_sched_class), otherwise all requests
+ * are processed in the order they were received. Requests of the same
+ * connection are executed in order anyway, see
+ * iproto_connection::sched_queue.
+ */
+bool iproto_sched_classes = false;
+
+/**
+ * Names of the users whose requests are put to the batch scheduling
+ * class. Accessed only by the tx thread.
+ */
+static char **iproto_sched_batch_users;
+/** Number of entries in iproto_sched_batch_users. */
+static int iproto_sched_batch_user_count;
+
 /**
  * In Greek mythology, Kharon is the ferryman who carries souls
  * of the newly deceased across the river Styx that divided the
@@ -317,6 +453,38 @@ struct iproto_kharon {
  */
 unsigned iproto_readahead = 16320;
 
+/**
+ * Tuples with data of this size or bigger are referenced by the output
+ * buffer in SELECT replies instead of being copied to it. Zero disables
+ * referencing of tuples.
+ */
+uint64_t iproto_tuple_ref_min_size = 4096;
+
+/**
+ * Bodies of replies of this size or bigger (including the header) are
+ * compressed if the client supports IPROTO_FEATURE_COMPRESSION. Zero
+ * disables compression of replies.
+ */
+uint64_t iproto_compression_min_size = 1024;
+
+/**
+ * Max number of cursors opened by a connection at the same time. Zero
+ * means no limit.
+ */
+uint64_t iproto_cursor_max = 64;
+
+/**
+ * Target delay of requests in the queue to the tx thread, in seconds.
+ * If even the requests that waited the least over an interval waited
+ * longer, the tx thread is considered overloaded and rejects requests
+ * that waited too long, see tx_admission_check(). Zero disables
+ * admission control.
+ */
+double iproto_admission_target = 0.05;
+
+/** Interval of measuring the minimal queue delay, in seconds. */
+double iproto_admission_interval = 1;
+
 /* The maximal number of iproto messages in fly. */
 static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
 
@@ -554,6 +722,10 @@ struct iproto_msg
 		struct begin_request begin;
 		/** COMMIT request */
 		struct commit_request commit;
+		/** BATCH request */
+		struct batch_request batch;
+		/** CURSOR_FETCH or CURSOR_CLOSE request. */
+		struct cursor_request cursor;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
 	};
@@ -578,6 +750,26 @@ struct iproto_msg
 	 * the buffer.
 	 */
 	const char *reqstart;
+	/**
+	 * Decompressed request body if the request body is compressed,
+	 * otherwise NULL. Allocated with malloc().
+	 */
+	char *body_buf;
+	/**
+	 * Set by the tx thread if the reply should be compressed by the
+	 * iproto thread before it is written to the socket.
+	 */
+	bool compress_reply;
+	/**
+	 * Start of the reply in the output buffer of @a wpos. Valid only
+	 * if @a compress_reply is set.
+	 */
+	struct obuf_svp reply_svp;
+	/**
+	 * Monotonic time when the message was sent to the tx thread.
+	 * Used to measure the queue delay by admission control.
+	 */
+	double enqueue_time;
 	/**
 	 * Position in the connection output buffer. When sending a
 	 * message to the tx thread, iproto sets it to its current
@@ -608,6 +800,15 @@ struct iproto_msg
 	struct stailq_entry in_stream;
 	/** Stream that owns this message, or NULL. */
 	struct iproto_stream *stream;
+	/** Link in iproto_connection::sched_queue. */
+	struct stailq_entry in_sched_queue;
+	/**
+	 * Set if requests of the session user must be put to the batch
+	 * scheduling class. Copied from the connection when the message
+	 * is sent to tx and updated by tx in "connect" and AUTH messages,
+	 * see iproto_connection::is_sched_batch_user.
+	 */
+	bool is_sched_batch_user;
 	/** Link in connection->tx.inprogress. */
 	struct rlist in_inprogress;
 	/** TX thread fiber that processing this message. */
@@ -649,11 +850,13 @@ const char *rmean_net_strings[RMEAN_NET_LAST] = {
 
 enum rmean_tx_name {
 	REQUESTS_IN_PROGRESS,
+	REQUESTS_REJECTED,
 	RMEAN_TX_LAST,
 };
 
 const char *rmean_tx_strings[RMEAN_TX_LAST] = {
 	"REQUESTS_IN_PROGRESS",
+	"REQUESTS_REJECTED",
 };
 
 static void
@@ -775,6 +978,12 @@ struct iproto_connection
 	 * is flushed by the iproto thread.
 	 */
 	struct obuf obuf[2];
+	/**
+	 * Tuples referenced by the corresponding output buffers.
+	 * Appended and reset by the tx thread, read by the iproto
+	 * thread up to the count published in the write end.
+	 */
+	struct iproto_tuple_refs tuple_refs[2];
 	/**
 	 * Position in the output buffer that points to the beginning
 	 * of the data awaiting to be flushed. Advanced by the iproto
@@ -820,6 +1029,35 @@ struct iproto_connection
 	 * occasion.
 	 */
 	struct cmsg disconnect_msg;
+	/**
+	 * Set if the disconnect msg must be sent as soon as all
+	 * requests waiting in @a sched_queue are sent to tx.
+	 * Accessed only by the iproto thread.
+	 */
+	bool is_disconnect_pending;
+	/**
+	 * Requests waiting to be sent to tx. Requests of the connection
+	 * being processed by tx share the same scheduling class, see
+	 * @a sched_class. A request of another class waits here until
+	 * all of them are finished so that tx executes the requests
+	 * of the connection in the order they were received even if
+	 * it serves the classes out of order. An AUTH request waits
+	 * for all requests before it and blocks all requests after it.
+	 * Accessed only by the iproto thread.
+	 */
+	struct stailq sched_queue;
+	/** Scheduling class of the requests being processed by tx. */
+	enum iproto_sched_class sched_class;
+	/** Number of the requests being processed by tx. */
+	int sched_msg_count;
+	/** Set if the request being processed by tx is AUTH. */
+	bool is_sched_exclusive;
+	/**
+	 * Set if requests of the session user must be put to the
+	 * batch scheduling class, see iproto_sched_batch_users.
+	 * Updated on connect and authentication.
+	 */
+	bool is_sched_batch_user;
 	/**
 	 * Pre-allocated destroy msg. Is sent after disconnect has
 	 * happened and a last request has finished. Firstly
@@ -845,6 +1083,18 @@ struct iproto_connection
 	 * This field is accesable only from iproto thread.
 	 */
 	struct mh_i64ptr_t *streams;
+	/**
+	 * Set if the client announced IPROTO_FEATURE_COMPRESSION in
+	 * the last IPROTO_ID request. Compressed requests are rejected
+	 * unless it is set. Accessed only by the iproto thread.
+	 */
+	bool is_compression_enabled;
+	/**
+	 * Replies compressed by the iproto thread and not written yet,
+	 * in the order of positions, see struct iproto_compressed_reply.
+	 * Accessed only by the iproto thread.
+	 */
+	struct stailq compressed_replies;
 	/**
 	 * Kharon is used to implement box.session.push().
 	 * When a new push is ready, tx uses kharon to notify
@@ -893,6 +1143,12 @@ struct iproto_connection
 		bool is_push_pending;
 		/** List of inprogress messages. */
 		struct rlist inprogress;
+		/** List of open cursors. */
+		struct rlist cursors;
+		/** Number of cursors in the list. */
+		uint32_t cursor_count;
+		/** ID of the next opened cursor. */
+		uint64_t next_cursor_id;
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
@@ -924,6 +1180,90 @@ struct iproto_connection
 	size_t request_count;
 };
 
+/** Returns the tuples referenced by an output buffer of a connection. */
+static inline struct iproto_tuple_refs *
+iproto_connection_tuple_refs(struct iproto_connection *con, struct obuf *out)
+{
+	assert(out == &con->obuf[0] || out == &con->obuf[1]);
+	return &con->tuple_refs[out - con->obuf];
+}
+
+/** Create a position at the end of the current output buffer. */
+static void
+iproto_wpos_create(struct iproto_wpos *wpos, struct iproto_connection *con)
+{
+	struct obuf *out = con->tx.p_obuf;
+	wpos->obuf = out;
+	wpos->svp = obuf_create_svp(out);
+	wpos->ref_count = iproto_connection_tuple_refs(con, out)->count;
+	wpos->ref_offset = 0;
+	wpos->ref = NULL;
+}
+
+/** Reset a position to the beginning of an output buffer. */
+static void
+iproto_wpos_reset(struct iproto_wpos *wpos, struct obuf *out)
+{
+	wpos->obuf = out;
+	obuf_svp_reset(&wpos->svp);
+	wpos->ref_count = 0;
+	wpos->ref_offset = 0;
+	wpos->ref = NULL;
+}
+
+static inline bool
+iproto_wpos_equal(const struct iproto_wpos *a, const struct iproto_wpos *b)
+{
+	return a->svp.used == b->svp.used && a->ref_count == b->ref_count;
+}
+
+static void
+iproto_tuple_refs_create(struct iproto_tuple_refs *refs)
+{
+	refs->first = NULL;
+	refs->last = NULL;
+	refs->count = 0;
+}
+
+/**
+ * Reference a tuple by the current output buffer instead of copying
+ * its data to the buffer. Return the size of the tuple data.
+ */
+static uint32_t
+tx_output_ref_tuple(struct iproto_connection *con, struct tuple *tuple)
+{
+	struct obuf *out = con->tx.p_obuf;
+	struct iproto_tuple_refs *refs = iproto_connection_tuple_refs(con, out);
+	struct iproto_tuple_ref *ref = (struct iproto_tuple_ref *)
+		xmempool_alloc(&iproto_tuple_ref_pool);
+	ref->svp = obuf_create_svp(out);
+	ref->tuple = tuple;
+	ref->data = tuple_data_range(tuple, &ref->size);
+	ref->next = NULL;
+	tuple_ref(tuple);
+	if (refs->last == NULL)
+		refs->first = ref;
+	else
+		refs->last->next = ref;
+	refs->last = ref;
+	refs->count++;
+	return ref->size;
+}
+
+/** Unreference all tuples referenced by an output buffer. */
+static void
+tx_tuple_refs_reset(struct iproto_tuple_refs *refs)
+{
+	struct iproto_tuple_ref *ref = refs->first;
+	while (ref != NULL) {
+		struct iproto_tuple_ref *next = ref->next;
+		tuple_unref(ref->tuple);
+		mempool_free(&iproto_tuple_ref_pool, ref);
+		ref = next;
+	}
+	iproto_tuple_refs_create(refs);
+}
+
 /** Returns a string suitable for logging. */
 static inline const char *
 iproto_connection_name(const struct iproto_connection *con)
@@ -988,6 +1328,7 @@ iproto_msg_delete(struct iproto_msg *msg)
 {
 	assert(msg->connection->request_count > 0);
 	msg->connection->request_count--;
+	free(msg->body_buf);
 	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 	mempool_free(&msg->connection->iproto_thread->iproto_msg_pool, msg);
 	iproto_resume(iproto_thread);
@@ -1012,6 +1353,10 @@ iproto_msg_new(struct iproto_connection *con)
 	msg->connection = con;
 	msg->stream = NULL;
 	msg->fiber = NULL;
+	msg->body_buf = NULL;
+	msg->compress_reply = false;
+	msg->is_sched_batch_user = con->is_sched_batch_user;
+	msg->enqueue_time = clock_monotonic();
 	rmean_collect(con->iproto_thread->rmean, IPROTO_REQUESTS, 1);
 	con->request_count++;
 	return msg;
@@ -1133,6 +1478,21 @@ iproto_connection_try_to_start_destroy(struct iproto_connection *con)
 	cpipe_push(&con->iproto_thread->tx_pipe, &con->destroy_msg);
 }
 
+/**
+ * Notify tx about the connection close. The message is sent in the
+ * scheduling class of the requests being processed by tx so that it
+ * doesn't overtake them.
+ */
+static inline void
+iproto_connection_push_disconnect(struct iproto_connection *con)
+{
+	assert(stailq_empty(&con->sched_queue));
+	con->disconnect_msg.sched_class = con->sched_msg_count > 0 ?
+					  con->sched_class :
+					  IPROTO_SCHED_SYSTEM;
+	cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect_msg);
+}
+
 /**
  * Initiate a connection shutdown. This method may
  * be invoked many times, and does the internal
@@ -1175,7 +1535,14 @@ iproto_connection_close(struct iproto_connection *con)
 			    stailq_empty(&stream->pending_requests))
 				iproto_stream_rollback_on_disconnect(stream);
 		}
-		cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect_msg);
+		/*
+		 * Requests waiting in the scheduling queue were
+		 * received before the close, so let them go first.
+		 */
+		if (stailq_empty(&con->sched_queue))
+			iproto_connection_push_disconnect(con);
+		else
+			con->is_disconnect_pending = true;
 		assert(con->state == IPROTO_CONNECTION_ALIVE);
 		con->state = IPROTO_CONNECTION_CLOSED;
 	} else if (con->state == IPROTO_CONNECTION_PENDING_DESTROY) {
@@ -1294,7 +1661,7 @@ static inline bool
 iproto_is_flushed(struct iproto_connection *con)
 {
 	return con->wpos.obuf == con->wend.obuf &&
-		   con->wpos.svp.used == con->wend.svp.used;
+		   iproto_wpos_equal(&con->wpos, &con->wend);
 }
 
 /**
@@ -1337,6 +1704,123 @@ iproto_msg_start_processing_in_stream(struct iproto_msg *msg)
 	return false;
 }
 
+/** Returns the tx scheduling class of a request of the given type. */
+static enum iproto_sched_class
+iproto_sched_class(uint32_t type)
+{
+	switch (type) {
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
+	case IPROTO_BATCH:
+		return IPROTO_SCHED_BATCH;
+	case IPROTO_JOIN:
+	case IPROTO_SUBSCRIBE:
+	case IPROTO_VOTE_DEPRECATED:
+	case IPROTO_VOTE:
+	case IPROTO_FETCH_SNAPSHOT:
+	case IPROTO_REGISTER:
+		return IPROTO_SCHED_SYSTEM;
+	default:
+		return IPROTO_SCHED_INTERACTIVE;
+	}
+}
+
+/**
+ * Returns the tx scheduling class of a request. Replication requests
+ * always go to the system class. Requests of the users listed in
+ * iproto_sched_batch_users go to the batch class. Other requests go
+ * to the class set in the request header, if any, or to the class
+ * matching the request type.
+ */
+static enum iproto_sched_class
+iproto_msg_sched_class(struct iproto_msg *msg)
+{
+	enum iproto_sched_class sched_class =
+		iproto_sched_class(msg->header.type);
+	if (sched_class == IPROTO_SCHED_SYSTEM)
+		return sched_class;
+	if (msg->connection->is_sched_batch_user)
+		return IPROTO_SCHED_BATCH;
+	switch (msg->header.sched_class) {
+	case IPROTO_SCHED_INTERACTIVE:
+		return IPROTO_SCHED_INTERACTIVE;
+	case IPROTO_SCHED_BATCH:
+		return IPROTO_SCHED_BATCH;
+	default:
+		return sched_class;
+	}
+}
+
+/**
+ * Sends a request to tx if it doesn't have to wait for the requests
+ * of the connection being processed by tx, see
+ * iproto_connection::sched_queue. Returns false otherwise.
+ */
+static bool
+iproto_connection_try_push_msg(struct iproto_connection *con,
+			       struct iproto_msg *msg)
+{
+	enum iproto_sched_class sched_class = IPROTO_SCHED_SYSTEM;
+	bool is_exclusive = false;
+	if (iproto_sched_classes) {
+		sched_class = iproto_msg_sched_class(msg);
+		is_exclusive = msg->header.type == IPROTO_AUTH;
+	}
+	if (con->sched_msg_count > 0 &&
+	    (sched_class != con->sched_class || con->is_sched_exclusive ||
+	     is_exclusive))
+		return false;
+	msg->base.sched_class = sched_class;
+	msg->is_sched_batch_user = con->is_sched_batch_user;
+	con->sched_class = sched_class;
+	con->is_sched_exclusive = is_exclusive;
+	con->sched_msg_count++;
+	msg->enqueue_time = clock_monotonic();
+	cpipe_push(&con->iproto_thread->tx_pipe, &msg->base);
+	return true;
+}
+
+/**
+ * Sends a request to tx or queues it until the requests of the
+ * connection received before it are finished.
+ */
+static void
+iproto_connection_push_msg(struct iproto_connection *con,
+			   struct iproto_msg *msg)
+{
+	if (!stailq_empty(&con->sched_queue) ||
+	    !iproto_connection_try_push_msg(con, msg))
+		stailq_add_tail_entry(&con->sched_queue, msg, in_sched_queue);
+}
+
+/**
+ * Accounts a request sent to tx by iproto_connection_push_msg() that
+ * returned to the iproto thread and sends the requests that waited
+ * for it.
+ */
+static void
+iproto_connection_complete_msg(struct iproto_connection *con)
+{
+	assert(con->sched_msg_count > 0);
+	if (--con->sched_msg_count > 0)
+		return;
+	while (!stailq_empty(&con->sched_queue)) {
+		struct iproto_msg *msg =
+			stailq_first_entry(&con->sched_queue,
+					   struct iproto_msg, in_sched_queue);
+		if (!iproto_connection_try_push_msg(con, msg))
+			return;
+		stailq_shift(&con->sched_queue);
+	}
+	if (con->is_disconnect_pending) {
+		con->is_disconnect_pending = false;
+		iproto_connection_push_disconnect(con);
+	}
+}
+
 /**
  * Enqueue all requests which were read up. If a request limit is
  * reached - stop the connection input even if not the whole batch
@@ -1392,7 +1876,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 
 		iproto_msg_prepare(msg, &pos, reqend);
 		if (iproto_msg_start_processing_in_stream(msg)) {
-			cpipe_push(&con->iproto_thread->tx_pipe, &msg->base);
+			iproto_connection_push_msg(con, msg);
 			n_requests++;
 		}
 
@@ -1547,68 +2031,281 @@ error:;
 	iproto_connection_close(con);
 }
 
+/**
+ * Max number of iovecs written by iproto_flush() at once: chunks of
+ * the output buffer split by the referenced tuples and the tuples.
+ */
+enum { IPROTO_FLUSH_IOV_MAX = 4 * (SMALL_OBUF_IOV_MAX + 1) };
+
+/** A piece of output written by iproto_flush(). */
+struct iproto_flush_seg {
+	/** The referenced tuple or NULL for a chunk of the buffer. */
+	struct iproto_tuple_ref *ref;
+	/** Index of the chunk of the output buffer. */
+	size_t pos;
+	/** Offset of the piece in the chunk or in the tuple data. */
+	size_t offset;
+};
+
+/**
+ * Append iovecs of the output buffer data between two positions.
+ * Return the new number of iovecs.
+ */
+static int
+iproto_flush_add_obuf(struct obuf *obuf, const struct obuf_svp *begin,
+		      const struct obuf_svp *end, struct iovec *iov,
+		      struct iproto_flush_seg *seg, int iovcnt)
+{
+	for (size_t pos = begin->pos; pos <= end->pos; pos++, iovcnt++) {
+		size_t offset = pos == begin->pos ? begin->iov_len : 0;
+		/*
+		 * iov_len may be concurrently modified in tx thread,
+		 * but only for the last position, so take it from the
+		 * end position.
+		 */
+		size_t len = pos == end->pos ? end->iov_len :
+			     obuf->iov[pos].iov_len;
+		iov[iovcnt].iov_base = (char *)obuf->iov[pos].iov_base + offset;
+		iov[iovcnt].iov_len = len - offset;
+		seg[iovcnt].ref = NULL;
+		seg[iovcnt].pos = pos;
+		seg[iovcnt].offset = offset;
+	}
+	return iovcnt;
+}
+
+/** Advance the write position by the number of written bytes. */
+static void
+iproto_wpos_advance(struct iproto_wpos *wpos, const struct iovec *iov,
+		    const struct iproto_flush_seg *seg, int iovcnt,
+		    size_t size)
+{
+	for (int i = 0; i < iovcnt && size > 0; i++) {
+		size_t len = MIN(size, iov[i].iov_len);
+		size -= len;
+		if (seg[i].ref == NULL) {
+			wpos->svp.pos = seg[i].pos;
+			wpos->svp.iov_len = seg[i].offset + len;
+			wpos->svp.used += len;
+		} else if (len < iov[i].iov_len) {
+			wpos->ref_offset = seg[i].offset + len;
+		} else {
+			wpos->ref = seg[i].ref;
+			wpos->ref_count++;
+			wpos->ref_offset = 0;
+		}
+	}
+}
+
+/** Move the write position to the end without writing the output. */
+static void
+iproto_wpos_skip(struct iproto_wpos *wpos, const struct iproto_wpos *end,
+		 struct iproto_tuple_refs *refs)
+{
+	for (; wpos->ref_count < end->ref_count; wpos->ref_count++)
+		wpos->ref = wpos->ref == NULL ? refs->first : wpos->ref->next;
+	wpos->svp = end->svp;
+	wpos->ref_offset = 0;
+}
+
+/**
+ * Free the compressed replies of a connection that start before
+ * the given position, or all of them if the position is NULL.
+ */
+static void
+iproto_discard_compressed_replies(struct iproto_connection *con,
+				  const struct iproto_wpos *end)
+{
+	while (!stailq_empty(&con->compressed_replies)) {
+		struct iproto_compressed_reply *reply =
+			stailq_first_entry(&con->compressed_replies,
+					   struct iproto_compressed_reply,
+					   in_compressed_replies);
+		if (end != NULL && (reply->begin.obuf != end->obuf ||
+				    reply->begin.svp.used >= end->svp.used))
+			break;
+		stailq_shift(&con->compressed_replies);
+		free(reply);
+	}
+}
+
+/**
+ * Compress the reply to a message written to the output buffer by the
+ * tx thread. The compressed reply is written to the socket instead of
+ * the reply data, see iproto_flush(). The reply is sent as is if it
+ * can't be compressed.
+ */
+static void
+iproto_compress_reply(struct iproto_msg *msg)
+{
+	struct iproto_connection *con = msg->connection;
+	struct obuf *obuf = msg->wpos.obuf;
+	const struct obuf_svp *begin = &msg->reply_svp;
+	const struct obuf_svp *end = &msg->wpos.svp;
+	size_t size = end->used - begin->used;
+	RegionGuard region_guard(&fiber()->gc);
+	char *packet = (char *)region_alloc(&fiber()->gc, size);
+	if (packet == NULL)
+		return;
+	char *p = packet;
+	for (size_t pos = begin->pos; pos <= end->pos; pos++) {
+		size_t offset = pos == begin->pos ? begin->iov_len : 0;
+		/*
+		 * iov_len may be concurrently modified in tx thread,
+		 * but only for the last position, so take it from the
+		 * end position.
+		 */
+		size_t len = pos == end->pos ? end->iov_len :
+			     obuf->iov[pos].iov_len;
+		memcpy(p, (char *)obuf->iov[pos].iov_base + offset,
+		       len - offset);
+		p += len - offset;
+	}
+	assert(p == packet + size);
+	size_t compressed_size;
+	const char *compressed = iproto_packet_compress(packet, size,
+							&compressed_size);
+	if (compressed == NULL)
+		return;
+	struct iproto_compressed_reply *reply =
+		(struct iproto_compressed_reply *)
+		malloc(sizeof(*reply) + compressed_size);
+	if (reply == NULL)
+		return;
+	reply->begin = msg->wpos;
+	reply->begin.svp = *begin;
+	reply->end = msg->wpos;
+	reply->offset = 0;
+	reply->size = compressed_size;
+	memcpy(reply->data, compressed, compressed_size);
+	stailq_add_tail_entry(&con->compressed_replies, reply,
+			      in_compressed_replies);
+}
+
 /** writev() to the socket and handle the result. */
 static int
 iproto_flush(struct iproto_connection *con)
 {
 	struct obuf *obuf = con->wpos.obuf;
-	struct obuf_svp obuf_end = obuf_create_svp(obuf);
-	struct obuf_svp *begin = &con->wpos.svp;
-	struct obuf_svp *end = &con->wend.svp;
+	struct iproto_tuple_refs *refs = iproto_connection_tuple_refs(con, obuf);
+	struct iproto_wpos *begin = &con->wpos;
+	struct iproto_wpos *end = &con->wend;
+	struct iproto_wpos obuf_end;
 	if (con->wend.obuf != obuf) {
 		/*
 		 * Flush the current buffer before
 		 * advancing to the next one.
 		 */
-		if (begin->used == obuf_end.used) {
-			obuf = con->wpos.obuf = con->wend.obuf;
-			obuf_svp_reset(begin);
+		obuf_end.obuf = obuf;
+		obuf_end.svp = obuf_create_svp(obuf);
+		obuf_end.ref_count = refs->count;
+		if (iproto_wpos_equal(begin, &obuf_end)) {
+			obuf = con->wend.obuf;
+			refs = iproto_connection_tuple_refs(con, obuf);
+			iproto_wpos_reset(begin, obuf);
 		} else {
 			end = &obuf_end;
 		}
 	}
-	if (begin->used == end->used) {
+	if (iproto_wpos_equal(begin, end)) {
 		/* Nothing to do. */
 		return 1;
 	}
 	if (!con->can_write) {
 		/* Receiving end was closed. Discard the output. */
-		*begin = *end;
+		iproto_wpos_skip(begin, end, refs);
+		iproto_discard_compressed_replies(con, end);
 		return 0;
 	}
-	assert(begin->used < end->used);
+	assert(begin->svp.used <= end->svp.used);
+	assert(begin->ref_count <= end->ref_count);
 
 	ERROR_INJECT(ERRINJ_IPROTO_FLUSH_DELAY, {
 		return IOSTREAM_WANT_WRITE;
 	});
 
-	struct iovec iov[SMALL_OBUF_IOV_MAX+1];
-	struct iovec *src = obuf->iov;
-	int iovcnt = end->pos - begin->pos + 1;
 	/*
-	 * iov[i].iov_len may be concurrently modified in tx thread,
-	 * but only for the last position.
+	 * A compressed reply is written instead of its data in the
+	 * output buffer. Flush the output preceding it first.
 	 */
-	memcpy(iov, src + begin->pos, iovcnt * sizeof(struct iovec));
-	sio_add_to_iov(iov, -begin->iov_len);
-	/* *Overwrite* iov_len of the last pos as it may be garbage. */
-	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
+	struct iproto_compressed_reply *reply = NULL;
+	if (!stailq_empty(&con->compressed_replies)) {
+		reply = stailq_first_entry(&con->compressed_replies,
+					   struct iproto_compressed_reply,
+					   in_compressed_replies);
+		if (reply->begin.obuf != obuf ||
+		    reply->begin.svp.used >= end->svp.used) {
+			reply = NULL;
+		} else if (begin->svp.used < reply->begin.svp.used) {
+			end = &reply->begin;
+			reply = NULL;
+		}
+	}
+
+	struct iovec iov[IPROTO_FLUSH_IOV_MAX];
+	struct iproto_flush_seg seg[IPROTO_FLUSH_IOV_MAX];
+	int iovcnt = 0;
+	if (reply != NULL) {
+		assert(begin->svp.used == reply->begin.svp.used);
+		iov[0].iov_base = reply->data + reply->offset;
+		iov[0].iov_len = reply->size - reply->offset;
+		iovcnt = 1;
+	} else {
+		/*
+		 * Interleave the output buffer data with the data of
+		 * the referenced tuples. The data after the last added
+		 * tuple is left for the next call if the iovecs are
+		 * exhausted.
+		 */
+		struct obuf_svp svp = begin->svp;
+		struct iproto_tuple_ref *ref = begin->ref;
+		uint32_t ref_count = begin->ref_count;
+		uint32_t ref_offset = begin->ref_offset;
+		for (; ref_count < end->ref_count; ref_count++) {
+			if (iovcnt + SMALL_OBUF_IOV_MAX + 2 >
+			    IPROTO_FLUSH_IOV_MAX)
+				break;
+			ref = ref == NULL ? refs->first : ref->next;
+			iovcnt = iproto_flush_add_obuf(obuf, &svp, &ref->svp,
+						       iov, seg, iovcnt);
+			iov[iovcnt].iov_base = (char *)ref->data + ref_offset;
+			iov[iovcnt].iov_len = ref->size - ref_offset;
+			seg[iovcnt].ref = ref;
+			seg[iovcnt].pos = 0;
+			seg[iovcnt].offset = ref_offset;
+			iovcnt++;
+			svp = ref->svp;
+			ref_offset = 0;
+		}
+		if (ref_count == end->ref_count) {
+			iovcnt = iproto_flush_add_obuf(obuf, &svp, &end->svp,
+						       iov, seg, iovcnt);
+		}
+	}
+	size_t size = 0;
+	for (int i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
 
 	ssize_t nwr = iostream_writev(&con->io, iov, iovcnt);
 	if (nwr >= 0) {
 		/* Count statistics */
 		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
-		if (begin->used + nwr == end->used) {
-			*begin = *end;
+		if (reply != NULL) {
+			reply->offset += nwr;
+			if (reply->offset < reply->size)
+				return IOSTREAM_WANT_WRITE;
+			/* No tuples are referenced by the reply data. */
+			assert(begin->ref_count == reply->end.ref_count);
+			begin->svp = reply->end.svp;
+			stailq_shift(&con->compressed_replies);
+			free(reply);
 			return 0;
 		}
-		size_t offset = 0;
-		int advance = 0;
-		advance = sio_move_iov(iov, nwr, &offset);
-		begin->used += nwr;             /* advance write position */
-		begin->iov_len = advance == 0 ? begin->iov_len + offset: offset;
-		begin->pos += advance;
-		assert(begin->pos <= end->pos);
+		/* Advance write position. */
+		iproto_wpos_advance(begin, iov, seg, iovcnt, nwr);
+		assert(begin->svp.pos <= end->svp.pos);
+		if ((size_t)nwr == size)
+			return 0;
 		return IOSTREAM_WANT_WRITE;
 	} else if (nwr == IOSTREAM_ERROR) {
 		/*
@@ -1619,7 +2316,8 @@ iproto_flush(struct iproto_connection *con)
 		 */
 		diag_log();
 		con->can_write = false;
-		*begin = *end;
+		iproto_wpos_skip(begin, end, refs);
+		iproto_discard_compressed_replies(con, end);
 		return 0;
 	}
 	return nwr;
@@ -1677,21 +2375,34 @@ iproto_connection_new(struct iproto_thread *iproto_thread)
 		    iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
-	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
-	iproto_wpos_create(&con->wend, con->tx.p_obuf);
+	iproto_tuple_refs_create(&con->tuple_refs[0]);
+	iproto_tuple_refs_create(&con->tuple_refs[1]);
+	iproto_wpos_create(&con->wpos, con);
+	iproto_wpos_create(&con->wend, con);
 	con->parse_size = 0;
 	con->can_write = true;
 	con->long_poll_count = 0;
 	con->session = NULL;
 	con->is_in_replication = false;
+	con->is_compression_enabled = false;
+	stailq_create(&con->compressed_replies);
 	con->is_drop_pending = false;
 	con->is_established = false;
 	rlist_create(&con->in_stop_list);
 	rlist_create(&con->tx.inprogress);
+	rlist_create(&con->tx.cursors);
+	con->tx.cursor_count = 0;
+	con->tx.next_cursor_id = 1;
 	rlist_add_entry(&iproto_thread->connections, con, in_connections);
 	/* It may be very awkward to allocate at close. */
 	cmsg_init(&con->destroy_msg, con->iproto_thread->destroy_route);
 	cmsg_init(&con->disconnect_msg, con->iproto_thread->disconnect_route);
+	con->is_disconnect_pending = false;
+	stailq_create(&con->sched_queue);
+	con->sched_class = IPROTO_SCHED_SYSTEM;
+	con->sched_msg_count = 0;
+	con->is_sched_exclusive = false;
+	con->is_sched_batch_user = false;
 	con->state = IPROTO_CONNECTION_ALIVE;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
@@ -1744,6 +2455,7 @@ iproto_connection_delete(struct iproto_connection *con)
 
 	assert(mh_size(con->streams) == 0);
 	mh_i64ptr_delete(con->streams);
+	iproto_discard_compressed_replies(con, NULL);
 	rlist_del(&con->in_connections);
 	if (con->is_drop_pending) {
 		struct iproto_thread *iproto_thread = con->iproto_thread;
@@ -1772,6 +2484,12 @@ tx_process1(struct cmsg *msg);
 static void
 tx_process_select(struct cmsg *msg);
 
+static void
+tx_process_batch(struct cmsg *msg);
+
+static void
+tx_process_cursor(struct cmsg *msg);
+
 static void
 tx_process_sql(struct cmsg *msg);
 
@@ -1822,6 +2540,21 @@ iproto_msg_prepare(struct iproto_msg *msg, const char **pos, const char *reqend)
 	if (xrow_decode(&msg->header, pos, reqend, true) != 0)
 		goto error;
 	assert(*pos == reqend);
+	if (msg->header.compression != IPROTO_COMPRESSION_NONE) {
+		if (!con->is_compression_enabled) {
+			diag_set(ClientError, ER_PROTOCOL,
+				 "Compression is not negotiated by IPROTO_ID");
+			goto error;
+		}
+		/*
+		 * Limit the decompressed body size so that a small
+		 * packet can't make us allocate an arbitrary amount
+		 * of memory.
+		 */
+		if (xrow_decompress_body(&msg->header, iproto_max_input_size(),
+					 &msg->body_buf) != 0)
+			goto error;
+	}
 
 	type = msg->header.type;
 	stream_id = msg->header.stream_id;
@@ -1929,6 +2662,27 @@ iproto_msg_decode(struct iproto_msg *msg, struct cmsg_hop **route)
 	case IPROTO_ROLLBACK:
 		*route = iproto_thread->rollback_route;
 		return 0;
+	case IPROTO_BATCH:
+		*route = iproto_thread->batch_route;
+		if (xrow_decode_batch(&msg->header, &msg->batch) != 0)
+			return -1;
+		return 0;
+	case IPROTO_CURSOR_OPEN:
+		*route = iproto_thread->cursor_route;
+		/* The body is the one of SELECT, but the limit is optional. */
+		if (xrow_decode_dml_iproto(&msg->header, &msg->dml,
+					   dml_request_key_map(IPROTO_SELECT) &
+					   ~iproto_key_bit(IPROTO_LIMIT)) != 0)
+			return -1;
+		msg->dml.type = IPROTO_SELECT;
+		msg->dml.header = NULL;
+		return 0;
+	case IPROTO_CURSOR_FETCH:
+	case IPROTO_CURSOR_CLOSE:
+		*route = iproto_thread->cursor_route;
+		if (xrow_decode_cursor(&msg->header, &msg->cursor) != 0)
+			return -1;
+		return 0;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
@@ -1964,6 +2718,9 @@ iproto_msg_decode(struct iproto_msg *msg, struct cmsg_hop **route)
 		});
 		if (xrow_decode_id(&msg->header, &msg->id) != 0)
 			return -1;
+		msg->connection->is_compression_enabled =
+			iproto_features_test(&msg->id.features,
+					     IPROTO_FEATURE_COMPRESSION);
 		return 0;
 	case IPROTO_JOIN:
 	case IPROTO_FETCH_SNAPSHOT:
@@ -2102,6 +2859,11 @@ tx_process_destroy(struct cmsg *m)
 	 */
 	obuf_destroy(&con->obuf[0]);
 	obuf_destroy(&con->obuf[1]);
+	tx_tuple_refs_reset(&con->tuple_refs[0]);
+	tx_tuple_refs_reset(&con->tuple_refs[1]);
+	struct iproto_cursor *cursor, *tmp;
+	rlist_foreach_entry_safe(cursor, &con->tx.cursors, in_cursors, tmp)
+		tx_cursor_delete(cursor);
 }
 
 /**
@@ -2190,8 +2952,11 @@ tx_accept_wpos(struct iproto_connection *con, const struct iproto_wpos *wpos)
 		 * guaranteed to have been flushed first, since
 		 * buffers are never flushed out of order.
 		 */
-		if (obuf_size(prev) != 0)
+		if (obuf_size(prev) != 0) {
 			obuf_reset(prev);
+			tx_tuple_refs_reset(
+				iproto_connection_tuple_refs(con, prev));
+		}
 	}
 	if (obuf_size(con->tx.p_obuf) != 0 && obuf_size(prev) == 0) {
 		/*
@@ -2254,6 +3019,95 @@ check_watch_key(const char *key, uint32_t len)
 	return strncmp(key, box_ballot_event_key, len) == 0;
 }
 
+/**
+ * Admission control of requests to the tx thread based on CoDel
+ * (Controlled Delay). The tx thread is overloaded if even the requests
+ * that waited the least in the queue over the last interval waited
+ * longer than the target delay: a short burst doesn't trigger it
+ * because the queue drains within the interval, while a standing
+ * queue does. Overload is checked once per interval.
+ */
+static struct {
+	/** End of the current measurement interval. */
+	double interval_end;
+	/** Minimal queue delay of requests in the current interval. */
+	double min_delay;
+	/** Set if the tx thread was overloaded in the last interval. */
+	bool is_overloaded;
+} tx_admission;
+
+/**
+ * Returns the maximal queue delay of a request of the given type
+ * accepted when the tx thread is overloaded, in units of the target
+ * delay, or 0 if requests of the type are never rejected.
+ *
+ * Requests that release resources or don't access data (COMMIT,
+ * ROLLBACK, AUTH, PING, etc.) and replication requests are never
+ * rejected. Data changes are rejected after a longer delay than reads
+ * and calls.
+ */
+static int
+tx_admission_max_delay(uint32_t type)
+{
+	switch (type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+	case IPROTO_INSERT_ARROW:
+	case IPROTO_BEGIN:
+	case IPROTO_BATCH:
+		return 2;
+	case IPROTO_SELECT:
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
+	case IPROTO_CURSOR_OPEN:
+	case IPROTO_CURSOR_FETCH:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Check if the tx thread may process a request depending on the time
+ * it waited in the queue and its type. Returns -1 and sets diag if the
+ * request is rejected.
+ */
+static int
+tx_admission_check(struct iproto_msg *msg)
+{
+	double target = iproto_admission_target;
+	if (target <= 0)
+		return 0;
+	double now = clock_monotonic();
+	double delay = now - msg->enqueue_time;
+	if (now >= tx_admission.interval_end) {
+		/* Forget the interval if there were no requests after it. */
+		tx_admission.is_overloaded =
+			now < tx_admission.interval_end +
+			      iproto_admission_interval &&
+			tx_admission.min_delay > target;
+		tx_admission.interval_end = now + iproto_admission_interval;
+		tx_admission.min_delay = delay;
+	} else if (delay < tx_admission.min_delay) {
+		tx_admission.min_delay = delay;
+	}
+	if (!tx_admission.is_overloaded)
+		return 0;
+	int max_delay = tx_admission_max_delay(msg->header.type);
+	if (max_delay == 0 || delay <= max_delay * target)
+		return 0;
+	rmean_collect(msg->connection->iproto_thread->tx.rmean,
+		      REQUESTS_REJECTED, 1);
+	diag_set(ClientError, ER_OVERLOADED);
+	return -1;
+}
+
 /**
  * Check if the tx thread may continue with processing an accepted message.
  * If something's wrong, returns -1 and sets diag, otherwise returns 0.
@@ -2261,6 +3115,8 @@ check_watch_key(const char *key, uint32_t len)
 static int
 tx_check_msg(struct iproto_msg *msg)
 {
+	if (tx_admission_check(msg) != 0)
+		return -1;
 	uint64_t new_schema_version = msg->header.schema_version;
 	if (new_schema_version != 0 && new_schema_version != schema_version) {
 		diag_set(ClientError, ER_WRONG_SCHEMA_VERSION,
@@ -2277,9 +3133,45 @@ tx_check_msg(struct iproto_msg *msg)
 	return 0;
 }
 
+/** Check if big replies to the connection are compressed. */
+static inline bool
+tx_reply_compression_is_enabled(struct iproto_connection *con)
+{
+	return iproto_compression_min_size != 0 &&
+	       iproto_features_test(&con->session->meta.features,
+				    IPROTO_FEATURE_COMPRESSION);
+}
+
+/**
+ * Let the iproto thread compress the reply written to the output buffer
+ * at @a svp if the client supports compression and the reply is big
+ * enough. Compression is done by the iproto thread to keep it off the
+ * tx thread, see iproto_compress_reply().
+ */
+static void
+tx_prepare_reply_compression(struct iproto_msg *msg,
+			     const struct obuf_svp *svp)
+{
+	struct iproto_connection *con = msg->connection;
+	struct obuf *out = con->tx.p_obuf;
+	size_t size = obuf_size(out) - svp->used;
+	if (size < iproto_compression_min_size ||
+	    !tx_reply_compression_is_enabled(con))
+		return;
+	/* Referenced tuples are not stored in the output buffer. */
+	struct iproto_tuple_refs *refs = iproto_connection_tuple_refs(con, out);
+	if (refs->last != NULL && refs->last->svp.used >= svp->used)
+		return;
+	assert(msg->wpos.obuf == out && msg->wpos.svp.used == out->used);
+	msg->compress_reply = true;
+	msg->reply_svp = *svp;
+}
+
 static inline void
 tx_end_msg(struct iproto_msg *msg, struct obuf_svp *svp)
 {
+	if (msg->connection->tx.p_obuf->used != svp->used)
+		tx_prepare_reply_compression(msg, svp);
 	if (msg->stream != NULL) {
 		assert(msg->stream->txn == NULL);
 		msg->stream->txn = txn_detach();
@@ -2302,7 +3194,7 @@ tx_reply_error(struct iproto_msg *msg)
 	struct obuf *out = msg->connection->tx.p_obuf;
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 }
 
 /**
@@ -2317,7 +3209,7 @@ tx_reply_iproto_error(struct cmsg *m)
 	struct obuf_svp header = obuf_create_svp(out);
 	iproto_reply_error(out, diag_last_error(&msg->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header);
 }
 
@@ -2365,7 +3257,7 @@ tx_process_begin(struct cmsg *m)
 	out = msg->connection->tx.p_obuf;
 	header = obuf_create_svp(out);
 	iproto_reply_ok(out, msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header);
 	return;
 error:
@@ -2395,7 +3287,7 @@ tx_process_commit(struct cmsg *m)
 	out = msg->connection->tx.p_obuf;
 	header = obuf_create_svp(out);
 	iproto_reply_ok(out, msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header);
 	return;
 error:
@@ -2421,7 +3313,7 @@ tx_process_rollback(struct cmsg *m)
 	out = msg->connection->tx.p_obuf;
 	header = obuf_create_svp(out);
 	iproto_reply_ok(out, msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header);
 	return;
 error:
@@ -2511,7 +3403,7 @@ tx_process1(struct cmsg *m)
 		goto error;
 	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
 			    tuple != 0, box_tuple_as_ext);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &svp);
 	return;
 error:
@@ -2521,13 +3413,106 @@ tx_process1(struct cmsg *m)
 	tx_end_msg(msg, &svp);
 }
 
+/**
+ * Dump the tuples of a SELECT result to the current output buffer.
+ * Tuples of iproto_tuple_ref_min_size or bigger are referenced by the
+ * buffer instead of being copied to it, their total size is returned
+ * in @a ref_size. Return the number of dumped tuples.
+ */
+static int
+tx_dump_select(struct iproto_connection *con, struct port *port,
+	       uint32_t *ref_size)
+{
+	struct obuf *out = con->tx.p_obuf;
+	int count = 0;
+	*ref_size = 0;
+	const struct port_c_entry *pe = port_get_c_entries(port);
+	for (; pe != NULL; pe = pe->next, count++) {
+		assert(pe->type == PORT_C_ENTRY_TUPLE);
+		uint32_t size;
+		const char *data = tuple_data_range(pe->tuple, &size);
+		if (size < iproto_tuple_ref_min_size)
+			xobuf_dup(out, data, size);
+		else
+			*ref_size += tx_output_ref_tuple(con, pe->tuple);
+	}
+	return count;
+}
+
+/**
+ * Decode the IPROTO_FIELDS array of a SELECT request to an array of
+ * field numbers allocated on the fiber region. The array is set to NULL
+ * if the request has no IPROTO_FIELDS. Return -1 and set diag if the
+ * array contains anything but field numbers.
+ */
+static int
+tx_decode_select_fields(const struct request *req, uint32_t **fields,
+			uint32_t *field_count)
+{
+	*fields = NULL;
+	*field_count = 0;
+	if (req->fields == NULL)
+		return 0;
+	const char *data = req->fields;
+	uint32_t count = mp_decode_array(&data);
+	uint32_t *result = xregion_alloc_array(&fiber()->gc, uint32_t,
+					       count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (mp_typeof(*data) != MP_UINT) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "IPROTO_FIELDS must be an array of "
+				 "field numbers");
+			return -1;
+		}
+		uint64_t fieldno = mp_decode_uint(&data);
+		result[i] = fieldno > UINT32_MAX ? UINT32_MAX : fieldno;
+	}
+	*fields = result;
+	*field_count = count;
+	return 0;
+}
+
+/**
+ * Dump the tuples of a SELECT result projected to the given fields to
+ * @a out. Each tuple is encoded as an array of the given fields taken
+ * right from the tuple data, absent fields are encoded as nils. Return
+ * the number of dumped tuples.
+ */
+static int
+tx_dump_select_fields(struct port *port, const uint32_t *fields,
+		      uint32_t field_count, struct obuf *out)
+{
+	int count = 0;
+	const struct port_c_entry *pe = port_get_c_entries(port);
+	for (; pe != NULL; pe = pe->next, count++) {
+		assert(pe->type == PORT_C_ENTRY_TUPLE);
+		char *data = (char *)xobuf_alloc(out,
+						 mp_sizeof_array(field_count));
+		mp_encode_array(data, field_count);
+		for (uint32_t i = 0; i < field_count; i++) {
+			const char *field = tuple_field(pe->tuple, fields[i]);
+			if (field == NULL) {
+				data = (char *)xobuf_alloc(out, mp_sizeof_nil());
+				mp_encode_nil(data);
+				continue;
+			}
+			const char *field_end = field;
+			mp_next(&field_end);
+			xobuf_dup(out, field, field_end - field);
+		}
+	}
+	return count;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
+	/* Projected tuples are sent as plain arrays. */
 	bool box_tuple_as_ext =
 		iproto_features_test(&msg->connection->session->meta.features,
-				     IPROTO_FEATURE_DML_TUPLE_EXTENSION);
+				     IPROTO_FEATURE_DML_TUPLE_EXTENSION) &&
+		msg->dml.fields == NULL;
 	struct obuf *out;
 	struct obuf_svp svp;
 	struct port port;
@@ -2544,9 +3529,12 @@ tx_process_select(struct cmsg *m)
 	ctx_guard.is_active = box_tuple_as_ext;
 
 	int count;
+	uint32_t ref_size;
 	int rc;
 	const char *packed_pos, *packed_pos_end;
 	bool reply_position;
+	uint32_t *fields;
+	uint32_t field_count;
 	struct request *req = &msg->dml;
 	uint32_t region_svp = region_used(&fiber()->gc);
 	if (tx_check_msg(msg) != 0)
@@ -2555,6 +3543,8 @@ tx_process_select(struct cmsg *m)
 	tx_inject_delay();
 	if (tx_resolve_space_and_index_name(&msg->dml) != 0)
 		goto error;
+	if (tx_decode_select_fields(req, &fields, &field_count) != 0)
+		goto error;
 	packed_pos = req->after_position;
 	packed_pos_end = req->after_position_end;
 	if (packed_pos != NULL) {
@@ -2581,9 +3571,18 @@ tx_process_select(struct cmsg *m)
 	else
 		iproto_prepare_select(out, &svp);
 	/*
-	 * SELECT output format has not changed since Tarantool 1.6
+	 * SELECT output format has not changed since Tarantool 1.6.
+	 * Tuples are copied to compressed replies, so they aren't
+	 * referenced if the reply may be compressed.
 	 */
-	count = port_dump_msgpack_16_with_ctx(&port, out, ctx_ref);
+	ref_size = 0;
+	if (fields != NULL)
+		count = tx_dump_select_fields(&port, fields, field_count, out);
+	else if (!box_tuple_as_ext && iproto_tuple_ref_min_size != 0 &&
+		 !tx_reply_compression_is_enabled(msg->connection))
+		count = tx_dump_select(msg->connection, &port, &ref_size);
+	else
+		count = port_dump_msgpack_16_with_ctx(&port, out, ctx_ref);
 	port_destroy(&port);
 	if (count < 0 || (box_tuple_as_ext &&
 			  tuple_format_map_to_iproto_obuf(&ctx.tuple_format_map,
@@ -2600,8 +3599,10 @@ tx_process_select(struct cmsg *m)
 		iproto_reply_select(out, &svp, msg->header.sync,
 				    ::schema_version, count, box_tuple_as_ext);
 	}
+	if (ref_size != 0)
+		iproto_reply_add_body_size(out, &svp, ref_size);
 	region_truncate(&fiber()->gc, region_svp);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &svp);
 	return;
 discard:
@@ -2609,6 +3610,337 @@ tx_process_select(struct cmsg *m)
 	obuf_rollback_to_svp(out, &svp);
 error:
 	region_truncate(&fiber()->gc, region_svp);
+	out = msg->connection->tx.p_obuf;
+	svp = obuf_create_svp(out);
+	if (is_atomic) {
+		tx_reply_error(msg);
+	} else {
+		iproto_reply_batch_error(out, diag_last_error(diag_get()),
+					 msg->header.sync, ::schema_version,
+					 applied_count);
+		iproto_wpos_create(&msg->wpos, msg->connection);
+	}
+	tx_end_msg(msg, &svp);
+}
+
+/**
+ * Execute a request of a BATCH request and write its result to @a out
+ * as an array of tuples: the selected tuples for SELECT and the tuple
+ * returned by DML (if any) otherwise.
+ */
+static int
+tx_process_batch_request(struct request *req, struct obuf *out)
+{
+	if (tx_resolve_space_and_index_name(req) != 0)
+		return -1;
+	if (req->type != IPROTO_SELECT) {
+		struct tuple *tuple;
+		if (box_process1(req, &tuple) != 0)
+			return -1;
+		char *data = (char *)xobuf_alloc(out, mp_sizeof_array(1));
+		mp_encode_array(data, tuple != NULL ? 1 : 0);
+		if (tuple != NULL && tuple_to_obuf(tuple, out) != 0)
+			return -1;
+		return 0;
+	}
+	const char *packed_pos = req->after_position;
+	const char *packed_pos_end = req->after_position_end;
+	if (packed_pos != NULL) {
+		mp_decode_strl(&packed_pos);
+	} else if (req->after_tuple != NULL) {
+		if (box_index_tuple_position(req->space_id, req->index_id,
+					     req->after_tuple,
+					     req->after_tuple_end,
+					     &packed_pos,
+					     &packed_pos_end) != 0)
+			return -1;
+	}
+	uint32_t *fields, field_count;
+	if (tx_decode_select_fields(req, &fields, &field_count) != 0)
+		return -1;
+	struct port port;
+	if (box_select(req->space_id, req->index_id, req->iterator,
+		       req->offset, req->limit, req->key, req->key_end,
+		       &packed_pos, &packed_pos_end, false, &port) != 0)
+		return -1;
+	/* Reserve MP_ARRAY32 header, the tuple count is unknown yet. */
+	char *data = (char *)xobuf_alloc(out, mp_sizeof_array(UINT32_MAX));
+	int count;
+	if (fields != NULL)
+		count = tx_dump_select_fields(&port, fields, field_count, out);
+	else
+		count = port_dump_msgpack_16(&port, out);
+	port_destroy(&port);
+	if (count < 0)
+		return -1;
+	*data = (char)0xdd;
+	mp_store_u32(data + 1, count);
+	return 0;
+}
+
+/**
+ * Execute the requests of a BATCH request one by one, in one
+ * transaction if the request is atomic, and reply with an array of
+ * their results. Execution stops at the first failed request: if the
+ * request is atomic, the whole transaction is rolled back, otherwise
+ * the preceding requests stay applied and their number is sent in the
+ * error response.
+ */
+static void
+tx_process_batch(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct batch_request *batch = &msg->batch;
+	struct obuf *out;
+	struct obuf_svp svp;
+	const char *data;
+	/* Number of the requests executed successfully. */
+	uint32_t applied_count = 0;
+	/* Requests of a stream transaction are executed in it. */
+	bool is_atomic = batch->is_atomic && !in_txn();
+	uint32_t region_svp = region_used(&fiber()->gc);
+	/*
+	 * Requests may yield so the results are written to a temporary
+	 * buffer to avoid interleaving them with the replies to other
+	 * requests of the connection.
+	 */
+	struct obuf buf;
+	obuf_create(&buf, &cord()->slabc, IPROTO_BATCH_BUF_SIZE);
+	auto buf_guard = make_scoped_guard([&buf] {
+		obuf_destroy(&buf);
+	});
+	if (tx_check_msg(msg) != 0)
+		goto error;
+	tx_inject_delay();
+	if (is_atomic && box_txn_begin() != 0)
+		goto error;
+	data = batch->requests;
+	mp_decode_array(&data);
+	for (applied_count = 0; applied_count < batch->request_count;
+	     applied_count++) {
+		struct xrow_header row;
+		struct request req;
+		if (xrow_decode_batch_next(&data, &row, &req) != 0 ||
+		    tx_process_batch_request(&req, &buf) != 0)
+			goto rollback;
+	}
+	if (is_atomic && box_txn_commit() != 0)
+		goto error;
+	out = msg->connection->tx.p_obuf;
+	iproto_prepare_select(out, &svp);
+	for (int i = 0; i < obuf_iovcnt(&buf); i++)
+		xobuf_dup(out, buf.iov[i].iov_base, buf.iov[i].iov_len);
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    batch->request_count, false);
+	region_truncate(&fiber()->gc, region_svp);
+	iproto_wpos_create(&msg->wpos, msg->connection);
+	tx_end_msg(msg, &svp);
+	return;
+rollback:
+	if (is_atomic) {
+		int rc = box_txn_rollback();
+		assert(rc == 0);
+		(void)rc;
+	}
+error:
+	region_truncate(&fiber()->gc, region_svp);
+	out = msg->connection->tx.p_obuf;
+	svp = obuf_create_svp(out);
+	if (is_atomic) {
+		tx_reply_error(msg);
+	} else {
+		iproto_reply_batch_error(out, diag_last_error(diag_get()),
+					 msg->header.sync, ::schema_version,
+					 applied_count);
+		iproto_wpos_create(&msg->wpos, msg->connection);
+	}
+	tx_end_msg(msg, &svp);
+}
+
+/** Find an open cursor of a connection or set diag if there's none. */
+static struct iproto_cursor *
+tx_cursor_find(struct iproto_connection *con, uint64_t id)
+{
+	struct iproto_cursor *cursor;
+	rlist_foreach_entry(cursor, &con->tx.cursors, in_cursors) {
+		if (cursor->id == id)
+			return cursor;
+	}
+	diag_set(ClientError, ER_NO_SUCH_CURSOR, (unsigned long long)id);
+	return NULL;
+}
+
+/**
+ * Open a cursor for the SELECT request of the message and write its ID
+ * to the output buffer at @a svp.
+ */
+static int
+tx_cursor_open(struct iproto_msg *msg, struct obuf_svp *svp)
+{
+	struct iproto_connection *con = msg->connection;
+	struct request *req = &msg->dml;
+	if (req->fields != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, "IPROTO_CURSOR_OPEN",
+			 "IPROTO_FIELDS");
+		return -1;
+	}
+	if (iproto_cursor_max != 0 &&
+	    con->tx.cursor_count >= iproto_cursor_max) {
+		diag_set(ClientError, ER_CURSOR_LIMIT,
+			 (unsigned)iproto_cursor_max);
+		return -1;
+	}
+	if (tx_resolve_space_and_index_name(req) != 0)
+		return -1;
+	uint32_t region_svp = region_used(&fiber()->gc);
+	const char *packed_pos = req->after_position;
+	const char *packed_pos_end = req->after_position_end;
+	if (packed_pos != NULL) {
+		mp_decode_strl(&packed_pos);
+	} else if (req->after_tuple != NULL) {
+		if (box_index_tuple_position(req->space_id, req->index_id,
+					     req->after_tuple,
+					     req->after_tuple_end,
+					     &packed_pos,
+					     &packed_pos_end) != 0)
+			return -1;
+	}
+	box_iterator_t *it = box_index_iterator_with_offset(
+		req->space_id, req->index_id, req->iterator, req->key,
+		req->key_end, packed_pos, packed_pos_end, req->offset);
+	region_truncate(&fiber()->gc, region_svp);
+	if (it == NULL)
+		return -1;
+	struct iproto_cursor *cursor =
+		(struct iproto_cursor *)xmalloc(sizeof(*cursor));
+	cursor->id = con->tx.next_cursor_id++;
+	cursor->it = it;
+	cursor->is_busy = false;
+	cursor->is_closed = false;
+	rlist_add_tail_entry(&con->tx.cursors, cursor, in_cursors);
+	con->tx.cursor_count++;
+
+	struct obuf *out = con->tx.p_obuf;
+	iproto_prepare_select(out, svp);
+	char *data = (char *)xobuf_alloc(out, mp_sizeof_uint(cursor->id));
+	mp_encode_uint(data, cursor->id);
+	iproto_reply_select(out, svp, msg->header.sync, ::schema_version,
+			    1, false);
+	return 0;
+}
+
+/**
+ * Fetch up to the requested number of tuples from a cursor and write
+ * them to the output buffer at @a svp like a SELECT reply. An empty
+ * reply means that the cursor is exhausted.
+ */
+static int
+tx_cursor_fetch(struct iproto_msg *msg, struct obuf_svp *svp)
+{
+	struct iproto_connection *con = msg->connection;
+	struct iproto_cursor *cursor =
+		tx_cursor_find(con, msg->cursor.cursor_id);
+	if (cursor == NULL)
+		return -1;
+	if (cursor->is_busy) {
+		diag_set(ClientError, ER_CURSOR_BUSY,
+			 (unsigned long long)cursor->id);
+		return -1;
+	}
+	/*
+	 * The iterator may yield so the tuples are collected in a port
+	 * first to avoid interleaving the reply with the replies to
+	 * other requests of the connection.
+	 */
+	struct port port;
+	port_c_create(&port);
+	auto port_guard = make_scoped_guard([&port] {
+		port_destroy(&port);
+	});
+	int rc = 0;
+	cursor->is_busy = true;
+	for (uint32_t i = 0; i < msg->cursor.limit; i++) {
+		struct tuple *tuple;
+		rc = box_iterator_next(cursor->it, &tuple);
+		if (rc != 0 || tuple == NULL)
+			break;
+		port_c_add_tuple(&port, tuple);
+	}
+	cursor->is_busy = false;
+	if (cursor->is_closed)
+		tx_cursor_delete(cursor);
+	if (rc != 0)
+		return -1;
+
+	struct obuf *out = con->tx.p_obuf;
+	iproto_prepare_select(out, svp);
+	uint32_t ref_size = 0;
+	int count;
+	if (iproto_tuple_ref_min_size != 0 &&
+	    !tx_reply_compression_is_enabled(con))
+		count = tx_dump_select(con, &port, &ref_size);
+	else
+		count = port_dump_msgpack_16(&port, out);
+	if (count < 0) {
+		obuf_rollback_to_svp(out, svp);
+		return -1;
+	}
+	iproto_reply_select(out, svp, msg->header.sync, ::schema_version,
+			    count, false);
+	if (ref_size != 0)
+		iproto_reply_add_body_size(out, svp, ref_size);
+	return 0;
+}
+
+/** Close a cursor and write an empty reply to the output buffer. */
+static int
+tx_cursor_close(struct iproto_msg *msg, struct obuf_svp *svp)
+{
+	struct iproto_cursor *cursor =
+		tx_cursor_find(msg->connection, msg->cursor.cursor_id);
+	if (cursor == NULL)
+		return -1;
+	rlist_del_entry(cursor, in_cursors);
+	msg->connection->tx.cursor_count--;
+	if (cursor->is_busy)
+		cursor->is_closed = true;
+	else
+		tx_cursor_delete(cursor);
+	struct obuf *out = msg->connection->tx.p_obuf;
+	*svp = obuf_create_svp(out);
+	iproto_reply_ok(out, msg->header.sync, ::schema_version);
+	return 0;
+}
+
+static void
+tx_process_cursor(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out;
+	struct obuf_svp svp;
+	int rc;
+	if (tx_check_msg(msg) != 0)
+		goto error;
+	tx_inject_delay();
+	switch (msg->header.type) {
+	case IPROTO_CURSOR_OPEN:
+		rc = tx_cursor_open(msg, &svp);
+		break;
+	case IPROTO_CURSOR_FETCH:
+		rc = tx_cursor_fetch(msg, &svp);
+		break;
+	case IPROTO_CURSOR_CLOSE:
+		rc = tx_cursor_close(msg, &svp);
+		break;
+	default:
+		unreachable();
+	}
+	if (rc != 0)
+		goto error;
+	iproto_wpos_create(&msg->wpos, msg->connection);
+	tx_end_msg(msg, &svp);
+	return;
+error:
 	out = msg->connection->tx.p_obuf;
 	svp = obuf_create_svp(out);
 	tx_reply_error(msg);
@@ -2719,7 +4051,7 @@ tx_process_call(struct cmsg *m)
 	}
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count, box_tuple_as_ext);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &svp);
 	return;
 error:
@@ -2745,6 +4077,25 @@ iproto_session_notify(struct session *session, uint64_t sync,
 		      const char *key, size_t key_len,
 		      const char *data, const char *data_end);
 
+/**
+ * Returns true if requests of the session user must be put to the
+ * batch scheduling class, see iproto_sched_batch_users.
+ */
+static bool
+tx_session_is_sched_batch_user(struct session *session)
+{
+	if (iproto_sched_batch_user_count == 0)
+		return false;
+	struct user *user = user_by_id(session->credentials.uid);
+	if (user == NULL)
+		return false;
+	for (int i = 0; i < iproto_sched_batch_user_count; i++) {
+		if (strcmp(user->def->name, iproto_sched_batch_users[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
 static void
 tx_process_misc(struct cmsg *m)
 {
@@ -2763,6 +4114,8 @@ tx_process_misc(struct cmsg *m)
 		if (box_process_auth(&msg->auth, con->salt,
 				     IPROTO_SALT_SIZE) != 0)
 			goto error;
+		msg->is_sched_batch_user =
+			tx_session_is_sched_batch_user(con->session);
 		iproto_reply_ok(out, msg->header.sync, ::schema_version);
 		break;
 	case IPROTO_PING:
@@ -2807,7 +4160,7 @@ tx_process_misc(struct cmsg *m)
 	default:
 		unreachable();
 	}
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header);
 	return;
 error:
@@ -2845,7 +4198,7 @@ tx_process_sql(struct cmsg *m)
 	}
 	port_destroy(&port);
 	iproto_reply_sql(out, &header_svp, msg->header.sync, schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	tx_end_msg(msg, &header_svp);
 	return;
 error:
@@ -3116,15 +4469,12 @@ static void
 tx_process_override(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
-	const char *header = msg->reqstart;
-	mp_decode_uint(&header);
-
-	const char *header_end = msg->reqstart + msg->len;
+	const char *header = msg->header.header;
+	const char *header_end = msg->header.header_end;
 	const char *body = "\x80"; /* Empty MsgPack map encoding. */
 	const char *body_end = body + 1;
 	if (msg->header.bodycnt != 0) {
 		assert(msg->header.bodycnt == 1);
-		header_end -= msg->header.body[0].iov_len;
 		body = (const char *)msg->header.body[0].iov_base;
 		body_end = body + msg->header.body[0].iov_len;
 	}
@@ -3167,7 +4517,7 @@ tx_process_override(struct cmsg *m)
 	switch (rc) {
 	case IPROTO_HANDLER_OK: {
 		struct obuf *out = msg->connection->tx.p_obuf;
-		iproto_wpos_create(&msg->wpos, out);
+		iproto_wpos_create(&msg->wpos, msg->connection);
 		struct obuf_svp empty = obuf_create_svp(out);
 		tx_end_msg(msg, &empty);
 		return;
@@ -3237,8 +4587,7 @@ iproto_msg_finish_processing_in_stream(struct iproto_msg *msg)
 		assert(stream->current != NULL);
 		stream->current->wpos = con->wpos;
 		con->iproto_thread->requests_in_stream_queue--;
-		cpipe_push(&con->iproto_thread->tx_pipe,
-			   &stream->current->base);
+		iproto_connection_push_msg(con, stream->current);
 	}
 }
 
@@ -3248,6 +4597,9 @@ net_send_msg(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	if (msg->header.type == IPROTO_AUTH)
+		con->is_sched_batch_user = msg->is_sched_batch_user;
+	iproto_connection_complete_msg(con);
 	iproto_msg_finish_processing_in_stream(msg);
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
@@ -3257,6 +4609,8 @@ net_send_msg(struct cmsg *m)
 		assert(con->long_poll_count > 0);
 		con->long_poll_count--;
 	}
+	if (msg->compress_reply && con->can_write)
+		iproto_compress_reply(msg);
 	con->wend = msg->wpos;
 
 	if (con->state == IPROTO_CONNECTION_ALIVE) {
@@ -3287,6 +4641,7 @@ net_end_join(struct cmsg *m)
 	struct iproto_connection *con = msg->connection;
 	struct ibuf *ibuf = msg->p_ibuf;
 
+	iproto_connection_complete_msg(con);
 	iproto_msg_finish_input(msg);
 	iproto_msg_delete(msg);
 
@@ -3311,6 +4666,7 @@ net_end_subscribe(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	iproto_connection_complete_msg(con);
 	iproto_msg_finish_input(msg);
 	iproto_msg_delete(msg);
 
@@ -3350,7 +4706,8 @@ tx_process_connect(struct cmsg *m)
 	xobuf_dup(out, greeting, IPROTO_GREETING_SIZE);
 	if (session_run_on_connect_triggers(con->session) != 0)
 		goto error;
-	iproto_wpos_create(&msg->wpos, out);
+	msg->is_sched_batch_user = tx_session_is_sched_batch_user(con->session);
+	iproto_wpos_create(&msg->wpos, msg->connection);
 	return;
 error:
 	tx_reply_error(msg);
@@ -3388,6 +4745,7 @@ net_send_greeting(struct cmsg *m)
 		return;
 	}
 	con->is_established = true;
+	con->is_sched_batch_user = msg->is_sched_batch_user;
 	con->wend = msg->wpos;
 	/*
 	 * Connect is synchronous, so no one could have been
@@ -3522,7 +4880,7 @@ tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
 	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
-	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
+	iproto_wpos_create(&con->kharon.wpos, con);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
 	cpipe_push(&con->iproto_thread->net_pipe,
@@ -3633,6 +4991,14 @@ iproto_thread_init_routes(struct iproto_thread *iproto_thread)
 		{ tx_process_rollback, &iproto_thread->net_pipe };
 	iproto_thread->rollback_route[1] =
 		{ net_send_msg, NULL };
+	iproto_thread->batch_route[0] =
+		{ tx_process_batch, &iproto_thread->net_pipe };
+	iproto_thread->batch_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->cursor_route[0] =
+		{ tx_process_cursor, &iproto_thread->net_pipe };
+	iproto_thread->cursor_route[1] =
+		{ net_send_msg, NULL };
 	iproto_thread->rollback_on_disconnect_route[0] =
 		{ tx_process_rollback_on_disconnect,
 		  &iproto_thread->net_pipe };
@@ -3880,9 +5246,10 @@ TRIGGER(trigger_on_change, trigger_on_change_iproto_notify);
 
 /** Initialize the iproto subsystem and start network io thread */
 void
-iproto_init(int threads_count)
+iproto_init(int threads_count, bool listen_reuseport)
 {
 	iproto_threads_count = 0;
+	iproto_listen_reuseport = listen_reuseport;
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -3896,6 +5263,8 @@ iproto_init(int threads_count)
 	iproto_threads = xalloc_array(struct iproto_thread, threads_count);
 	memset(iproto_threads, 0, sizeof(struct iproto_thread) * threads_count);
 	fiber_cond_create(&drop_finished_cond);
+	mempool_create(&iproto_tuple_ref_pool, &cord()->slabc,
+		       sizeof(struct iproto_tuple_ref));
 
 	for (int i = 0; i < threads_count; i++, iproto_threads_count++) {
 		struct iproto_thread *iproto_thread = &iproto_threads[i];
@@ -3949,6 +5318,25 @@ iproto_fill_stat(struct iproto_thread *iproto_thread,
 		iproto_thread->requests_in_stream_queue;
 }
 
+/**
+ * Start accepting connections on the listen sockets of the tx thread
+ * or on own sockets bound with SO_REUSEPORT to the same addresses.
+ */
+static void
+iproto_thread_attach(struct iproto_thread *iproto_thread)
+{
+	struct evio_service *binary = &iproto_thread->binary;
+	if (iproto_thread->id > 0 && tx_binary.reuseport) {
+		if (evio_service_attach_reuseport(binary, &tx_binary) == 0)
+			return;
+		diag_log();
+		say_warn("iproto thread %d failed to bind its own listen "
+			 "socket, sharing the common one", iproto_thread->id);
+		evio_service_detach(binary);
+	}
+	evio_service_attach(binary, &tx_binary);
+}
+
 static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
@@ -3969,7 +5357,7 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 	case IPROTO_CFG_START:
 		if (iproto_thread->is_shutting_down)
 			break;
-		evio_service_attach(binary, &tx_binary);
+		iproto_thread_attach(iproto_thread);
 		break;
 	case IPROTO_CFG_SHUTDOWN:
 		iproto_thread->is_shutting_down = true;
@@ -3979,7 +5367,7 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 		break;
 	case IPROTO_CFG_RESTART:
 		evio_service_detach(binary);
-		evio_service_attach(binary, &tx_binary);
+		iproto_thread_attach(iproto_thread);
 		break;
 	case IPROTO_CFG_STAT:
 		iproto_fill_stat(iproto_thread, cfg_msg);
@@ -4188,8 +5576,12 @@ iproto_listen(const struct uri_set *uri_set)
 	 * Please note, we bind sockets in main thread, and then
 	 * listen these sockets in all iproto threads! With this
 	 * implementation, we rely on the Linux kernel to distribute
-	 * incoming connections across iproto threads.
+	 * incoming connections across iproto threads. With
+	 * iproto_listen_reuseport, the threads bind their own sockets
+	 * to the same addresses, see iproto_thread_attach().
 	 */
+	tx_binary.reuseport = iproto_listen_reuseport &&
+			      iproto_threads_count > 1;
 	if (evio_service_start(&tx_binary, uri_set) != 0)
 		return -1;
 	iproto_send_start_msg();
@@ -4262,6 +5654,16 @@ iproto_set_msg_max(int new_iproto_msg_max)
 	return 0;
 }
 
+void
+iproto_set_sched_batch_users(char **names, int count)
+{
+	for (int i = 0; i < iproto_sched_batch_user_count; i++)
+		free(iproto_sched_batch_users[i]);
+	free(iproto_sched_batch_users);
+	iproto_sched_batch_users = names;
+	iproto_sched_batch_user_count = count;
+}
+
 int
 iproto_session_new(struct iostream *io, struct user *user, uint64_t *sid)
 {
@@ -4371,6 +5773,7 @@ iproto_free(void)
 	}
 	mh_i32ptr_delete(tx_req_handlers);
 	fiber_cond_destroy(&drop_finished_cond);
+	iproto_set_sched_batch_users(NULL, 0);
 
 	/*
 	 * Here we close sockets and unlink all unix socket paths.
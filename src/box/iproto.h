@@ -64,6 +64,28 @@ enum {
 	IPROTO_THREADS_MAX = 1000,
 };
 
+/**
+ * Scheduling classes of requests sent to the tx thread. Requests of
+ * different classes are queued separately by the tx fiber pool, and
+ * the classes are served in proportion to their weights, so a burst
+ * of heavy requests doesn't delay cheap ones.
+ */
+enum iproto_sched_class {
+	/**
+	 * Messages not bound to a request (connect, disconnect, etc),
+	 * replication requests, and messages of other threads.
+	 */
+	IPROTO_SCHED_SYSTEM,
+	/** Reads, writes, transaction control, and other cheap requests. */
+	IPROTO_SCHED_INTERACTIVE,
+	/** Requests running user code or many requests: CALL, EVAL, etc. */
+	IPROTO_SCHED_BATCH,
+	iproto_sched_class_MAX,
+};
+
+/** Names of the request scheduling classes. */
+extern const char *iproto_sched_class_strs[];
+
 struct iproto_stats {
 	/** Size of memory used for storing network buffers. */
 	size_t mem_used;
@@ -80,7 +102,13 @@ struct iproto_stats {
 };
 
 extern unsigned iproto_readahead;
+extern uint64_t iproto_tuple_ref_min_size;
+extern uint64_t iproto_compression_min_size;
+extern uint64_t iproto_cursor_max;
+extern double iproto_admission_target;
+extern double iproto_admission_interval;
 extern int iproto_threads_count;
+extern bool iproto_sched_classes;
 
 /**
  * An mp_ctx for `box.iproto.key` constants encoding and aliasing: used
@@ -143,8 +171,13 @@ int
 iproto_override(uint32_t req_type, iproto_handler_t cb,
 		iproto_handler_destroy_t destroy, void *ctx);
 
+/**
+ * Initialize the iproto subsystem and start @a threads_count network
+ * threads. If @a listen_reuseport is set, every thread listens on its
+ * own socket bound with SO_REUSEPORT.
+ */
 void
-iproto_init(int threads_count);
+iproto_init(int threads_count, bool listen_reuseport);
 
 int
 iproto_listen(const struct uri_set *uri_set);
@@ -152,6 +185,15 @@ iproto_listen(const struct uri_set *uri_set);
 int
 iproto_set_msg_max(int iproto_msg_max);
 
+/**
+ * Sets the names of the users whose requests are put to the batch
+ * scheduling class. Takes ownership of the array and the strings,
+ * which must be allocated with malloc(). Applies to connections
+ * established and users authenticated after the call.
+ */
+void
+iproto_set_sched_batch_users(char **names, int count);
+
 /**
  * Creates a new IPROTO session over the given IO stream. Doesn't yield.
  * Set the output parameter sid to the sid of newly created session.
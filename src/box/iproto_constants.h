@@ -93,6 +93,18 @@ extern const char *iproto_flag_bit_strs[];
 	_(TSN, 0x08, MP_UINT)						\
 	_(FLAGS, 0x09, MP_UINT)						\
 	_(STREAM_ID, 0x0a, MP_UINT)					\
+	/**
+	 * Compression algorithm of the packet body, see
+	 * enum iproto_compression. The compressed body is
+	 * encoded as MP_BIN.
+	 */								\
+	_(COMPRESSION, 0x0b, MP_UINT)					\
+	/**
+	 * Scheduling class of the request in the transaction
+	 * processor thread: 1 - interactive, 2 - batch. Other
+	 * values are ignored, see enum iproto_sched_class.
+	 */								\
+	_(SCHED_CLASS, 0x0c, MP_UINT)					\
 	/* Leave a gap for other keys in the header. */			\
 	_(SPACE_ID, 0x10, MP_UINT)					\
 	_(INDEX_ID, 0x11, MP_UINT)					\
@@ -238,6 +250,28 @@ extern const char *iproto_flag_bit_strs[];
 	  * true and CHECKPOINT_VCLOCK to be set.
 	  */								\
 	 _(CHECKPOINT_LSN, 0x64, MP_UINT)				\
+	/**
+	 * Array of the requests of IPROTO_BATCH. Every request is a map
+	 * of its body keys and IPROTO_REQUEST_TYPE.
+	 */								\
+	_(REQUESTS, 0x65, MP_ARRAY)					\
+	/**
+	 * Flag indicating whether the requests of IPROTO_BATCH are
+	 * executed in one transaction.
+	 */								\
+	_(IS_ATOMIC, 0x66, MP_BOOL)					\
+	/** ID of a server-side cursor. */				\
+	_(CURSOR_ID, 0x67, MP_UINT)					\
+	/**
+	 * Array of 0-based numbers of the tuple fields to return
+	 * from IPROTO_SELECT.
+	 */								\
+	_(FIELDS, 0x68, MP_ARRAY)					\
+	/**
+	 * Number of the requests of a non-atomic IPROTO_BATCH applied
+	 * before the failed one. Sent in the error response body.
+	 */								\
+	_(APPLIED_COUNT, 0x69, MP_UINT)					\
 
 #define IPROTO_KEY_MEMBER(s, v, ...) IPROTO_ ## s = v,
 
@@ -257,6 +291,12 @@ static_assert(iproto_key_MAX <= 0x80, "iproto_key_MAX must be <= 0x80");
 /** IPROTO key name by code. */
 extern const char *iproto_key_strs[];
 
+/** Compression algorithms of IPROTO packet bodies. */
+enum iproto_compression {
+	IPROTO_COMPRESSION_NONE = 0,
+	IPROTO_COMPRESSION_ZSTD = 1,
+};
+
 /** MsgPack value type by IPROTO key. */
 extern const unsigned char iproto_key_type[];
 
@@ -352,6 +392,17 @@ iproto_key_bit(unsigned char key)
 	_(ROLLBACK, 16)							\
 	/** INSERT Arrow request. */					\
 	_(INSERT_ARROW, 17)						\
+	/** Execute a batch of DML and SELECT requests. */		\
+	_(BATCH, 18)							\
+	/**
+	 * Server-side cursors. IPROTO_CURSOR_OPEN takes the body of
+	 * IPROTO_SELECT without limit and replies with the cursor ID,
+	 * IPROTO_CURSOR_FETCH replies with up to IPROTO_LIMIT next tuples
+	 * of the cursor, IPROTO_CURSOR_CLOSE closes the cursor.
+	 */								\
+	_(CURSOR_OPEN, 19)						\
+	_(CURSOR_FETCH, 20)						\
+	_(CURSOR_CLOSE, 21)						\
 									\
 	_(RAFT, 30)							\
 	/** PROMOTE request. */						\
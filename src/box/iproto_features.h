@@ -120,6 +120,34 @@ extern "C" {
 	 * Available since IPROTO protocol version 10.
 	 */								\
 	_(INSERT_ARROW, 12)						\
+	/**
+	 * Compression of request and response bodies:
+	 * IPROTO_COMPRESSION header key.
+	 *
+	 * Available since IPROTO protocol version 11.
+	 */								\
+	_(COMPRESSION, 13)						\
+	/**
+	 * Server-side cursors: IPROTO_CURSOR_OPEN, IPROTO_CURSOR_FETCH,
+	 * IPROTO_CURSOR_CLOSE commands.
+	 *
+	 * Available since IPROTO protocol version 12.
+	 */								\
+	_(CURSORS, 14)							\
+	/**
+	 * Projection of selected tuples: IPROTO_FIELDS request body key
+	 * of IPROTO_SELECT.
+	 *
+	 * Available since IPROTO protocol version 13.
+	 */								\
+	_(SELECT_FIELDS, 15)						\
+	/**
+	 * Batches of requests: IPROTO_BATCH command and IPROTO_APPLIED_COUNT
+	 * error response body key.
+	 *
+	 * Available since IPROTO protocol version 14.
+	 */								\
+	_(BATCH, 16)							\
 
 #define IPROTO_FEATURE_MEMBER(s, v) IPROTO_FEATURE_ ## s = v,
 
@@ -144,7 +172,7 @@ struct iproto_features {
  * `box.iproto.protocol_version` needs to be updated correspondingly.
  */
 enum {
-	IPROTO_CURRENT_VERSION = 10,
+	IPROTO_CURRENT_VERSION = 14,
 };
 
 /**
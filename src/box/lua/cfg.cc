@@ -111,6 +111,116 @@ lbox_cfg_set_readahead(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_iproto_admission_target(struct lua_State *L)
+{
+	try {
+		box_set_iproto_admission_target();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_admission_interval(struct lua_State *L)
+{
+	try {
+		box_set_iproto_admission_interval();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_cursor_max(struct lua_State *L)
+{
+	try {
+		box_set_iproto_cursor_max();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_compression_min_size(struct lua_State *L)
+{
+	try {
+		box_set_iproto_compression_min_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_tuple_ref_min_size(struct lua_State *L)
+{
+	try {
+		box_set_iproto_tuple_ref_min_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_sched_classes(struct lua_State *L)
+{
+	try {
+		box_set_iproto_sched_classes();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_sched_weight_system(struct lua_State *L)
+{
+	try {
+		box_set_iproto_sched_weight_system();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_sched_weight_interactive(struct lua_State *L)
+{
+	try {
+		box_set_iproto_sched_weight_interactive();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_sched_weight_batch(struct lua_State *L)
+{
+	try {
+		box_set_iproto_sched_weight_batch();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_iproto_sched_batch_users(struct lua_State *L)
+{
+	try {
+		box_set_iproto_sched_batch_users();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_io_collect_interval(struct lua_State *L)
 {
@@ -305,6 +415,14 @@ lbox_set_prepared_stmt_cache_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_sql_plan_cache_size(struct lua_State *L)
+{
+	if (box_set_sql_plan_cache_size() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
@@ -534,6 +652,16 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication", lbox_cfg_set_replication},
 		{"cfg_set_worker_pool_threads", lbox_cfg_set_worker_pool_threads},
 		{"cfg_set_readahead", lbox_cfg_set_readahead},
+		{"cfg_set_iproto_admission_target", lbox_cfg_set_iproto_admission_target},
+		{"cfg_set_iproto_admission_interval", lbox_cfg_set_iproto_admission_interval},
+		{"cfg_set_iproto_cursor_max", lbox_cfg_set_iproto_cursor_max},
+		{"cfg_set_iproto_compression_min_size", lbox_cfg_set_iproto_compression_min_size},
+		{"cfg_set_iproto_tuple_ref_min_size", lbox_cfg_set_iproto_tuple_ref_min_size},
+		{"cfg_set_iproto_sched_classes", lbox_cfg_set_iproto_sched_classes},
+		{"cfg_set_iproto_sched_weight_system", lbox_cfg_set_iproto_sched_weight_system},
+		{"cfg_set_iproto_sched_weight_interactive", lbox_cfg_set_iproto_sched_weight_interactive},
+		{"cfg_set_iproto_sched_weight_batch", lbox_cfg_set_iproto_sched_weight_batch},
+		{"cfg_set_iproto_sched_batch_users", lbox_cfg_set_iproto_sched_batch_users},
 		{"cfg_set_io_collect_interval", lbox_cfg_set_io_collect_interval},
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
 		{"cfg_set_snap_io_rate_limit", lbox_cfg_set_snap_io_rate_limit},
@@ -570,6 +698,7 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_cluster_name", lbox_cfg_set_cluster_name},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
+		{"cfg_set_sql_plan_cache_size", lbox_cfg_set_sql_plan_cache_size},
 		{"cfg_set_feedback", lbox_cfg_set_feedback},
 		{"cfg_set_txn_timeout", lbox_cfg_set_txn_timeout},
 		{"cfg_set_txn_isolation", lbox_cfg_set_txn_isolation},
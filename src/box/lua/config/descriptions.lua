@@ -1187,6 +1187,23 @@ I['iproto'] = format_text([[
     to and between cluster instances.
 ]])
 
+I['iproto.admission_interval'] = format_text([[
+    The interval in seconds over which the minimal delay of requests in
+    the queue to the transaction processor thread is measured for admission
+    control, see `iproto.admission_target`.
+]])
+
+I['iproto.admission_target'] = format_text([[
+    The target delay in seconds of requests in the queue to the transaction
+    processor thread. If even the requests that waited the least over
+    `iproto.admission_interval` waited longer than the target, the thread is
+    considered overloaded and requests that waited too long are rejected
+    with the retryable `OVERLOADED` error. Data changes are rejected after
+    twice the target delay, reads and calls after the target delay, while
+    transaction control, authentication, ping and replication requests are
+    never rejected. 0 disables admission control.
+]])
+
 -- {{{ iproto.advertise configuration
 
 I['iproto.advertise'] = format_text([[
@@ -1291,6 +1308,20 @@ I['iproto.advertise.sharding.uri'] = format_text([[
 
 -- }}} iproto.advertise configuration
 
+I['iproto.compression_min_size'] = format_text([[
+    The minimal size of a reply in bytes that is compressed before being
+    sent to a client that negotiated the `COMPRESSION` IPROTO feature.
+    Replies are compressed by the network threads. 0 disables compression
+    of replies, while compressed requests are still accepted.
+]])
+
+I['iproto.cursor_max'] = format_text([[
+    The maximal number of server-side cursors opened by one connection at
+    the same time. An attempt to open one more cursor fails. Cursors keep
+    read views of the data open, so the limit bounds the memory that a
+    single client can pin. 0 means no limit.
+]])
+
 I['iproto.listen'] = format_text([[
     An array of URIs used to listen for incoming requests. If required,
     you can enable SSL for specific URIs by providing additional parameters
@@ -1339,6 +1370,14 @@ I['iproto.listen.*.uri'] = format_text([[
     in the URI string. Use the `iproto.listen.*.params` for them.
 ]])
 
+I['iproto.listen_reuseport'] = format_text([[
+    If set, every network thread listens on its own socket bound with
+    `SO_REUSEPORT` to each TCP address from `iproto.listen`, so that the
+    kernel distributes incoming connections between the threads evenly.
+    Otherwise, all the threads listen on one socket. The setting has no
+    effect if `iproto.threads` is 1.
+]])
+
 I['iproto.net_msg_max'] = format_text([[
     To handle messages, Tarantool allocates fibers. To prevent fiber overhead
     from affecting the whole system, Tarantool restricts how many messages the
@@ -1372,6 +1411,40 @@ I['iproto.readahead'] = format_text([[
     leave this setting at its default.
 ]])
 
+I['iproto.sched_batch_users'] = format_text([[
+    Names of the users whose requests are always put to the `batch`
+    scheduling class, see `iproto.sched_classes`. The option applies to
+    connections established and users authenticated after it is changed.
+]])
+
+I['iproto.sched_batch_users.*'] = 'User name.'
+
+I['iproto.sched_classes'] = format_text([[
+    Whether to split requests into scheduling classes in the transaction
+    processor thread. Replication requests go to the `system` class. Other
+    requests go to the `interactive` or `batch` class as requested in their
+    `IPROTO_SCHED_CLASS` header, or by their type: calls, evaluations and SQL
+    requests are `batch`, the rest are `interactive`. Requests of different
+    classes are executed in proportion to the class weights, see
+    `iproto.sched_weight_*`. Requests of one connection are always executed
+    in the order they were sent.
+]])
+
+I['iproto.sched_weight_batch'] = format_text([[
+    The weight of the `batch` request scheduling class, see
+    `iproto.sched_classes`.
+]])
+
+I['iproto.sched_weight_interactive'] = format_text([[
+    The weight of the `interactive` request scheduling class, see
+    `iproto.sched_classes`.
+]])
+
+I['iproto.sched_weight_system'] = format_text([[
+    The weight of the `system` request scheduling class, see
+    `iproto.sched_classes`.
+]])
+
 I['iproto.threads'] = format_text([[
     The number of network threads. There can be unusual workloads where the
     network thread is 100% loaded and the transaction processor thread is not,
@@ -1380,6 +1453,14 @@ I['iproto.threads'] = format_text([[
     to which thread.
 ]])
 
+I['iproto.tuple_ref_min_size'] = format_text([[
+    The minimal size of a tuple in bytes that is sent in `IPROTO_SELECT`
+    replies right from the tuple memory instead of being copied to the
+    connection output buffer. Referencing big tuples saves memory bandwidth
+    of the transaction processor thread, but keeps the tuples in memory
+    until the reply is sent. 0 disables referencing of tuples.
+]])
+
 -- }}} iproto configuration
 
 -- {{{ isolated configuration
@@ -1558,6 +1639,13 @@ I['memtx.allocator'] = format_text([[
       switch to `system` in such cases.
 ]])
 
+I['memtx.huge_pages'] = format_text([[
+    Back the memory preallocated for memtx tuples and indexes with
+    transparent huge pages. This reduces TLB misses on random index
+    lookups over large datasets. The setting has no effect if transparent
+    huge pages are disabled in the system.
+]])
+
 I['memtx.max_tuple_size'] = format_text([[
     Size of the largest allocation unit for the memtx storage engine in bytes.
     It can be increased if it is necessary to store large tuples.
@@ -1576,6 +1664,12 @@ I['memtx.min_tuple_size'] = format_text([[
     most of the tuples are very small.
 ]])
 
+I['memtx.numa_node'] = format_text([[
+    The NUMA node to allocate the memory preallocated for memtx tuples and
+    indexes from. If the node runs out of memory, other nodes are used.
+    By default, the system memory policy is used.
+]])
+
 I['memtx.slab_alloc_factor'] = format_text([[
     The multiplier for computing the sizes of memory chunks that tuples
     are stored in. A lower value may result in less wasted memory depending
@@ -2346,6 +2440,13 @@ I['sql.cache_size'] = format_text([[
     To see the actual cache size, use `box.info.sql().cache.size`.
 ]])
 
+I['sql.plan_cache_size'] = format_text([[
+    The maximum size (in bytes) of the cache of compiled SQL statements that
+    are executed without explicit preparation. The least recently used
+    statements are evicted when the limit is reached. 0 disables the cache.
+    To see the cache statistics, use `box.info.sql().plan_cache`.
+]])
+
 -- }}} sql configuration
 
 -- {{{ vinyl configuration
@@ -871,6 +871,12 @@ return schema.new('instance_config', schema.record({
             box_cfg_nondynamic = true,
             default = 1,
         }),
+        listen_reuseport = schema.scalar({
+            type = 'boolean',
+            box_cfg = 'iproto_listen_reuseport',
+            box_cfg_nondynamic = true,
+            default = false,
+        }),
         net_msg_max = schema.scalar({
             type = 'integer',
             box_cfg = 'net_msg_max',
@@ -881,6 +887,58 @@ return schema.new('instance_config', schema.record({
             box_cfg = 'readahead',
             default = 16320,
         }),
+        admission_target = schema.scalar({
+            type = 'number',
+            box_cfg = 'iproto_admission_target',
+            default = 0.05,
+        }),
+        admission_interval = schema.scalar({
+            type = 'number',
+            box_cfg = 'iproto_admission_interval',
+            default = 1,
+        }),
+        cursor_max = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_cursor_max',
+            default = 64,
+        }),
+        compression_min_size = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_compression_min_size',
+            default = 1024,
+        }),
+        tuple_ref_min_size = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_tuple_ref_min_size',
+            default = 4096,
+        }),
+        sched_classes = schema.scalar({
+            type = 'boolean',
+            box_cfg = 'iproto_sched_classes',
+            default = false,
+        }),
+        sched_weight_system = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_sched_weight_system',
+            default = 8,
+        }),
+        sched_weight_interactive = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_sched_weight_interactive',
+            default = 4,
+        }),
+        sched_weight_batch = schema.scalar({
+            type = 'integer',
+            box_cfg = 'iproto_sched_weight_batch',
+            default = 1,
+        }),
+        sched_batch_users = schema.array({
+            items = schema.scalar({
+                type = 'string',
+            }),
+            box_cfg = 'iproto_sched_batch_users',
+            default = box.NULL,
+        }),
     }),
     database = schema.record({
         instance_uuid = schema.scalar({
@@ -943,6 +1001,11 @@ return schema.new('instance_config', schema.record({
             box_cfg = 'sql_cache_size',
             default = 5 * 1024 * 1024,
         }),
+        plan_cache_size = schema.scalar({
+            type = 'integer',
+            box_cfg = 'sql_plan_cache_size',
+            default = 5 * 1024 * 1024,
+        }),
     }),
     memtx = schema.record({
         memory = schema.scalar({
@@ -987,6 +1050,18 @@ return schema.new('instance_config', schema.record({
             box_cfg_nondynamic = true,
             default = box.NULL,
         }),
+        huge_pages = schema.scalar({
+            type = 'boolean',
+            box_cfg = 'memtx_huge_pages',
+            box_cfg_nondynamic = true,
+            default = false,
+        }),
+        numa_node = schema.scalar({
+            type = 'integer',
+            box_cfg = 'memtx_numa_node',
+            box_cfg_nondynamic = true,
+            default = box.NULL,
+        }),
     }),
     vinyl = schema.record({
         bloom_fpr = schema.scalar({
@@ -34,6 +34,7 @@
 #include "info/info.h"
 #include "box/box.h"
 #include "box/index.h"
+#include "box/port.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h"
 #include "small/region.h"
@@ -214,6 +215,46 @@ lbox_index_get(lua_State *L)
 	return rc == 0 ? luaT_pushtupleornil(L, tuple) : luaT_error(L);
 }
 
+static int
+lbox_index_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    lua_type(L, 3) != LUA_TTABLE) {
+		diag_set(IllegalParams,
+			 "Usage: index.get_many(space_id, index_id, keys)");
+		return luaT_error(L);
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t keys_len;
+	size_t region_svp = region_used(&fiber()->gc);
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+	if (keys == NULL)
+		return luaT_error(L);
+	const char *data = keys;
+	uint32_t key_count = mp_decode_array(&data);
+	struct tuple **results = xregion_alloc_array(&fiber()->gc,
+						     struct tuple *,
+						     key_count);
+	if (box_index_get_many(space_id, index_id, keys, keys + keys_len,
+			       results) != 0) {
+		region_truncate(&fiber()->gc, region_svp);
+		return luaT_error(L);
+	}
+	lua_createtable(L, key_count, 0);
+	int count = 0;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (results[i] == NULL)
+			continue;
+		luaT_pushtuple(L, results[i]);
+		lua_rawseti(L, -2, ++count);
+		tuple_unref(results[i]);
+	}
+	region_truncate(&fiber()->gc, region_svp);
+	return 1;
+}
+
 static int
 lbox_index_min(lua_State *L)
 {
@@ -467,6 +508,7 @@ box_lua_index_init(struct lua_State *L)
 		{"delete",  lbox_index_delete},
 		{"random", lbox_index_random},
 		{"get",  lbox_index_get},
+		{"get_many", lbox_index_get_many},
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
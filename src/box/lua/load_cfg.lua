@@ -93,7 +93,10 @@ local default_cfg = {
     slab_alloc_granularity = 8,
     slab_alloc_factor   = 1.05,
     iproto_threads      = 1,
+    iproto_listen_reuseport = false,
     memtx_allocator     = "small",
+    memtx_huge_pages    = false,
+    memtx_numa_node     = nil,
     work_dir            = nil,
     memtx_dir           = ".",
     wal_dir             = ".",
@@ -204,7 +207,18 @@ local default_cfg = {
     feedback_metrics_collect_interval = ifdef_feedback(60),
     feedback_metrics_limit = ifdef_feedback(1024 * 1024),
     net_msg_max           = 768,
+    iproto_admission_target = 0.05,
+    iproto_admission_interval = 1,
+    iproto_cursor_max = 64,
+    iproto_compression_min_size = 1024,
+    iproto_tuple_ref_min_size = 4096,
+    iproto_sched_classes = false,
+    iproto_sched_weight_system = 8,
+    iproto_sched_weight_interactive = 4,
+    iproto_sched_weight_batch = 1,
+    iproto_sched_batch_users = nil,
     sql_cache_size        = 5 * 1024 * 1024,
+    sql_plan_cache_size   = 5 * 1024 * 1024,
     txn_timeout           = 365 * 100 * 86400,
     txn_isolation         = "best-effort",
     memtx_sort_threads    = nil,
@@ -297,7 +311,10 @@ local template_cfg = {
     slab_alloc_granularity = 'number',
     slab_alloc_factor   = 'number',
     iproto_threads      = 'number',
+    iproto_listen_reuseport = 'boolean',
     memtx_allocator     = 'string',
+    memtx_huge_pages    = 'boolean',
+    memtx_numa_node     = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
     wal_dir             = 'string',
@@ -408,7 +425,18 @@ local template_cfg = {
     feedback_metrics_collect_interval = ifdef_feedback('number'),
     feedback_metrics_limit = ifdef_feedback('number'),
     net_msg_max           = 'number',
+    iproto_admission_target = 'number',
+    iproto_admission_interval = 'number',
+    iproto_cursor_max = 'number',
+    iproto_compression_min_size = 'number',
+    iproto_tuple_ref_min_size = 'number',
+    iproto_sched_classes = 'boolean',
+    iproto_sched_weight_system = 'number',
+    iproto_sched_weight_interactive = 'number',
+    iproto_sched_weight_batch = 'number',
+    iproto_sched_batch_users = 'string, table',
     sql_cache_size        = 'number',
+    sql_plan_cache_size   = 'number',
     txn_timeout           = 'number',
     memtx_sort_threads    = 'number',
 
@@ -548,7 +576,18 @@ local dynamic_cfg = {
     replicaset_name         = private.cfg_set_replicaset_name,
     cluster_name            = private.cfg_set_cluster_name,
     net_msg_max             = private.cfg_set_net_msg_max,
+    iproto_admission_target = private.cfg_set_iproto_admission_target,
+    iproto_admission_interval = private.cfg_set_iproto_admission_interval,
+    iproto_cursor_max = private.cfg_set_iproto_cursor_max,
+    iproto_compression_min_size = private.cfg_set_iproto_compression_min_size,
+    iproto_tuple_ref_min_size = private.cfg_set_iproto_tuple_ref_min_size,
+    iproto_sched_classes = private.cfg_set_iproto_sched_classes,
+    iproto_sched_weight_system = private.cfg_set_iproto_sched_weight_system,
+    iproto_sched_weight_interactive = private.cfg_set_iproto_sched_weight_interactive,
+    iproto_sched_weight_batch = private.cfg_set_iproto_sched_weight_batch,
+    iproto_sched_batch_users = private.cfg_set_iproto_sched_batch_users,
     sql_cache_size          = private.cfg_set_sql_cache_size,
+    sql_plan_cache_size     = private.cfg_set_sql_plan_cache_size,
     txn_timeout             = private.cfg_set_txn_timeout,
     txn_isolation           = private.cfg_set_txn_isolation,
     auth_type               = private.cfg_set_auth_type,
@@ -722,6 +761,17 @@ local dynamic_cfg_skip_at_load = {
     cluster_name            = true,
     net_msg_max             = true,
     readahead               = true,
+    sql_plan_cache_size     = true,
+    iproto_sched_batch_users = true,
+    iproto_sched_weight_batch = true,
+    iproto_sched_weight_interactive = true,
+    iproto_sched_weight_system = true,
+    iproto_sched_classes = true,
+    iproto_tuple_ref_min_size = true,
+    iproto_compression_min_size = true,
+    iproto_cursor_max = true,
+    iproto_admission_interval = true,
+    iproto_admission_target = true,
     auth_type               = true,
     auth_delay              = ifdef_security(true),
     auth_retries            = ifdef_security(true),
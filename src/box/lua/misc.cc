@@ -413,14 +413,44 @@ lbox_prepare_auth(lua_State *L)
 
 /** {{{ Lua/C implementation of index:select(): used only by Vinyl **/
 
+/**
+ * Pushes a table of selected tuples projected to the given fields onto
+ * the Lua stack. Each tuple is converted to a Lua table that contains
+ * only the given fields, in the given order, absent fields are pushed
+ * as nils. Fields are decoded right from the tuple data so that no
+ * intermediate tuples are created.
+ */
+static void
+lbox_select_push_fields(struct lua_State *L, struct port *port,
+			const uint32_t *fields, uint32_t field_count)
+{
+	struct port_c *port_c = (struct port_c *)port;
+	lua_createtable(L, port_c->size, 0);
+	int i = 0;
+	for (struct port_c_entry *pe = port_c->first; pe != NULL;
+	     pe = pe->next) {
+		assert(pe->type == PORT_C_ENTRY_TUPLE);
+		lua_createtable(L, field_count, 0);
+		for (uint32_t j = 0; j < field_count; j++) {
+			const char *field = tuple_field(pe->tuple, fields[j]);
+			if (field != NULL)
+				luamp_decode(L, luaL_msgpack_default, &field);
+			else
+				luaL_pushnull(L);
+			lua_rawseti(L, -2, j + 1);
+		}
+		lua_rawseti(L, -2, ++i);
+	}
+}
+
 static int
 lbox_select(lua_State *L)
 {
-	if (lua_gettop(L) != 8 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	if (lua_gettop(L) != 9 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
 	    !lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5) ||
-	    !lua_isboolean(L, 8)) {
+	    !lua_isboolean(L, 8) || (!lua_isnil(L, 9) && !lua_istable(L, 9))) {
 		return luaL_error(L, "Usage index:select(iterator, offset, "
-				  "limit, key, after, fetch_pos)");
+				  "limit, key, after, fetch_pos, fields)");
 	}
 
 	uint32_t svp = region_used(&fiber()->gc);
@@ -442,6 +472,21 @@ lbox_select(lua_State *L)
 	if (lbox_index_normalize_position(L, 7, space_id, index_id,
 					  &packed_pos, &packed_pos_end) != 0)
 		goto fail;
+	/* Field numbers are checked and converted to 0-based in Lua. */
+	uint32_t *fields;
+	uint32_t field_count;
+	fields = NULL;
+	field_count = 0;
+	if (lua_istable(L, 9)) {
+		field_count = lua_objlen(L, 9);
+		fields = xregion_alloc_array(&fiber()->gc, uint32_t,
+					     field_count);
+		for (uint32_t i = 0; i < field_count; i++) {
+			lua_rawgeti(L, 9, i + 1);
+			fields[i] = lua_tointeger(L, -1);
+			lua_pop(L, 1);
+		}
+	}
 
 	if (box_select(space_id, index_id, iterator, offset, limit, key,
 		       key + key_len, &packed_pos, &packed_pos_end, fetch_pos,
@@ -456,7 +501,10 @@ lbox_select(lua_State *L)
 	 * table always crashed the first (can't be fixed with pcall).
 	 * https://github.com/tarantool/tarantool/issues/1182
 	 */
-	port_dump_lua(&port, L, PORT_DUMP_LUA_MODE_TABLE);
+	if (fields != NULL)
+		lbox_select_push_fields(L, &port, fields, field_count);
+	else
+		port_dump_lua(&port, L, PORT_DUMP_LUA_MODE_TABLE);
 	port_destroy(&port);
 	if (fetch_pos && packed_pos != NULL) {
 		lua_pushlstring(L, packed_pos, packed_pos_end - packed_pos);
@@ -82,7 +82,11 @@ enum {
 	/**
 	 * IPROTO protocol version supported by the netbox connector.
 	 */
-	NETBOX_IPROTO_VERSION = 10,
+	NETBOX_IPROTO_VERSION = 13,
+	/**
+	 * Minimal size of a request to compress, in bytes.
+	 */
+	NETBOX_COMPRESSION_MIN_SIZE = 1024,
 };
 
 /**
@@ -113,6 +117,10 @@ static struct iproto_features NETBOX_IPROTO_FEATURES;
 	_(ROLLBACK)							\
 	_(WATCH_ONCE)							\
 	_(INJECT)							\
+	_(CURSOR_OPEN)							\
+	_(CURSOR_FETCH)							\
+	_(CURSOR_CLOSE)							\
+	_(BATCH)							\
 
 #define NETBOX_METHOD_MEMBER(s) \
 	NETBOX_ ## s,
@@ -178,6 +186,11 @@ struct netbox_options {
 	 * Flag that determines is it required to fetch server schema or not.
 	 */
 	 bool fetch_schema;
+	/**
+	 * Flag that determines whether big requests and responses should
+	 * be compressed if the server supports it.
+	 */
+	bool compression;
 };
 
 /**
@@ -288,6 +301,25 @@ struct netbox_transport {
 	 * by the user.
 	 */
 	int64_t inprogress_request_count;
+	/**
+	 * Buffer for the decompressed body of the last received message
+	 * or NULL if no compressed messages have been received yet.
+	 */
+	char *body_buf;
+};
+
+/**
+ * A group of asynchronous requests that are waited for together.
+ *
+ * Requests of a pipeline are completed by the worker fiber as usual,
+ * but a fiber waiting for the pipeline is woken up only once, when
+ * the last of them is completed, rather than on each response.
+ */
+struct netbox_pipeline {
+	/** Number of requests of the pipeline that haven't completed yet. */
+	int64_t pending_count;
+	/** Signaled when the last pending request is completed. */
+	struct fiber_cond cond;
 };
 
 struct netbox_request {
@@ -358,6 +390,16 @@ struct netbox_request {
 	 * collection in case the user discards the connection.
 	 */
 	int remote_ref;
+	/**
+	 * The pipeline this request was added to or NULL. The pipeline
+	 * is detached from the request when the request is completed.
+	 */
+	struct netbox_pipeline *pipeline;
+	/**
+	 * Lua reference to the pipeline object. Used to prevent garbage
+	 * collection while the request is in progress.
+	 */
+	int pipeline_ref;
 };
 
 /*
@@ -379,6 +421,7 @@ struct netbox_method_encode_ctx {
 
 static const char netbox_transport_typename[] = "net.box.transport";
 static const char netbox_request_typename[] = "net.box.request";
+static const char netbox_pipeline_typename[] = "net.box.pipeline";
 
 /**
  * We keep a reference to each C function that is frequently called with
@@ -386,10 +429,29 @@ static const char netbox_request_typename[] = "net.box.request";
  */
 static int luaT_netbox_request_iterator_next_ref = LUA_NOREF;
 
+/**
+ * Detaches a request from its pipeline, if any, and wakes up the pipeline
+ * waiters if it was the last pending request of the pipeline.
+ */
+static void
+netbox_request_leave_pipeline(struct netbox_request *request)
+{
+	struct netbox_pipeline *pipeline = request->pipeline;
+	if (pipeline == NULL)
+		return;
+	request->pipeline = NULL;
+	assert(pipeline->pending_count > 0);
+	if (--pipeline->pending_count == 0)
+		fiber_cond_broadcast(&pipeline->cond);
+	luaL_unref(tarantool_L, LUA_REGISTRYINDEX, request->pipeline_ref);
+	request->pipeline_ref = LUA_NOREF;
+}
+
 static void
 netbox_request_destroy(struct netbox_request *request)
 {
 	assert(request->transport == NULL);
+	assert(request->pipeline == NULL);
 	if (request->format != NULL)
 		tuple_format_unref(request->format);
 	fiber_cond_destroy(&request->cond);
@@ -435,6 +497,7 @@ netbox_request_unregister(struct netbox_request *request)
 	assert(k != mh_end(h));
 	assert(mh_i64ptr_node(h, k)->val == request);
 	mh_i64ptr_del(h, k, NULL);
+	netbox_request_leave_pipeline(request);
 }
 
 static inline bool
@@ -558,6 +621,7 @@ netbox_transport_create(struct netbox_transport *transport)
 	transport->next_sync = 1;
 	transport->requests = mh_i64ptr_new();
 	transport->inprogress_request_count = 0;
+	transport->body_buf = NULL;
 }
 
 static void
@@ -579,6 +643,7 @@ netbox_transport_destroy(struct netbox_transport *transport)
 	assert(mh_size(h) == 0);
 	mh_i64ptr_delete(h);
 	assert(transport->inprogress_request_count == 0);
+	free(transport->body_buf);
 }
 
 /**
@@ -622,6 +687,7 @@ netbox_transport_set_error(struct netbox_transport *transport)
 		request->transport = NULL;
 		netbox_request_set_error(request, error);
 		netbox_request_signal(request);
+		netbox_request_leave_pipeline(request);
 	}
 	mh_i64ptr_clear(h);
 	transport->inprogress_request_count = 0;
@@ -705,13 +771,15 @@ netbox_encode_ping(lua_State *L, int idx, struct netbox_method_encode_ctx *ctx)
  */
 static void
 netbox_encode_id(struct lua_State *L, struct ibuf *ibuf, uint64_t sync,
-		 bool fetch_schema)
+		 bool fetch_schema, bool compression)
 {
 	struct iproto_features features = NETBOX_IPROTO_FEATURES;
 	if (fetch_schema) {
 		iproto_features_clear(&features,
 				      IPROTO_FEATURE_DML_TUPLE_EXTENSION);
 	}
+	if (!compression)
+		iproto_features_clear(&features, IPROTO_FEATURE_COMPRESSION);
 #ifndef NDEBUG
 	struct errinj *errinj = errinj(ERRINJ_NETBOX_FLIP_FEATURE, ERRINJ_INT);
 	if (errinj->iparam >= 0 && errinj->iparam < iproto_feature_id_MAX) {
@@ -906,6 +974,27 @@ netbox_encode_index_id_or_name(lua_State *L, int idx, struct mpstream *stream)
 	}
 }
 
+/*
+ * Encode the position or the tuple to start iteration after which is
+ * stored in the Lua stack at the index idx.
+ */
+static int
+netbox_encode_after(lua_State *L, int idx, struct mpstream *stream)
+{
+	if (lua_isstring(L, idx)) {
+		mpstream_encode_uint(stream, IPROTO_AFTER_POSITION);
+		size_t size;
+		const char *pos = lua_tolstring(L, idx, &size);
+		mpstream_encode_strn(stream, pos, size);
+	} else {
+		assert(luaT_istuple(L, idx) != NULL || lua_istable(L, idx));
+		mpstream_encode_uint(stream, IPROTO_AFTER_TUPLE);
+		if (luamp_encode_tuple(L, cfg, stream, idx) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /* Encode select request. */
 static int
 netbox_encode_select(lua_State *L, int idx,
@@ -913,7 +1002,7 @@ netbox_encode_select(lua_State *L, int idx,
 {
 	/*
 	 * Lua stack at idx: space_id, index_id, iterator, offset, limit, key,
-	 * after, fetch_pos.
+	 * after, fetch_pos, fields (optional, 0-based field numbers).
 	 */
 	size_t svp = netbox_begin_encode(ctx->stream, ctx->sync, IPROTO_SELECT,
 					 ctx->stream_id);
@@ -925,6 +1014,9 @@ netbox_encode_select(lua_State *L, int idx,
 	bool fetch_pos = lua_toboolean(L, idx + 7);
 	if (fetch_pos)
 		map_size++;
+	bool have_fields = !lua_isnoneornil(L, idx + 8);
+	if (have_fields)
+		map_size++;
 	mpstream_encode_map(ctx->stream, map_size);
 	int iterator = lua_tointeger(L, idx + 2);
 	uint32_t offset = lua_tonumber(L, idx + 3);
@@ -952,21 +1044,8 @@ netbox_encode_select(lua_State *L, int idx,
 		return -1;
 
 	/* encode after */
-	if (have_after) {
-		if (lua_isstring(L, idx + 6)) {
-			mpstream_encode_uint(ctx->stream,
-					     IPROTO_AFTER_POSITION);
-			size_t size;
-			const char *pos = lua_tolstring(L, idx + 6, &size);
-			mpstream_encode_strn(ctx->stream, pos, size);
-		} else {
-			assert(luaT_istuple(L, idx + 6) != NULL ||
-			       lua_istable(L, idx + 6));
-			mpstream_encode_uint(ctx->stream, IPROTO_AFTER_TUPLE);
-			if (luamp_encode_tuple(L, cfg, ctx->stream, idx + 6) != 0)
-				return -1;
-		}
-	}
+	if (have_after && netbox_encode_after(L, idx + 6, ctx->stream) != 0)
+		return -1;
 
 	/* encode fetch_pos */
 	if (fetch_pos) {
@@ -974,6 +1053,18 @@ netbox_encode_select(lua_State *L, int idx,
 		mpstream_encode_bool(ctx->stream, fetch_pos);
 	}
 
+	/* encode fields */
+	if (have_fields) {
+		mpstream_encode_uint(ctx->stream, IPROTO_FIELDS);
+		uint32_t field_count = lua_objlen(L, idx + 8);
+		mpstream_encode_array(ctx->stream, field_count);
+		for (uint32_t i = 0; i < field_count; i++) {
+			lua_rawgeti(L, idx + 8, i + 1);
+			mpstream_encode_uint(ctx->stream, lua_tointeger(L, -1));
+			lua_pop(L, 1);
+		}
+	}
+
 	netbox_end_encode(ctx->stream, svp);
 	return 0;
 }
@@ -1289,6 +1380,12 @@ netbox_transport_send_and_recv(struct netbox_transport *transport,
 				int rc = xrow_decode(hdr, &rpos, body_end,
 						     /*end_is_exact=*/true);
 				transport->last_msg_size = body_end - bufpos;
+				if (rc == 0 && hdr->compression !=
+					       IPROTO_COMPRESSION_NONE) {
+					rc = xrow_decompress_body(
+						hdr, UINT32_MAX,
+						&transport->body_buf);
+				}
 				return rc;
 			}
 		}
@@ -1463,6 +1560,184 @@ netbox_encode_watch_once(struct lua_State *L, int idx,
 	return 0;
 }
 
+/* Encode cursor open request. */
+static int
+netbox_encode_cursor_open(lua_State *L, int idx,
+			  struct netbox_method_encode_ctx *ctx)
+{
+	/* Lua stack at idx: space_id, index_id, iterator, offset, key, after */
+	size_t svp = netbox_begin_encode(ctx->stream, ctx->sync,
+					 IPROTO_CURSOR_OPEN, ctx->stream_id);
+	bool have_after = !lua_isnil(L, idx + 5);
+	mpstream_encode_map(ctx->stream, have_after ? 6 : 5);
+	int iterator = lua_tointeger(L, idx + 2);
+	uint32_t offset = lua_tonumber(L, idx + 3);
+	netbox_encode_space_id_or_name(L, idx, ctx->stream);
+	netbox_encode_index_id_or_name(L, idx + 1, ctx->stream);
+	mpstream_encode_uint(ctx->stream, IPROTO_ITERATOR);
+	mpstream_encode_uint(ctx->stream, iterator);
+	mpstream_encode_uint(ctx->stream, IPROTO_OFFSET);
+	mpstream_encode_uint(ctx->stream, offset);
+	mpstream_encode_uint(ctx->stream, IPROTO_KEY);
+	if (luamp_convert_key(L, cfg, ctx->stream, idx + 4) != 0)
+		return -1;
+	if (have_after && netbox_encode_after(L, idx + 5, ctx->stream) != 0)
+		return -1;
+	netbox_end_encode(ctx->stream, svp);
+	return 0;
+}
+
+/* Encode cursor fetch request. */
+static int
+netbox_encode_cursor_fetch(lua_State *L, int idx,
+			   struct netbox_method_encode_ctx *ctx)
+{
+	/* Lua stack at idx: cursor_id, limit */
+	uint64_t cursor_id = lua_tointeger(L, idx);
+	uint32_t limit = lua_tonumber(L, idx + 1);
+	size_t svp = netbox_begin_encode(ctx->stream, ctx->sync,
+					 IPROTO_CURSOR_FETCH, ctx->stream_id);
+	mpstream_encode_map(ctx->stream, 2);
+	mpstream_encode_uint(ctx->stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(ctx->stream, cursor_id);
+	mpstream_encode_uint(ctx->stream, IPROTO_LIMIT);
+	mpstream_encode_uint(ctx->stream, limit);
+	netbox_end_encode(ctx->stream, svp);
+	return 0;
+}
+
+/* Encode cursor close request. */
+static int
+netbox_encode_cursor_close(lua_State *L, int idx,
+			   struct netbox_method_encode_ctx *ctx)
+{
+	/* Lua stack at idx: cursor_id */
+	uint64_t cursor_id = lua_tointeger(L, idx);
+	size_t svp = netbox_begin_encode(ctx->stream, ctx->sync,
+					 IPROTO_CURSOR_CLOSE, ctx->stream_id);
+	mpstream_encode_map(ctx->stream, 1);
+	mpstream_encode_uint(ctx->stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(ctx->stream, cursor_id);
+	netbox_end_encode(ctx->stream, svp);
+	return 0;
+}
+
+/**
+ * Encode a request of a batch stored in the Lua stack at the index idx.
+ * The request is an array of: request type, space, index, key or tuple,
+ * operations, iterator, offset, limit. Fields not used by the request
+ * type are ignored.
+ */
+static int
+netbox_encode_batch_request(lua_State *L, int idx, struct mpstream *stream)
+{
+	for (int i = 1; i <= 8; i++)
+		lua_rawgeti(L, idx, i);
+	int base = lua_gettop(L) - 7;
+	uint32_t type = lua_tointeger(L, base);
+	int rc = -1;
+	switch (type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+		mpstream_encode_map(stream, 3);
+		break;
+	case IPROTO_DELETE:
+		mpstream_encode_map(stream, 4);
+		break;
+	case IPROTO_UPSERT:
+		mpstream_encode_map(stream, 5);
+		break;
+	case IPROTO_UPDATE:
+		mpstream_encode_map(stream, 6);
+		break;
+	case IPROTO_SELECT:
+		mpstream_encode_map(stream, 7);
+		break;
+	default:
+		unreachable();
+	}
+	mpstream_encode_uint(stream, IPROTO_REQUEST_TYPE);
+	mpstream_encode_uint(stream, type);
+	netbox_encode_space_id_or_name(L, base + 1, stream);
+	if (type == IPROTO_DELETE || type == IPROTO_UPDATE ||
+	    type == IPROTO_SELECT)
+		netbox_encode_index_id_or_name(L, base + 2, stream);
+	if (type == IPROTO_UPDATE || type == IPROTO_UPSERT) {
+		mpstream_encode_uint(stream, IPROTO_INDEX_BASE);
+		mpstream_encode_uint(stream, 1);
+	}
+	if (type == IPROTO_SELECT) {
+		mpstream_encode_uint(stream, IPROTO_ITERATOR);
+		mpstream_encode_uint(stream, lua_tointeger(L, base + 5));
+		mpstream_encode_uint(stream, IPROTO_OFFSET);
+		mpstream_encode_uint(stream, (uint32_t)lua_tonumber(L, base + 6));
+		mpstream_encode_uint(stream, IPROTO_LIMIT);
+		mpstream_encode_uint(stream, (uint32_t)lua_tonumber(L, base + 7));
+	}
+	switch (type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+		mpstream_encode_uint(stream, IPROTO_TUPLE);
+		if (luamp_encode_tuple(L, cfg, stream, base + 3) != 0)
+			goto out;
+		break;
+	case IPROTO_UPSERT:
+		mpstream_encode_uint(stream, IPROTO_TUPLE);
+		if (luamp_encode_tuple(L, cfg, stream, base + 3) != 0)
+			goto out;
+		mpstream_encode_uint(stream, IPROTO_OPS);
+		if (luamp_encode_tuple(L, cfg, stream, base + 4) != 0)
+			goto out;
+		break;
+	case IPROTO_UPDATE:
+		mpstream_encode_uint(stream, IPROTO_KEY);
+		if (luamp_convert_key(L, cfg, stream, base + 3) != 0)
+			goto out;
+		mpstream_encode_uint(stream, IPROTO_TUPLE);
+		if (luamp_encode_tuple(L, cfg, stream, base + 4) != 0)
+			goto out;
+		break;
+	default:
+		mpstream_encode_uint(stream, IPROTO_KEY);
+		if (luamp_convert_key(L, cfg, stream, base + 3) != 0)
+			goto out;
+		break;
+	}
+	rc = 0;
+out:
+	lua_pop(L, 8);
+	return rc;
+}
+
+/* Encode batch request. */
+static int
+netbox_encode_batch(lua_State *L, int idx,
+		    struct netbox_method_encode_ctx *ctx)
+{
+	/* Lua stack at idx: requests, is_atomic */
+	size_t svp = netbox_begin_encode(ctx->stream, ctx->sync, IPROTO_BATCH,
+					 ctx->stream_id);
+	bool is_atomic = lua_toboolean(L, idx + 1);
+	mpstream_encode_map(ctx->stream, is_atomic ? 2 : 1);
+	mpstream_encode_uint(ctx->stream, IPROTO_REQUESTS);
+	uint32_t request_count = lua_objlen(L, idx);
+	mpstream_encode_array(ctx->stream, request_count);
+	for (uint32_t i = 0; i < request_count; i++) {
+		lua_rawgeti(L, idx, i + 1);
+		int rc = netbox_encode_batch_request(L, lua_gettop(L),
+						     ctx->stream);
+		lua_pop(L, 1);
+		if (rc != 0)
+			return -1;
+	}
+	if (is_atomic) {
+		mpstream_encode_uint(ctx->stream, IPROTO_IS_ATOMIC);
+		mpstream_encode_bool(ctx->stream, true);
+	}
+	netbox_end_encode(ctx->stream, svp);
+	return 0;
+}
+
 /**
  * Write an injection to the provided MsgPack stream.
  */
@@ -1517,6 +1792,10 @@ netbox_encode_method(struct lua_State *L, int idx, enum netbox_method method,
 		[NETBOX_ROLLBACK]	= netbox_encode_rollback,
 		[NETBOX_WATCH_ONCE]	= netbox_encode_watch_once,
 		[NETBOX_INJECT]		= netbox_encode_inject,
+		[NETBOX_CURSOR_OPEN]	= netbox_encode_cursor_open,
+		[NETBOX_CURSOR_FETCH]	= netbox_encode_cursor_fetch,
+		[NETBOX_CURSOR_CLOSE]	= netbox_encode_cursor_close,
+		[NETBOX_BATCH]		= netbox_encode_batch,
 	};
 	struct mpstream stream;
 	mpstream_init(&stream, ibuf, ibuf_reserve_cb, ibuf_alloc_cb,
@@ -1725,6 +2004,38 @@ netbox_decode_select(struct lua_State *L, const char **data,
 	mp_ctx_destroy((struct mp_ctx *)&ctx);
 }
 
+/**
+ * Decodes the response body of a BATCH request consisting of single
+ * IPROTO_DATA key into an array of tuple arrays, one per request, and
+ * pushes it to Lua stack. The requests may access different spaces so
+ * tuples are created without a space format.
+ */
+static void
+netbox_decode_batch(struct lua_State *L, const char **data,
+		    const char *data_end, bool return_raw,
+		    struct tuple_format *format)
+{
+	(void)format;
+	struct response_body response_body;
+	response_body_decode(&response_body, data, data_end);
+	struct mp_box_ctx ctx;
+	mp_box_ctx_create(&ctx, NULL, response_body.tuple_formats);
+	if (return_raw) {
+		luamp_push_with_ctx(L, response_body.data,
+				    response_body.data_end,
+				    (struct mp_ctx *)&ctx);
+	} else {
+		uint32_t count = mp_decode_array(&response_body.data);
+		lua_createtable(L, count, 0);
+		for (uint32_t i = 0; i < count; i++) {
+			netbox_decode_data(L, &response_body.data,
+					   tuple_format_runtime, &ctx);
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+	mp_ctx_destroy((struct mp_ctx *)&ctx);
+}
+
 /**
  * Decodes Tarantool response body consisting of IPROTO_DATA and probably
  * IPROTO_POSITION keys into array with array of tuple on the first place
@@ -2062,6 +2373,10 @@ netbox_decode_method(struct lua_State *L, enum netbox_method method,
 		[NETBOX_ROLLBACK]	= netbox_decode_nil,
 		[NETBOX_WATCH_ONCE]	= netbox_decode_value,
 		[NETBOX_INJECT]		= netbox_decode_table,
+		[NETBOX_CURSOR_OPEN]	= netbox_decode_count,
+		[NETBOX_CURSOR_FETCH]	= netbox_decode_select,
+		[NETBOX_CURSOR_CLOSE]	= netbox_decode_nil,
+		[NETBOX_BATCH]		= netbox_decode_batch,
 	};
 	method_decoder[method](L, data, data_end, return_raw, format);
 }
@@ -2376,17 +2691,86 @@ luaT_netbox_request_pairs(struct lua_State *L)
 	return 3;
 }
 
+static inline struct netbox_pipeline *
+luaT_check_netbox_pipeline(struct lua_State *L, int idx)
+{
+	return luaL_checkudata(L, idx, netbox_pipeline_typename);
+}
+
+/**
+ * Creates a pipeline object (userdata) and pushes it to Lua stack.
+ */
+static int
+luaT_netbox_new_pipeline(struct lua_State *L)
+{
+	struct netbox_pipeline *pipeline;
+	pipeline = lua_newuserdata(L, sizeof(*pipeline));
+	pipeline->pending_count = 0;
+	fiber_cond_create(&pipeline->cond);
+	luaL_getmetatable(L, netbox_pipeline_typename);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int
+luaT_netbox_pipeline_gc(struct lua_State *L)
+{
+	struct netbox_pipeline *pipeline = luaT_check_netbox_pipeline(L, 1);
+	/* Pending requests keep a reference to the pipeline. */
+	assert(pipeline->pending_count == 0);
+	fiber_cond_destroy(&pipeline->cond);
+	return 0;
+}
+
+/**
+ * Returns true if all requests of the pipeline have been completed.
+ */
+static int
+luaT_netbox_pipeline_is_ready(struct lua_State *L)
+{
+	struct netbox_pipeline *pipeline = luaT_check_netbox_pipeline(L, 1);
+	lua_pushboolean(L, pipeline->pending_count == 0);
+	return 1;
+}
+
+/**
+ * Waits until all requests of the pipeline are completed. Takes a timeout
+ * as the second argument. Returns true on success, false on timeout.
+ */
+static int
+luaT_netbox_pipeline_wait(struct lua_State *L)
+{
+	struct netbox_pipeline *pipeline = luaT_check_netbox_pipeline(L, 1);
+	double timeout = TIMEOUT_INFINITY;
+	if (!lua_isnoneornil(L, 2)) {
+		if (lua_type(L, 2) != LUA_TNUMBER || lua_tonumber(L, 2) < 0)
+			luaL_error(L, "Usage: pipeline:wait(timeout)");
+		timeout = lua_tonumber(L, 2);
+	}
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	while (pipeline->pending_count > 0) {
+		timeout = deadline - ev_monotonic_now(loop());
+		if (timeout <= 0 ||
+		    fiber_cond_wait_timeout(&pipeline->cond, timeout) != 0)
+			break;
+	}
+	luaL_testcancel(L);
+	lua_pushboolean(L, pipeline->pending_count == 0);
+	return 1;
+}
+
 /**
  * Creates a netbox transport object (userdata) and pushes it to Lua stack.
  * Takes the following arguments: uri (string or table) or fd (number),
  * user (string or nil), password (string or nil), callback (function),
  * connect_timeout (number or nil), reconnect_after (number or nil),
- * fetch_schema (boolean or nil), auth_type (string or nil).
+ * fetch_schema (boolean or nil), auth_type (string or nil),
+ * compression (boolean or nil).
  */
 static int
 luaT_netbox_new_transport(struct lua_State *L)
 {
-	assert(lua_gettop(L) == 8);
+	assert(lua_gettop(L) == 9);
 	/* Create a transport object. */
 	struct netbox_transport *transport;
 	transport = lua_newuserdata(L, sizeof(*transport));
@@ -2432,6 +2816,8 @@ luaT_netbox_new_transport(struct lua_State *L)
 			return luaT_error(L);
 		}
 	}
+	if (!lua_isnil(L, 9))
+		opts->compression = lua_toboolean(L, 9);
 	if (opts->user == NULL && opts->password != NULL) {
 		diag_set(ClientError, ER_PROC_LUA,
 			 "net.box: user is not defined");
@@ -2440,6 +2826,31 @@ luaT_netbox_new_transport(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * Compresses the request written to the send buffer at the given offset
+ * if it's big enough and compression reduces its size.
+ */
+static void
+netbox_transport_compress_request(struct netbox_transport *transport,
+				  size_t svp)
+{
+	struct ibuf *ibuf = &transport->send_buf;
+	size_t size = ibuf_used(ibuf) - svp;
+	if (size < NETBOX_COMPRESSION_MIN_SIZE)
+		return;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t compressed_size;
+	const char *compressed = iproto_packet_compress(ibuf->rpos + svp, size,
+							&compressed_size);
+	if (compressed != NULL) {
+		assert(compressed_size < size);
+		memcpy(ibuf->rpos + svp, compressed, compressed_size);
+		ibuf_truncate(ibuf, svp + compressed_size);
+	}
+	region_truncate(region, region_svp);
+}
+
 /**
  * Writes a request to the send buffer and registers the request object
  * ('future') that can be used for waiting for a response.
@@ -2496,6 +2907,10 @@ luaT_netbox_transport_make_request(struct lua_State *L, int idx,
 		ibuf_truncate(&transport->send_buf, svp);
 		return -1;
 	}
+	if (transport->opts.compression &&
+	    iproto_features_test(&transport->features,
+				 IPROTO_FEATURE_COMPRESSION))
+		netbox_transport_compress_request(transport, svp);
 	/* Alert worker to notify it of the queued outgoing data. */
 	if (svp == 0)
 		fiber_wakeup(transport->worker);
@@ -2524,6 +2939,8 @@ luaT_netbox_transport_make_request(struct lua_State *L, int idx,
 	request->result_ref = LUA_NOREF;
 	request->error = NULL;
 	request->remote_ref = LUA_NOREF;
+	request->pipeline = NULL;
+	request->pipeline_ref = LUA_NOREF;
 	netbox_request_register(request, transport);
 	return 0;
 }
@@ -2534,11 +2951,21 @@ luaT_netbox_transport_perform_async_request(struct lua_State *L)
 	struct netbox_transport *transport = luaT_check_netbox_transport(L, 1);
 	/* The connection object. */
 	assert(lua_istable(L, 2));
+	/* The pipeline to add the request to or nil. */
+	struct netbox_pipeline *pipeline = NULL;
+	if (!lua_isnil(L, 3))
+		pipeline = luaT_check_netbox_pipeline(L, 3);
 	struct netbox_request *request = lua_newuserdata(L, sizeof(*request));
-	if (luaT_netbox_transport_make_request(L, 3, transport, request) != 0)
+	if (luaT_netbox_transport_make_request(L, 4, transport, request) != 0)
 		return luaT_push_nil_and_error(L);
 	lua_pushvalue(L, 2);
 	request->remote_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	if (pipeline != NULL) {
+		lua_pushvalue(L, 3);
+		request->pipeline_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		request->pipeline = pipeline;
+		pipeline->pending_count++;
+	}
 	luaL_getmetatable(L, netbox_request_typename);
 	lua_setmetatable(L, -2);
 	return 1;
@@ -2833,7 +3260,8 @@ netbox_transport_do_id(struct netbox_transport *transport, struct lua_State *L)
 	if (peer_version_id < version_id(2, 10, 0))
 		goto unsupported;
 	netbox_encode_id(L, &transport->send_buf, transport->next_sync++,
-			 transport->opts.fetch_schema);
+			 transport->opts.fetch_schema,
+			 transport->opts.compression);
 	struct xrow_header hdr;
 	if (netbox_transport_send_and_recv(transport, &hdr) != 0)
 		luaT_error(L);
@@ -3288,6 +3716,14 @@ luaopen_net_box(struct lua_State *L)
 			    IPROTO_FEATURE_CALL_ARG_TUPLE_EXTENSION);
 	iproto_features_set(&NETBOX_IPROTO_FEATURES,
 			    IPROTO_FEATURE_IS_SYNC);
+	iproto_features_set(&NETBOX_IPROTO_FEATURES,
+			    IPROTO_FEATURE_COMPRESSION);
+	iproto_features_set(&NETBOX_IPROTO_FEATURES,
+			    IPROTO_FEATURE_CURSORS);
+	iproto_features_set(&NETBOX_IPROTO_FEATURES,
+			    IPROTO_FEATURE_SELECT_FIELDS);
+	iproto_features_set(&NETBOX_IPROTO_FEATURES,
+			    IPROTO_FEATURE_BATCH);
 
 	lua_pushcfunction(L, luaT_netbox_request_iterator_next);
 	luaT_netbox_request_iterator_next_ref = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -3325,8 +3761,17 @@ luaopen_net_box(struct lua_State *L)
 	};
 	luaL_register_type(L, netbox_request_typename, netbox_request_meta);
 
+	static const struct luaL_Reg netbox_pipeline_meta[] = {
+		{ "__gc",           luaT_netbox_pipeline_gc },
+		{ "is_ready",       luaT_netbox_pipeline_is_ready },
+		{ "wait",           luaT_netbox_pipeline_wait },
+		{ NULL, NULL }
+	};
+	luaL_register_type(L, netbox_pipeline_typename, netbox_pipeline_meta);
+
 	static const luaL_Reg net_box_lib[] = {
 		{ "new_transport",  luaT_netbox_new_transport },
+		{ "new_pipeline",   luaT_netbox_new_pipeline },
 		{ NULL, NULL}
 	};
 	luaT_newmodule(L, "net.box.lib", net_box_lib);
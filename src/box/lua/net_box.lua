@@ -14,6 +14,7 @@ local max               = math.max
 local fiber_clock       = fiber.clock
 
 local check_select_opts   = box.internal.check_select_opts
+local check_select_fields = box.internal.check_select_fields
 local check_index_arg     = box.internal.check_index_arg
 local check_space_arg     = box.internal.check_space_arg
 local check_primary_index = box.internal.check_primary_index
@@ -29,6 +30,15 @@ local TIMEOUT_INFINITY = 500 * 365 * 86400
 local E_NO_CONNECTION        = box.error.NO_CONNECTION
 local E_PROC_LUA             = box.error.PROC_LUA
 
+local pipeline_methods = {}
+local pipeline_mt = {
+    __index = pipeline_methods,
+    __tostring = function()
+        return 'net.box.pipeline'
+    end,
+}
+pipeline_mt.__serialize = pipeline_mt.__tostring
+
 local REQUEST_OPTION_TYPES = {
     is_async    = "boolean",
     iterator    = "string",
@@ -40,6 +50,7 @@ local REQUEST_OPTION_TYPES = {
     skip_header = "boolean",
     timeout     = "number",
     fetch_pos   = "boolean",
+    fields      = "table",
     after = function(after)
         if after ~= nil and type(after) ~= "string" and type(after) ~= "table"
                 and not is_tuple(after) then
@@ -53,6 +64,16 @@ local REQUEST_OPTION_TYPES = {
        end
        return true
     end,
+    pipeline = function(pipeline)
+        if getmetatable(pipeline) ~= pipeline_mt then
+            return false, "net.box.pipeline"
+        end
+        return true
+    end,
+}
+
+local PIPELINE_OPTION_TYPES = {
+    on_complete = "function",
 }
 
 local CONNECT_OPTION_TYPES = {
@@ -66,6 +87,7 @@ local CONNECT_OPTION_TYPES = {
     auth_type                   = "string",
     required_protocol_version   = "number",
     required_protocol_features  = "table",
+    compression                 = "boolean",
     _disable_graceful_shutdown  = "boolean",
 }
 
@@ -445,7 +467,7 @@ local function new_sm(uri_or_fd, opts)
     local transport = internal.new_transport(
             uri_or_fd, user, password, weak_callback,
             opts.connect_timeout, opts.reconnect_after,
-            opts.fetch_schema, opts.auth_type)
+            opts.fetch_schema, opts.auth_type, opts.compression)
     weak_refs.transport = transport
     remote._transport = transport
     remote._gc_hook = ffi.gc(ffi.new('char[1]'), function()
@@ -686,6 +708,83 @@ function remote_methods:new_stream()
     return stream
 end
 
+local function check_pipeline_arg(pipeline, method)
+    if type(pipeline) ~= 'table' then
+        local fmt = 'Use pipeline:%s(...) instead of pipeline.%s(...)'
+        box.error(E_PROC_LUA, string.format(fmt, method, method))
+    end
+end
+
+-- Runs the on_complete callback once all requests of the pipeline
+-- added so far, including ones added while waiting, are completed.
+function pipeline_methods:_run_on_complete()
+    local is_ready = self._pipeline:wait()
+    self._is_waiting = false
+    if not is_ready then
+        return
+    end
+    local status, err = pcall(self._on_complete, self)
+    if not status then
+        log.error(err)
+    end
+end
+
+function pipeline_methods:_on_request()
+    if self._on_complete ~= nil and not self._is_waiting then
+        self._is_waiting = true
+        fiber.new(self._run_on_complete, self)
+    end
+end
+
+-- Returns request options that add the request to the pipeline.
+function pipeline_methods:_request_opts(opts)
+    check_param_table(opts, REQUEST_OPTION_TYPES)
+    local pipeline_opts = {}
+    if opts ~= nil then
+        for k, v in pairs(opts) do
+            pipeline_opts[k] = v
+        end
+    end
+    pipeline_opts.is_async = true
+    pipeline_opts.pipeline = self
+    return pipeline_opts
+end
+
+function pipeline_methods:call(func_name, args, opts)
+    check_pipeline_arg(self, 'call')
+    return self._conn:call(func_name, args, self:_request_opts(opts))
+end
+
+function pipeline_methods:eval(code, args, opts)
+    check_pipeline_arg(self, 'eval')
+    return self._conn:eval(code, args, self:_request_opts(opts))
+end
+
+function pipeline_methods:execute(query, parameters, sql_opts, netbox_opts)
+    check_pipeline_arg(self, 'execute')
+    return self._conn:execute(query, parameters, sql_opts,
+                              self:_request_opts(netbox_opts))
+end
+
+function pipeline_methods:batch(requests, batch_opts, netbox_opts)
+    check_pipeline_arg(self, 'batch')
+    return self._conn:batch(requests, batch_opts,
+                            self:_request_opts(netbox_opts))
+end
+
+function pipeline_methods:is_ready()
+    check_pipeline_arg(self, 'is_ready')
+    return self._pipeline:is_ready()
+end
+
+function pipeline_methods:wait(timeout)
+    check_pipeline_arg(self, 'wait')
+    if self._conn._fiber == fiber.self() then
+        error('Waiting for a pipeline is not allowed in net.box trigger')
+    end
+    return self._pipeline:wait(timeout)
+end
+
 local watcher_methods = {}
 local watcher_mt = {
     __index = watcher_methods,
@@ -890,14 +989,32 @@ function remote_methods:_request_impl(method, opts, format, stream_id, ...)
         buffer = opts.buffer
         skip_header = opts.skip_header
         return_raw = opts.return_raw
+        local pipeline = opts.pipeline
+        if pipeline ~= nil then
+            if not opts.is_async then
+                error('Only async requests can be added to a pipeline')
+            end
+            if pipeline._transport ~= transport then
+                error('The pipeline belongs to another connection')
+            end
+        end
         if opts.is_async then
             if opts.on_push or opts.on_push_ctx then
                 error('To handle pushes in an async request use future:pairs()')
             end
-            return transport:perform_async_request(self, buffer, skip_header,
-                                                   return_raw, table.insert,
-                                                   {}, format, stream_id,
-                                                   method, ...)
+            if pipeline == nil then
+                return transport:perform_async_request(self, nil, buffer,
+                                                       skip_header, return_raw,
+                                                       table.insert, {}, format,
+                                                       stream_id, method, ...)
+            end
+            local future, err = transport:perform_async_request(
+                self, pipeline._pipeline, buffer, skip_header, return_raw,
+                table.insert, {}, format, stream_id, method, ...)
+            if future ~= nil then
+                pipeline:_on_request()
+            end
+            return future, err
         end
         if opts.timeout then
             deadline = fiber_clock() + opts.timeout
@@ -1022,6 +1139,99 @@ function remote_methods:unprepare(query, parameters, sql_opts, netbox_opts)
                          query, parameters or {}, sql_opts or {})
 end
 
+--
+-- Converts a request of conn:batch() to the array expected by the
+-- BATCH request encoder: request type, space, index, key or tuple,
+-- operations, iterator, offset, limit.
+--
+local function batch_request(request)
+    if type(request) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "batch request should be a table")
+    end
+    local request_type, space = request[1], request[2]
+    if type(space) ~= 'number' and type(space) ~= 'string' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "batch request space should be a number or a string")
+    end
+    local t = box.iproto.type
+    if request_type == 'insert' then
+        return {t.INSERT, space, nil, request[3]}
+    elseif request_type == 'replace' then
+        return {t.REPLACE, space, nil, request[3]}
+    elseif request_type == 'delete' then
+        return {t.DELETE, space, request[4] or 0, request[3]}
+    elseif request_type == 'update' then
+        return {t.UPDATE, space, request[5] or 0, request[3], request[4]}
+    elseif request_type == 'upsert' then
+        return {t.UPSERT, space, nil, request[3], request[4]}
+    elseif request_type == 'select' then
+        local key, opts = request[3], request[4]
+        local key_is_nil = (key == nil or
+                            (type(key) == 'table' and #key == 0))
+        local iterator, offset, limit = check_select_opts(opts, key_is_nil)
+        local index = type(opts) == 'table' and opts.index or 0
+        return {t.SELECT, space, index, key, nil, iterator, offset, limit}
+    end
+    box.error(box.error.ILLEGAL_PARAMS,
+              string.format("unknown batch request type '%s'",
+                            tostring(request_type)))
+end
+
+--
+-- Executes a batch of requests in one round trip. Every request is an
+-- array starting with the request type:
+--
+--   {'insert', space, tuple}
+--   {'replace', space, tuple}
+--   {'delete', space, key[, index]}
+--   {'update', space, key, ops[, index]}
+--   {'upsert', space, tuple, ops}
+--   {'select', space, key[, {index = ..., iterator = ..., offset = ...,
+--                            limit = ...}]}
+--
+-- Spaces and indexes are given by id or by name. Returns an array of the
+-- results of the requests, each one an array of tuples. If batch_opts
+-- has is_atomic set, the requests are executed in one transaction.
+-- Otherwise, if a request fails, the preceding requests stay applied and
+-- their number is stored in the applied_count field of the error.
+--
+function remote_methods:batch(requests, batch_opts, netbox_opts)
+    check_remote_arg(self, 'batch')
+    if type(requests) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS, "requests should be a table")
+    end
+    check_param_table(batch_opts, {is_atomic = 'boolean'})
+    check_param_table(netbox_opts, REQUEST_OPTION_TYPES)
+    if not self.peer_protocol_features.batch then
+        box.error(box.error.UNSUPPORTED, "Remote server", "batch")
+    end
+    local batch = {}
+    for i, request in ipairs(requests) do
+        batch[i] = batch_request(request)
+    end
+    local is_atomic = batch_opts ~= nil and batch_opts.is_atomic or false
+    return self:_request('BATCH', netbox_opts, nil, self._stream_id,
+                         batch, is_atomic)
+end
+
+--
+-- Creates a pipeline - a group of async requests that are waited
+-- for together. A fiber waiting for a pipeline is woken up once,
+-- when all its requests are completed, rather than on each response.
+--
+function remote_methods:pipeline(opts)
+    check_remote_arg(self, 'pipeline')
+    check_param_table(opts, PIPELINE_OPTION_TYPES)
+    return setmetatable({
+        _conn = self,
+        _transport = self._transport,
+        _pipeline = internal.new_pipeline(),
+        _on_complete = opts and opts.on_complete,
+        _is_waiting = false,
+    }, pipeline_mt)
+end
+
 function remote_methods:wait_state(state, timeout)
     check_remote_arg(self, 'wait_state')
     local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
@@ -1178,6 +1388,44 @@ local function nothing_or_data(value)
     end
 end
 
+local function check_cursor_arg(cursor, method)
+    if type(cursor) ~= 'table' or cursor._id == nil then
+        local fmt = 'Use cursor:%s(...) instead of cursor.%s(...)'
+        box.error(E_PROC_LUA, string.format(fmt, method, method))
+    end
+end
+
+--
+-- A server-side cursor returned by index:cursor(). Tuples are fetched
+-- in batches of the given size, CURSOR_FETCH_LIMIT_DEFAULT by default.
+-- The cursor is closed on the server with cursor:close() or when the
+-- connection is closed.
+--
+local CURSOR_FETCH_LIMIT_DEFAULT = 1000
+
+local cursor_methods = {}
+
+function cursor_methods:fetch(limit, opts)
+    check_cursor_arg(self, 'fetch')
+    check_param_table(opts, REQUEST_OPTION_TYPES)
+    if limit == nil then
+        limit = CURSOR_FETCH_LIMIT_DEFAULT
+    elseif type(limit) ~= 'number' or limit < 0 then
+        box.error(E_PROC_LUA, 'limit must be a non-negative number')
+    end
+    return self._remote:_request('CURSOR_FETCH', opts, self._format_cdata,
+                                 nil, self._id, limit)
+end
+
+function cursor_methods:close(opts)
+    check_cursor_arg(self, 'close')
+    check_param_table(opts, REQUEST_OPTION_TYPES)
+    return nothing_or_data(self._remote:_request('CURSOR_CLOSE', opts, nil,
+                                                 nil, self._id))
+end
+
+local cursor_mt = { __index = cursor_methods, __metatable = false }
+
 space_metatable = function(remote)
     local methods = {}
 
@@ -1224,6 +1472,11 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:cursor(key, opts)
+        check_space_arg(self, 'cursor')
+        return check_primary_index(self):cursor(key, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1250,19 +1503,53 @@ index_metatable = function(remote)
             return box.error(box.error.UNSUPPORTED, "Remote server",
                 "pagination")
         end
+        local fields = check_select_fields(opts)
+        if fields ~= nil and
+                not remote.peer_protocol_features.select_fields then
+            return box.error(box.error.UNSUPPORTED, "Remote server",
+                "select fields")
+        end
 
+        -- Projected tuples don't have the space format.
+        local format = fields == nil and self.space._format_cdata or nil
         local res
         local method = fetch_pos and 'SELECT_WITH_POS' or 'SELECT'
-        res = (remote:_request(method, opts, self.space._format_cdata,
+        res = (remote:_request(method, opts, format,
                                self._stream_id, self.space._id_or_name,
                                self._id_or_name, iterator, offset, limit, key,
-                               after, fetch_pos))
+                               after, fetch_pos, fields))
         if type(res) ~= 'table' or not fetch_pos or opts and opts.is_async then
             return res
         end
         return unpack(res)
     end
 
+    function methods:cursor(key, opts)
+        check_index_arg(self, 'cursor')
+        check_param_table(opts, REQUEST_OPTION_TYPES)
+        if opts and (opts.buffer or opts.is_async) then
+            error("index:cursor() doesn't support `buffer` and " ..
+                  "`is_async` arguments")
+        end
+        if not remote.peer_protocol_features.cursors then
+            box.error(box.error.UNSUPPORTED, "Remote server", "cursors")
+        end
+        if opts and opts.fields ~= nil then
+            error("index:cursor() doesn't support `fields` argument")
+        end
+        local key_is_nil = (key == nil or
+                            (type(key) == 'table' and #key == 0))
+        local iterator, offset, _, after = check_select_opts(opts, key_is_nil)
+        local id = remote:_request('CURSOR_OPEN', opts, nil, self._stream_id,
+                                   self.space._id_or_name, self._id_or_name,
+                                   iterator, offset, key, after)
+        return setmetatable({
+            _remote = remote,
+            _id = id,
+            _format_cdata = self.space._format_cdata,
+        }, cursor_mt)
+    end
+
     function methods:get(key, opts)
         check_index_arg(self, 'get')
         check_param_table(opts, REQUEST_OPTION_TYPES)
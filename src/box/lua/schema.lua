@@ -1558,6 +1558,7 @@ local index_options = {
     page_size = 'number',
     bloom_fpr = 'number',
     func = 'number, string',
+    filter = 'number, string',
     hint = 'boolean',
     covers = 'table',
     layout = 'string',
@@ -1734,6 +1735,7 @@ box.schema.index.create = atomic_wrapper(function(space_id, name, options)
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
             func = options.func,
+            filter = options.filter,
             hint = options.hint,
             covers = options.covers,
             layout = options.layout,
@@ -1762,6 +1764,9 @@ box.schema.index.create = atomic_wrapper(function(space_id, name, options)
     if index_opts.func ~= nil and type(index_opts.func) == 'string' then
         index_opts.func = func_id_by_name(index_opts.func, 2)
     end
+    if index_opts.filter ~= nil and type(index_opts.filter) == 'string' then
+        index_opts.filter = func_id_by_name(index_opts.filter, 2)
+    end
     if index_opts.covers ~= nil then
         index_opts.covers = normalize_fields(index_opts.covers, format,
                                              'options.covers', 2)
@@ -1907,6 +1912,9 @@ box.schema.index.alter = atomic_wrapper(function(space_id, index_id, options)
     if index_opts.func ~= nil and type(index_opts.func) == 'string' then
         index_opts.func = func_id_by_name(index_opts.func, 2)
     end
+    if index_opts.filter ~= nil and type(index_opts.filter) == 'string' then
+        index_opts.filter = func_id_by_name(index_opts.filter, 2)
+    end
     if index_opts.covers ~= nil then
         index_opts.covers = normalize_fields(index_opts.covers, format,
                                              'options.covers', 2)
@@ -2644,6 +2652,18 @@ base_index_mt.get_luac = function(index, key)
     return internal.get(index.space_id, index.id, key)
 end
 
+base_index_mt.get_many = function(index, keys)
+    check_index_arg(index, 'get_many', 2)
+    if type(keys) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS, "Usage: index:get_many(keys)", 2)
+    end
+    local normalized_keys = {}
+    for i, key in ipairs(keys) do
+        normalized_keys[i] = keify(key)
+    end
+    return internal.get_many(index.space_id, index.id, normalized_keys)
+end
+
 local function check_select_opts(opts, key_is_nil, level)
     local offset = 0
     local limit = 4294967295
@@ -2674,8 +2694,34 @@ end
 
 box.internal.check_select_opts = check_select_opts -- for net.box
 
+-- Returns the list of 0-based field numbers to return from select or nil
+-- if the 'fields' option isn't set.
+local function check_select_fields(opts, level)
+    if opts == nil or type(opts) ~= 'table' or opts.fields == nil then
+        return nil
+    end
+    local usage = "options parameter 'fields' should be a table " ..
+                  "of field numbers"
+    if type(opts.fields) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS, usage, level and level + 1)
+    end
+    local fields = {}
+    for i, fieldno in ipairs(opts.fields) do
+        if type(fieldno) ~= 'number' or fieldno < 1 or
+                fieldno ~= math.floor(fieldno) or fieldno > 0x7fffffff then
+            box.error(box.error.ILLEGAL_PARAMS, usage, level and level + 1)
+        end
+        fields[i] = fieldno - 1
+    end
+    return fields
+end
+
+box.internal.check_select_fields = check_select_fields -- for net.box
+
 base_index_mt.select_ffi = function(index, key, opts)
-    if builtin.box_read_ffi_is_disabled then
+    -- Projected rows are built in C right from the tuple data.
+    if builtin.box_read_ffi_is_disabled or
+            (type(opts) == 'table' and opts.fields ~= nil) then
         return base_index_mt.select_luac(index, key, opts)
     end
     check_index_arg(index, 'select', 2)
@@ -2721,8 +2767,9 @@ base_index_mt.select_luac = function(index, key, opts)
     local key_is_nil = #key == 0
     local iterator, offset, limit, after, fetch_pos =
         check_select_opts(opts, key_is_nil, 2)
+    local fields = check_select_fields(opts, 2)
     return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key, after, fetch_pos)
+        offset, limit, key, after, fetch_pos, fields)
 end
 
 base_index_mt.update = function(index, key, ops)
@@ -2827,6 +2874,10 @@ space_mt.get = function(space, key)
     check_space_arg(space, 'get', 2)
     return check_primary_index(space, 2):get(key)
 end
+space_mt.get_many = function(space, keys)
+    check_space_arg(space, 'get_many', 2)
+    return check_primary_index(space, 2):get_many(keys)
+end
 space_mt.select = function(space, key, opts)
     check_space_arg(space, 'select', 2)
     return check_primary_index(space, 2):select(key, opts)
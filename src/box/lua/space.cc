@@ -617,6 +617,23 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_settable(L, -3);
 		}
 
+		if (index_opts->filter_func_id > 0) {
+			lua_pushstring(L, "filter");
+			lua_newtable(L);
+
+			lua_pushnumber(L, index_opts->filter_func_id);
+			lua_setfield(L, -2, "fid");
+
+			struct func *func =
+				func_by_id(index_opts->filter_func_id);
+			if (func != NULL) {
+				lua_pushstring(L, func->def->name);
+				lua_setfield(L, -2, "name");
+			}
+
+			lua_settable(L, -3);
+		}
+
 		lua_pushstring(L, index_type_strs[index_def->type]);
 		lua_setfield(L, -2, "type");
 
@@ -261,7 +261,8 @@ lbox_stat_net_index(struct lua_State *L)
  * - STREAMS: total, rps, current;
  * - REQUESTS: total, rps, current;
  * - REQUESTS_IN_PROGRESS: total, rps, current;
- * - REQUESTS_IN_STREAM_QUEUE: total, rps, current.
+ * - REQUESTS_IN_STREAM_QUEUE: total, rps, current;
+ * - REQUESTS_REJECTED: total, rps.
  *
  * These fields have the following meaning:
  *
@@ -326,6 +327,16 @@ lbox_stat_sql(struct lua_State *L)
 	return 1;
 }
 
+/* box.stat.tx_queue() */
+static int
+lbox_stat_tx_queue(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	box_fiber_pool_stat(&h);
+	return 1;
+}
+
 static const struct luaL_Reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -367,6 +378,7 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"tx_queue", lbox_stat_tx_queue},
 		{NULL, NULL}
 	};
 
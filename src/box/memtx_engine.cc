@@ -63,6 +63,7 @@
 #include "tt_sort.h"
 #include "assoc.h"
 #include "wal.h"
+#include "alter.h"
 
 #include <type_traits>
 
@@ -92,6 +93,9 @@ memtx_tuple_new_raw_impl(struct tuple_format *format, const char *data,
 static void
 memtx_engine_run_gc(struct memtx_engine *memtx, bool *stop);
 
+static int
+memtx_engine_defrag_f(va_list va);
+
 static void *
 memtx_index_extent_alloc(struct matras_allocator *matras_allocator);
 
@@ -212,6 +216,14 @@ memtx_engine_shutdown(struct engine *engine)
 	fiber_cancel(memtx->gc_fiber);
 	fiber_join(memtx->gc_fiber);
 	memtx->gc_fiber = NULL;
+	fiber_cancel(memtx->defrag_fiber);
+	fiber_join(memtx->defrag_fiber);
+	memtx->defrag_fiber = NULL;
+	while (!stailq_empty(&memtx->defrag_queue)) {
+		struct memtx_defrag_task *task = stailq_shift_entry(
+			&memtx->defrag_queue, struct memtx_defrag_task, link);
+		free(task);
+	}
 }
 
 static void
@@ -686,17 +698,8 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	else
 		panic("transaction rolled back during snapshot recovery");
 
-	for (uint32_t i = 0; i < index_count; i++) {
-		struct tuple *unused;
-		struct index *index = space->index[i];
-		/* Rollback must not fail. */
-		if (index_replace(index, new_tuple, old_tuple,
-				  DUP_INSERT, &unused, &unused) != 0) {
-			diag_log();
-			unreachable();
-			panic("failed to rollback change");
-		}
-	}
+	memtx_space_rollback_replace(space, index_count, old_tuple, new_tuple,
+				     stmt->rollback_info.partial_index_mask);
 
 	memtx_space_update_tuple_stat(space, new_tuple, old_tuple);
 	if (old_tuple != NULL)
@@ -1628,6 +1631,228 @@ memtx_engine_gc_f(va_list va)
 	return 0;
 }
 
+/*
+ * Yield every 1K relocated tuples while defragmenting a space.
+ * In debug mode yield more often for testing purposes.
+ */
+#ifdef NDEBUG
+enum { MEMTX_DEFRAG_YIELD_LOOPS = 1000 };
+#else
+enum { MEMTX_DEFRAG_YIELD_LOOPS = 10 };
+#endif
+
+/** Space scheduled for defragmentation. */
+struct memtx_defrag_task {
+	/** Link in memtx_engine::defrag_queue. */
+	struct stailq_entry link;
+	/** Id of the space to defragment. */
+	uint32_t space_id;
+};
+
+/**
+ * Returns true if tuples of the space may be relocated now. Besides the
+ * checks done by memtx_space_can_relocate_tuples(), makes sure that the
+ * space isn't being altered: an alter may be rolled back after a yield,
+ * restoring indexes that weren't updated by relocation.
+ */
+static bool
+memtx_engine_can_defrag_space(struct space *space)
+{
+	return memtx_space_can_relocate_tuples(space) &&
+	       !space_is_being_altered(space->def->id);
+}
+
+/** Size classes of the tuple arena that may be compacted. */
+struct memtx_defrag_classes {
+	/** Object sizes of the classes. */
+	size_t *objsize;
+	/** Number of the classes. */
+	uint32_t count;
+	/** Capacity of the objsize array. */
+	uint32_t capacity;
+};
+
+/**
+ * Adds the size class described by the given mempool stats to the
+ * classes to compact if its objects would fit in fewer slabs.
+ */
+static int
+memtx_defrag_classes_add(const void *stats, void *cb_ctx)
+{
+	const struct mempool_stats *pool = (const struct mempool_stats *)stats;
+	struct memtx_defrag_classes *classes =
+		(struct memtx_defrag_classes *)cb_ctx;
+	if (pool->slabcount <= 1 || pool->objsize == 0)
+		return 0;
+	/* Leave room for the slab header. */
+	uint64_t per_slab = pool->slabsize / pool->objsize;
+	per_slab = per_slab > 1 ? per_slab - 1 : 1;
+	uint64_t objcount = pool->totals.used / pool->objsize;
+	if (pool->slabcount <= DIV_ROUND_UP(objcount, per_slab))
+		return 0;
+	if (classes->count == classes->capacity) {
+		classes->capacity = MAX(classes->capacity * 2, 16);
+		classes->objsize = (size_t *)xrealloc(
+			classes->objsize,
+			classes->capacity * sizeof(*classes->objsize));
+	}
+	classes->objsize[classes->count++] = pool->objsize;
+	return 0;
+}
+
+/**
+ * Returns true if the tuple is allocated from a size class that may be
+ * compacted. Tuples allocated with malloc aren't relocated.
+ */
+static bool
+memtx_defrag_classes_has_tuple(const struct memtx_defrag_classes *classes,
+			       struct tuple *tuple)
+{
+	struct tuple_info info;
+	tuple_info(tuple, &info);
+	if (info.arena_type != TUPLE_ARENA_MEMTX)
+		return false;
+	size_t objsize = tuple_size(tuple) + info.waste_size;
+	for (uint32_t i = 0; i < classes->count; i++) {
+		if (classes->objsize[i] == objsize)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Relocates tuples stored in a space, see memtx_space_relocate_tuple().
+ *
+ * Since a tuple is allocated from the most densely populated slab that has
+ * free room, rewriting tuples of a space moves them out of sparsely
+ * populated slabs, which are then returned to the arena. Only tuples of
+ * size classes whose objects would fit in fewer slabs are rewritten. The
+ * allocator doesn't tell how full the slab of a tuple is, so all tuples
+ * of such a class are rewritten.
+ *
+ * Yields periodically. Stops if the space is dropped or altered or an index
+ * build is started on it.
+ */
+static void
+memtx_engine_defrag_space(struct memtx_engine *memtx, uint32_t space_id)
+{
+	struct space *space = space_by_id(space_id);
+	if (space == NULL || !memtx_engine_can_defrag_space(space))
+		return;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL)
+		return;
+	struct memtx_defrag_classes classes = {NULL, 0, 0};
+	struct allocator_stats alloc_stats;
+	SmallAlloc::stats(&alloc_stats, memtx_defrag_classes_add, &classes);
+	if (classes.count == 0) {
+		say_info("Defragmentation of space '%s' skipped: "
+			 "the tuple arena is not fragmented",
+			 space_name(space));
+		return;
+	}
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL) {
+		diag_log();
+		free(classes.objsize);
+		return;
+	}
+	say_info("Defragmenting space '%s'...", space_name(space));
+	int64_t relocated = 0;
+	int loops = 0;
+	bool is_aborted = false;
+	while (!fiber_is_cancelled()) {
+		struct tuple *tuple;
+		if (iterator_next_internal(it, &tuple) != 0) {
+			diag_log();
+			is_aborted = true;
+			break;
+		}
+		if (tuple == NULL)
+			break;
+		/*
+		 * Dirty tuples are referenced by MVCC stories so
+		 * we can't move them.
+		 */
+		if (!tuple_has_flag(tuple, TUPLE_IS_DIRTY) &&
+		    memtx_defrag_classes_has_tuple(&classes, tuple)) {
+			space = index_weak_ref_get_space_checked(
+				&it->index_ref);
+			if (memtx_space_relocate_tuple(space, tuple) != 0) {
+				diag_log();
+				is_aborted = true;
+				break;
+			}
+			relocated++;
+			memtx->defrag_relocated++;
+		}
+		if (++loops % MEMTX_DEFRAG_YIELD_LOOPS != 0)
+			continue;
+		/*
+		 * Tuples relocated while a snapshot is in progress are
+		 * pinned by its read view so memory usage would only grow.
+		 */
+		do {
+			fiber_sleep(memtx->checkpoint == NULL ? 0 : 0.1);
+		} while (memtx->checkpoint != NULL && !fiber_is_cancelled());
+		/* The space may have been altered while we were sleeping. */
+		space = index_weak_ref_get_space(&it->index_ref);
+		if (space == NULL || !memtx_engine_can_defrag_space(space)) {
+			is_aborted = true;
+			break;
+		}
+	}
+	iterator_delete(it);
+	free(classes.objsize);
+	say_info("Defragmentation of space %u %s: %lld tuples relocated",
+		 (unsigned)space_id,
+		 is_aborted || fiber_is_cancelled() ? "aborted" : "done",
+		 (long long)relocated);
+}
+
+static int
+memtx_engine_defrag_f(va_list va)
+{
+	struct memtx_engine *memtx = va_arg(va, struct memtx_engine *);
+	while (!fiber_is_cancelled()) {
+		FiberGCChecker gc_check;
+		if (stailq_empty(&memtx->defrag_queue)) {
+			fiber_yield_timeout(TIMEOUT_INFINITY);
+			continue;
+		}
+		struct memtx_defrag_task *task = stailq_first_entry(
+			&memtx->defrag_queue, struct memtx_defrag_task, link);
+		memtx_engine_defrag_space(memtx, task->space_id);
+		if (fiber_is_cancelled())
+			break;
+		stailq_shift(&memtx->defrag_queue);
+		free(task);
+	}
+	return 0;
+}
+
+void
+memtx_engine_schedule_defrag(struct memtx_engine *memtx, uint32_t space_id)
+{
+	struct memtx_defrag_task *task;
+	stailq_foreach_entry(task, &memtx->defrag_queue, link) {
+		if (task->space_id == space_id)
+			return;
+	}
+	task = (struct memtx_defrag_task *)xmalloc(sizeof(*task));
+	task->space_id = space_id;
+	stailq_add_tail_entry(&memtx->defrag_queue, task, link);
+	if (memtx->defrag_fiber != NULL)
+		fiber_wakeup(memtx->defrag_fiber);
+}
+
+void
+memtx_index_compact(struct index *index)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)index->engine;
+	memtx_engine_schedule_defrag(memtx, index->def->space_id);
+}
+
 void
 memtx_set_tuple_format_vtab(const char *allocator_name)
 {
@@ -1659,8 +1884,9 @@ memtx_tuple_validate(struct tuple_format *format, struct tuple *tuple)
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		 bool dontdump, unsigned granularity,
-		 const char *allocator, float alloc_factor, int sort_threads,
+		 bool dontdump, bool huge_pages, int numa_node,
+		 unsigned granularity, const char *allocator,
+		 float alloc_factor, int sort_threads,
 		 memtx_on_indexes_built_cb on_indexes_built)
 {
 	int64_t snap_signature;
@@ -1723,6 +1949,13 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		goto fail;
 	fiber_set_joinable(memtx->gc_fiber, true);
 
+	stailq_create(&memtx->defrag_queue);
+	memtx->defrag_fiber = fiber_new_system("memtx.defrag",
+					       memtx_engine_defrag_f);
+	if (memtx->defrag_fiber == NULL)
+		goto fail;
+	fiber_set_joinable(memtx->defrag_fiber, true);
+
 	/*
 	 * Currently we have two quota consumers: tuple and index allocators.
 	 * The first one uses either SystemAlloc or memtx->slab_cache (in case
@@ -1766,6 +1999,9 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	quota_init(&memtx->quota, tuple_arena_max_size);
 	tuple_arena_create(&memtx->arena, &memtx->quota, tuple_arena_max_size,
 			   SLAB_SIZE, dontdump, "memtx");
+	/* Index extents share the arena so they get the same placement. */
+	tuple_arena_set_placement(&memtx->arena, huge_pages, numa_node,
+				  "memtx");
 	slab_cache_create(&memtx->slab_cache, &memtx->arena);
 	float actual_alloc_factor;
 	allocator_settings alloc_settings;
@@ -1838,6 +2074,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->on_indexes_built_cb = on_indexes_built;
 
 	fiber_start(memtx->gc_fiber, memtx);
+	fiber_start(memtx->defrag_fiber, memtx);
 	return memtx;
 fail:
 	xdir_destroy(&memtx->snap_dir);
@@ -1938,12 +2175,27 @@ memtx_engine_stat_index(struct memtx_engine *memtx, struct info_handler *h)
 	info_table_end(h); /* index */
 }
 
+/** Appends memtx arena defragmentation stats to info. */
+static void
+memtx_engine_stat_defrag(struct memtx_engine *memtx, struct info_handler *h)
+{
+	int64_t queue = 0;
+	struct memtx_defrag_task *task;
+	stailq_foreach_entry(task, &memtx->defrag_queue, link)
+		queue++;
+	info_table_begin(h, "defrag");
+	info_append_int(h, "queue", queue);
+	info_append_int(h, "relocated", memtx->defrag_relocated);
+	info_table_end(h); /* defrag */
+}
+
 void
 memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h)
 {
 	info_begin(h);
 	memtx_engine_stat_data(memtx, h);
 	memtx_engine_stat_index(memtx, h);
+	memtx_engine_stat_defrag(memtx, h);
 	memtx_engine_stat_tx(memtx, h);
 	info_end(h);
 }
@@ -2197,6 +2449,8 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.func_id != new_def->opts.func_id)
 		return true;
+	if (old_def->opts.filter_func_id != new_def->opts.filter_func_id)
+		return true;
 	if (old_def->opts.hint != new_def->opts.hint)
 		return true;
 
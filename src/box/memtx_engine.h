@@ -169,6 +169,19 @@ struct memtx_engine {
 	int sort_threads;
 	/** Set of extents allocated using malloc. */
 	struct mh_ptr_t *malloc_extents;
+	/**
+	 * Arena defragmentation fiber. Relocates tuples of spaces scheduled
+	 * with index:compact() so that they are packed densely in the slabs.
+	 */
+	struct fiber *defrag_fiber;
+	/**
+	 * Spaces scheduled for defragmentation, linked by
+	 * memtx_defrag_task::link. The first entry is the space
+	 * being processed.
+	 */
+	struct stailq defrag_queue;
+	/** Number of tuples relocated by the defragmentation fiber. */
+	int64_t defrag_relocated;
 };
 
 struct memtx_gc_task;
@@ -200,11 +213,27 @@ void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task);
 
+/**
+ * Schedule relocation of all tuples of a space in order to reduce
+ * fragmentation of the memtx arena. The work is done incrementally
+ * in a background fiber. Does nothing if the space is already queued.
+ */
+void
+memtx_engine_schedule_defrag(struct memtx_engine *memtx, uint32_t space_id);
+
+/**
+ * Creates the memtx engine.
+ *
+ * If @a huge_pages is set, the memory preallocated for tuples and index
+ * extents is backed with transparent huge pages. If @a numa_node is not
+ * negative, the memory is allocated from the given NUMA node if possible.
+ */
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		 bool dontdump, unsigned granularity,
-		 const char *allocator, float alloc_factor, int threads_num,
+		 bool dontdump, bool huge_pages, int numa_node,
+		 unsigned granularity, const char *allocator,
+		 float alloc_factor, int threads_num,
 		 memtx_on_indexes_built_cb on_indexes_built);
 
 /**
@@ -294,6 +323,13 @@ int
 memtx_index_get(struct index *index, const char *key, uint32_t part_count,
 		struct tuple **result);
 
+/**
+ * Common function for all memtx indexes. Schedules defragmentation
+ * of the space the index belongs to, see memtx_engine_schedule_defrag().
+ */
+void
+memtx_index_compact(struct index *index);
+
 /**
  * Common function for all memtx indexes. Iterate to the next tuple and
  * return it in @a ret in format in which, it should be visible for users.
@@ -322,16 +358,16 @@ memtx_tuple_validate(struct tuple_format *format, struct tuple *tuple);
 static inline struct memtx_engine *
 memtx_engine_new_xc(const char *snap_dirname, bool force_recovery,
 		    uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		    bool dontdump, unsigned granularity,
-		    const char *allocator, float alloc_factor,
-		    int sort_threads,
+		    bool dontdump, bool huge_pages, int numa_node,
+		    unsigned granularity, const char *allocator,
+		    float alloc_factor, int sort_threads,
 		    memtx_on_indexes_built_cb on_indexes_built)
 {
 	struct memtx_engine *memtx;
 	memtx = memtx_engine_new(snap_dirname, force_recovery,
 				 tuple_arena_max_size, objsize_min, dontdump,
-				 granularity, allocator, alloc_factor,
-				 sort_threads, on_indexes_built);
+				 huge_pages, numa_node, granularity, allocator,
+				 alloc_factor, sort_threads, on_indexes_built);
 	if (memtx == NULL)
 		diag_raise();
 	return memtx;
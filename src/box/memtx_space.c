@@ -203,6 +203,29 @@ memtx_space_replace_primary_key(struct space *space, struct tuple *old_tuple,
 	return 0;
 }
 
+void
+memtx_space_rollback_replace(struct space *space, uint32_t index_count,
+			     struct tuple *old_tuple, struct tuple *new_tuple,
+			     const char *partial_index_mask)
+{
+	for (uint32_t i = index_count; i > 0; i--) {
+		struct tuple *unused;
+		struct index *index = space->index[i - 1];
+		bool is_partial = index->def->opts.filter_func_id != 0;
+		/* Rollback must not fail. */
+		if (index_replace(index, new_tuple,
+				  is_partial ? NULL : old_tuple,
+				  DUP_INSERT, &unused, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+		if (unlikely(is_partial) && old_tuple != NULL &&
+		    bit_test(partial_index_mask, i - 1))
+			memtx_tree_index_restore(index, old_tuple);
+	}
+}
+
 /**
  * @brief A single method to handle REPLACE, DELETE and UPDATE.
  *
@@ -329,21 +352,122 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 		return -1;
 	assert(old_tuple || new_tuple);
 
+	/*
+	 * Partial indexes that stored the old tuple, so that it can be
+	 * restored on rollback without calling the filter functions.
+	 */
+	char partial_index_mask[BITMAP_SIZE(BOX_INDEX_MAX)];
+	memset(partial_index_mask, 0, sizeof(partial_index_mask));
+	bool has_partial_indexes = false;
+
 	/* Update secondary keys. */
 	for (i++; i < space->index_count; i++) {
-		struct tuple *unused;
+		struct tuple *replaced, *unused;
 		struct index *index = space->index[i];
 		if (index_replace(index, old_tuple, new_tuple,
-				  DUP_INSERT, &unused, &unused) != 0)
+				  DUP_INSERT, &replaced, &unused) != 0)
 			goto rollback;
+		if (unlikely(index->def->opts.filter_func_id != 0)) {
+			has_partial_indexes = true;
+			if (replaced != NULL)
+				bit_set(partial_index_mask, i);
+		}
 	}
 
+	if (has_partial_indexes && !space->def->opts.is_ephemeral) {
+		struct txn_stmt *stmt = txn_current_stmt(in_txn());
+		memcpy(stmt->rollback_info.partial_index_mask,
+		       partial_index_mask, sizeof(partial_index_mask));
+	}
 	memtx_space_update_tuple_stat(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
 		tuple_ref(new_tuple);
 	*result = old_tuple;
 	return 0;
 
+rollback:
+	memtx_space_rollback_replace(space, i, old_tuple, new_tuple,
+				     partial_index_mask);
+	return -1;
+}
+
+static int
+memtx_check_on_replace(struct trigger *trigger, void *event);
+
+static int
+memtx_build_on_replace(struct trigger *trigger, void *event);
+
+/**
+ * Returns true if an index build or a format check is in progress for
+ * the space. Their on_replace triggers keep pointers to the tuples of
+ * the space.
+ */
+static bool
+memtx_space_is_being_checked(struct space *space)
+{
+	struct trigger *trigger;
+	rlist_foreach_entry(trigger, &space->on_replace, link) {
+		if (trigger->run == memtx_check_on_replace ||
+		    trigger->run == memtx_build_on_replace)
+			return true;
+	}
+	return false;
+}
+
+bool
+memtx_space_can_relocate_tuples(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace != memtx_space_replace_all_keys)
+		return false;
+	if (space->def->opts.is_ephemeral || space->upgrade != NULL ||
+	    space->format->is_compressed)
+		return false;
+	/*
+	 * Relocation doesn't run on_replace triggers, which is fine for
+	 * user and materialized view triggers since the tuple data don't
+	 * change, but an index build or a format check keeps pointers to
+	 * tuples and can only be notified within a transaction statement.
+	 * System spaces are skipped: they are small, and their triggers
+	 * maintain the schema.
+	 */
+	if (space_is_system(space) || memtx_space_is_being_checked(space))
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index_def *index_def = space->index[i]->def;
+		if (index_def->key_def->for_func_index ||
+		    index_def->opts.filter_func_id != 0)
+			return false;
+	}
+	return true;
+}
+
+int
+memtx_space_relocate_tuple(struct space *space, struct tuple *old_tuple)
+{
+	assert(memtx_space_can_relocate_tuples(space));
+	assert(!tuple_has_flag(old_tuple, TUPLE_IS_DIRTY));
+	uint32_t bsize;
+	const char *data = tuple_data_range(old_tuple, &bsize);
+	struct tuple *new_tuple = memtx_tuple_new_raw(tuple_format(old_tuple),
+						      data, data + bsize,
+						      false);
+	if (new_tuple == NULL)
+		return -1;
+	/* The reference held by the primary index. */
+	tuple_ref(new_tuple);
+	uint32_t i;
+	for (i = 0; i < space->index_count; i++) {
+		struct tuple *unused;
+		struct index *index = space->index[i];
+		if (index_replace(index, old_tuple, new_tuple,
+				  i == 0 ? DUP_REPLACE : DUP_INSERT,
+				  &unused, &unused) != 0)
+			goto rollback;
+	}
+	memtx_space_update_tuple_stat(space, old_tuple, new_tuple);
+	tuple_unref(old_tuple);
+	return 0;
 rollback:
 	for (; i > 0; i--) {
 		struct tuple *unused;
@@ -356,6 +480,7 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 			panic("failed to rollback change");
 		}
 	}
+	tuple_unref(new_tuple);
 	return -1;
 }
 
@@ -764,6 +889,11 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->opts.filter_func_id != 0 && index_def->type != TREE) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type], "partial indexes");
+		return -1;
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -786,7 +916,13 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 		}
 		break;
 	case TREE:
-		/* TREE index has no limitations. */
+		if (index_def->opts.filter_func_id != 0 &&
+		    (key_def->is_multikey || key_def->for_func_index)) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "partial index can't be multikey or functional");
+			return -1;
+		}
 		break;
 	case RTREE:
 		if (key_def->part_count != 1) {
@@ -896,6 +1032,11 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 				 "Memtx MVCC engine", "multikey indexes");
 			return -1;
 		}
+		if (index_def->opts.filter_func_id != 0) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Memtx MVCC engine", "partial indexes");
+			return -1;
+		}
 		/*
 		 * Also, functional multikey indexes are not supported,
 		 * corresponding check can be found in a routine checking
@@ -90,6 +90,46 @@ int
 memtx_space_replace_all_keys(struct space *, struct tuple *, struct tuple *,
 			     enum dup_replace_mode, struct tuple **);
 
+/**
+ * Roll back a replace of @a old_tuple with @a new_tuple in the first
+ * @a index_count indexes of a space. The filter functions of partial
+ * indexes aren't called: @a old_tuple is put back to a partial index
+ * only if its bit is set in @a partial_index_mask. Never fails.
+ */
+void
+memtx_space_rollback_replace(struct space *space, uint32_t index_count,
+			     struct tuple *old_tuple, struct tuple *new_tuple,
+			     const char *partial_index_mask);
+
+/**
+ * Returns true if tuples of the space may be relocated with
+ * memtx_space_relocate_tuple(), i.e. the space is fully built and its
+ * tuples are not referenced by anything that depends on their address
+ * except indexes (functional index keys, compression, space upgrade,
+ * index build and format check triggers) and relocating them doesn't
+ * require calling user functions (partial index predicates). User
+ * on_replace triggers don't prevent relocation, because relocation
+ * doesn't change the tuple data and doesn't run them.
+ *
+ * The result may change on yield so it must be rechecked after each
+ * yield before relocating tuples.
+ */
+bool
+memtx_space_can_relocate_tuples(struct space *space);
+
+/**
+ * Moves a tuple to a freshly allocated memory chunk and makes all indexes
+ * of the space refer to the new copy. The old tuple loses the reference
+ * held by the space, so it is freed as soon as it isn't used by anyone
+ * else (including open read views). The tuple must be stored in the space
+ * and must not be dirty (managed by MVCC).
+ *
+ * Used for memtx arena defragmentation. On error returns -1 and sets diag,
+ * the space is left intact in this case.
+ */
+int
+memtx_space_relocate_tuple(struct space *space, struct tuple *old_tuple);
+
 struct space *
 memtx_space_new(struct memtx_engine *memtx,
 		struct space_def *def, struct rlist *key_list);
@@ -36,13 +36,17 @@
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
+#include "func.h"
+#include "func_cache.h"
 #include "key_list.h"
+#include "port.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tx.h"
 #include "trivia/config.h"
 #include "trivia/util.h"
 #include "tt_sort.h"
+#include "tt_static.h"
 #include <small/mempool.h>
 
 /**
@@ -217,6 +221,12 @@ struct memtx_tree_index {
 	memtx_tree_iterator_t<USE_HINT> gc_iterator;
 	/** Whether index is functional. */
 	bool is_func;
+	/**
+	 * Holder of the partial index predicate function. The function
+	 * is NULL until it's resolved, which may be deferred until the
+	 * index is built in case of initial recovery.
+	 */
+	struct func_cache_holder filter_holder;
 };
 
 /* {{{ Utilities. *************************************************/
@@ -1025,6 +1035,8 @@ memtx_tree_index_destroy(struct index *base)
 	struct memtx_tree_index<USE_HINT> *index =
 		(struct memtx_tree_index<USE_HINT> *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	if (index->filter_holder.func != NULL)
+		func_unpin(&index->filter_holder);
 	if (base->def->iid == 0 || index->is_func) {
 		/*
 		 * Primary index. We need to free all tuples stored
@@ -1330,6 +1342,73 @@ memtx_tree_index_get_internal(struct index *base, const char *key,
 	return 0;
 }
 
+/**
+ * Batched version of memtx_tree_index_get_internal() that descends
+ * the tree for a group of keys at once, see memtx_tree_find_batch().
+ * Used only for general (not multikey and not functional) indexes.
+ */
+template <bool USE_HINT>
+static int
+memtx_tree_index_get_many(struct index *base, const char **keys,
+			  uint32_t key_count, uint32_t part_count,
+			  struct tuple **results)
+{
+	assert(base->def->opts.is_unique &&
+	       part_count == base->def->key_def->part_count);
+	assert(!base->def->key_def->is_multikey &&
+	       !base->def->key_def->for_func_index);
+	struct memtx_tree_index<USE_HINT> *index =
+		(struct memtx_tree_index<USE_HINT> *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct txn *txn = in_txn();
+	struct space *space = space_by_id(base->def->space_id);
+	struct memtx_tree_key_data<USE_HINT> key_data[BPS_TREE_FIND_BATCH_SIZE];
+	struct memtx_tree_key_data<USE_HINT> *key_ptrs[BPS_TREE_FIND_BATCH_SIZE];
+	struct memtx_tree_data<USE_HINT> *found[BPS_TREE_FIND_BATCH_SIZE];
+	for (uint32_t first = 0; first < key_count;
+	     first += BPS_TREE_FIND_BATCH_SIZE) {
+		uint32_t n = MIN(key_count - first,
+				 (uint32_t)BPS_TREE_FIND_BATCH_SIZE);
+		for (uint32_t i = 0; i < n; i++) {
+			const char *key = keys[first + i];
+			key_data[i].key = key;
+			key_data[i].part_count = part_count;
+			if (USE_HINT) {
+				key_data[i].set_hint(key_hint(key, part_count,
+							      cmp_def));
+			}
+			key_ptrs[i] = &key_data[i];
+		}
+		memtx_tree_find_batch(&index->tree, key_ptrs, n, found);
+		for (uint32_t i = 0; i < n; i++) {
+			struct tuple **result = &results[first + i];
+			if (found[i] == NULL) {
+				*result = NULL;
+				memtx_tx_track_point(txn, space, base,
+						     keys[first + i]);
+				continue;
+			}
+			*result = memtx_tx_tuple_clarify(txn, space,
+							 found[i]->tuple,
+							 base, 0);
+			if (memtx_prepare_result_tuple(space, result) != 0) {
+				for (uint32_t j = 0; j < first + i; j++) {
+					if (results[j] != NULL)
+						tuple_unref(results[j]);
+				}
+				return -1;
+			}
+			/*
+			 * The tuple may be kept alive only until the next
+			 * call to tuple_bless(), see get_many() contract.
+			 */
+			if (*result != NULL)
+				tuple_ref(*result);
+		}
+	}
+	return 0;
+}
+
 /**
  * Implementation of iterator position for general and multikey indexes.
  */
@@ -1433,6 +1512,76 @@ tree_iterator_position_func(struct iterator *it, const char **pos,
 						pos, size);
 }
 
+/**
+ * Resolve and pin the predicate function of a partial index.
+ * Returns -1 and sets diag if the function doesn't exist.
+ */
+static int
+memtx_tree_index_filter_pin(struct index *base,
+			    struct func_cache_holder *holder)
+{
+	assert(holder->func == NULL);
+	struct index_def *def = base->def;
+	struct func *func = func_by_id(def->opts.filter_func_id);
+	if (func == NULL) {
+		diag_set(ClientError, ER_INDEX_FILTER_FUNC, def->name,
+			 def->space_name, tt_sprintf("function '%u' was not "
+						     "found by ID",
+						     def->opts.filter_func_id));
+		return -1;
+	}
+	func_pin(func, holder, FUNC_HOLDER_INDEX_FILTER);
+	return 0;
+}
+
+/**
+ * Call the predicate function of a partial index for a tuple.
+ * Returns 1 if the tuple must be stored in the index, 0 if it
+ * must be skipped, -1 on error (diag is set).
+ */
+static int
+memtx_tree_index_filter(struct index *base, struct func_cache_holder *holder,
+			struct tuple *tuple)
+{
+	struct index_def *def = base->def;
+	assert(def->opts.filter_func_id != 0);
+	if (holder->func == NULL &&
+	    memtx_tree_index_filter_pin(base, holder) != 0)
+		return -1;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct port out_port, in_port;
+	port_c_create(&in_port);
+	port_c_add_tuple(&in_port, tuple);
+	int rc = func_call_no_access_check(holder->func, &in_port, &out_port);
+	port_destroy(&in_port);
+	if (rc != 0) {
+		diag_add(ClientError, ER_INDEX_FILTER_FUNC, def->name,
+			 def->space_name, "can't evaluate function");
+		return -1;
+	}
+	uint32_t ret_size;
+	const char *ret = port_get_msgpack(&out_port, &ret_size);
+	port_destroy(&out_port);
+	if (ret == NULL) {
+		diag_add(ClientError, ER_INDEX_FILTER_FUNC, def->name,
+			 def->space_name,
+			 "can't get a value returned by function");
+		return -1;
+	}
+	assert(mp_typeof(*ret) == MP_ARRAY);
+	if (mp_decode_array(&ret) != 1 || mp_typeof(*ret) != MP_BOOL) {
+		diag_set(ClientError, ER_INDEX_FILTER_FUNC, def->name,
+			 def->space_name, "function must return a boolean");
+		rc = -1;
+	} else {
+		rc = mp_decode_bool(&ret) ? 1 : 0;
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 template <bool USE_HINT>
 static int
 memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
@@ -1443,8 +1592,17 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 		(struct memtx_tree_index<USE_HINT> *)base;
 	struct key_def *key_def = base->def->key_def;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
-	if (new_tuple != NULL &&
-	    !tuple_key_is_excluded(new_tuple, key_def, MULTIKEY_NONE)) {
+	bool is_partial = base->def->opts.filter_func_id != 0;
+	bool insert_new = new_tuple != NULL &&
+		!tuple_key_is_excluded(new_tuple, key_def, MULTIKEY_NONE);
+	if (insert_new && unlikely(is_partial)) {
+		int rc = memtx_tree_index_filter(base, &index->filter_holder,
+						 new_tuple);
+		if (rc < 0)
+			return -1;
+		insert_new = rc > 0;
+	}
+	if (insert_new) {
 		struct memtx_tree_data<USE_HINT> new_data;
 		new_data.tuple = new_tuple;
 		if (USE_HINT)
@@ -1474,8 +1632,26 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			return 0;
 		}
 	}
-	if (old_tuple != NULL &&
-	    !tuple_key_is_excluded(old_tuple, key_def, MULTIKEY_NONE)) {
+	if (old_tuple != NULL && unlikely(is_partial)) {
+		/*
+		 * Don't call the filter function for the old tuple so
+		 * that deletion never fails: just remove the tuple if
+		 * it's present in the index. Deletion by value is used,
+		 * because a tuple with the same key that passed the
+		 * filter may be stored in a unique index. Whether the
+		 * tuple was removed is returned in @a result so that
+		 * the caller can restore it on rollback without calling
+		 * the filter function, see memtx_tree_index_restore().
+		 */
+		struct memtx_tree_data<USE_HINT> old_data, deleted_data;
+		old_data.tuple = old_tuple;
+		if (USE_HINT)
+			old_data.set_hint(tuple_hint(old_tuple, cmp_def));
+		deleted_data.tuple = NULL;
+		memtx_tree_delete_value(&index->tree, old_data, &deleted_data);
+		*result = deleted_data.tuple;
+	} else if (old_tuple != NULL &&
+		   !tuple_key_is_excluded(old_tuple, key_def, MULTIKEY_NONE)) {
 		struct memtx_tree_data<USE_HINT> old_data;
 		old_data.tuple = old_tuple;
 		if (USE_HINT)
@@ -1488,6 +1664,34 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 	return 0;
 }
 
+template <bool USE_HINT>
+static void
+memtx_tree_index_restore_tpl(struct index *base, struct tuple *tuple)
+{
+	struct memtx_tree_index<USE_HINT> *index =
+		(struct memtx_tree_index<USE_HINT> *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct memtx_tree_data<USE_HINT> data;
+	data.tuple = tuple;
+	if (USE_HINT)
+		data.set_hint(tuple_hint(tuple, cmp_def));
+	/* Memory for the insertion is reserved before the replace. */
+	if (memtx_tree_insert(&index->tree, data, NULL, NULL) != 0)
+		panic("failed to restore a tuple in a partial index");
+}
+
+void
+memtx_tree_index_restore(struct index *index, struct tuple *tuple)
+{
+	assert(index->def->opts.filter_func_id != 0);
+	assert(!index->def->key_def->is_multikey &&
+	       !index->def->key_def->for_func_index);
+	if (index->def->opts.hint == INDEX_HINT_ON)
+		memtx_tree_index_restore_tpl<true>(index, tuple);
+	else
+		memtx_tree_index_restore_tpl<false>(index, tuple);
+}
+
 /**
  * Perform tuple insertion by given multikey index.
  * In case of replacement, all old tuple entries are deleted
@@ -1975,6 +2179,11 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 {
 	struct memtx_tree_index<USE_HINT> *index =
 		(struct memtx_tree_index<USE_HINT> *)base;
+	/* Resolve the filter function deferred by initial recovery. */
+	if (base->def->opts.filter_func_id != 0 &&
+	    index->filter_holder.func == NULL &&
+	    memtx_tree_index_filter_pin(base, &index->filter_holder) != 0)
+		return -1;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
 	struct memtx_tree_data<USE_HINT> *tmp =
@@ -2037,6 +2246,12 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 		return 0;
 	struct memtx_tree_index<USE_HINT> *index =
 		(struct memtx_tree_index<USE_HINT> *)base;
+	if (unlikely(base->def->opts.filter_func_id != 0)) {
+		int rc = memtx_tree_index_filter(base, &index->filter_holder,
+						 tuple);
+		if (rc <= 0)
+			return rc;
+	}
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	return memtx_tree_index_build_array_append(index, tuple,
 						   tuple_hint(tuple, cmp_def));
@@ -2293,16 +2508,19 @@ tree_read_view_iterator_start(struct tree_read_view_iterator<USE_HINT> *it,
 	assert(key == NULL);
 	assert(part_count == 0);
 	assert(pos == NULL);
-	assert(offset == 0);
 	(void)type;
 	(void)key;
 	(void)part_count;
 	(void)pos;
-	(void)offset;
 	struct tree_read_view<USE_HINT> *rv =
 		(struct tree_read_view<USE_HINT> *)it->base.index;
 	it->base.next_raw = tree_read_view_iterator_next_raw<USE_HINT>;
-	it->tree_iterator = memtx_tree_view_first(&rv->tree_view);
+	if (offset == 0) {
+		it->tree_iterator = memtx_tree_view_first(&rv->tree_view);
+	} else {
+		it->tree_iterator = memtx_tree_view_iterator_at(&rv->tree_view,
+								offset);
+	}
 	return 0;
 }
 
@@ -2442,6 +2660,7 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .count = */ generic_index_count,
 	/* .get_internal = */ generic_index_get_internal,
 	/* .get = */ generic_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ disabled_index_replace,
 	/* .create_iterator = */ generic_index_create_iterator,
 	/* .create_iterator_with_offset = */
@@ -2506,6 +2725,8 @@ get_memtx_tree_index_vtab(void)
 		/* .count = */ memtx_tree_index_count<USE_HINT>,
 		/* .get_internal */ memtx_tree_index_get_internal<USE_HINT>,
 		/* .get = */ memtx_index_get,
+		/* .get_many = */ is_mk || is_func ? generic_index_get_many :
+				   memtx_tree_index_get_many<USE_HINT>,
 		/* .replace = */ is_mk ? memtx_tree_index_replace_multikey :
 				 is_func ? memtx_tree_func_index_replace :
 				 memtx_tree_index_replace<USE_HINT>,
@@ -2517,7 +2738,7 @@ get_memtx_tree_index_vtab(void)
 		/* .create_read_view = */
 			memtx_tree_index_create_read_view<USE_HINT>,
 		/* .stat = */ generic_index_stat,
-		/* .compact = */ generic_index_compact,
+		/* .compact = */ memtx_index_compact,
 		/* .reset_stat = */ generic_index_reset_stat,
 		/* .begin_build = */ memtx_tree_index_begin_build<USE_HINT>,
 		/* .reserve = */ memtx_tree_index_reserve<USE_HINT>,
@@ -2548,6 +2769,18 @@ memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
 			  &memtx->index_extent_allocator,
 			  &memtx->index_extent_stats);
 	index->is_func = def->key_def->func_index_func != NULL;
+	/*
+	 * During initial recovery the function cache isn't loaded yet
+	 * so the filter function is resolved when secondary keys are
+	 * built, see memtx_tree_index_reserve().
+	 */
+	if (def->opts.filter_func_id != 0 &&
+	    recovery_state > INITIAL_RECOVERY &&
+	    memtx_tree_index_filter_pin(&index->base,
+					&index->filter_holder) != 0) {
+		index_unref(&index->base);
+		return NULL;
+	}
 	return &index->base;
 }
 
@@ -38,10 +38,19 @@ extern "C" {
 struct index;
 struct index_def;
 struct memtx_engine;
+struct tuple;
 
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Put a tuple back to a partial tree index without calling the index
+ * filter function. Used on rollback of a statement that deleted the
+ * tuple from the index. Never fails.
+ */
+void
+memtx_tree_index_restore(struct index *index, struct tuple *tuple);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
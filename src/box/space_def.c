@@ -43,6 +43,7 @@ const struct space_opts space_opts_default = {
 	/* .type = */ SPACE_TYPE_NORMAL,
 	/* .is_ephemeral = */ false,
 	/* .view = */ false,
+	/* .is_materialized = */ false,
 	/* .is_sync = */ false,
 	/* .defer_deletes = */ false,
 	/* .sql        = */ NULL,
@@ -95,6 +96,7 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("group_id", OPT_UINT32, struct space_opts, group_id),
 	OPT_DEF_CUSTOM("temporary", space_opts_parse_temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
+	OPT_DEF("materialized", OPT_BOOL, struct space_opts, is_materialized),
 	OPT_DEF("is_sync", OPT_BOOL, struct space_opts, is_sync),
 	OPT_DEF("defer_deletes", OPT_BOOL, struct space_opts, defer_deletes),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
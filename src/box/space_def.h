@@ -100,6 +100,12 @@ struct space_opts {
 	 * this flag can't be changed after space creation.
 	 */
 	bool is_view;
+	/**
+	 * If the space is a materialized view, then its rows are
+	 * maintained on changes of the space read by the SQL
+	 * statement. The flag can't be changed after space creation.
+	 */
+	bool is_materialized;
 	/**
 	 * Synchronous space makes all transactions, affecting its
 	 * data, synchronous. That means they are not applied
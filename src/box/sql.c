@@ -36,6 +36,7 @@
 #include "sql/tarantoolInt.h"
 #include "sql/mem.h"
 #include "sql/vdbeInt.h"
+#include "sql/analyze.h"
 
 #include "index.h"
 #include "info/info.h"
@@ -143,7 +144,7 @@ int
 key_alloc(BtCursor *c, size_t key_size);
 
 static int
-cursor_seek(BtCursor *pCur, int *pRes);
+cursor_seek(BtCursor *pCur, uint32_t offset, int *pRes);
 
 static int
 cursor_advance(BtCursor *pCur, int *pRes);
@@ -162,13 +163,14 @@ const void *tarantoolsqlPayloadFetch(BtCursor *pCur, u32 *pAmt)
  * Set cursor to the first tuple in given space.
  * It is a simple wrapper around cursor_seek().
  */
-int tarantoolsqlFirst(BtCursor *pCur, int *pRes)
+int
+tarantoolsqlFirst(struct BtCursor *pCur, uint32_t offset, int *pRes)
 {
 	if (key_alloc(pCur, sizeof(nil_key)) != 0)
 		return -1;
 	memcpy(pCur->key, nil_key, sizeof(nil_key));
 	pCur->iter_type = ITER_GE;
-	return cursor_seek(pCur, pRes);
+	return cursor_seek(pCur, offset, pRes);
 }
 
 /* Set cursor to the last tuple in given space. */
@@ -178,7 +180,7 @@ int tarantoolsqlLast(BtCursor *pCur, int *pRes)
 		return -1;
 	memcpy(pCur->key, nil_key, sizeof(nil_key));
 	pCur->iter_type = ITER_LE;
-	return cursor_seek(pCur, pRes);
+	return cursor_seek(pCur, 0, pRes);
 }
 
 /*
@@ -226,7 +228,7 @@ sql_cursor_seek(struct BtCursor *cur, struct Mem *mems, uint32_t len, int *res)
 		return -1;
 	memcpy(cur->key, tuple, size);
 	region_truncate(region, used);
-	return cursor_seek(cur, res);
+	return cursor_seek(cur, 0, res);
 }
 
 /*
@@ -864,6 +866,7 @@ key_alloc(BtCursor *cur, size_t key_size)
  * given key. If cursor already contains iterator, it will be freed.
  *
  * @param pCur Cursor which points to space.
+ * @param offset Number of tuples to skip.
  * @param pRes Flag which is == 0 if reached end of space, == 1 otherwise.
  * @param type Type of Tarantool iterator.
  * @param key Start of buffer containing key.
@@ -872,7 +875,7 @@ key_alloc(BtCursor *cur, size_t key_size)
  * @retval 0 on success, -1 otherwise.
  */
 static int
-cursor_seek(BtCursor *pCur, int *pRes)
+cursor_seek(BtCursor *pCur, uint32_t offset, int *pRes)
 {
 	/* Close existing iterator, if any */
 	if (pCur->iter) {
@@ -893,8 +896,9 @@ cursor_seek(BtCursor *pCur, int *pRes)
 	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn, &svp) != 0)
 		return -1;
 	struct iterator *it =
-		index_create_iterator(pCur->index, pCur->iter_type, key,
-				      part_count);
+		index_create_iterator_with_offset(pCur->index, pCur->iter_type,
+						  key, part_count, NULL,
+						  offset);
 	if (txn != NULL)
 		txn_end_ro_stmt(txn, &svp);
 	if (it == NULL) {
@@ -1078,13 +1082,14 @@ sql_encode_table_opts(struct region *region, struct space_def *def,
 	mpstream_init(&stream, region, region_reserve_cb, region_alloc_cb,
 		      set_encode_error, &is_error);
 	bool is_view = def->opts.is_view;
-	mpstream_encode_map(&stream, 2 * is_view);
+	bool is_materialized = def->opts.is_materialized;
+	mpstream_encode_map(&stream, 2 * (is_view || is_materialized));
 
-	if (is_view) {
+	if (is_view || is_materialized) {
 		assert(def->opts.sql != NULL);
 		mpstream_encode_str(&stream, "sql");
 		mpstream_encode_str(&stream, def->opts.sql);
-		mpstream_encode_str(&stream, "view");
+		mpstream_encode_str(&stream, is_view ? "view" : "materialized");
 		mpstream_encode_bool(&stream, true);
 	}
 	mpstream_flush(&stream);
@@ -1271,8 +1276,10 @@ vdbe_field_ref_fill(struct vdbe_field_ref *field_ref, struct tuple *tuple,
 	field_ref->format = NULL;
 	field_ref->field_count = MIN(field_ref->field_capacity, mp_count);
 	field_ref->slots[0] = 0;
+	/* Only the slots initialized for the previous data are reset. */
 	memset(&field_ref->slots[1], 0,
-	       field_ref->field_count * sizeof(field_ref->slots[0]));
+	       field_ref->slot_max * sizeof(field_ref->slots[0]));
+	field_ref->slot_max = 0;
 	field_ref->slot_bitmask = 0;
 	bitmask64_set_bit(&field_ref->slot_bitmask, 0);
 }
@@ -1295,7 +1302,7 @@ vdbe_field_ref_prepare_tuple(struct vdbe_field_ref *field_ref,
 	uint32_t data_sz = tuple_bsize(tuple);
 	const char *field0 = data;
 	uint32_t mp_count = mp_decode_array(&field0);
-	vdbe_field_ref_fill(field_ref, NULL, mp_count, field0,
+	vdbe_field_ref_fill(field_ref, tuple, mp_count, field0,
 			    (uint32_t)(field0 - data) + data_sz);
 }
 
@@ -1311,6 +1318,7 @@ vdbe_field_ref_create(struct vdbe_field_ref *ref, uint32_t capacity)
 {
 	memset(ref, 0, sizeof(*ref) + capacity * sizeof(ref->slots[0]));
 	ref->field_capacity = capacity;
+	ref->column_mask = COLUMN_MASK_FULL;
 }
 
 ssize_t
@@ -1381,6 +1389,20 @@ index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 	if (field == idx_def->key_def->part_count &&
 	    idx_def->opts.is_unique)
 		return 0;
+	struct sql_index_stat *stat = sql_index_stat_get(idx_def);
+	if (stat != NULL) {
+		/*
+		 * The statistics can be stale, so the number of tuples is
+		 * taken from the index and the average number of tuples
+		 * with the same key can't exceed it.
+		 */
+		struct index *index = space_index(space, idx_def->iid);
+		ssize_t size = index_size(index);
+		LogEst size_est = sqlLogEst(size > 0 ? size : 1);
+		if (field == 0)
+			return size_est;
+		return MIN(stat->tuple_log_est[field - 1], size_est);
+	}
 	return default_tuple_est[field + 1 >= 6 ? 6 : field];
 }
 
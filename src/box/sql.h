@@ -359,6 +359,18 @@ struct vdbe_field_ref {
 	 * extra tuple decoding as possible.
 	 */
 	uint64_t slot_bitmask;
+	/**
+	 * Mask of the fields used by the statement, see column_mask.h.
+	 * Offsets of the fields that are not in the mask aren't saved
+	 * to the slots when the tuple is decoded. COLUMN_MASK_FULL by
+	 * default.
+	 */
+	uint64_t column_mask;
+	/**
+	 * The greatest number of a slot initialized since the tuple
+	 * data was set. All the slots after it are zero.
+	 */
+	uint32_t slot_max;
 	/**
 	 * Array of offsets of tuple fields.
 	 * Only values <= rightmost_slot are valid.
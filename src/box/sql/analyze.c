@@ -0,0 +1,420 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "analyze.h"
+
+#include "sqlInt.h"
+#include "box/index.h"
+#include "box/schema.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "diag.h"
+#include "fiber.h"
+#include "small/region.h"
+#include "msgpuck/msgpuck.h"
+
+enum {
+	/**
+	 * Maximal number of bounds collected during a scan. When the
+	 * index turns out to be bigger than expected (the size of vinyl
+	 * indexes is approximate), every other bound is dropped.
+	 */
+	SQL_STAT_BOUND_MAX = 2 * SQL_STAT_BUCKET_COUNT,
+};
+
+/** Check if the statistics can be collected for the index. */
+static bool
+sql_index_stat_is_supported(const struct index *index)
+{
+	const struct key_def *key_def = index->def->key_def;
+	return index->def->type == TREE && !key_def->is_multikey &&
+	       !key_def->for_func_index;
+}
+
+/** Copy the first key part of the tuple to the region. */
+static const char *
+sql_index_stat_bound_new(struct tuple *tuple, struct key_def *key_def,
+			 struct region *region)
+{
+	const char *field = tuple_field_by_part(tuple, &key_def->parts[0],
+						MULTIKEY_NONE);
+	if (field == NULL) {
+		char *nil = xregion_alloc(region, mp_sizeof_nil());
+		mp_encode_nil(nil);
+		return nil;
+	}
+	const char *end = field;
+	mp_next(&end);
+	char *bound = xregion_alloc(region, end - field);
+	memcpy(bound, field, end - field);
+	return bound;
+}
+
+/**
+ * Return the number of the first key part the tuple differs from the
+ * previous one in or the number of key parts if the keys are equal.
+ */
+static uint32_t
+sql_index_stat_diff(struct tuple *prev, struct tuple *tuple,
+		    struct key_def *key_def)
+{
+	const char *key = tuple_extract_key(tuple, key_def, MULTIKEY_NONE,
+					    NULL);
+	mp_decode_array(&key);
+	uint32_t part_count = key_def->part_count;
+	for (uint32_t i = 0; i < part_count; i++) {
+		if (tuple_compare_with_key(prev, HINT_NONE, key, i + 1,
+					   HINT_NONE, key_def) != 0)
+			return i;
+	}
+	return part_count;
+}
+
+/**
+ * Collect the statistics of the index by a full scan. The statistics
+ * are allocated with malloc() as a single chunk of memory.
+ */
+static struct sql_index_stat *
+sql_index_stat_collect(struct index *index)
+{
+	struct key_def *key_def = index->def->key_def;
+	uint32_t part_count = key_def->part_count;
+	ssize_t size = index_size(index);
+	if (size < 0)
+		return NULL;
+	uint64_t step = size / SQL_STAT_BUCKET_COUNT;
+	if (step == 0)
+		step = 1;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint64_t *distinct = xregion_alloc_array(region, uint64_t, part_count);
+	memset(distinct, 0, part_count * sizeof(*distinct));
+	const char **bounds = xregion_alloc_array(region, const char *,
+						  SQL_STAT_BOUND_MAX + 1);
+	uint32_t bound_count = 0;
+	uint64_t tuple_count = 0;
+	uint64_t null_count = 0;
+	struct iterator *it = index_create_iterator(index, ITER_ALL, NULL, 0);
+	if (it == NULL) {
+		region_truncate(region, region_svp);
+		return NULL;
+	}
+	struct tuple *prev = NULL;
+	bool is_last_bound = false;
+	int rc = 0;
+	while (true) {
+		/* Keys extracted for comparisons are freed after each step. */
+		size_t step_svp = region_used(region);
+		struct tuple *tuple;
+		if ((rc = iterator_next(it, &tuple)) != 0 || tuple == NULL)
+			break;
+		const char *field = tuple_field_by_part(tuple,
+							&key_def->parts[0],
+							MULTIKEY_NONE);
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			null_count++;
+		uint32_t diff = prev == NULL ? 0 :
+				sql_index_stat_diff(prev, tuple, key_def);
+		for (uint32_t i = diff; i < part_count; i++)
+			distinct[i]++;
+		region_truncate(region, step_svp);
+		is_last_bound = false;
+		if (tuple_count % step == 0 &&
+		    bound_count == SQL_STAT_BOUND_MAX) {
+			for (uint32_t i = 0; i < bound_count / 2; i++)
+				bounds[i] = bounds[2 * i];
+			bound_count /= 2;
+			step *= 2;
+		}
+		if (tuple_count % step == 0) {
+			bounds[bound_count++] =
+				sql_index_stat_bound_new(tuple, key_def,
+							 region);
+			is_last_bound = true;
+		}
+		tuple_ref(tuple);
+		if (prev != NULL)
+			tuple_unref(prev);
+		prev = tuple;
+		tuple_count++;
+	}
+	iterator_delete(it);
+	if (prev != NULL && rc == 0 && !is_last_bound) {
+		bounds[bound_count++] =
+			sql_index_stat_bound_new(prev, key_def, region);
+	}
+	if (prev != NULL)
+		tuple_unref(prev);
+	if (rc != 0) {
+		region_truncate(region, region_svp);
+		return NULL;
+	}
+
+	size_t bounds_size = 0;
+	for (uint32_t i = 0; i < bound_count; i++) {
+		const char *end = bounds[i];
+		mp_next(&end);
+		bounds_size += end - bounds[i];
+	}
+	struct sql_index_stat *stat;
+	size_t alloc_size = sizeof(*stat) +
+			    bound_count * sizeof(stat->bounds[0]) +
+			    part_count * sizeof(stat->tuple_log_est[0]) +
+			    bounds_size;
+	stat = xmalloc(alloc_size);
+	stat->tuple_count = tuple_count;
+	stat->null_count = null_count;
+	stat->bound_count = bound_count;
+	stat->bounds = (const char **)(stat + 1);
+	stat->tuple_log_est = (int16_t *)(stat->bounds + bound_count);
+	for (uint32_t i = 0; i < part_count; i++) {
+		uint64_t count = distinct[i] == 0 ? 0 :
+				 DIV_ROUND_UP(tuple_count, distinct[i]);
+		stat->tuple_log_est[i] = sqlLogEst(count);
+	}
+	char *data = (char *)(stat->tuple_log_est + part_count);
+	for (uint32_t i = 0; i < bound_count; i++) {
+		const char *end = bounds[i];
+		mp_next(&end);
+		memcpy(data, bounds[i], end - bounds[i]);
+		stat->bounds[i] = data;
+		data += end - bounds[i];
+	}
+	region_truncate(region, region_svp);
+	return stat;
+}
+
+int
+sql_analyze_space(uint32_t space_id)
+{
+	struct space *space = space_by_id(space_id);
+	if (space == NULL || space->def->opts.is_view)
+		return 0;
+	if (access_check_space(space, PRIV_R) != 0)
+		return -1;
+	/*
+	 * The scan of a vinyl index can yield, so the space is looked up
+	 * again for each index: it can be altered or dropped meanwhile.
+	 */
+	for (uint32_t iid = 0; ; iid++) {
+		space = space_by_id(space_id);
+		if (space == NULL || iid > space->index_id_max)
+			break;
+		struct index *index = space_index(space, iid);
+		if (index == NULL || !sql_index_stat_is_supported(index))
+			continue;
+		index_ref(index);
+		struct sql_index_stat *stat = sql_index_stat_collect(index);
+		if (stat == NULL) {
+			index_unref(index);
+			return -1;
+		}
+		free(index->sql_stat);
+		index->sql_stat = stat;
+		index_unref(index);
+	}
+	return 0;
+}
+
+/** Return the index with the given definition or NULL. */
+static struct index *
+sql_index_by_def(const struct index_def *def)
+{
+	struct space *space = space_by_id(def->space_id);
+	if (space == NULL)
+		return NULL;
+	struct index *index = space_index(space, def->iid);
+	if (index == NULL || index->def->key_def->part_count <
+			     def->key_def->part_count)
+		return NULL;
+	return index;
+}
+
+struct sql_index_stat *
+sql_index_stat_get(const struct index_def *def)
+{
+	struct index *index = sql_index_by_def(def);
+	return index != NULL ? index->sql_stat : NULL;
+}
+
+/**
+ * Encode the constant as a value of the first key part of the index on
+ * the region. Only integer and string literals that can be compared with
+ * values of the key part are supported.
+ *
+ * @retval NULL if the constant is not supported.
+ */
+static const char *
+sql_index_stat_value_new(struct Expr *expr, const struct key_part *part,
+			 struct region *region)
+{
+	if (expr == NULL)
+		return NULL;
+	bool is_neg = false;
+	if (expr->op == TK_UMINUS) {
+		is_neg = true;
+		expr = expr->pLeft;
+	}
+	if (expr->op == TK_STRING && !is_neg) {
+		if (part->type != FIELD_TYPE_STRING &&
+		    part->type != FIELD_TYPE_SCALAR)
+			return NULL;
+		uint32_t len = strlen(expr->u.zToken);
+		char *value = xregion_alloc(region, mp_sizeof_str(len));
+		mp_encode_str(value, expr->u.zToken, len);
+		return value;
+	}
+	if (expr->op != TK_INTEGER)
+		return NULL;
+	uint64_t u;
+	if (ExprHasProperty(expr, EP_IntValue)) {
+		u = expr->u.iValue;
+	} else {
+		const char *z = expr->u.zToken;
+		int64_t i;
+		bool unused;
+		if (z[0] == '0' && (z[1] == 'x' || z[1] == 'X'))
+			return NULL;
+		if (sql_atoi64(z, &i, &unused, strlen(z)) != 0)
+			return NULL;
+		u = (uint64_t)i;
+	}
+	if (is_neg && u > (uint64_t)INT64_MAX + 1)
+		return NULL;
+	is_neg = is_neg && u != 0;
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+		if (is_neg)
+			return NULL;
+		break;
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_NUMBER:
+	case FIELD_TYPE_SCALAR:
+		break;
+	default:
+		return NULL;
+	}
+	char *value = xregion_alloc(region, 9);
+	if (is_neg)
+		mp_encode_int(value, (int64_t)(0 - u));
+	else
+		mp_encode_uint(value, u);
+	return value;
+}
+
+/**
+ * Return the number of bounds of the histogram less than the value or,
+ * if @a is_inclusive is set, less than or equal to the value.
+ */
+static uint32_t
+sql_index_stat_rank(const struct sql_index_stat *stat,
+		    struct key_def *key_def, const char *value,
+		    bool is_inclusive)
+{
+	uint32_t rank = 0;
+	for (uint32_t i = 0; i < stat->bound_count; i++) {
+		int rc = key_compare(stat->bounds[i], 1, HINT_NONE,
+				     value, 1, HINT_NONE, key_def);
+		if (rc < 0 || (rc == 0 && is_inclusive))
+			rank++;
+		else
+			break;
+	}
+	return rank;
+}
+
+bool
+sql_index_stat_eq_est(const struct index_def *def, struct Expr *value,
+		      int16_t *est)
+{
+	struct index *index = sql_index_by_def(def);
+	if (index == NULL || index->sql_stat == NULL ||
+	    index->sql_stat->bound_count < 2)
+		return false;
+	struct sql_index_stat *stat = index->sql_stat;
+	struct key_def *key_def = index->def->key_def;
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	const char *key = sql_index_stat_value_new(value, &key_def->parts[0],
+						   region);
+	uint32_t count = 0;
+	if (key != NULL) {
+		count = sql_index_stat_rank(stat, key_def, key, true) -
+			sql_index_stat_rank(stat, key_def, key, false);
+	}
+	region_truncate(region, svp);
+	if (count < 2)
+		return false;
+	ssize_t size = index_size(index);
+	if (size < 0)
+		return false;
+	*est = sqlLogEst(size * (count - 1) / (stat->bound_count - 1));
+	return true;
+}
+
+bool
+sql_index_stat_null_est(const struct index_def *def, int16_t *est)
+{
+	struct index *index = sql_index_by_def(def);
+	if (index == NULL || index->sql_stat == NULL ||
+	    index->sql_stat->tuple_count == 0)
+		return false;
+	struct sql_index_stat *stat = index->sql_stat;
+	ssize_t size = index_size(index);
+	if (size < 0)
+		return false;
+	uint64_t count = size * stat->null_count / stat->tuple_count;
+	*est = sqlLogEst(count > 0 ? count : 1);
+	return true;
+}
+
+bool
+sql_index_stat_range_est(const struct index_def *def, struct Expr *lower,
+			 bool is_lower_strict, struct Expr *upper,
+			 bool is_upper_strict, int16_t *est)
+{
+	struct index *index = sql_index_by_def(def);
+	if (index == NULL || index->sql_stat == NULL ||
+	    index->sql_stat->bound_count < 2)
+		return false;
+	struct sql_index_stat *stat = index->sql_stat;
+	struct key_def *key_def = index->def->key_def;
+	struct key_part *part = &key_def->parts[0];
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	const char *lower_key = lower == NULL ? NULL :
+				sql_index_stat_value_new(lower, part, region);
+	const char *upper_key = upper == NULL ? NULL :
+				sql_index_stat_value_new(upper, part, region);
+	if ((lower != NULL && lower_key == NULL) ||
+	    (upper != NULL && upper_key == NULL)) {
+		region_truncate(region, svp);
+		return false;
+	}
+	/* Bounds that fall into the range. */
+	uint32_t begin = 0;
+	uint32_t end = stat->bound_count;
+	if (lower_key != NULL) {
+		begin = sql_index_stat_rank(stat, key_def, lower_key,
+					    is_lower_strict);
+	}
+	if (upper_key != NULL) {
+		end = sql_index_stat_rank(stat, key_def, upper_key,
+					  !is_upper_strict);
+	}
+	region_truncate(region, svp);
+	ssize_t size = index_size(index);
+	if (size < 0)
+		return false;
+	uint64_t count = end > begin ?
+			 size * (end - begin) / stat->bound_count : 0;
+	/* The range can lie between two neighbouring bounds. */
+	uint64_t min_count = size / (2 * (stat->bound_count - 1));
+	if (count < min_count)
+		count = min_count;
+	*est = sqlLogEst(count > 0 ? count : 1);
+	return true;
+}
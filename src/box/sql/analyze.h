@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Expr;
+struct index;
+struct index_def;
+
+enum {
+	/**
+	 * Number of buckets of the histogram of the first key part. The
+	 * histogram has one more bound than buckets.
+	 */
+	SQL_STAT_BUCKET_COUNT = 32,
+};
+
+/**
+ * Statistics of an index collected by the ANALYZE statement. The
+ * statistics are kept in memory with the index (see index::sql_stat)
+ * and used by the query planner to estimate the number of rows selected
+ * by a search.
+ */
+struct sql_index_stat {
+	/** Number of tuples in the index at the moment of the analysis. */
+	uint64_t tuple_count;
+	/** Number of tuples with NULL in the first key part. */
+	uint64_t null_count;
+	/**
+	 * Equi-depth histogram of the first key part: MsgPack values of
+	 * the first key part of tuples taken with the same step in the
+	 * index order, the first and the last tuples included.
+	 */
+	const char **bounds;
+	/**
+	 * Logarithmic estimates (see sqlLogEst()) of the average number
+	 * of tuples with the same first i key parts, i = 1..part_count.
+	 */
+	int16_t *tuple_log_est;
+	/** Number of bounds of the histogram. */
+	uint32_t bound_count;
+};
+
+/**
+ * Return the statistics of the index with the given definition or NULL
+ * if the index hasn't been analyzed.
+ */
+struct sql_index_stat *
+sql_index_stat_get(const struct index_def *def);
+
+/**
+ * Collect the statistics of all indexes of the space with the given ID
+ * that support them and replace the old statistics of the indexes.
+ *
+ * @retval 0 on success.
+ * @retval -1 on error, diag is set.
+ */
+int
+sql_analyze_space(uint32_t space_id);
+
+/**
+ * Estimate the number of tuples with the first key part equal to the
+ * constant @a value using the histogram. Only values that occupy more
+ * than one bucket of the histogram are estimated: the frequency of
+ * other values is not known better than the average one.
+ *
+ * @param[out] est Logarithmic estimate of the number of tuples.
+ * @retval true if the estimate is set.
+ */
+bool
+sql_index_stat_eq_est(const struct index_def *def, struct Expr *value,
+		      int16_t *est);
+
+/**
+ * Estimate the number of tuples with NULL in the first key part.
+ *
+ * @param[out] est Logarithmic estimate of the number of tuples.
+ * @retval true if the estimate is set.
+ */
+bool
+sql_index_stat_null_est(const struct index_def *def, int16_t *est);
+
+/**
+ * Estimate the number of tuples with the first key part within the
+ * range given by the constants @a lower and @a upper using the
+ * histogram. Any of the bounds can be NULL, which means the range is
+ * not limited from the side.
+ *
+ * @param[out] est Logarithmic estimate of the number of tuples.
+ * @retval true if the estimate is set.
+ */
+bool
+sql_index_stat_range_est(const struct index_def *def, struct Expr *lower,
+			 bool is_lower_strict, struct Expr *upper,
+			 bool is_upper_strict, int16_t *est);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
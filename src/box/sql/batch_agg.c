@@ -0,0 +1,892 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "batch_agg.h"
+
+#include <math.h>
+
+#include "sqlInt.h"
+#include "mem.h"
+#include "box/index.h"
+#include "box/memtx_tx.h"
+#include "box/read_view.h"
+#include "box/schema.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "box/txn.h"
+#include "coio_task.h"
+#include "diag.h"
+#include "fiber.h"
+#include "tweaks.h"
+#include "small/region.h"
+#include "msgpuck/msgpuck.h"
+
+enum {
+	/** Number of tuples decoded and processed at once. */
+	SQL_BATCH_AGG_SIZE = 256,
+};
+
+/** Values of a field in a batch of tuples. */
+struct sql_batch_agg_column {
+	/** Values of an integer field, NULLs are stored as 0. */
+	int64_t *ints;
+	/** Values of a double field, NULLs are stored as -0.0. */
+	double *doubles;
+	/** Set for NULL values. */
+	bool *is_null;
+};
+
+/** A constant a field is compared with. */
+union sql_batch_agg_value {
+	int64_t i;
+	double d;
+};
+
+/** State of an aggregate function. */
+struct sql_batch_agg_state {
+	/** Number of non-NULL arguments or number of rows for COUNT(*). */
+	uint64_t count;
+	/** Sum, minimum or maximum of an integer argument. */
+	int64_t i;
+	/**
+	 * Minimum and maximum of the intermediate sums of an integer
+	 * argument, used to check that partial sums can be merged without
+	 * an overflow.
+	 */
+	int64_t min_sum;
+	int64_t max_sum;
+	/** Sum, minimum or maximum of a double argument. */
+	double d;
+	/** Set if the integer sum is overflowed. */
+	bool is_overflow;
+};
+
+struct sql_batch_agg *
+sql_batch_agg_new(uint32_t space_id, uint32_t filter_count,
+		  uint32_t step_count)
+{
+	/* Every filter and every function uses at most one field. */
+	uint32_t field_count = filter_count + step_count;
+	uint32_t agg_size = sizeof(struct sql_batch_agg);
+	uint32_t fields_size = field_count * sizeof(struct sql_batch_agg_field);
+	uint32_t filters_size =
+		filter_count * sizeof(struct sql_batch_agg_filter);
+	uint32_t steps_size = step_count * sizeof(struct sql_batch_agg_step);
+	uint32_t size = agg_size + fields_size + filters_size + steps_size;
+
+	struct sql_batch_agg *agg = sql_xmalloc(size);
+	agg->space_id = space_id;
+	agg->fields = (struct sql_batch_agg_field *)((char *)agg + agg_size);
+	agg->filters = (struct sql_batch_agg_filter *)
+		((char *)agg->fields + fields_size);
+	agg->steps = (struct sql_batch_agg_step *)
+		((char *)agg->filters + filters_size);
+	agg->field_count = 0;
+	agg->filter_count = filter_count;
+	agg->step_count = step_count;
+	return agg;
+}
+
+uint32_t
+sql_batch_agg_add_field(struct sql_batch_agg *agg, uint32_t fieldno,
+			enum field_type type)
+{
+	assert(sql_batch_agg_type_is_supported(type));
+	for (uint32_t i = 0; i < agg->field_count; i++) {
+		if (agg->fields[i].fieldno == fieldno)
+			return i;
+	}
+	assert(agg->field_count < agg->filter_count + agg->step_count);
+	struct sql_batch_agg_field *field = &agg->fields[agg->field_count];
+	field->fieldno = fieldno;
+	field->type = type;
+	return agg->field_count++;
+}
+
+bool
+sql_batch_agg_type_is_supported(enum field_type type)
+{
+	return type == FIELD_TYPE_INTEGER || type == FIELD_TYPE_UNSIGNED ||
+	       type == FIELD_TYPE_DOUBLE;
+}
+
+/**
+ * Convert the constant a field of the given type is compared with.
+ * Only comparisons that are exact in the type of the field are
+ * supported.
+ *
+ * @retval true on success.
+ * @retval false if the comparison can't be evaluated in batches.
+ */
+static bool
+sql_batch_agg_value_from_mem(const struct Mem *mem, enum field_type type,
+			     union sql_batch_agg_value *value)
+{
+	if (type == FIELD_TYPE_DOUBLE) {
+		if (mem_is_double(mem) && !isnan(mem->u.r)) {
+			value->d = mem->u.r;
+			return true;
+		}
+		/* Integers up to 2^53 are converted to double exactly. */
+		const int64_t max_exact = (int64_t)1 << 53;
+		if (mem_is_uint(mem) && mem->u.u <= (uint64_t)max_exact) {
+			value->d = (double)mem->u.u;
+			return true;
+		}
+		if (mem_is_nint(mem) && mem->u.i >= -max_exact) {
+			value->d = (double)mem->u.i;
+			return true;
+		}
+		return false;
+	}
+	if (mem_is_uint(mem) && mem->u.u <= INT64_MAX) {
+		value->i = (int64_t)mem->u.u;
+		return true;
+	}
+	if (mem_is_nint(mem)) {
+		value->i = mem->u.i;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Decode the value of a field into the i-th position of the batch.
+ *
+ * @retval true on success.
+ * @retval false if the value can't be processed in batches.
+ */
+static inline bool
+sql_batch_agg_decode(struct sql_batch_agg_column *column,
+		     enum field_type type, uint32_t i, const char *data)
+{
+	bool is_double = type == FIELD_TYPE_DOUBLE;
+	if (data == NULL || mp_typeof(*data) == MP_NIL) {
+		column->is_null[i] = true;
+		if (is_double)
+			column->doubles[i] = -0.0;
+		else
+			column->ints[i] = 0;
+		return true;
+	}
+	column->is_null[i] = false;
+	switch (mp_typeof(*data)) {
+	case MP_UINT: {
+		uint64_t u = mp_decode_uint(&data);
+		if (is_double || u > INT64_MAX)
+			return false;
+		column->ints[i] = (int64_t)u;
+		return true;
+	}
+	case MP_INT:
+		if (is_double)
+			return false;
+		column->ints[i] = mp_decode_int(&data);
+		return true;
+	case MP_DOUBLE:
+	case MP_FLOAT: {
+		if (!is_double)
+			return false;
+		double d = mp_typeof(*data) == MP_DOUBLE ?
+			   mp_decode_double(&data) : mp_decode_float(&data);
+		if (isnan(d))
+			return false;
+		column->doubles[i] = d;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+/**
+ * Leave in the selection vector only the rows whose values are not NULL
+ * and satisfy "values[i] <op> value".
+ */
+#define SQL_BATCH_AGG_FILTER(values, op, value) do {			\
+	uint32_t selected = 0;						\
+	for (uint32_t k = 0; k < *sel_count; k++) {			\
+		uint32_t i = sel[k];					\
+		sel[selected] = i;					\
+		selected += (uint32_t)!is_null[i] &			\
+			    (uint32_t)(values[i] op value);		\
+	}								\
+	*sel_count = selected;						\
+} while (0)
+
+#define SQL_BATCH_AGG_FILTER_CMP(cmp, values, value) do {		\
+	switch (cmp) {							\
+	case SQL_BATCH_AGG_EQ:						\
+		SQL_BATCH_AGG_FILTER(values, ==, value);		\
+		break;							\
+	case SQL_BATCH_AGG_NE:						\
+		SQL_BATCH_AGG_FILTER(values, !=, value);		\
+		break;							\
+	case SQL_BATCH_AGG_LT:						\
+		SQL_BATCH_AGG_FILTER(values, <, value);			\
+		break;							\
+	case SQL_BATCH_AGG_LE:						\
+		SQL_BATCH_AGG_FILTER(values, <=, value);		\
+		break;							\
+	case SQL_BATCH_AGG_GT:						\
+		SQL_BATCH_AGG_FILTER(values, >, value);			\
+		break;							\
+	case SQL_BATCH_AGG_GE:						\
+		SQL_BATCH_AGG_FILTER(values, >=, value);		\
+		break;							\
+	default:							\
+		unreachable();						\
+	}								\
+} while (0)
+
+/** Apply the filter to the rows of the selection vector. */
+static void
+sql_batch_agg_filter(const struct sql_batch_agg_filter *filter,
+		     const struct sql_batch_agg_column *column,
+		     enum field_type type, union sql_batch_agg_value value,
+		     uint32_t *sel, uint32_t *sel_count)
+{
+	const bool *is_null = column->is_null;
+	if (type == FIELD_TYPE_DOUBLE) {
+		const double *doubles = column->doubles;
+		SQL_BATCH_AGG_FILTER_CMP(filter->cmp, doubles, value.d);
+	} else {
+		const int64_t *ints = column->ints;
+		SQL_BATCH_AGG_FILTER_CMP(filter->cmp, ints, value.i);
+	}
+}
+
+#undef SQL_BATCH_AGG_FILTER_CMP
+#undef SQL_BATCH_AGG_FILTER
+
+/** Initialize the state of the aggregate function. */
+static void
+sql_batch_agg_state_create(struct sql_batch_agg_state *state,
+			   enum sql_batch_agg_func func)
+{
+	state->count = 0;
+	state->min_sum = 0;
+	state->max_sum = 0;
+	state->is_overflow = false;
+	switch (func) {
+	case SQL_BATCH_AGG_MIN:
+		state->i = INT64_MAX;
+		state->d = INFINITY;
+		break;
+	case SQL_BATCH_AGG_MAX:
+		state->i = INT64_MIN;
+		state->d = -INFINITY;
+		break;
+	case SQL_BATCH_AGG_TOTAL:
+		state->i = 0;
+		state->d = 0.0;
+		break;
+	default:
+		/*
+		 * SUM() and AVG() of doubles start with the first value,
+		 * -0.0 is the only start value that doesn't change it.
+		 */
+		state->i = 0;
+		state->d = -0.0;
+		break;
+	}
+}
+
+/** Update the state of the aggregate function with the selected rows. */
+static void
+sql_batch_agg_step(const struct sql_batch_agg_step *step,
+		   const struct sql_batch_agg_column *column,
+		   enum field_type type, const uint32_t *sel,
+		   uint32_t sel_count, struct sql_batch_agg_state *state)
+{
+	if (column == NULL) {
+		assert(step->func == SQL_BATCH_AGG_COUNT);
+		state->count += sel_count;
+		return;
+	}
+	const bool *is_null = column->is_null;
+	const int64_t *ints = column->ints;
+	const double *doubles = column->doubles;
+	bool is_double = type == FIELD_TYPE_DOUBLE;
+	uint64_t count = 0;
+	for (uint32_t k = 0; k < sel_count; k++)
+		count += !is_null[sel[k]];
+	state->count += count;
+	switch (step->func) {
+	case SQL_BATCH_AGG_COUNT:
+		break;
+	case SQL_BATCH_AGG_SUM:
+	case SQL_BATCH_AGG_AVG:
+		if (!is_double) {
+			int64_t sum = state->i;
+			int64_t min_sum = state->min_sum;
+			int64_t max_sum = state->max_sum;
+			bool is_overflow = false;
+			for (uint32_t k = 0; k < sel_count; k++) {
+				is_overflow |= __builtin_add_overflow(
+					sum, ints[sel[k]], &sum);
+				min_sum = MIN(min_sum, sum);
+				max_sum = MAX(max_sum, sum);
+			}
+			state->i = sum;
+			state->min_sum = min_sum;
+			state->max_sum = max_sum;
+			state->is_overflow |= is_overflow;
+			break;
+		}
+		FALLTHROUGH;
+	case SQL_BATCH_AGG_TOTAL: {
+		double sum = state->d;
+		if (is_double) {
+			for (uint32_t k = 0; k < sel_count; k++)
+				sum += doubles[sel[k]];
+		} else {
+			for (uint32_t k = 0; k < sel_count; k++)
+				sum += (double)ints[sel[k]];
+		}
+		state->d = sum;
+		break;
+	}
+	case SQL_BATCH_AGG_MIN:
+		for (uint32_t k = 0; k < sel_count; k++) {
+			uint32_t i = sel[k];
+			if (is_null[i])
+				continue;
+			if (is_double && doubles[i] < state->d)
+				state->d = doubles[i];
+			else if (!is_double && ints[i] < state->i)
+				state->i = ints[i];
+		}
+		break;
+	case SQL_BATCH_AGG_MAX:
+		for (uint32_t k = 0; k < sel_count; k++) {
+			uint32_t i = sel[k];
+			if (is_null[i])
+				continue;
+			if (is_double && doubles[i] > state->d)
+				state->d = doubles[i];
+			else if (!is_double && ints[i] > state->i)
+				state->i = ints[i];
+		}
+		break;
+	default:
+		unreachable();
+	}
+}
+
+/**
+ * Store the final value of the aggregate function to the register. The
+ * value is the same as the one computed by the row-by-row
+ * implementation of the function.
+ */
+static int
+sql_batch_agg_finalize(const struct sql_batch_agg_step *step,
+		       enum field_type type,
+		       const struct sql_batch_agg_state *state,
+		       struct Mem *result)
+{
+	bool is_double = type == FIELD_TYPE_DOUBLE;
+	switch (step->func) {
+	case SQL_BATCH_AGG_COUNT:
+		mem_set_uint(result, state->count);
+		return 0;
+	case SQL_BATCH_AGG_TOTAL:
+		mem_set_double(result, state->d);
+		return 0;
+	default:
+		break;
+	}
+	if (state->count == 0) {
+		mem_set_null(result);
+		return 0;
+	}
+	if (step->func != SQL_BATCH_AGG_AVG) {
+		if (is_double)
+			mem_set_double(result, state->d);
+		else
+			mem_set_int(result, state->i);
+		return 0;
+	}
+	struct Mem sum;
+	struct Mem count;
+	mem_create(&sum);
+	mem_create(&count);
+	if (is_double)
+		mem_set_double(&sum, state->d);
+	else
+		mem_set_int(&sum, state->i);
+	mem_set_uint(&count, state->count);
+	return mem_div(&sum, &count, result);
+}
+
+/**
+ * Merge the state of the aggregate function computed over a part of the
+ * index into the state computed over the preceding parts. Only
+ * functions whose result doesn't depend on the order of the rows are
+ * merged, see sql_batch_agg_is_parallel().
+ */
+static void
+sql_batch_agg_state_merge(enum sql_batch_agg_func func, enum field_type type,
+			  struct sql_batch_agg_state *state,
+			  const struct sql_batch_agg_state *part)
+{
+	bool is_double = type == FIELD_TYPE_DOUBLE;
+	state->count += part->count;
+	state->is_overflow |= part->is_overflow;
+	switch (func) {
+	case SQL_BATCH_AGG_COUNT:
+		break;
+	case SQL_BATCH_AGG_SUM:
+	case SQL_BATCH_AGG_AVG: {
+		assert(!is_double);
+		/*
+		 * The sequential scan would have overflowed if any
+		 * intermediate sum of the part added to the preceding sum
+		 * had been out of range.
+		 */
+		int64_t min_sum;
+		int64_t max_sum;
+		state->is_overflow |= __builtin_add_overflow(
+			state->i, part->min_sum, &min_sum);
+		state->is_overflow |= __builtin_add_overflow(
+			state->i, part->max_sum, &max_sum);
+		state->min_sum = MIN(state->min_sum, min_sum);
+		state->max_sum = MAX(state->max_sum, max_sum);
+		state->is_overflow |= __builtin_add_overflow(
+			state->i, part->i, &state->i);
+		break;
+	}
+	case SQL_BATCH_AGG_MIN:
+		if (is_double && part->d < state->d)
+			state->d = part->d;
+		else if (!is_double && part->i < state->i)
+			state->i = part->i;
+		break;
+	case SQL_BATCH_AGG_MAX:
+		if (is_double && part->d > state->d)
+			state->d = part->d;
+		else if (!is_double && part->i > state->i)
+			state->i = part->i;
+		break;
+	default:
+		unreachable();
+	}
+}
+
+/** Type of the argument of the aggregate function. */
+static inline enum field_type
+sql_batch_agg_step_type(const struct sql_batch_agg *agg,
+			const struct sql_batch_agg_step *step)
+{
+	return step->field == UINT32_MAX ? FIELD_TYPE_ANY :
+	       agg->fields[step->field].type;
+}
+
+/** Scan of a sequence of tuples that feeds them to the batches. */
+struct sql_batch_agg_scan {
+	/** The query. */
+	const struct sql_batch_agg *agg;
+	/** Constants the fields are compared with, one per filter. */
+	const union sql_batch_agg_value *values;
+	/** Values of the fields in the current batch. */
+	struct sql_batch_agg_column *columns;
+	/** Selection vector of the current batch. */
+	uint32_t *sel;
+	/** Number of tuples in the current batch. */
+	uint32_t count;
+	/** States of the aggregate functions. */
+	struct sql_batch_agg_state *states;
+	/** Cleared if a value can't be processed in batches. */
+	bool is_supported;
+};
+
+/** Allocate the batch of the scan on the region. */
+static void
+sql_batch_agg_scan_create(struct sql_batch_agg_scan *scan,
+			  const struct sql_batch_agg *agg,
+			  const union sql_batch_agg_value *values,
+			  struct region *region)
+{
+	scan->agg = agg;
+	scan->values = values;
+	scan->columns = xregion_alloc_array(region, typeof(*scan->columns),
+					    agg->field_count);
+	for (uint32_t i = 0; i < agg->field_count; i++) {
+		struct sql_batch_agg_column *column = &scan->columns[i];
+		column->ints = NULL;
+		column->doubles = NULL;
+		if (agg->fields[i].type == FIELD_TYPE_DOUBLE) {
+			column->doubles = xregion_alloc_array(
+				region, double, SQL_BATCH_AGG_SIZE);
+		} else {
+			column->ints = xregion_alloc_array(
+				region, int64_t, SQL_BATCH_AGG_SIZE);
+		}
+		column->is_null = xregion_alloc_array(region, bool,
+						      SQL_BATCH_AGG_SIZE);
+	}
+	scan->sel = xregion_alloc_array(region, uint32_t, SQL_BATCH_AGG_SIZE);
+	scan->count = 0;
+	scan->states = xregion_alloc_array(region, typeof(*scan->states),
+					   agg->step_count);
+	for (uint32_t i = 0; i < agg->step_count; i++) {
+		sql_batch_agg_state_create(&scan->states[i],
+					   agg->steps[i].func);
+	}
+	scan->is_supported = true;
+}
+
+/** Apply the filters and update the aggregate functions with the batch. */
+static void
+sql_batch_agg_scan_flush(struct sql_batch_agg_scan *scan)
+{
+	const struct sql_batch_agg *agg = scan->agg;
+	uint32_t *sel = scan->sel;
+	uint32_t sel_count = scan->count;
+	scan->count = 0;
+	for (uint32_t i = 0; i < sel_count; i++)
+		sel[i] = i;
+	for (uint32_t i = 0; i < agg->filter_count && sel_count > 0; i++) {
+		const struct sql_batch_agg_filter *filter = &agg->filters[i];
+		sql_batch_agg_filter(filter, &scan->columns[filter->field],
+				     agg->fields[filter->field].type,
+				     scan->values[i], sel, &sel_count);
+	}
+	if (sel_count == 0)
+		return;
+	for (uint32_t i = 0; i < agg->step_count; i++) {
+		const struct sql_batch_agg_step *step = &agg->steps[i];
+		const struct sql_batch_agg_column *column =
+			step->field == UINT32_MAX ? NULL :
+			&scan->columns[step->field];
+		sql_batch_agg_step(step, column,
+				   sql_batch_agg_step_type(agg, step), sel,
+				   sel_count, &scan->states[i]);
+	}
+}
+
+/** Add a tuple to the batch, flushing it if it's full. */
+static void
+sql_batch_agg_scan_add(struct sql_batch_agg_scan *scan, struct tuple *tuple)
+{
+	const struct sql_batch_agg *agg = scan->agg;
+	for (uint32_t i = 0; i < agg->field_count; i++) {
+		const struct sql_batch_agg_field *field = &agg->fields[i];
+		const char *data = tuple_field(tuple, field->fieldno);
+		if (!sql_batch_agg_decode(&scan->columns[i], field->type,
+					  scan->count, data)) {
+			scan->is_supported = false;
+			return;
+		}
+	}
+	if (++scan->count == SQL_BATCH_AGG_SIZE)
+		sql_batch_agg_scan_flush(scan);
+}
+
+/**
+ * Add a tuple given by its raw MsgPack data to the batch, flushing it
+ * if it's full. Unlike sql_batch_agg_scan_add(), doesn't use the tuple
+ * format so it can be called from any thread.
+ */
+static void
+sql_batch_agg_scan_add_raw(struct sql_batch_agg_scan *scan, const char *data)
+{
+	const struct sql_batch_agg *agg = scan->agg;
+	uint32_t field_count = mp_decode_array(&data);
+	uint32_t decoded = 0;
+	for (uint32_t fieldno = 0; decoded < agg->field_count; fieldno++) {
+		const char *field = fieldno < field_count ? data : NULL;
+		for (uint32_t i = 0; i < agg->field_count; i++) {
+			if (agg->fields[i].fieldno != fieldno)
+				continue;
+			decoded++;
+			if (!sql_batch_agg_decode(&scan->columns[i],
+						  agg->fields[i].type,
+						  scan->count, field)) {
+				scan->is_supported = false;
+				return;
+			}
+		}
+		if (field != NULL)
+			mp_next(&data);
+	}
+	if (++scan->count == SQL_BATCH_AGG_SIZE)
+		sql_batch_agg_scan_flush(scan);
+}
+
+/**
+ * Maximal number of parts a query is split into. The parts are scanned
+ * in the coio thread pool, see the worker_pool_threads option.
+ */
+static uint64_t sql_batch_agg_parallel_max_parts = 4;
+TWEAK_UINT(sql_batch_agg_parallel_max_parts);
+
+/** Minimal number of tuples scanned by a worker thread. */
+static uint64_t sql_batch_agg_parallel_min_part_size = 100000;
+TWEAK_UINT(sql_batch_agg_parallel_min_part_size);
+
+/** A part of the index scanned in parallel. */
+struct sql_batch_agg_part {
+	/** Scan of the tuples of the part. */
+	struct sql_batch_agg_scan scan;
+	/** Read view iterator positioned at the first tuple of the part. */
+	struct index_read_view_iterator it;
+	/** Number of tuples in the part. */
+	uint32_t size;
+	/** Result of the scan of the part. */
+	int rc;
+};
+
+/** Scan a part of the index, called in a coio thread. */
+static ssize_t
+sql_batch_agg_part_f(va_list ap)
+{
+	struct sql_batch_agg_part *part =
+		va_arg(ap, struct sql_batch_agg_part *);
+	struct sql_batch_agg_scan *scan = &part->scan;
+	for (uint32_t i = 0; i < part->size && scan->is_supported; i++) {
+		struct read_view_tuple tuple;
+		if (index_read_view_iterator_next_raw(&part->it, &tuple) != 0)
+			return -1;
+		if (tuple.data == NULL)
+			break;
+		sql_batch_agg_scan_add_raw(scan, tuple.data);
+	}
+	if (scan->is_supported)
+		sql_batch_agg_scan_flush(scan);
+	return 0;
+}
+
+/** Fiber waiting for the scan of a part in a coio thread. */
+static int
+sql_batch_agg_part_fiber_f(va_list ap)
+{
+	struct sql_batch_agg_part *part =
+		va_arg(ap, struct sql_batch_agg_part *);
+	part->rc = coio_call(sql_batch_agg_part_f, part) < 0 ? -1 : 0;
+	return 0;
+}
+
+/** Read view filter that leaves only the primary index of the space. */
+static bool
+sql_batch_agg_filter_space(struct space *space, void *arg)
+{
+	return space_id(space) == *(uint32_t *)arg;
+}
+
+static bool
+sql_batch_agg_filter_index(struct space *space, struct index *index,
+			   void *arg)
+{
+	return sql_batch_agg_filter_space(space, arg) &&
+	       index->def->iid == 0;
+}
+
+/**
+ * Return the number of parts the query over the space can be split
+ * into or 1 if it must be executed sequentially.
+ */
+static uint32_t
+sql_batch_agg_part_count(const struct sql_batch_agg *agg, struct space *space)
+{
+	/*
+	 * The scan yields, which would abort a memtx transaction, and
+	 * without the MVCC engine a read view contains exactly the tuples
+	 * of the index so its parts can be given by offsets.
+	 */
+	if (in_txn() != NULL || memtx_tx_manager_use_mvcc_engine)
+		return 1;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL || pk->def->type != TREE)
+		return 1;
+	/*
+	 * Sums of doubles depend on the order of the rows, so splitting
+	 * them could change the result.
+	 */
+	for (uint32_t i = 0; i < agg->step_count; i++) {
+		const struct sql_batch_agg_step *step = &agg->steps[i];
+		enum field_type type = sql_batch_agg_step_type(agg, step);
+		if (step->func == SQL_BATCH_AGG_TOTAL)
+			return 1;
+		if ((step->func == SQL_BATCH_AGG_SUM ||
+		     step->func == SQL_BATCH_AGG_AVG) &&
+		    type == FIELD_TYPE_DOUBLE)
+			return 1;
+	}
+	uint64_t min_size = MAX(sql_batch_agg_parallel_min_part_size, 1);
+	uint64_t count = (uint64_t)index_size(pk) / min_size;
+	count = MIN(count, sql_batch_agg_parallel_max_parts);
+	return MAX(count, 1);
+}
+
+/**
+ * Execute the query over a read view of the primary index of the space
+ * split into @a part_count parts scanned in coio threads. The states of
+ * the parts are merged into @a states.
+ *
+ * @retval true on success.
+ * @retval false if the query can't be executed in parallel, e.g. the
+ *         read view can't be open or a value can't be processed in
+ *         batches. The query should be executed sequentially then.
+ */
+static bool
+sql_batch_agg_run_parallel(const struct sql_batch_agg *agg,
+			   struct space *space, uint32_t part_count,
+			   const union sql_batch_agg_value *values,
+			   struct sql_batch_agg_state *states)
+{
+	struct region *region = &fiber()->gc;
+	uint32_t id = space_id(space);
+	struct read_view rv;
+	struct read_view_opts opts;
+	read_view_opts_create(&opts);
+	opts.name = "sql";
+	opts.filter_space = sql_batch_agg_filter_space;
+	opts.filter_index = sql_batch_agg_filter_index;
+	opts.filter_arg = &id;
+	opts.enable_data_temporary_spaces = true;
+	if (read_view_open(&rv, &opts) != 0) {
+		diag_clear(diag_get());
+		return false;
+	}
+	struct index_read_view *index_rv = NULL;
+	struct space_read_view *space_rv;
+	read_view_foreach_space(space_rv, &rv)
+		index_rv = space_read_view_index(space_rv, 0);
+	ssize_t size = index_size(space_index(space, 0));
+	struct sql_batch_agg_part *parts =
+		xregion_alloc_array(region, typeof(*parts), part_count);
+	uint32_t started = 0;
+	bool is_done = index_rv != NULL;
+	for (uint32_t i = 0; i < part_count && is_done; i++) {
+		struct sql_batch_agg_part *part = &parts[i];
+		uint32_t offset = size * i / part_count;
+		part->size = size * (i + 1) / part_count - offset;
+		part->rc = 0;
+		sql_batch_agg_scan_create(&part->scan, agg, values, region);
+		if (index_read_view_create_iterator_with_offset(
+				index_rv, ITER_ALL, NULL, 0, NULL, offset,
+				&part->it) != 0) {
+			diag_clear(diag_get());
+			is_done = false;
+			break;
+		}
+		started++;
+	}
+	/* The first part is scanned by the current fiber. */
+	struct fiber **fibers = xregion_alloc_array(region, struct fiber *,
+						    part_count);
+	uint32_t fiber_count = 1;
+	for (; fiber_count < started; fiber_count++) {
+		struct fiber *f = fiber_new("sql_scan",
+					    sql_batch_agg_part_fiber_f);
+		if (f == NULL) {
+			diag_clear(diag_get());
+			is_done = false;
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, &parts[fiber_count]);
+		fibers[fiber_count] = f;
+	}
+	if (is_done && coio_call(sql_batch_agg_part_f, &parts[0]) < 0) {
+		diag_clear(diag_get());
+		parts[0].rc = -1;
+	}
+	for (uint32_t i = 1; i < fiber_count; i++)
+		fiber_join(fibers[i]);
+	for (uint32_t i = 0; i < started; i++) {
+		struct sql_batch_agg_part *part = &parts[i];
+		index_read_view_iterator_destroy(&part->it);
+		if (part->rc != 0 || !part->scan.is_supported)
+			is_done = false;
+	}
+	read_view_close(&rv);
+	if (!is_done)
+		return false;
+	for (uint32_t i = 0; i < part_count; i++) {
+		for (uint32_t j = 0; j < agg->step_count; j++) {
+			const struct sql_batch_agg_step *step = &agg->steps[j];
+			sql_batch_agg_state_merge(
+				step->func, sql_batch_agg_step_type(agg, step),
+				&states[j], &parts[i].scan.states[j]);
+		}
+	}
+	return true;
+}
+
+int
+sql_batch_agg_run(const struct sql_batch_agg *agg, struct index *index,
+		  const struct Mem *args, struct Mem *regs, bool *is_done)
+{
+	*is_done = false;
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	union sql_batch_agg_value *values =
+		xregion_alloc_array(region, typeof(*values),
+				    agg->filter_count);
+	for (uint32_t i = 0; i < agg->filter_count; i++) {
+		const struct sql_batch_agg_filter *filter = &agg->filters[i];
+		if (!sql_batch_agg_value_from_mem(
+				&args[i], agg->fields[filter->field].type,
+				&values[i])) {
+			region_truncate(region, svp);
+			return 0;
+		}
+	}
+	struct sql_batch_agg_scan scan;
+	sql_batch_agg_scan_create(&scan, agg, values, region);
+
+	int rc = 0;
+	struct space *space = space_by_id(index->def->space_id);
+	assert(space != NULL);
+	uint32_t part_count = sql_batch_agg_part_count(agg, space);
+	if (part_count <= 1 ||
+	    !sql_batch_agg_run_parallel(agg, space, part_count, values,
+					scan.states)) {
+		/* The states are not changed if the parallel scan failed. */
+		struct txn *txn = NULL;
+		struct txn_ro_savepoint txn_svp;
+		if (space->def->id != 0 &&
+		    txn_begin_ro_stmt(space, &txn, &txn_svp) != 0) {
+			region_truncate(region, svp);
+			return -1;
+		}
+		struct iterator *it = index_create_iterator(index, ITER_ALL,
+							    NULL, 0);
+		if (txn != NULL)
+			txn_end_ro_stmt(txn, &txn_svp);
+		if (it == NULL) {
+			region_truncate(region, svp);
+			return -1;
+		}
+		struct tuple *tuple;
+		while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+			sql_batch_agg_scan_add(&scan, tuple);
+			if (!scan.is_supported)
+				break;
+		}
+		iterator_delete(it);
+		if (rc == 0 && scan.is_supported)
+			sql_batch_agg_scan_flush(&scan);
+	}
+
+	bool is_supported = scan.is_supported;
+	for (uint32_t i = 0; i < agg->step_count; i++) {
+		if (scan.states[i].is_overflow)
+			is_supported = false;
+	}
+	if (rc == 0 && is_supported) {
+		for (uint32_t i = 0; i < agg->step_count && rc == 0; i++) {
+			const struct sql_batch_agg_step *step = &agg->steps[i];
+			rc = sql_batch_agg_finalize(
+				step, sql_batch_agg_step_type(agg, step),
+				&scan.states[i], &regs[step->reg]);
+		}
+		*is_done = rc == 0;
+	}
+	region_truncate(region, svp);
+	return rc;
+}
@@ -0,0 +1,136 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "box/field_def.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Mem;
+struct index;
+
+/** Aggregate functions that can be computed in batches. */
+enum sql_batch_agg_func {
+	SQL_BATCH_AGG_COUNT,
+	SQL_BATCH_AGG_SUM,
+	SQL_BATCH_AGG_TOTAL,
+	SQL_BATCH_AGG_AVG,
+	SQL_BATCH_AGG_MIN,
+	SQL_BATCH_AGG_MAX,
+};
+
+/** Comparisons of a field with a constant used to filter tuples. */
+enum sql_batch_agg_cmp {
+	SQL_BATCH_AGG_EQ,
+	SQL_BATCH_AGG_NE,
+	SQL_BATCH_AGG_LT,
+	SQL_BATCH_AGG_LE,
+	SQL_BATCH_AGG_GT,
+	SQL_BATCH_AGG_GE,
+};
+
+/** A field of the space decoded into the batches. */
+struct sql_batch_agg_field {
+	/** Number of the field in the tuples. */
+	uint32_t fieldno;
+	/** Type of the field: INTEGER, UNSIGNED or DOUBLE. */
+	enum field_type type;
+};
+
+/** A filter of the form "field <cmp> constant". */
+struct sql_batch_agg_filter {
+	/** Index of the field in sql_batch_agg::fields. */
+	uint32_t field;
+	/** Comparison of the field with the constant. */
+	enum sql_batch_agg_cmp cmp;
+};
+
+/** An aggregate function computed over the filtered tuples. */
+struct sql_batch_agg_step {
+	/** The aggregate function. */
+	enum sql_batch_agg_func func;
+	/**
+	 * Index of the argument in sql_batch_agg::fields or UINT32_MAX
+	 * for COUNT(*).
+	 */
+	uint32_t field;
+	/** Register the final value of the function is stored to. */
+	int reg;
+};
+
+/**
+ * Description of a query of the form
+ *
+ *   SELECT agg(x), ... FROM t WHERE y <cmp> const AND ...
+ *
+ * that can be executed batch-at-a-time: tuples are read from the index
+ * iterator in batches, the fields used by the query are decoded into
+ * typed arrays and the filters and aggregates are evaluated by tight
+ * loops over these arrays.
+ */
+struct sql_batch_agg {
+	/** ID of the space. */
+	uint32_t space_id;
+	/** Fields used by the query. */
+	struct sql_batch_agg_field *fields;
+	/** Filters, all of which must be passed by a tuple. */
+	struct sql_batch_agg_filter *filters;
+	/** Aggregate functions. */
+	struct sql_batch_agg_step *steps;
+	/** Number of fields. */
+	uint32_t field_count;
+	/** Number of filters. */
+	uint32_t filter_count;
+	/** Number of aggregate functions. */
+	uint32_t step_count;
+};
+
+/**
+ * Allocate a query description with room for @a filter_count filters
+ * and @a step_count aggregate functions. The description is allocated
+ * as a single chunk of memory and must be freed with sql_xfree().
+ */
+struct sql_batch_agg *
+sql_batch_agg_new(uint32_t space_id, uint32_t filter_count,
+		  uint32_t step_count);
+
+/**
+ * Return the index of the field in agg->fields, adding the field if it
+ * is not there yet.
+ */
+uint32_t
+sql_batch_agg_add_field(struct sql_batch_agg *agg, uint32_t fieldno,
+			enum field_type type);
+
+/** Check if fields of the given type can be decoded into the batches. */
+bool
+sql_batch_agg_type_is_supported(enum field_type type);
+
+/**
+ * Compute the aggregate functions over the tuples of @a index that pass
+ * all the filters and store their final values to @a regs. The
+ * constants the fields are compared with are given by @a args, one per
+ * filter.
+ *
+ * @param[out] is_done Set to false if the query can't be executed in
+ *        batches, e.g. a constant is not a number or an integer sum
+ *        overflows. Registers are not changed in this case and the
+ *        query should be executed row by row.
+ * @retval 0 on success.
+ * @retval -1 on error, diag is set.
+ */
+int
+sql_batch_agg_run(const struct sql_batch_agg *agg, struct index *index,
+		  const struct Mem *args, struct Mem *regs, bool *is_done);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -49,6 +49,7 @@
 #include "vdbeInt.h"
 #include "mp_decimal.h"
 #include "tarantoolInt.h"
+#include "matview.h"
 #include "box/sequence.h"
 #include "box/session.h"
 #include "box/identifier.h"
@@ -1523,6 +1524,76 @@ sqlEndTable(struct Parse *pParse)
 	vdbe_emit_create_defaults(pParse, reg_space_id);
 }
 
+/**
+ * Set nullability and collations of the columns of a materialized
+ * view: the GROUP BY columns form the primary key and compare as the
+ * fields of the base space do, the aggregates may be NULL.
+ */
+static void
+matview_def_prepare_fields(struct space_def *def,
+			   const struct sql_matview *matview)
+{
+	for (uint32_t i = 0; i < def->field_count; i++) {
+		def->fields[i].is_nullable = true;
+		def->fields[i].nullable_action = ON_CONFLICT_ACTION_NONE;
+	}
+	for (uint32_t i = 0; i < matview->group_count; i++) {
+		uint32_t fieldno = matview->group_columns[i];
+		struct field_def *field = &def->fields[fieldno];
+		field->is_nullable = false;
+		field->nullable_action = ON_CONFLICT_ACTION_ABORT;
+		field->coll_id = matview->group_key_def->parts[i].coll_id;
+	}
+}
+
+/**
+ * Generate code to create the primary key of a materialized view
+ * over its GROUP BY columns and to fill the view from the base
+ * space.
+ */
+static void
+vdbe_emit_matview_create(struct Parse *parse, struct space *space,
+			 const struct sql_matview *matview, int space_id_reg)
+{
+	struct space_def *def = space->def;
+	size_t region_svp = region_used(&fiber()->gc);
+	struct key_part_def *parts =
+		xregion_alloc_array(&fiber()->gc, typeof(parts[0]),
+				    matview->group_count);
+	for (uint32_t i = 0; i < matview->group_count; i++) {
+		uint32_t fieldno = matview->group_columns[i];
+		parts[i] = key_part_def_default;
+		parts[i].fieldno = fieldno;
+		parts[i].type = def->fields[fieldno].type;
+		parts[i].coll_id = def->fields[fieldno].coll_id;
+		parts[i].nullable_action = ON_CONFLICT_ACTION_ABORT;
+	}
+	struct key_def *key_def = key_def_new(parts, matview->group_count, 0);
+	region_truncate(&fiber()->gc, region_svp);
+	if (key_def == NULL) {
+		parse->is_aborted = true;
+		return;
+	}
+	struct index_opts opts;
+	index_opts_create(&opts);
+	opts.is_unique = true;
+	char *name = sqlMPrintf("pk_unnamed_%s_1", def->name);
+	struct index_def *pk_def =
+		index_def_new(def->id, 0, name, strlen(name), def->name,
+			      def->engine_name, TREE, &opts, key_def, NULL);
+	sql_xfree(name);
+	key_def_delete(key_def);
+	/*
+	 * The primary key is created along with the space, the same
+	 * way as the one of CREATE TABLE.
+	 */
+	parse->create_table_def.new_space = space;
+	vdbe_emit_create_index(parse, def, pk_def, space_id_reg, 0);
+	parse->create_table_def.new_space = NULL;
+	index_def_delete(pk_def);
+	sqlVdbeAddOp1(sqlGetVdbe(parse), OP_MatViewRefresh, space_id_reg);
+}
+
 void
 sql_create_view(struct Parse *parse_context)
 {
@@ -1567,7 +1638,15 @@ sql_create_view(struct Parse *parse_context)
 		select_res_space->def->fields = NULL;
 		select_res_space->def->field_count = 0;
 	}
-	space->def->opts.is_view = true;
+	bool is_materialized = view_def->is_materialized;
+	if (is_materialized) {
+		space->def->opts.is_materialized = true;
+		strlcpy(space->def->engine_name,
+			sql_storage_engine_strs[SQL_STORAGE_ENGINE_MEMTX],
+			ENGINE_NAME_MAX + 1);
+	} else {
+		space->def->opts.is_view = true;
+	}
 	/*
 	 * Locate the end of the CREATE VIEW statement.
 	 * Make sEnd point to the end.
@@ -1591,6 +1670,15 @@ sql_create_view(struct Parse *parse_context)
 		parse_context->is_aborted = true;
 		goto create_view_fail;
 	}
+	struct sql_matview *matview = NULL;
+	if (is_materialized) {
+		matview = sql_matview_new(space->def);
+		if (matview == NULL) {
+			parse_context->is_aborted = true;
+			goto create_view_fail;
+		}
+		matview_def_prepare_fields(space->def, matview);
+	}
 	const char *space_name = sql_name_from_token(&create_entity_def->name);
 	int name_reg = ++parse_context->nMem;
 	sqlVdbeAddOp4(parse_context->pVdbe, OP_String8, 0, name_reg, 0,
@@ -1600,8 +1688,13 @@ sql_create_view(struct Parse *parse_context)
 					  name_reg, 1, ER_SPACE_EXISTS,
 					  space_name, (no_err != 0),
 					  OP_NoConflict);
-	vdbe_emit_space_create(parse_context, getNewSpaceId(parse_context),
-			       name_reg, space);
+	int space_id_reg = getNewSpaceId(parse_context);
+	vdbe_emit_space_create(parse_context, space_id_reg, name_reg, space);
+	if (matview != NULL) {
+		vdbe_emit_matview_create(parse_context, space, matview,
+					 space_id_reg);
+		sql_matview_delete(matview);
+	}
 
  create_view_fail:
 	sql_expr_list_delete(view_def->aliases);
@@ -1817,19 +1910,22 @@ sql_drop_table(struct Parse *parse_context)
 	 * Ensure DROP TABLE is not used on a view,
 	 * and DROP VIEW is not used on a table.
 	 */
-	if (is_view && !space->def->opts.is_view) {
+	bool space_is_view = space->def->opts.is_view ||
+			     space->def->opts.is_materialized;
+	if (is_view && !space_is_view) {
 		diag_set(ClientError, ER_DROP_SPACE, space_name,
 			 "use DROP TABLE");
 		parse_context->is_aborted = true;
 		goto exit_drop_table;
 	}
-	if (!is_view && space->def->opts.is_view) {
+	if (!is_view && space_is_view) {
 		diag_set(ClientError, ER_DROP_SPACE, space_name,
 			 "use DROP VIEW");
 		parse_context->is_aborted = true;
 		goto exit_drop_table;
 	}
-	sql_code_drop_table(parse_context, space, is_view);
+	/* Materialized views have indexes to drop as tables do. */
+	sql_code_drop_table(parse_context, space, space->def->opts.is_view);
 
  exit_drop_table:
 	sqlSrcListDelete(table_name_list);
@@ -3780,3 +3876,40 @@ sql_emit_show_create_table_all(struct Parse *parse)
 	sqlVdbeAddOp2(v, OP_Next, cursor, addr2);
 	sqlVdbeJumpHere(v, addr1);
 }
+
+/** Emit VDBE instructions for "ANALYZE table_name;" statement. */
+void
+sql_emit_analyze_one(struct Parse *parse, struct Token *name)
+{
+	const struct space *space = sql_space_by_token(name);
+	if (space == NULL) {
+		const char *name_str = sql_tt_name_from_token(name);
+		diag_set(ClientError, ER_NO_SUCH_SPACE, name_str);
+		parse->is_aborted = true;
+		return;
+	}
+	struct Vdbe *v = sqlGetVdbe(parse);
+	int space_id_reg = ++parse->nMem;
+	sqlVdbeAddOp2(v, OP_Integer, space->def->id, space_id_reg);
+	sqlVdbeAddOp1(v, OP_Analyze, space_id_reg);
+}
+
+/** Emit VDBE instructions for "ANALYZE;" statement. */
+void
+sql_emit_analyze_all(struct Parse *parse)
+{
+	struct Vdbe *v = sqlGetVdbe(parse);
+	int cursor = parse->nTab++;
+	int space_reg = ++parse->nMem;
+	int key_reg = ++parse->nMem;
+	sqlVdbeAddOp2(v, OP_OpenSpace, space_reg, BOX_VSPACE_ID);
+	sqlVdbeAddOp3(v, OP_IteratorOpen, cursor, 0, space_reg);
+	sqlVdbeAddOp2(v, OP_Integer, BOX_SYSTEM_ID_MAX, key_reg);
+	int addr1 = sqlVdbeAddOp4Int(v, OP_SeekGT, cursor, 0, key_reg, 1);
+	int space_id_reg = ++parse->nMem;
+	int addr2 = sqlVdbeAddOp3(v, OP_Column, cursor, BOX_SPACE_FIELD_ID,
+				  space_id_reg);
+	sqlVdbeAddOp1(v, OP_Analyze, space_id_reg);
+	sqlVdbeAddOp2(v, OP_Next, cursor, addr2);
+	sqlVdbeJumpHere(v, addr1);
+}
@@ -0,0 +1,489 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "filter.h"
+
+#include <math.h>
+#include <string.h>
+#include <unicode/utf8.h>
+
+#include "sqlInt.h"
+#include "mem.h"
+#include "msgpuck/msgpuck.h"
+
+struct sql_filter *
+sql_filter_new(uint32_t term_count)
+{
+	uint32_t filter_size = sizeof(struct sql_filter);
+	uint32_t terms_size = term_count * sizeof(struct sql_filter_term);
+	struct sql_filter *filter = sql_xmalloc0(filter_size + terms_size);
+	filter->run = 0;
+	filter->term_count = term_count;
+	filter->terms =
+		(struct sql_filter_term *)((char *)filter + filter_size);
+	return filter;
+}
+
+bool
+sql_filter_type_is_supported(enum field_type type, enum sql_filter_op op,
+			     enum sql_filter_arith arith_op)
+{
+	switch (op) {
+	case SQL_FILTER_IS_NULL:
+	case SQL_FILTER_NOT_NULL:
+		return arith_op == SQL_FILTER_ARITH_NONE;
+	case SQL_FILTER_LIKE:
+		return type == FIELD_TYPE_STRING &&
+		       arith_op == SQL_FILTER_ARITH_NONE;
+	default:
+		if (type == FIELD_TYPE_STRING)
+			return arith_op == SQL_FILTER_ARITH_NONE;
+		return type == FIELD_TYPE_INTEGER ||
+		       type == FIELD_TYPE_UNSIGNED ||
+		       type == FIELD_TYPE_DOUBLE;
+	}
+}
+
+/** Decode an integer field. Unsigned values above INT64_MAX are unknown. */
+static enum sql_filter_result
+sql_filter_load_int(const char *data, union sql_filter_value *value)
+{
+	switch (mp_typeof(*data)) {
+	case MP_NIL:
+		return SQL_FILTER_FALSE;
+	case MP_UINT: {
+		uint64_t u = mp_decode_uint(&data);
+		if (u > INT64_MAX)
+			return SQL_FILTER_UNKNOWN;
+		value->i = (int64_t)u;
+		return SQL_FILTER_TRUE;
+	}
+	case MP_INT:
+		value->i = mp_decode_int(&data);
+		return SQL_FILTER_TRUE;
+	default:
+		return SQL_FILTER_UNKNOWN;
+	}
+}
+
+/** Decode a double field. NaNs are unknown. */
+static enum sql_filter_result
+sql_filter_load_double(const char *data, union sql_filter_value *value)
+{
+	double d;
+	switch (mp_typeof(*data)) {
+	case MP_NIL:
+		return SQL_FILTER_FALSE;
+	case MP_DOUBLE:
+		d = mp_decode_double(&data);
+		break;
+	case MP_FLOAT:
+		d = mp_decode_float(&data);
+		break;
+	default:
+		return SQL_FILTER_UNKNOWN;
+	}
+	if (isnan(d))
+		return SQL_FILTER_UNKNOWN;
+	value->d = d;
+	return SQL_FILTER_TRUE;
+}
+
+/** Decode a string field. */
+static enum sql_filter_result
+sql_filter_load_str(const char *data, union sql_filter_value *value)
+{
+	switch (mp_typeof(*data)) {
+	case MP_NIL:
+		return SQL_FILTER_FALSE;
+	case MP_STR:
+		value->s.z = mp_decode_str(&data, &value->s.n);
+		return SQL_FILTER_TRUE;
+	default:
+		return SQL_FILTER_UNKNOWN;
+	}
+}
+
+static bool
+sql_filter_int_add(union sql_filter_value *value,
+		   const union sql_filter_value *operand)
+{
+	return !__builtin_add_overflow(value->i, operand->i, &value->i);
+}
+
+static bool
+sql_filter_int_sub(union sql_filter_value *value,
+		   const union sql_filter_value *operand)
+{
+	return !__builtin_sub_overflow(value->i, operand->i, &value->i);
+}
+
+static bool
+sql_filter_int_mul(union sql_filter_value *value,
+		   const union sql_filter_value *operand)
+{
+	return !__builtin_mul_overflow(value->i, operand->i, &value->i);
+}
+
+static bool
+sql_filter_double_add(union sql_filter_value *value,
+		      const union sql_filter_value *operand)
+{
+	value->d += operand->d;
+	return !isnan(value->d);
+}
+
+static bool
+sql_filter_double_sub(union sql_filter_value *value,
+		      const union sql_filter_value *operand)
+{
+	value->d -= operand->d;
+	return !isnan(value->d);
+}
+
+static bool
+sql_filter_double_mul(union sql_filter_value *value,
+		      const union sql_filter_value *operand)
+{
+	value->d *= operand->d;
+	return !isnan(value->d);
+}
+
+/** Compare strings the way the binary collation does. */
+static inline int
+sql_filter_str_cmp(const union sql_filter_value *a,
+		   const union sql_filter_value *b)
+{
+	int rc = memcmp(a->s.z, b->s.z, MIN(a->s.n, b->s.n));
+	if (rc != 0)
+		return rc;
+	return a->s.n < b->s.n ? -1 : a->s.n > b->s.n;
+}
+
+#define SQL_FILTER_CMP(name, op)					\
+static bool								\
+sql_filter_int_##name(const union sql_filter_value *value,		\
+		      const union sql_filter_value *constant)		\
+{									\
+	return value->i op constant->i;					\
+}									\
+									\
+static bool								\
+sql_filter_double_##name(const union sql_filter_value *value,		\
+			 const union sql_filter_value *constant)	\
+{									\
+	return value->d op constant->d;					\
+}									\
+									\
+static bool								\
+sql_filter_str_##name(const union sql_filter_value *value,		\
+		      const union sql_filter_value *constant)		\
+{									\
+	return sql_filter_str_cmp(value, constant) op 0;		\
+}
+
+SQL_FILTER_CMP(eq, ==)
+SQL_FILTER_CMP(ne, !=)
+SQL_FILTER_CMP(lt, <)
+SQL_FILTER_CMP(le, <=)
+SQL_FILTER_CMP(gt, >)
+SQL_FILTER_CMP(ge, >=)
+
+#undef SQL_FILTER_CMP
+
+/** Comparisons of each type, indexed by enum sql_filter_op. */
+static const sql_filter_cmp_f sql_filter_int_cmps[] = {
+	sql_filter_int_eq, sql_filter_int_ne, sql_filter_int_lt,
+	sql_filter_int_le, sql_filter_int_gt, sql_filter_int_ge,
+};
+
+static const sql_filter_cmp_f sql_filter_double_cmps[] = {
+	sql_filter_double_eq, sql_filter_double_ne, sql_filter_double_lt,
+	sql_filter_double_le, sql_filter_double_gt, sql_filter_double_ge,
+};
+
+static const sql_filter_cmp_f sql_filter_str_cmps[] = {
+	sql_filter_str_eq, sql_filter_str_ne, sql_filter_str_lt,
+	sql_filter_str_le, sql_filter_str_gt, sql_filter_str_ge,
+};
+
+/** Arithmetic operations of each type, indexed by enum sql_filter_arith. */
+static const sql_filter_arith_f sql_filter_int_ariths[] = {
+	NULL, sql_filter_int_add, sql_filter_int_sub, sql_filter_int_mul,
+};
+
+static const sql_filter_arith_f sql_filter_double_ariths[] = {
+	NULL, sql_filter_double_add, sql_filter_double_sub,
+	sql_filter_double_mul,
+};
+
+/** Test of a term that can't be evaluated by the filter. */
+static enum sql_filter_result
+sql_filter_test_unknown(const struct sql_filter_term *term, const char *data)
+{
+	(void)term;
+	(void)data;
+	return SQL_FILTER_UNKNOWN;
+}
+
+/** Test of a term compared with NULL: the result is always NULL. */
+static enum sql_filter_result
+sql_filter_test_false(const struct sql_filter_term *term, const char *data)
+{
+	(void)term;
+	(void)data;
+	return SQL_FILTER_FALSE;
+}
+
+/**
+ * Test of a comparison: the field is decoded, the arithmetic
+ * operation is applied and the result is compared with the constant.
+ */
+static enum sql_filter_result
+sql_filter_test_cmp(const struct sql_filter_term *term, const char *data)
+{
+	if (data == NULL)
+		return SQL_FILTER_UNKNOWN;
+	union sql_filter_value value;
+	enum sql_filter_result rc = term->load(data, &value);
+	if (rc != SQL_FILTER_TRUE)
+		return rc;
+	if (term->arith != NULL && !term->arith(&value, &term->operand))
+		return SQL_FILTER_UNKNOWN;
+	return term->cmp(&value, &term->value) ?
+	       SQL_FILTER_TRUE : SQL_FILTER_FALSE;
+}
+
+static enum sql_filter_result
+sql_filter_test_is_null(const struct sql_filter_term *term, const char *data)
+{
+	(void)term;
+	if (data == NULL)
+		return SQL_FILTER_UNKNOWN;
+	return mp_typeof(*data) == MP_NIL ? SQL_FILTER_TRUE : SQL_FILTER_FALSE;
+}
+
+static enum sql_filter_result
+sql_filter_test_not_null(const struct sql_filter_term *term, const char *data)
+{
+	(void)term;
+	if (data == NULL)
+		return SQL_FILTER_UNKNOWN;
+	return mp_typeof(*data) == MP_NIL ? SQL_FILTER_FALSE : SQL_FILTER_TRUE;
+}
+
+/**
+ * Test of LIKE with a pattern without wildcards: with the binary
+ * collation it matches only the equal string.
+ */
+static enum sql_filter_result
+sql_filter_test_like_exact(const struct sql_filter_term *term,
+			   const char *data)
+{
+	if (data == NULL)
+		return SQL_FILTER_UNKNOWN;
+	union sql_filter_value value;
+	enum sql_filter_result rc = sql_filter_load_str(data, &value);
+	if (rc != SQL_FILTER_TRUE)
+		return rc;
+	if (value.s.n > SQL_MAX_LENGTH)
+		return SQL_FILTER_UNKNOWN;
+	return sql_filter_str_eq(&value, &term->value) ?
+	       SQL_FILTER_TRUE : SQL_FILTER_FALSE;
+}
+
+/**
+ * Test of LIKE with a pattern of the form "prefix%": with the binary
+ * collation it matches strings that start with the prefix.
+ */
+static enum sql_filter_result
+sql_filter_test_like_prefix(const struct sql_filter_term *term,
+			    const char *data)
+{
+	if (data == NULL)
+		return SQL_FILTER_UNKNOWN;
+	union sql_filter_value value;
+	enum sql_filter_result rc = sql_filter_load_str(data, &value);
+	if (rc != SQL_FILTER_TRUE)
+		return rc;
+	if (value.s.n > SQL_MAX_LENGTH)
+		return SQL_FILTER_UNKNOWN;
+	if (value.s.n < term->value.s.n ||
+	    memcmp(value.s.z, term->value.s.z, term->value.s.n) != 0)
+		return SQL_FILTER_FALSE;
+	return SQL_FILTER_TRUE;
+}
+
+/**
+ * Convert the constant a field is compared with. Only comparisons
+ * that are exact in the type of the field are supported.
+ *
+ * @retval true on success.
+ * @retval false if the comparison can't be evaluated by the filter.
+ */
+static bool
+sql_filter_value_from_mem(const struct Mem *mem, enum field_type type,
+			  union sql_filter_value *value)
+{
+	if (type == FIELD_TYPE_STRING) {
+		if (!mem_is_str(mem))
+			return false;
+		value->s.z = mem->z;
+		value->s.n = mem->n;
+		return true;
+	}
+	if (type == FIELD_TYPE_DOUBLE) {
+		if (mem_is_double(mem) && !isnan(mem->u.r)) {
+			value->d = mem->u.r;
+			return true;
+		}
+		/* Integers up to 2^53 are converted to double exactly. */
+		const int64_t max_exact = (int64_t)1 << 53;
+		if (mem_is_uint(mem) && mem->u.u <= (uint64_t)max_exact) {
+			value->d = (double)mem->u.u;
+			return true;
+		}
+		if (mem_is_nint(mem) && mem->u.i >= -max_exact) {
+			value->d = (double)mem->u.i;
+			return true;
+		}
+		return false;
+	}
+	if (mem_is_uint(mem) && mem->u.u <= INT64_MAX) {
+		value->i = (int64_t)mem->u.u;
+		return true;
+	}
+	if (mem_is_nint(mem)) {
+		value->i = mem->u.i;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Convert the operand of an arithmetic operation. Integers are added
+ * to doubles the same way the byte code does it.
+ */
+static bool
+sql_filter_operand_from_mem(const struct Mem *mem, enum field_type type,
+			    union sql_filter_value *value)
+{
+	if (type != FIELD_TYPE_DOUBLE)
+		return sql_filter_value_from_mem(mem, type, value);
+	if (mem_is_double(mem)) {
+		value->d = mem->u.r;
+		return true;
+	}
+	if (mem_is_uint(mem)) {
+		value->d = (double)mem->u.u;
+		return true;
+	}
+	if (mem_is_nint(mem)) {
+		value->d = (double)mem->u.i;
+		return true;
+	}
+	return false;
+}
+
+/** Choose the test of a comparison term. */
+static sql_filter_test_f
+sql_filter_prepare_cmp(struct sql_filter_term *term, const struct Mem *regs)
+{
+	/*
+	 * The arithmetic operation is checked first since it may fail
+	 * even if the result is compared with NULL.
+	 */
+	if (term->arith_op != SQL_FILTER_ARITH_NONE) {
+		const struct Mem *operand = &regs[term->reg_operand];
+		if (mem_is_null(operand))
+			return sql_filter_test_false;
+		if (!sql_filter_operand_from_mem(operand, term->type,
+						 &term->operand))
+			return sql_filter_test_unknown;
+	}
+	const struct Mem *value = &regs[term->reg_value];
+	if (mem_is_null(value))
+		return sql_filter_test_false;
+	if (!sql_filter_value_from_mem(value, term->type, &term->value))
+		return sql_filter_test_unknown;
+	term->arith = NULL;
+	switch (term->type) {
+	case FIELD_TYPE_STRING:
+		term->load = sql_filter_load_str;
+		term->cmp = sql_filter_str_cmps[term->op];
+		break;
+	case FIELD_TYPE_DOUBLE:
+		term->load = sql_filter_load_double;
+		term->arith = sql_filter_double_ariths[term->arith_op];
+		term->cmp = sql_filter_double_cmps[term->op];
+		break;
+	default:
+		term->load = sql_filter_load_int;
+		term->arith = sql_filter_int_ariths[term->arith_op];
+		term->cmp = sql_filter_int_cmps[term->op];
+		break;
+	}
+	return sql_filter_test_cmp;
+}
+
+/**
+ * Choose the test of a LIKE term. Only patterns that are valid UTF-8
+ * and contain no wildcards except the trailing '%' are supported.
+ */
+static sql_filter_test_f
+sql_filter_prepare_like(struct sql_filter_term *term, const struct Mem *regs)
+{
+	const struct Mem *pattern = &regs[term->reg_value];
+	if (mem_is_null(pattern))
+		return sql_filter_test_false;
+	int limit = sql_get()->aLimit[SQL_LIMIT_LIKE_PATTERN_LENGTH];
+	if (!mem_is_str(pattern) || pattern->n > SQL_MAX_LENGTH ||
+	    pattern->n > (size_t)limit)
+		return sql_filter_test_unknown;
+	const char *z = pattern->z;
+	int32_t len = pattern->n;
+	int32_t prefix_len = len;
+	for (int32_t pos = 0; pos < len; ) {
+		int32_t char_pos = pos;
+		UChar32 c;
+		U8_NEXT((const uint8_t *)z, pos, len, c);
+		/*
+		 * U+FFFD is treated by LIKE as an invalid symbol too.
+		 */
+		if (c < 0 || c == 0xfffd || c == '_')
+			return sql_filter_test_unknown;
+		if (c == '%' && prefix_len == len)
+			prefix_len = char_pos;
+		else if (c != '%' && prefix_len != len)
+			return sql_filter_test_unknown;
+	}
+	term->value.s.z = z;
+	term->value.s.n = prefix_len;
+	if (prefix_len == len)
+		return sql_filter_test_like_exact;
+	return sql_filter_test_like_prefix;
+}
+
+void
+sql_filter_prepare(struct sql_filter *filter, const struct Mem *regs)
+{
+	for (uint32_t i = 0; i < filter->term_count; i++) {
+		struct sql_filter_term *term = &filter->terms[i];
+		switch (term->op) {
+		case SQL_FILTER_IS_NULL:
+			term->test = sql_filter_test_is_null;
+			break;
+		case SQL_FILTER_NOT_NULL:
+			term->test = sql_filter_test_not_null;
+			break;
+		case SQL_FILTER_LIKE:
+			term->test = sql_filter_prepare_like(term, regs);
+			break;
+		default:
+			term->test = sql_filter_prepare_cmp(term, regs);
+			break;
+		}
+	}
+}
@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "box/field_def.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Mem;
+struct sql_filter_term;
+
+/** Result of a filter term test. */
+enum sql_filter_result {
+	/** The tuple doesn't pass the term: it's FALSE or NULL. */
+	SQL_FILTER_FALSE,
+	/** The tuple passes the term. */
+	SQL_FILTER_TRUE,
+	/**
+	 * The term can't be evaluated exactly by the filter, e.g. the
+	 * field has an unexpected type or an integer overflows. The
+	 * term must be evaluated by the byte code.
+	 */
+	SQL_FILTER_UNKNOWN,
+};
+
+/** Operations of filter terms. */
+enum sql_filter_op {
+	/** "expr = const". */
+	SQL_FILTER_EQ,
+	/** "expr <> const". */
+	SQL_FILTER_NE,
+	/** "expr < const". */
+	SQL_FILTER_LT,
+	/** "expr <= const". */
+	SQL_FILTER_LE,
+	/** "expr > const". */
+	SQL_FILTER_GT,
+	/** "expr >= const". */
+	SQL_FILTER_GE,
+	/** "field IS NULL". */
+	SQL_FILTER_IS_NULL,
+	/** "field IS NOT NULL". */
+	SQL_FILTER_NOT_NULL,
+	/** "field LIKE const". */
+	SQL_FILTER_LIKE,
+};
+
+/** Arithmetic operations applied to a field before a comparison. */
+enum sql_filter_arith {
+	/** The field is compared as is. */
+	SQL_FILTER_ARITH_NONE,
+	/** "field + const". */
+	SQL_FILTER_ARITH_ADD,
+	/** "field - const". */
+	SQL_FILTER_ARITH_SUB,
+	/** "field * const". */
+	SQL_FILTER_ARITH_MUL,
+};
+
+/** A value of a field or a constant decoded for a filter term. */
+union sql_filter_value {
+	/** Value of an INTEGER or UNSIGNED field. */
+	int64_t i;
+	/** Value of a DOUBLE field. */
+	double d;
+	/** Value of a STRING field. */
+	struct {
+		/** String, not NUL-terminated. */
+		const char *z;
+		/** Length of the string. */
+		uint32_t n;
+	} s;
+};
+
+/**
+ * Test the MsgPack value of a field. @a data is NULL if the tuple
+ * has no such field.
+ */
+typedef enum sql_filter_result
+(*sql_filter_test_f)(const struct sql_filter_term *term, const char *data);
+
+/**
+ * Decode the MsgPack value of a field. Return SQL_FILTER_FALSE if the
+ * value is NULL and SQL_FILTER_UNKNOWN if it has an unexpected type.
+ */
+typedef enum sql_filter_result
+(*sql_filter_load_f)(const char *data, union sql_filter_value *value);
+
+/**
+ * Apply an arithmetic operation to a field value and a constant.
+ * Return false if the result can't be computed exactly.
+ */
+typedef bool
+(*sql_filter_arith_f)(union sql_filter_value *value,
+		      const union sql_filter_value *operand);
+
+/** Compare a field value with a constant. */
+typedef bool
+(*sql_filter_cmp_f)(const union sql_filter_value *value,
+		    const union sql_filter_value *constant);
+
+/**
+ * A term of the WHERE clause of the form "field <op> const", "field
+ * <arith> const <op> const", "field IS [NOT] NULL" or "field LIKE
+ * const" compiled to a chain of functions specialized for the type of
+ * the field, the operations and the types of the constants.
+ */
+struct sql_filter_term {
+	/** Operation of the term. */
+	enum sql_filter_op op;
+	/** Arithmetic operation applied to the field. */
+	enum sql_filter_arith arith_op;
+	/** Number of the field in the tuples. */
+	uint32_t fieldno;
+	/** Type of the field. */
+	enum field_type type;
+	/** Register of the constant the field is compared with. */
+	int reg_value;
+	/** Register of the operand of the arithmetic operation. */
+	int reg_operand;
+	/**
+	 * Test of the field chosen by sql_filter_prepare() for the
+	 * current values of the constants.
+	 */
+	sql_filter_test_f test;
+	/** Decoder of the field value used by comparisons. */
+	sql_filter_load_f load;
+	/** Arithmetic operation used by comparisons or NULL. */
+	sql_filter_arith_f arith;
+	/** Comparison of the field value with the constant. */
+	sql_filter_cmp_f cmp;
+	/** The constant the field is compared with. */
+	union sql_filter_value value;
+	/** The operand of the arithmetic operation. */
+	union sql_filter_value operand;
+};
+
+/**
+ * Filter of tuples of a cursor: a conjunction of terms of the WHERE
+ * clause evaluated by the OP_Filter instruction instead of the byte
+ * code of the terms.
+ */
+struct sql_filter {
+	/**
+	 * Value of P1 of the OP_Init instruction at the moment the terms
+	 * were specialized for the values of the constants. The terms
+	 * are specialized once per execution of the statement.
+	 */
+	int run;
+	/** Number of terms. */
+	uint32_t term_count;
+	/** Terms, all of which must be passed by a tuple. */
+	struct sql_filter_term *terms;
+};
+
+/**
+ * Allocate a filter with room for @a term_count terms. The filter is
+ * allocated as a single chunk of memory and must be freed with
+ * sql_xfree().
+ */
+struct sql_filter *
+sql_filter_new(uint32_t term_count);
+
+/** Check if fields of the given type can be tested by a filter. */
+bool
+sql_filter_type_is_supported(enum field_type type, enum sql_filter_op op,
+			     enum sql_filter_arith arith_op);
+
+/**
+ * Choose the functions implementing the terms of the filter for the
+ * values of the constants stored in @a regs. Terms that can't be
+ * evaluated exactly for these values always return
+ * SQL_FILTER_UNKNOWN.
+ */
+void
+sql_filter_prepare(struct sql_filter *filter, const struct Mem *regs);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -0,0 +1,237 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "hash_join.h"
+
+#include "sqlInt.h"
+#include "mem.h"
+#include "box/key_def.h"
+#include "fiber.h"
+#include "small/region.h"
+#include "msgpuck/msgpuck.h"
+
+/** A row stored in the hash table. */
+struct sql_hash_join_row {
+	/** Next row with the same key. */
+	struct sql_hash_join_row *next;
+	/** Hash of the key of the row. */
+	uint32_t hash;
+	/** Size of the MsgPack array of the row. */
+	uint32_t size;
+	/** MsgPack array of the row. */
+	char data[0];
+};
+
+/** Key used to look up rows in the hash table. */
+struct sql_hash_join_key {
+	/** Key fields without the MsgPack array header. */
+	const char *data;
+	/** Hash of the key. */
+	uint32_t hash;
+};
+
+/** Return the key of the row: its fields without the array header. */
+static inline const char *
+sql_hash_join_row_key(const struct sql_hash_join_row *row)
+{
+	const char *key = row->data;
+	mp_decode_array(&key);
+	return key;
+}
+
+/** Return 0 if the key is equal to the key of the row. */
+static inline int
+sql_hash_join_key_cmp(const char *key, const struct sql_hash_join_row *row,
+		      struct key_def *key_def)
+{
+	return key_compare(key, key_def->part_count, HINT_NONE,
+			   sql_hash_join_row_key(row), key_def->part_count,
+			   HINT_NONE, key_def);
+}
+
+/*
+ * Nodes of the hash table are the heads of chains of rows that have
+ * equal keys.
+ */
+#define MH_SOURCE 1
+#define mh_name _sql_hash_join
+#define mh_key_t const struct sql_hash_join_key *
+#define mh_node_t struct sql_hash_join_row *
+#define mh_arg_t struct key_def *
+#define mh_hash(a, arg) ((*(a))->hash)
+#define mh_hash_key(a, arg) ((a)->hash)
+#define mh_cmp(a, b, arg) \
+	(sql_hash_join_key_cmp(sql_hash_join_row_key(*(a)), *(b), arg) != 0)
+#define mh_cmp_key(a, b, arg) \
+	(sql_hash_join_key_cmp((a)->data, *(b), arg) != 0)
+#include "salad/mhash.h"
+
+struct sql_hash_join {
+	/** Hash table of chains of rows with equal keys. */
+	struct mh_sql_hash_join_t *hash;
+	/** Definition of the key: the first fields of the rows. */
+	struct key_def *key_def;
+	/** Types of all fields of the rows. */
+	const enum field_type *types;
+	/** Number of fields of the rows. */
+	uint32_t field_count;
+	/** Region the rows are allocated on. */
+	struct region region;
+	/** The row the iterator points to. */
+	struct sql_hash_join_row *curr;
+};
+
+bool
+sql_hash_join_type_is_supported(enum field_type type)
+{
+	/*
+	 * Values of other types may be equal while having different
+	 * MsgPack representations, e.g. decimals 1.0 and 1.00, so their
+	 * hashes would differ.
+	 */
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_DOUBLE:
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_VARBINARY:
+	case FIELD_TYPE_UUID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+struct sql_hash_join *
+sql_hash_join_new(const struct sql_space_info *info)
+{
+	assert(info->parts != NULL && info->part_count > 0);
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	struct key_part_def *parts =
+		xregion_alloc_array(region, typeof(*parts), info->part_count);
+	for (uint32_t i = 0; i < info->part_count; i++) {
+		uint32_t fieldno = info->parts[i];
+		assert(fieldno == i);
+		assert(sql_hash_join_type_is_supported(info->types[fieldno]));
+		parts[i].fieldno = fieldno;
+		parts[i].type = info->types[fieldno];
+		parts[i].coll_id = info->coll_ids[fieldno];
+		parts[i].is_nullable = true;
+		parts[i].nullable_action = ON_CONFLICT_ACTION_NONE;
+		parts[i].exclude_null = false;
+		parts[i].sort_order = SORT_ORDER_ASC;
+		parts[i].path = NULL;
+	}
+	struct key_def *key_def = key_def_new(parts, info->part_count, 0);
+	region_truncate(region, svp);
+	if (key_def == NULL)
+		return NULL;
+	struct sql_hash_join *hash_join = xmalloc(sizeof(*hash_join));
+	hash_join->hash = mh_sql_hash_join_new();
+	hash_join->key_def = key_def;
+	hash_join->types = info->types;
+	hash_join->field_count = info->field_count;
+	region_create(&hash_join->region, &cord()->slabc);
+	hash_join->curr = NULL;
+	return hash_join;
+}
+
+void
+sql_hash_join_delete(struct sql_hash_join *hash_join)
+{
+	if (hash_join == NULL)
+		return;
+	mh_sql_hash_join_delete(hash_join->hash);
+	region_destroy(&hash_join->region);
+	key_def_delete(hash_join->key_def);
+	free(hash_join);
+}
+
+struct key_def *
+sql_hash_join_key_def(const struct sql_hash_join *hash_join)
+{
+	return hash_join->key_def;
+}
+
+enum field_type
+sql_hash_join_field_type(const struct sql_hash_join *hash_join,
+			 uint32_t fieldno)
+{
+	assert(fieldno < hash_join->field_count);
+	return hash_join->types[fieldno];
+}
+
+int
+sql_hash_join_insert(struct sql_hash_join *hash_join, const char *data,
+		     uint32_t size)
+{
+	struct sql_hash_join_row *row;
+	size_t row_size = sizeof(*row) + size;
+	row = region_aligned_alloc(&hash_join->region, row_size,
+				   alignof(*row));
+	if (row == NULL) {
+		diag_set(OutOfMemory, row_size, "region_aligned_alloc", "row");
+		return -1;
+	}
+	memcpy(row->data, data, size);
+	row->size = size;
+	row->hash = key_hash(sql_hash_join_row_key(row), hash_join->key_def);
+	/*
+	 * The new row replaces the head of the chain of rows with the
+	 * same key, if any, and the old head is linked after it.
+	 */
+	struct sql_hash_join_row *replaced = NULL;
+	struct sql_hash_join_row **preplaced = &replaced;
+	mh_sql_hash_join_put(hash_join->hash, &row, &preplaced,
+			     hash_join->key_def);
+	row->next = preplaced != NULL ? replaced : NULL;
+	return 0;
+}
+
+int
+sql_hash_join_probe(struct sql_hash_join *hash_join, const struct Mem *mems,
+		    uint32_t count, bool *found)
+{
+	assert(count == hash_join->key_def->part_count);
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	uint32_t size;
+	const char *data = mem_encode_array(mems, count, &size, region);
+	if (data == NULL)
+		return -1;
+	mp_decode_array(&data);
+	struct sql_hash_join_key key;
+	key.data = data;
+	key.hash = key_hash(data, hash_join->key_def);
+	mh_int_t pos = mh_sql_hash_join_find(hash_join->hash, &key,
+					     hash_join->key_def);
+	region_truncate(region, svp);
+	if (pos == mh_end(hash_join->hash)) {
+		hash_join->curr = NULL;
+		*found = false;
+		return 0;
+	}
+	hash_join->curr = *mh_sql_hash_join_node(hash_join->hash, pos);
+	*found = true;
+	return 0;
+}
+
+bool
+sql_hash_join_next(struct sql_hash_join *hash_join)
+{
+	assert(hash_join->curr != NULL);
+	hash_join->curr = hash_join->curr->next;
+	return hash_join->curr != NULL;
+}
+
+const char *
+sql_hash_join_row(const struct sql_hash_join *hash_join, uint32_t *size)
+{
+	assert(hash_join->curr != NULL);
+	*size = hash_join->curr->size;
+	return hash_join->curr->data;
+}
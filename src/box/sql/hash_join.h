@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "box/field_def.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Mem;
+struct sql_space_info;
+struct sql_hash_join;
+
+/**
+ * Create an in-memory hash table used as the build side of a hash join.
+ * The table stores MsgPack arrays with field types described by @a info.
+ * It is keyed by the first info->part_count fields of the arrays, and
+ * rows with equal keys are chained together.
+ *
+ * @retval NULL on error, diag is set.
+ */
+struct sql_hash_join *
+sql_hash_join_new(const struct sql_space_info *info);
+
+/** Free the hash table and all rows stored in it. NULL is allowed. */
+void
+sql_hash_join_delete(struct sql_hash_join *hash_join);
+
+/** Return the key definition of the hash table. */
+struct key_def *
+sql_hash_join_key_def(const struct sql_hash_join *hash_join);
+
+/** Return the type of the given field of the stored rows. */
+enum field_type
+sql_hash_join_field_type(const struct sql_hash_join *hash_join,
+			 uint32_t fieldno);
+
+/**
+ * Copy the MsgPack array @a data of @a size bytes into the hash table.
+ * @retval 0 on success.
+ * @retval -1 on memory error, diag is set.
+ */
+int
+sql_hash_join_insert(struct sql_hash_join *hash_join, const char *data,
+		     uint32_t size);
+
+/**
+ * Look up rows with the key given by @a count MEMs and position the hash
+ * table iterator at the first of them. The MEMs must be compatible with
+ * the types of the key parts.
+ *
+ * @param[out] found Set to true if there is a matching row.
+ * @retval 0 on success.
+ * @retval -1 on error, diag is set.
+ */
+int
+sql_hash_join_probe(struct sql_hash_join *hash_join, const struct Mem *mems,
+		    uint32_t count, bool *found);
+
+/**
+ * Advance the iterator to the next row with the same key.
+ * @retval true if the iterator points to a row.
+ */
+bool
+sql_hash_join_next(struct sql_hash_join *hash_join);
+
+/** Return the row the iterator points to. */
+const char *
+sql_hash_join_row(const struct sql_hash_join *hash_join, uint32_t *size);
+
+/**
+ * Check if values of the given field type can be looked up in a hash
+ * table: equal values of the type must have equal hashes.
+ */
+bool
+sql_hash_join_type_is_supported(enum field_type type);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
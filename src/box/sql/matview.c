@@ -0,0 +1,656 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "matview.h"
+
+#include "sqlInt.h"
+#include "mem.h"
+#include "box/box.h"
+#include "box/coll_id_cache.h"
+#include "box/engine.h"
+#include "box/schema.h"
+#include "box/session.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "box/txn.h"
+#include "msgpuck/msgpuck.h"
+
+/** List of all attached materialized views. */
+static RLIST_HEAD(sql_matviews);
+
+/**
+ * Fiber writing rows of a materialized view or NULL. Only the view
+ * itself may change its space, see sql_matview_check_write().
+ */
+static struct fiber *sql_matview_writer;
+
+static int
+sql_matview_on_replace(struct trigger *trigger, void *event);
+
+/**
+ * Return the number of the field of the base space referenced by a
+ * column expression or UINT32_MAX if the expression is not a plain
+ * column reference.
+ */
+static uint32_t
+sql_matview_fieldno(const struct space *base, const struct Expr *expr)
+{
+	if (expr->op == TK_DOT)
+		expr = expr->pRight;
+	if (expr->op != TK_ID)
+		return UINT32_MAX;
+	return sql_fieldno_by_expr(base, expr);
+}
+
+/**
+ * Fill a column of the view from an item of the SELECT list. Return
+ * the reason the item is not supported or NULL.
+ */
+static const char *
+sql_matview_column_init(struct sql_matview_column *column,
+			const struct space *base, const struct Expr *expr)
+{
+	column->coll = NULL;
+	column->fieldno = sql_matview_fieldno(base, expr);
+	if (column->fieldno != UINT32_MAX) {
+		column->kind = SQL_MATVIEW_GROUP;
+		return NULL;
+	}
+	if (expr->op != TK_FUNCTION || ExprHasProperty(expr, EP_Distinct))
+		return "only columns and COUNT, SUM, MIN and MAX are allowed";
+	const char *name = expr->u.zToken;
+	const struct ExprList *args = expr->x.pList;
+	if (args == NULL) {
+		if (sqlStrICmp(name, "COUNT") != 0)
+			return "only columns and COUNT, SUM, MIN and MAX are "
+			       "allowed";
+		column->kind = SQL_MATVIEW_COUNT_ALL;
+		return NULL;
+	}
+	if (sqlStrICmp(name, "COUNT") == 0)
+		column->kind = SQL_MATVIEW_COUNT;
+	else if (sqlStrICmp(name, "SUM") == 0)
+		column->kind = SQL_MATVIEW_SUM;
+	else if (sqlStrICmp(name, "MIN") == 0)
+		column->kind = SQL_MATVIEW_MIN;
+	else if (sqlStrICmp(name, "MAX") == 0)
+		column->kind = SQL_MATVIEW_MAX;
+	else
+		return "only columns and COUNT, SUM, MIN and MAX are allowed";
+	if (args->nExpr != 1)
+		return "aggregate functions must have one argument";
+	column->fieldno = sql_matview_fieldno(base, args->a[0].pExpr);
+	if (column->fieldno == UINT32_MAX)
+		return "arguments of aggregate functions must be columns";
+	const struct field_def *field = &base->def->fields[column->fieldno];
+	switch (column->kind) {
+	case SQL_MATVIEW_SUM:
+		/*
+		 * Sums are maintained by adding and subtracting deltas,
+		 * which accumulates rounding errors for floating point
+		 * values, so only exact integer sums are supported.
+		 */
+		if (field->type != FIELD_TYPE_INTEGER &&
+		    field->type != FIELD_TYPE_UNSIGNED)
+			return "SUM is allowed only for integer columns";
+		break;
+	case SQL_MATVIEW_MIN:
+	case SQL_MATVIEW_MAX:
+		if (field->type == FIELD_TYPE_ANY ||
+		    field->type == FIELD_TYPE_BOOLEAN ||
+		    field->type == FIELD_TYPE_MAP ||
+		    field->type == FIELD_TYPE_ARRAY ||
+		    field->type == FIELD_TYPE_DATETIME ||
+		    field->type == FIELD_TYPE_INTERVAL)
+			return "MIN and MAX are allowed only for scalar "
+			       "columns";
+		if (field->coll_id != COLL_NONE)
+			column->coll = coll_by_id(field->coll_id)->coll;
+		break;
+	default:
+		break;
+	}
+	return NULL;
+}
+
+/**
+ * Fill the view from the SELECT of its definition. Return the
+ * reason the SELECT is not supported or NULL.
+ */
+static const char *
+sql_matview_init(struct sql_matview *view, const struct space_def *def,
+		 const struct Select *select)
+{
+	if (select->pPrior != NULL || select->pWith != NULL ||
+	    select->pWhere != NULL || select->pHaving != NULL ||
+	    select->pOrderBy != NULL || select->pLimit != NULL ||
+	    (select->selFlags & SF_Distinct) != 0)
+		return "only GROUP BY SELECT without WHERE, HAVING, "
+		       "ORDER BY, LIMIT, DISTINCT and compound parts is "
+		       "supported";
+	if (select->pGroupBy == NULL)
+		return "GROUP BY clause is required";
+	const struct SrcList *src = select->pSrc;
+	if (src == NULL || src->nSrc != 1 || src->a[0].pSelect != NULL)
+		return "SELECT must read a single space";
+	const struct space *base = sql_space_by_src(&src->a[0]);
+	if (base == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_SPACE, src->a[0].zName);
+		return "";
+	}
+	if (base->def->opts.is_view || base->def->opts.is_materialized ||
+	    !space_is_memtx(base) || space_is_data_temporary(base))
+		return "the base space must be a persistent memtx space";
+	/* The view exposes the data of the base space to its readers. */
+	if (access_check_space((struct space *)base, PRIV_R) != 0)
+		return "";
+	view->base_id = base->def->id;
+
+	const struct ExprList *list = select->pEList;
+	if ((uint32_t)list->nExpr != def->field_count)
+		return "number of columns doesn't match the format";
+	view->column_count = list->nExpr;
+	view->columns = sql_xmalloc0(list->nExpr * sizeof(view->columns[0]));
+	uint32_t count_fieldno = view->column_count + 1;
+	for (int i = 0; i < list->nExpr; i++) {
+		struct sql_matview_column *column = &view->columns[i];
+		const char *err = sql_matview_column_init(column, base,
+							  list->a[i].pExpr);
+		if (err != NULL)
+			return err;
+		if (column->kind == SQL_MATVIEW_SUM ||
+		    column->kind == SQL_MATVIEW_MIN ||
+		    column->kind == SQL_MATVIEW_MAX)
+			column->count_fieldno = count_fieldno++;
+	}
+	view->field_count = count_fieldno;
+
+	const struct ExprList *group_by = select->pGroupBy;
+	view->group_count = group_by->nExpr;
+	view->group_columns =
+		sql_xmalloc(group_by->nExpr * sizeof(view->group_columns[0]));
+	size_t region_svp = region_used(&fiber()->gc);
+	struct key_part_def *parts =
+		xregion_alloc_array(&fiber()->gc, typeof(parts[0]),
+				    group_by->nExpr);
+	const char *err = NULL;
+	for (int i = 0; i < group_by->nExpr && err == NULL; i++) {
+		uint32_t fieldno = sql_matview_fieldno(base,
+						       group_by->a[i].pExpr);
+		if (fieldno == UINT32_MAX) {
+			err = "GROUP BY terms must be columns";
+			break;
+		}
+		const struct field_def *field = &base->def->fields[fieldno];
+		if (field->is_nullable) {
+			err = "GROUP BY columns must be NOT NULL";
+			break;
+		}
+		view->group_columns[i] = UINT32_MAX;
+		for (uint32_t j = 0; j < view->column_count; j++) {
+			if (view->columns[j].kind == SQL_MATVIEW_GROUP &&
+			    view->columns[j].fieldno == fieldno) {
+				view->group_columns[i] = j;
+				break;
+			}
+		}
+		if (view->group_columns[i] == UINT32_MAX) {
+			err = "all GROUP BY columns must be selected";
+			break;
+		}
+		for (int j = 0; j < i; j++) {
+			if (parts[j].fieldno == fieldno) {
+				err = "GROUP BY columns must be distinct";
+				break;
+			}
+		}
+		parts[i] = key_part_def_default;
+		parts[i].fieldno = fieldno;
+		parts[i].type = field->type;
+		parts[i].coll_id = field->coll_id;
+	}
+	for (uint32_t i = 0; i < view->column_count && err == NULL; i++) {
+		const struct sql_matview_column *column = &view->columns[i];
+		if (column->kind != SQL_MATVIEW_GROUP)
+			continue;
+		bool is_grouped = false;
+		for (int j = 0; j < group_by->nExpr; j++)
+			is_grouped |= parts[j].fieldno == column->fieldno;
+		if (!is_grouped)
+			err = "selected columns must be in GROUP BY";
+	}
+	if (err == NULL) {
+		view->group_key_def = key_def_new(parts, group_by->nExpr, 0);
+		if (view->group_key_def == NULL)
+			err = "";
+	}
+	region_truncate(&fiber()->gc, region_svp);
+	return err;
+}
+
+struct sql_matview *
+sql_matview_new(const struct space_def *def)
+{
+	assert(def->opts.is_materialized && def->opts.sql != NULL);
+	if (strcmp(def->engine_name, "memtx") != 0) {
+		diag_set(ClientError, ER_CREATE_SPACE, def->name,
+			 "materialized view must be a memtx space");
+		return NULL;
+	}
+	struct Select *select = sql_view_compile(def->opts.sql);
+	if (select == NULL)
+		return NULL;
+	struct sql_matview *view = sql_xmalloc0(sizeof(*view));
+	view->id = def->id;
+	trigger_create(&view->on_replace, sql_matview_on_replace, view, NULL);
+	rlist_create(&view->link);
+	const char *err = sql_matview_init(view, def, select);
+	sql_select_delete(select);
+	if (err != NULL) {
+		/* An empty reason means that diag is already set. */
+		if (*err != '\0')
+			diag_set(ClientError, ER_CREATE_SPACE, def->name,
+				 tt_sprintf("materialized view: %s", err));
+		sql_matview_delete(view);
+		return NULL;
+	}
+	return view;
+}
+
+void
+sql_matview_delete(struct sql_matview *view)
+{
+	assert(rlist_empty(&view->link));
+	if (view->group_key_def != NULL)
+		key_def_delete(view->group_key_def);
+	sql_xfree(view->group_columns);
+	sql_xfree(view->columns);
+	sql_xfree(view);
+}
+
+struct sql_matview *
+sql_matview_by_id(uint32_t id)
+{
+	struct sql_matview *view;
+	rlist_foreach_entry(view, &sql_matviews, link) {
+		if (view->id == id)
+			return view;
+	}
+	return NULL;
+}
+
+int
+sql_matview_check_write(const struct space_def *def)
+{
+	if (!def->opts.is_materialized || sql_matview_writer == fiber())
+		return 0;
+	diag_set(ClientError, ER_VIEW_IS_RO, def->name);
+	return -1;
+}
+
+bool
+sql_matview_space_is_base(uint32_t space_id)
+{
+	struct sql_matview *view;
+	rlist_foreach_entry(view, &sql_matviews, link) {
+		if (view->base_id == space_id)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Encode the fields of a tuple at the first @a part_count parts of a
+ * key definition as a key on the region.
+ */
+static const char *
+sql_matview_key(struct tuple *tuple, const struct key_def *key_def,
+		uint32_t part_count, const char **key_end)
+{
+	struct region *region = &fiber()->gc;
+	size_t size = mp_sizeof_array(part_count);
+	for (uint32_t i = 0; i < part_count; i++) {
+		const char *field = tuple_field(tuple,
+						key_def->parts[i].fieldno);
+		const char *end = field;
+		mp_next(&end);
+		size += end - field;
+	}
+	char *key = xregion_alloc(region, size);
+	char *pos = mp_encode_array(key, part_count);
+	for (uint32_t i = 0; i < part_count; i++) {
+		const char *field = tuple_field(tuple,
+						key_def->parts[i].fieldno);
+		const char *end = field;
+		mp_next(&end);
+		memcpy(pos, field, end - field);
+		pos += end - field;
+	}
+	*key_end = pos;
+	return key;
+}
+
+/**
+ * Find a TREE index of the base space whose key starts with the
+ * GROUP BY fields so that the tuples of a group can be found without
+ * a full scan.
+ */
+static struct index *
+sql_matview_group_index(struct sql_matview *view, struct space *base)
+{
+	const struct key_def *group_key_def = view->group_key_def;
+	for (uint32_t i = 0; i < base->index_count; i++) {
+		struct index *index = base->index[i];
+		const struct key_def *key_def = index->def->key_def;
+		if (index->def->type != TREE || key_def->is_multikey ||
+		    key_def->for_func_index ||
+		    key_def->part_count < view->group_count)
+			continue;
+		uint32_t j = 0;
+		for (; j < view->group_count; j++) {
+			const struct key_part *part = &key_def->parts[j];
+			const struct key_part *group_part =
+				key_def_find_by_fieldno(group_key_def,
+							part->fieldno);
+			if (part->path != NULL || group_part == NULL ||
+			    group_part->coll_id != part->coll_id)
+				break;
+		}
+		if (j == view->group_count)
+			return index;
+	}
+	return NULL;
+}
+
+/** Check if a value is better than the current MIN or MAX. */
+static inline bool
+sql_matview_is_better(const struct sql_matview_column *column,
+		      const struct Mem *value, const struct Mem *current)
+{
+	if (mem_is_null(current))
+		return true;
+	int cmp = mem_cmp_scalar(value, current, column->coll);
+	return column->kind == SQL_MATVIEW_MIN ? cmp < 0 : cmp > 0;
+}
+
+/**
+ * Compute MIN or MAX of a column over the base tuples of the group of
+ * a tuple after the current value of the aggregate was deleted.
+ */
+static int
+sql_matview_extremum(struct sql_matview *view,
+		     const struct sql_matview_column *column,
+		     struct tuple *tuple, struct Mem *result)
+{
+	struct space *base = space_by_id(view->base_id);
+	assert(base != NULL);
+	struct index *index = sql_matview_group_index(view, base);
+	bool is_full_scan = index == NULL;
+	const char *key_end;
+	const char *key;
+	struct iterator *it;
+	if (!is_full_scan) {
+		key = sql_matview_key(tuple, index->def->key_def,
+				      view->group_count, &key_end);
+		it = index_create_iterator(index, ITER_EQ, key,
+					   view->group_count);
+	} else {
+		index = index_find(base, 0);
+		if (index == NULL)
+			return -1;
+		key = sql_matview_key(tuple, view->group_key_def,
+				      view->group_count, &key_end);
+		it = index_create_iterator(index, ITER_ALL, NULL, 0);
+	}
+	if (it == NULL)
+		return -1;
+	mem_set_null(result);
+	struct Mem value;
+	mem_create(&value);
+	struct tuple *base_tuple;
+	int rc;
+	while ((rc = iterator_next(it, &base_tuple)) == 0 &&
+	       base_tuple != NULL) {
+		if (is_full_scan &&
+		    tuple_compare_with_key(base_tuple, HINT_NONE, key,
+					   view->group_count, HINT_NONE,
+					   view->group_key_def) != 0)
+			continue;
+		const char *field = tuple_field(base_tuple, column->fieldno);
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			continue;
+		uint32_t len;
+		if (mem_from_mp_ephemeral(&value, field, &len) != 0) {
+			rc = -1;
+			break;
+		}
+		if (sql_matview_is_better(column, &value, result) &&
+		    mem_copy(result, &value) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	iterator_delete(it);
+	return rc;
+}
+
+/** Return the value of a hidden counter of a row of the view. */
+static inline uint64_t
+sql_matview_counter(const struct Mem *mem)
+{
+	return mem_is_uint(mem) ? mem->u.u : 0;
+}
+
+/**
+ * Write a row of the view or delete it if @a row is NULL. The view
+ * is updated on behalf of the admin since the user changing the base
+ * space may have no access to the view.
+ */
+static int
+sql_matview_write(struct sql_matview *view, const char *key,
+		  const char *key_end, const struct Mem *row)
+{
+	struct credentials *orig_credentials = effective_user();
+	fiber_set_user(fiber(), &admin_credentials);
+	assert(sql_matview_writer == NULL);
+	sql_matview_writer = fiber();
+	int rc;
+	if (row == NULL) {
+		rc = box_delete(view->id, 0, key, key_end, NULL);
+	} else {
+		uint32_t size;
+		const char *data = mem_encode_array(row, view->field_count,
+						    &size, &fiber()->gc);
+		rc = data == NULL ? -1 :
+		     box_replace(view->id, data, data + size, NULL);
+	}
+	sql_matview_writer = NULL;
+	fiber_set_user(fiber(), orig_credentials);
+	return rc;
+}
+
+/**
+ * Apply an inserted (@a sign is 1) or a deleted (@a sign is -1) base
+ * tuple to the row of its group.
+ */
+static int
+sql_matview_apply(struct sql_matview *view, struct tuple *tuple, int sign)
+{
+	struct space *space = space_by_id(view->id);
+	assert(space != NULL);
+	struct index *pk = index_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char *key_end;
+	const char *key = sql_matview_key(tuple, view->group_key_def,
+					  view->group_count, &key_end);
+	struct tuple *old_row;
+	if (index_get(pk, key, view->group_count, &old_row) != 0)
+		goto error;
+	uint64_t row_count = 0;
+	struct Mem *row = xregion_alloc_array(region, struct Mem,
+					      view->field_count);
+	for (uint32_t i = 0; i < view->field_count; i++)
+		mem_create(&row[i]);
+	if (old_row != NULL) {
+		const char *data = tuple_data(old_row);
+		uint32_t count = mp_decode_array(&data);
+		for (uint32_t i = 0; i < count && i < view->field_count; i++) {
+			uint32_t len;
+			if (mem_from_mp_ephemeral(&row[i], data, &len) != 0)
+				goto error_row;
+			data += len;
+		}
+		row_count = sql_matview_counter(&row[view->column_count]);
+	}
+	if (sign < 0 && row_count <= 1) {
+		/* The last tuple of the group is deleted. */
+		int rc = old_row == NULL ? 0 :
+			 sql_matview_write(view, key, key_end, NULL);
+		for (uint32_t i = 0; i < view->field_count; i++)
+			mem_destroy(&row[i]);
+		region_truncate(region, region_svp);
+		return rc;
+	}
+	row_count += sign;
+	mem_set_uint(&row[view->column_count], row_count);
+	for (uint32_t i = 0; i < view->column_count; i++) {
+		const struct sql_matview_column *column = &view->columns[i];
+		struct Mem *result = &row[i];
+		if (column->kind == SQL_MATVIEW_COUNT_ALL) {
+			mem_set_uint(result, row_count);
+			continue;
+		}
+		if (old_row == NULL && column->kind == SQL_MATVIEW_COUNT)
+			mem_set_uint(result, 0);
+		const char *field = tuple_field(tuple, column->fieldno);
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			continue;
+		struct Mem value;
+		uint32_t len;
+		mem_create(&value);
+		if (mem_from_mp_ephemeral(&value, field, &len) != 0)
+			goto error_row;
+		if (column->kind == SQL_MATVIEW_GROUP) {
+			if (old_row == NULL && mem_copy(result, &value) != 0)
+				goto error_row;
+			continue;
+		}
+		if (column->kind == SQL_MATVIEW_COUNT) {
+			mem_set_uint(result,
+				     sql_matview_counter(result) + sign);
+			continue;
+		}
+		struct Mem *count = &row[column->count_fieldno];
+		uint64_t value_count = sql_matview_counter(count);
+		if (sign < 0 && value_count <= 1) {
+			mem_set_uint(count, 0);
+			mem_set_null(result);
+			continue;
+		}
+		mem_set_uint(count, value_count + sign);
+		if (mem_is_null(result)) {
+			/* The first non-NULL value of the group. */
+			if (mem_copy(result, &value) != 0)
+				goto error_row;
+		} else if (column->kind == SQL_MATVIEW_SUM) {
+			if ((sign > 0 ? mem_add(result, &value, result) :
+			     mem_sub(result, &value, result)) != 0)
+				goto error_row;
+		} else if (sign > 0) {
+			if (sql_matview_is_better(column, &value, result) &&
+			    mem_copy(result, &value) != 0)
+				goto error_row;
+		} else if (mem_cmp_scalar(&value, result, column->coll) == 0) {
+			if (sql_matview_extremum(view, column, tuple,
+						 result) != 0)
+				goto error_row;
+		}
+	}
+	int rc = sql_matview_write(view, key, key_end, row);
+	for (uint32_t i = 0; i < view->field_count; i++)
+		mem_destroy(&row[i]);
+	region_truncate(region, region_svp);
+	return rc;
+error_row:
+	for (uint32_t i = 0; i < view->field_count; i++)
+		mem_destroy(&row[i]);
+error:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+/** Update the view on a change of the base space. */
+static int
+sql_matview_on_replace(struct trigger *trigger, void *event)
+{
+	/*
+	 * Rows of the view are recovered from the WAL and received from
+	 * the master along with the changes of the base space.
+	 */
+	if (recovery_state != FINISHED_RECOVERY ||
+	    current_session()->type == SESSION_TYPE_APPLIER)
+		return 0;
+	struct sql_matview *view = trigger->data;
+	struct txn *txn = event;
+	struct txn_stmt *stmt = txn_current_stmt(txn);
+	if (stmt->old_tuple != NULL &&
+	    sql_matview_apply(view, stmt->old_tuple, -1) != 0)
+		return -1;
+	if (stmt->new_tuple != NULL &&
+	    sql_matview_apply(view, stmt->new_tuple, 1) != 0)
+		return -1;
+	return 0;
+}
+
+void
+sql_matview_attach(struct sql_matview *view)
+{
+	assert(rlist_empty(&view->link));
+	struct space *base = space_by_id(view->base_id);
+	assert(base != NULL);
+	base->def->view_ref_count++;
+	trigger_add(&base->on_replace, &view->on_replace);
+	rlist_add_entry(&sql_matviews, view, link);
+}
+
+void
+sql_matview_detach(struct sql_matview *view)
+{
+	struct space *base = space_by_id(view->base_id);
+	assert(base != NULL && base->def->view_ref_count > 0);
+	base->def->view_ref_count--;
+	trigger_clear(&view->on_replace);
+	rlist_del_entry(view, link);
+}
+
+int
+sql_matview_refresh(uint32_t id)
+{
+	struct sql_matview *view = sql_matview_by_id(id);
+	assert(view != NULL);
+	struct space *base = space_by_id(view->base_id);
+	assert(base != NULL);
+	if (access_check_space(base, PRIV_R) != 0)
+		return -1;
+	struct index *pk = index_find(base, 0);
+	if (pk == NULL)
+		return -1;
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	struct tuple *tuple;
+	int rc;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		if (sql_matview_apply(view, tuple, 1) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	iterator_delete(it);
+	return rc;
+}
@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "small/rlist.h"
+#include "trigger.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct key_def;
+struct space_def;
+
+/** Kinds of columns of a materialized view. */
+enum sql_matview_column_kind {
+	/** A column of the GROUP BY clause. */
+	SQL_MATVIEW_GROUP,
+	/** "COUNT(*)". */
+	SQL_MATVIEW_COUNT_ALL,
+	/** "COUNT(field)". */
+	SQL_MATVIEW_COUNT,
+	/** "SUM(field)". */
+	SQL_MATVIEW_SUM,
+	/** "MIN(field)". */
+	SQL_MATVIEW_MIN,
+	/** "MAX(field)". */
+	SQL_MATVIEW_MAX,
+};
+
+/** A column of a materialized view. */
+struct sql_matview_column {
+	/** Kind of the column. */
+	enum sql_matview_column_kind kind;
+	/** Number of the field of the base space, unused by COUNT(*). */
+	uint32_t fieldno;
+	/**
+	 * Number of the hidden field of the rows of the view holding
+	 * the number of non-NULL values aggregated by SUM, MIN or MAX.
+	 */
+	uint32_t count_fieldno;
+	/** Collation used by MIN and MAX or NULL. */
+	struct coll *coll;
+};
+
+/**
+ * A materialized view: a memtx space holding the result of an
+ * aggregate SELECT over a single memtx space grouped by its fields.
+ * The rows of the view are updated by an on_replace trigger of the
+ * base space in the transaction changing the base space, so reads of
+ * the view are index lookups instead of repeated scans of the base
+ * space.
+ *
+ * Every row of the view is followed by hidden fields: the number of
+ * base tuples of the group and the number of non-NULL values of each
+ * SUM, MIN and MAX column, so the aggregates can be updated by deltas.
+ */
+struct sql_matview {
+	/** ID of the space of the view. */
+	uint32_t id;
+	/** ID of the base space. */
+	uint32_t base_id;
+	/** Number of columns of the view. */
+	uint32_t column_count;
+	/** Columns of the view. */
+	struct sql_matview_column *columns;
+	/** Number of fields of rows including the hidden ones. */
+	uint32_t field_count;
+	/** Number of columns of the GROUP BY clause. */
+	uint32_t group_count;
+	/**
+	 * Numbers of the columns of the view forming its primary key,
+	 * in the order of the GROUP BY clause.
+	 */
+	uint32_t *group_columns;
+	/** Key over the GROUP BY fields of the base space. */
+	struct key_def *group_key_def;
+	/** Trigger updating the view on changes of the base space. */
+	struct trigger on_replace;
+	/** Link in the list of attached materialized views. */
+	struct rlist link;
+};
+
+/**
+ * Create a materialized view from the definition of its space. The
+ * SELECT of the view must read a single memtx space, have a GROUP BY
+ * clause of fields of the space, list each of them as a column and
+ * compute only COUNT, SUM, MIN and MAX of fields of the space.
+ * Return NULL and set diag if the SELECT is not supported.
+ */
+struct sql_matview *
+sql_matview_new(const struct space_def *def);
+
+/** Free a materialized view that is not attached. */
+void
+sql_matview_delete(struct sql_matview *view);
+
+/**
+ * Start maintaining the view on changes of the base space and pin
+ * the base space so that it can't be dropped or renamed.
+ */
+void
+sql_matview_attach(struct sql_matview *view);
+
+/** Stop maintaining the view and unpin the base space. */
+void
+sql_matview_detach(struct sql_matview *view);
+
+/** Find an attached materialized view by the ID of its space. */
+struct sql_matview *
+sql_matview_by_id(uint32_t id);
+
+/**
+ * Check if a space may be changed by a DML request. The space of a
+ * materialized view may only be changed by the view itself, so that
+ * its rows stay consistent with the base space. Return -1 and set diag
+ * if the change is forbidden.
+ *
+ * Recovery and appliers apply rows bypassing the check.
+ */
+int
+sql_matview_check_write(const struct space_def *def);
+
+/** Check if a space is the base space of a materialized view. */
+bool
+sql_matview_space_is_base(uint32_t space_id);
+
+/**
+ * Fill an empty materialized view with the rows computed from all
+ * the tuples of the base space.
+ */
+int
+sql_matview_refresh(uint32_t id);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -259,7 +259,7 @@ columnlist ::= tcons.
   CONFLICT DEFERRED END ENGINE FAIL
   IGNORE INITIALLY INSTEAD NO MATCH PLAN
   QUERY KEY OFFSET RAISE RELEASE REPLACE RESTRICT
-  RENAME CTIME_KW IF ENABLE DISABLE UUID SHOW
+  RENAME CTIME_KW IF ENABLE DISABLE UUID SHOW MATERIALIZED
   .
 %wildcard WILDCARD.
 
@@ -415,6 +415,18 @@ cmd ::= createkw(X) VIEW ifnotexists(E) nm(Y) eidlist_opt(C)
   }
 }
 
+cmd ::= createkw(X) MATERIALIZED VIEW ifnotexists(E) nm(Y) eidlist_opt(C)
+          AS select(S). {
+  if (!pParse->parse_only) {
+    create_view_def_init(&pParse->create_view_def, &Y, &X, C, S, E);
+    pParse->create_view_def.is_materialized = true;
+    pParse->initiateTTrans = true;
+    sql_create_view(pParse);
+  } else {
+    sql_store_select(pParse, S);
+  }
+}
+
 //////////////////////// The SELECT statement /////////////////////////////////
 //
 cmd ::= select(X).  {
@@ -1516,6 +1528,14 @@ cmd ::= SHOW CREATE TABLE. {
   sql_emit_show_create_table_all(pParse);
 }
 
+//////////////////////////// The ANALYZE command /////////////////////////////
+cmd ::= ANALYZE. {
+  sql_emit_analyze_all(pParse);
+}
+cmd ::= ANALYZE nm(X). {
+  sql_emit_analyze_one(pParse, &X);
+}
+
 //////////////////////////// The CREATE TRIGGER command /////////////////////
 
 cmd ::= createkw trigger_decl(A) BEGIN trigger_cmd_list(S) END(Z). {
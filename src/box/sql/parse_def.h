@@ -274,6 +274,8 @@ struct create_view_def {
 	/** List of column aliases (SELECT x AS y ...). */
 	struct ExprList *aliases;
 	struct Select *select;
+	/** CREATE MATERIALIZED VIEW statement. */
+	bool is_materialized;
 };
 
 struct drop_entity_def {
@@ -530,6 +532,7 @@ create_view_def_init(struct create_view_def *view_def, struct Token *name,
 	view_def->create_start = create;
 	view_def->select = select;
 	view_def->aliases = aliases;
+	view_def->is_materialized = false;
 }
 
 static inline void
@@ -38,6 +38,7 @@
 #include "tarantoolInt.h"
 #include "mem.h"
 #include "vdbeInt.h"
+#include "batch_agg.h"
 #include "box/box.h"
 #include "box/coll_id_cache.h"
 #include "box/schema.h"
@@ -1042,8 +1043,12 @@ pushOntoSorter(Parse * pParse,		/* Parser context */
 		sqlVdbeJumpHere(v, addrJmp);
 	}
 	if (pSort->sortFlags & SORTFLAG_UseSorter) {
-		sqlVdbeAddOp2(v, OP_SorterInsert, pSort->iECursor,
-				  regRecord);
+		/*
+		 * The sorter keeps only LIMIT+OFFSET records sorted
+		 * first, so it doesn't have to sort all of them.
+		 */
+		sqlVdbeAddOp3(v, OP_SorterInsert, pSort->iECursor,
+			      regRecord, iLimit);
 		return;
 	}
 	sqlVdbeAddOp2(v, OP_IdxInsert, regRecord, pSort->reg_eph);
@@ -4492,6 +4497,210 @@ is_simple_count(struct Select *select, struct AggInfo *agg_info)
 	return space;
 }
 
+/**
+ * Check if the expression is a field of the space with the given cursor
+ * that can be decoded by batch aggregation.
+ */
+static bool
+batch_agg_expr_is_field(const struct Expr *expr, int cursor,
+			const struct space_def *def)
+{
+	if (expr->op != TK_COLUMN_REF && expr->op != TK_AGG_COLUMN)
+		return false;
+	if (expr->iTable != cursor || expr->iColumn < 0 ||
+	    (uint32_t)expr->iColumn >= def->field_count)
+		return false;
+	return sql_batch_agg_type_is_supported(def->fields[expr->iColumn].type);
+}
+
+/**
+ * Convert the comparison operator to batch aggregation comparison.
+ * If @a is_swapped is set, the operands of the comparison are swapped.
+ * Return -1 if the operator is not a comparison.
+ */
+static int
+batch_agg_cmp(int op, bool is_swapped)
+{
+	switch (op) {
+	case TK_EQ:
+		return SQL_BATCH_AGG_EQ;
+	case TK_NE:
+		return SQL_BATCH_AGG_NE;
+	case TK_LT:
+		return is_swapped ? SQL_BATCH_AGG_GT : SQL_BATCH_AGG_LT;
+	case TK_LE:
+		return is_swapped ? SQL_BATCH_AGG_GE : SQL_BATCH_AGG_LE;
+	case TK_GT:
+		return is_swapped ? SQL_BATCH_AGG_LT : SQL_BATCH_AGG_GT;
+	case TK_GE:
+		return is_swapped ? SQL_BATCH_AGG_LE : SQL_BATCH_AGG_GE;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * Return the batch aggregation function implementing the aggregate
+ * function, or -1 if it can't be computed in batches.
+ */
+static int
+batch_agg_func(const struct AggInfo_func *agg_func, int cursor,
+	       const struct space_def *def)
+{
+	static const char *const names[] = {
+		[SQL_BATCH_AGG_COUNT] = "COUNT",
+		[SQL_BATCH_AGG_SUM] = "SUM",
+		[SQL_BATCH_AGG_TOTAL] = "TOTAL",
+		[SQL_BATCH_AGG_AVG] = "AVG",
+		[SQL_BATCH_AGG_MIN] = "MIN",
+		[SQL_BATCH_AGG_MAX] = "MAX",
+	};
+	const struct Expr *expr = agg_func->pExpr;
+	const struct ExprList *args = expr->x.pList;
+	if (agg_func->func->def->language != FUNC_LANGUAGE_SQL_BUILTIN ||
+	    agg_func->iDistinct >= 0 || (expr->flags & EP_Distinct) != 0)
+		return -1;
+	int func = -1;
+	for (int i = 0; i < (int)lengthof(names); i++) {
+		if (strcmp(agg_func->func->def->name, names[i]) == 0)
+			func = i;
+	}
+	if (func < 0)
+		return -1;
+	if (args == NULL || args->nExpr == 0)
+		return func == SQL_BATCH_AGG_COUNT ? func : -1;
+	if (args->nExpr != 1 ||
+	    !batch_agg_expr_is_field(args->a[0].pExpr, cursor, def))
+		return -1;
+	return func;
+}
+
+/**
+ * Return the number of comparisons of fields with constants the WHERE
+ * clause consists of, if it is a conjunction of such comparisons.
+ * Return -1 otherwise.
+ */
+static int
+batch_agg_filter_count(struct Expr *expr, int cursor,
+		       const struct space_def *def)
+{
+	if (expr == NULL)
+		return 0;
+	if (expr->op == TK_AND) {
+		int left = batch_agg_filter_count(expr->pLeft, cursor, def);
+		int right = batch_agg_filter_count(expr->pRight, cursor, def);
+		if (left < 0 || right < 0)
+			return -1;
+		return left + right;
+	}
+	if (batch_agg_cmp(expr->op, false) < 0)
+		return -1;
+	if (batch_agg_expr_is_field(expr->pLeft, cursor, def) &&
+	    sqlExprIsConstant(expr->pRight))
+		return 1;
+	if (batch_agg_expr_is_field(expr->pRight, cursor, def) &&
+	    sqlExprIsConstant(expr->pLeft))
+		return 1;
+	return -1;
+}
+
+/**
+ * Add the comparisons of the WHERE clause to the batch aggregation
+ * filters and generate code that evaluates their constants into
+ * registers starting from @a reg_args.
+ */
+static void
+batch_agg_add_filters(struct Parse *parse, struct Expr *expr,
+		      const struct space_def *def, struct sql_batch_agg *agg,
+		      uint32_t *filter_count, int reg_args)
+{
+	if (expr == NULL)
+		return;
+	if (expr->op == TK_AND) {
+		batch_agg_add_filters(parse, expr->pLeft, def, agg,
+				      filter_count, reg_args);
+		batch_agg_add_filters(parse, expr->pRight, def, agg,
+				      filter_count, reg_args);
+		return;
+	}
+	bool is_swapped = !sqlExprIsConstant(expr->pRight);
+	struct Expr *field = is_swapped ? expr->pRight : expr->pLeft;
+	struct Expr *value = is_swapped ? expr->pLeft : expr->pRight;
+	struct sql_batch_agg_filter *filter = &agg->filters[*filter_count];
+	filter->field = sql_batch_agg_add_field(agg, field->iColumn,
+						def->fields[field->iColumn].type);
+	filter->cmp = batch_agg_cmp(expr->op, is_swapped);
+	sqlExprCode(parse, value, reg_args + *filter_count);
+	++*filter_count;
+}
+
+/**
+ * Generate code that computes the aggregate functions of the SELECT
+ * batch-at-a-time, if the statement is of the form:
+ *
+ *   SELECT agg(x), ... FROM <tbl> WHERE y <op> <const> AND ...
+ *
+ * where the table is a memtx space, all fields are integer or double
+ * and the functions are non-DISTINCT COUNT, SUM, TOTAL, AVG, MIN or
+ * MAX. The OP_BatchAggregate instruction computes the final values of
+ * the functions and jumps to @a label, or falls through to the regular
+ * code of the query if it can't be executed in batches.
+ *
+ * @retval Address of the OP_BatchAggregate instruction, whose P1 must
+ *         be set to the ID of the index to scan. -1 if the statement
+ *         doesn't match the pattern.
+ */
+static int
+vdbe_emit_batch_aggregate(struct Parse *parse, struct Select *select,
+			  struct AggInfo *agg_info, int label)
+{
+	assert(select->pGroupBy == NULL);
+	struct SrcList *src_list = select->pSrc;
+	if (select->pHaving != NULL || src_list->nSrc != 1 ||
+	    src_list->a[0].pSelect != NULL || agg_info->nAccumulator != 0 ||
+	    agg_info->nFunc == 0)
+		return -1;
+	struct space *space = src_list->a[0].space;
+	if (space == NULL || space->def->opts.is_view || !space_is_memtx(space))
+		return -1;
+	const struct space_def *def = space->def;
+	int cursor = src_list->a[0].iCursor;
+	int filter_count = batch_agg_filter_count(select->pWhere, cursor, def);
+	if (filter_count < 0)
+		return -1;
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		if (batch_agg_func(&agg_info->aFunc[i], cursor, def) < 0)
+			return -1;
+	}
+
+	struct sql_batch_agg *agg =
+		sql_batch_agg_new(def->id, filter_count, agg_info->nFunc);
+	int reg_args = 0;
+	if (filter_count > 0) {
+		reg_args = parse->nMem + 1;
+		parse->nMem += filter_count;
+	}
+	uint32_t count = 0;
+	batch_agg_add_filters(parse, select->pWhere, def, agg, &count,
+			      reg_args);
+	assert(count == (uint32_t)filter_count);
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		struct AggInfo_func *agg_func = &agg_info->aFunc[i];
+		struct ExprList *args = agg_func->pExpr->x.pList;
+		struct sql_batch_agg_step *step = &agg->steps[i];
+		step->func = batch_agg_func(agg_func, cursor, def);
+		step->reg = agg_func->iMem;
+		step->field = UINT32_MAX;
+		if (args == NULL || args->nExpr == 0)
+			continue;
+		uint32_t fieldno = args->a[0].pExpr->iColumn;
+		step->field = sql_batch_agg_add_field(agg, fieldno,
+						      def->fields[fieldno].type);
+	}
+	return sqlVdbeAddOp4(parse->pVdbe, OP_BatchAggregate, 0, label,
+			     reg_args, (char *)agg, P4_DYNAMIC);
+}
+
 /*
  * If the source-list item passed as an argument was augmented with an
  * INDEXED BY clause, then try to locate the specified index. If there
@@ -4512,7 +4721,15 @@ sqlIndexedByLookup(Parse * pParse, struct SrcList_item *pFrom)
 		return -1;
 	}
 	assert(index_id <= pFrom->space->index_id_max);
-	pFrom->pIBIndex = pFrom->space->index_map[index_id]->def;
+	struct index_def *def = pFrom->space->index_map[index_id]->def;
+	/* A partial index doesn't contain all tuples of the space. */
+	if (def->opts.filter_func_id != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "SQL",
+			 "INDEXED BY a partial index");
+		pParse->is_aborted = true;
+		return -1;
+	}
+	pFrom->pIBIndex = def;
 	return 0;
 }
 
@@ -5972,6 +6189,21 @@ sqlSelect(Parse * pParse,		/* The parser context */
 			sqlVdbeChangeToNoop(v, sSort.addrSortIndex);
 			sqlVdbeChangeToNoop(v, sSort.addrSortIndex + 1);
 		}
+		/*
+		 * If every tuple of a full scan is returned, skip
+		 * the OFFSET tuples in the index iterator instead of
+		 * reading them. The OFFSET counter is shared with
+		 * the next SELECT of a compound one, which needs the
+		 * exact number of skipped tuples, so it's done only
+		 * for the last SELECT.
+		 */
+		if (p->iOffset != 0 && pWhere == NULL &&
+		    sSort.pOrderBy == NULL && p->pNext == NULL &&
+		    (p->selFlags & SF_Distinct) == 0) {
+			int addr = sql_where_full_scan_addr(pWInfo);
+			if (addr >= 0)
+				sqlVdbeChangeP3(v, addr, p->iOffset);
+		}
 
 		/* Use the standard inner loop. */
 		selectInnerLoop(pParse, p, pEList, -1, &sSort, &sDistinct,
@@ -6421,6 +6653,19 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				 * of output.
 				 */
 				resetAccumulator(pParse, &sAggInfo);
+				/*
+				 * Try to compute the aggregates batch-at-a-time
+				 * first. This is only done for full scans:
+				 * the code is turned into no-op if where.c
+				 * decides to use an index lookup.
+				 */
+				int addr_batch = -1;
+				int addr_batch_done = sqlVdbeMakeLabel(v);
+				if (flag == WHERE_ORDERBY_NORMAL) {
+					addr_batch = vdbe_emit_batch_aggregate(
+						pParse, p, &sAggInfo,
+						addr_batch_done);
+				}
 				pWInfo =
 				    sqlWhereBegin(pParse, pTabList, pWhere,
 						      pMinMax, 0, flag, 0);
@@ -6428,6 +6673,17 @@ sqlSelect(Parse * pParse,		/* The parser context */
 					sql_expr_list_delete(pDel);
 					goto select_end;
 				}
+				if (addr_batch >= 0) {
+					int iid = sql_where_full_scan_index_id(
+						pWInfo);
+					if (iid < 0) {
+						sqlVdbeChangeToNoop(v,
+								    addr_batch);
+					} else {
+						sqlVdbeChangeP1(v, addr_batch,
+								iid);
+					}
+				}
 				updateAccumulator(pParse, &sAggInfo);
 				if (pParse->is_aborted)
 					goto select_end;
@@ -6443,6 +6699,7 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				}
 				sqlWhereEnd(pWInfo);
 				finalizeAggFunctions(pParse, &sAggInfo);
+				sqlVdbeResolveLabel(v, addr_batch_done);
 				sql_expr_list_delete(pDel);
 			}
 
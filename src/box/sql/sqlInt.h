@@ -1208,6 +1208,8 @@ struct UnpackedRecord {
  * keys: {1, 2}; the rest are different.
  * Notice, that stat[0] is an average number of tuples in a whole
  * index. By default it is DEFAULT_TUPLE_LOG_COUNT == 200.
+ * If the index has been analyzed, the statistics collected by
+ * the ANALYZE statement are used instead.
  * If there is no appropriate Tarantool's index,
  * return one of default values.
  *
@@ -2673,6 +2675,14 @@ sql_emit_show_create_table_all(struct Parse *parse);
 void
 sql_show_create_table(uint32_t space_id, struct Mem *ret, struct Mem *err);
 
+/** Emit VDBE instructions for "ANALYZE table_name;" statement. */
+void
+sql_emit_analyze_one(struct Parse *parse, struct Token *name);
+
+/** Emit VDBE instructions for "ANALYZE;" statement. */
+void
+sql_emit_analyze_all(struct Parse *parse);
+
 /**
  * Return true if given column is part of primary key.
  * If field number is less than 63, corresponding bit
@@ -3034,6 +3044,23 @@ int sqlWhereOkOnePass(WhereInfo *, int *);
 #define ONEPASS_SINGLE   1	/* ONEPASS valid for a single row update */
 #define ONEPASS_MULTI    2	/* ONEPASS is valid for multiple rows */
 
+/**
+ * Return the ID of the index if the WHERE clause is implemented as
+ * a single full scan of the index in its natural order, i.e. all
+ * tuples of the index are visited and filtered by the WHERE clause.
+ * Return -1 otherwise.
+ */
+int
+sql_where_full_scan_index_id(struct WhereInfo *where_info);
+
+/**
+ * Return the address of the OP_Rewind instruction if the WHERE clause
+ * is implemented as a single forward scan of all tuples of an index.
+ * Return -1 otherwise.
+ */
+int
+sql_where_full_scan_addr(struct WhereInfo *where_info);
+
 /**
  * Generate code that will extract the iColumn-th column from
  * table pTab and store the column value in a register.
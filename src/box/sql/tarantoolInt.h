@@ -58,7 +58,12 @@ struct ck_constraint_def {
 /* Storage interface. */
 const void *tarantoolsqlPayloadFetch(BtCursor * pCur, u32 * pAmt);
 
-int tarantoolsqlFirst(BtCursor * pCur, int *pRes);
+/**
+ * Set cursor to the first tuple in the index skipping @a offset
+ * tuples.
+ */
+int
+tarantoolsqlFirst(struct BtCursor *pCur, uint32_t offset, int *pRes);
 int tarantoolsqlLast(BtCursor * pCur, int *pRes);
 int tarantoolsqlNext(BtCursor * pCur, int *pRes);
 int tarantoolsqlPrevious(BtCursor * pCur, int *pRes);
@@ -47,6 +47,11 @@
 #include "sqlInt.h"
 #include "mem.h"
 #include "vdbeInt.h"
+#include "hash_join.h"
+#include "analyze.h"
+#include "batch_agg.h"
+#include "filter.h"
+#include "matview.h"
 #include "tarantoolInt.h"
 
 #include "msgpuck/msgpuck.h"
@@ -316,8 +321,16 @@ vdbe_field_ref_fetch_data(struct vdbe_field_ref *field_ref, uint32_t fieldno)
 			}
 		}
 		field_begin = field_ref->data + field_ref->slots[prev];
+		/*
+		 * Only the offsets of the fields used by the statement
+		 * are saved, so the fields that are fetched later are
+		 * decoded starting from the closest of them.
+		 */
+		uint64_t column_mask = field_ref->column_mask;
 		for (prev++; prev < fieldno; prev++) {
 			mp_next(&field_begin);
+			if (!column_mask_fieldno_is_set(column_mask, prev))
+				continue;
 			field_ref->slots[prev] =
 				(uint32_t)(field_begin - field_ref->data);
 			bitmask64_set_bit(&field_ref->slot_bitmask, prev);
@@ -326,6 +339,7 @@ vdbe_field_ref_fetch_data(struct vdbe_field_ref *field_ref, uint32_t fieldno)
 	}
 	field_ref->slots[fieldno] = (uint32_t)(field_begin - field_ref->data);
 	bitmask64_set_bit(&field_ref->slot_bitmask, fieldno);
+	field_ref->slot_max = MAX(field_ref->slot_max, fieldno);
 	return field_begin;
 }
 
@@ -1917,6 +1931,11 @@ case OP_Column: {
 			} else {
 				goto op_column_out;
 			}
+		} else if (pC->eCurType == CURTYPE_HASH_JOIN) {
+			uint32_t size;
+			const char *data = sql_hash_join_row(pC->uc.hash_join,
+							     &size);
+			vdbe_field_ref_prepare_data(&pC->field_ref, data, size);
 		} else {
 			pCrsr = pC->uc.pCursor;
 			assert(pC->eCurType==CURTYPE_TARANTOOL);
@@ -1930,7 +1949,8 @@ case OP_Column: {
 		pC->cacheStatus = p->cacheCtr;
 	}
 	assert(pC->eCurType == CURTYPE_TARANTOOL ||
-	       pC->eCurType == CURTYPE_PSEUDO);
+	       pC->eCurType == CURTYPE_PSEUDO ||
+	       pC->eCurType == CURTYPE_HASH_JOIN);
 	struct Mem *default_val_mem =
 		pOp->p4type == P4_MEM ? pOp->p4.pMem : NULL;
 	if (vdbe_field_ref_fetch(&pC->field_ref, p2, pDest) != 0)
@@ -1947,6 +1967,8 @@ case OP_Column: {
 	/* Currently PSEUDO cursor does not have info about field types. */
 	if (pC->eCurType == CURTYPE_TARANTOOL)
 		field_type = pC->uc.pCursor->space->def->fields[p2].type;
+	else if (pC->eCurType == CURTYPE_HASH_JOIN)
+		field_type = sql_hash_join_field_type(pC->uc.hash_join, p2);
 	if (field_type == FIELD_TYPE_ANY)
 		pDest->flags |= MEM_Any;
 	else if (field_type == FIELD_TYPE_SCALAR)
@@ -1958,6 +1980,55 @@ case OP_Column: {
 	break;
 }
 
+/* Opcode: Filter P1 P2 P3 P4 *
+ * Synopsis: if !filter(cursor P1) goto P2 else goto P3
+ *
+ * Test the tuple cursor P1 points to with the terms of the WHERE clause
+ * given by P4. Each term is evaluated by a chain of functions chosen
+ * for the type of the field and the values of the constants of the term
+ * once per execution of the statement. Jump to P2 if the tuple doesn't
+ * pass any of the terms and to P3 if it passes all of them. If some of
+ * the terms can't be evaluated exactly, e.g. the field has an
+ * unexpected type, fall through to the byte code of the terms.
+ */
+case OP_Filter: {             /* jump */
+	struct sql_filter *filter = pOp->p4.p;
+	if (filter->run != p->aOp[0].p1) {
+		sql_filter_prepare(filter, aMem);
+		filter->run = p->aOp[0].p1;
+	}
+	VdbeCursor *pC = p->apCsr[pOp->p1];
+	assert(pC != NULL);
+	if (pC->eCurType != CURTYPE_TARANTOOL || pC->nullRow)
+		break;
+	if (pC->cacheStatus != p->cacheCtr) {
+		BtCursor *pCrsr = pC->uc.pCursor;
+		assert(sqlCursorIsValid(pCrsr));
+		vdbe_field_ref_prepare_tuple(&pC->field_ref,
+					     pCrsr->last_tuple);
+		pC->cacheStatus = p->cacheCtr;
+	}
+	struct vdbe_field_ref *field_ref = &pC->field_ref;
+	bool is_unknown = false;
+	for (uint32_t i = 0; i < filter->term_count; i++) {
+		const struct sql_filter_term *term = &filter->terms[i];
+		const char *data = NULL;
+		if (term->fieldno < field_ref->field_count)
+			data = vdbe_field_ref_fetch_data(field_ref,
+							 term->fieldno);
+		enum sql_filter_result res = term->test(term, data);
+		if (res == SQL_FILTER_FALSE)
+			goto jump_to_p2;
+		if (res == SQL_FILTER_UNKNOWN)
+			is_unknown = true;
+	}
+	if (is_unknown)
+		break;
+	assert(pOp->p3 > 0 && pOp->p3 < p->nOp);
+	pOp = &aOp[pOp->p3 - 1];
+	break;
+}
+
 /**
  * Opcode: FetchByName P1 * P3 * P4
  * Synopsis: r[P3]=PX
@@ -2351,6 +2422,21 @@ case OP_CheckViewReferences: {
 	break;
 }
 
+/* Opcode: MatViewRefresh P1 * * * *
+ * Synopsis: r[P1] = space id
+ *
+ * Fill the materialized view just created in space r[P1] with the
+ * rows computed from the tuples of its base space.
+ */
+case OP_MatViewRefresh: {
+	assert(pOp->p1 > 0);
+	pIn1 = &aMem[pOp->p1];
+	assert(mem_is_uint(pIn1) && pIn1->u.u <= INT32_MAX);
+	if (sql_matview_refresh(pIn1->u.u) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
 /* Opcode: TransactionBegin * * * * *
  *
  * Start Tarantool's transaction.
@@ -2472,6 +2558,21 @@ case OP_IteratorOpen: {
 	break;
 }
 
+/* Opcode: ColumnsUsed P1 * * P4 *
+ * Synopsis: cursor=P1
+ *
+ * P4 is a mask of the columns of the cursor P1 that are used by the
+ * statement, see column_mask.h. When a tuple of the cursor is decoded,
+ * only the offsets of these columns are saved.
+ */
+case OP_ColumnsUsed: {
+	assert(pOp->p4type == P4_UINT64);
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_TARANTOOL);
+	cur->field_ref.column_mask = *pOp->p4.pI64;
+	break;
+}
+
 /**
  * Opcode: OP_OpenSpace P1 P2 * * *
  * Synopsis: reg[P1] = space_by_id(P2)
@@ -3341,7 +3442,7 @@ case OP_Sort: {        /* jump */
 			/* Fall through into OP_Rewind */
 			FALLTHROUGH;
 		}
-/* Opcode: Rewind P1 P2 * * *
+/* Opcode: Rewind P1 P2 P3 * *
  *
  * The next use of the Column or Next instruction for P1
  * will refer to the first entry in the database table or index.
@@ -3349,6 +3450,12 @@ case OP_Sort: {        /* jump */
  * If the table or index is not empty, fall through to the following
  * instruction.
  *
+ * If P3 is not zero, register P3 holds the number of entries to skip
+ * (the OFFSET counter). The entries are skipped by the index iterator
+ * and the register is decreased by the number of skipped entries. If
+ * there are no entries left, the register is set to zero, so it must
+ * not be shared with other loops.
+ *
  * This opcode leaves the cursor configured to move in forward order,
  * from the beginning toward the end.  In other words, the cursor is
  * configured to use Next, not Prev.
@@ -3373,8 +3480,16 @@ case OP_Rewind: {        /* jump */
 		assert(pC->eCurType==CURTYPE_TARANTOOL);
 		pCrsr = pC->uc.pCursor;
 		assert(pCrsr);
-		if (tarantoolsqlFirst(pCrsr, &res) != 0)
+		uint32_t offset = 0;
+		if (pOp->p3 != 0) {
+			pIn3 = &aMem[pOp->p3];
+			assert(mem_is_uint(pIn3));
+			offset = MIN(pIn3->u.u, UINT32_MAX);
+		}
+		if (tarantoolsqlFirst(pCrsr, offset, &res) != 0)
 			goto abort_due_to_error;
+		if (offset != 0)
+			pIn3->u.u = res == 0 ? pIn3->u.u - offset : 0;
 		pC->cacheStatus = CACHE_STALE;
 	}
 	pC->nullRow = (u8)res;
@@ -3504,12 +3619,16 @@ case OP_Next:          /* jump */
 	break;
 }
 
-/* Opcode: SorterInsert P1 P2 * * *
+/* Opcode: SorterInsert P1 P2 P3 * *
  * Synopsis: key=r[P2]
  *
  * Register P2 holds an SQL index key made using the
  * MakeRecord instructions.  This opcode writes that key
  * into the sorter P1.  Data for the entry is nil.
+ *
+ * If P3 is not zero, register P3 holds the number of records the
+ * sorter is going to return. The sorter may drop the records that
+ * are sorted after them.
  */
 case OP_SorterInsert: {      /* in2 */
 	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
@@ -3518,8 +3637,119 @@ case OP_SorterInsert: {      /* in2 */
 	assert(isSorter(cursor));
 	pIn2 = &aMem[pOp->p2];
 	assert(mem_is_bin(pIn2));
-	if (sqlVdbeSorterWrite(cursor, pIn2) != 0)
+	uint64_t limit = 0;
+	if (pOp->p3 != 0) {
+		pIn3 = &aMem[pOp->p3];
+		assert(mem_is_uint(pIn3));
+		limit = pIn3->u.u;
+	}
+	if (sqlVdbeSorterWrite(cursor, pIn2, limit) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
+/**
+ * Opcode: HashJoinOpen P1 * * P4 *
+ * Synopsis: hash_join[P1] = new(P4)
+ *
+ * Open cursor P1 over a new in-memory hash table. The table stores
+ * records with fields described by space info P4 and is keyed by its
+ * key parts, which must be the leading fields of the records. The
+ * table is filled with OP_HashJoinInsert and searched with
+ * OP_HashJoinProbe.
+ */
+case OP_HashJoinOpen: {
+	assert(pOp->p1 >= 0);
+	assert(pOp->p4type == P4_DYNAMIC);
+	struct sql_space_info *info = pOp->p4.space_info;
+	struct VdbeCursor *cur = allocateCursor(p, pOp->p1, info->field_count,
+						CURTYPE_HASH_JOIN);
+	if (cur == NULL)
 		goto abort_due_to_error;
+	cur->uc.hash_join = sql_hash_join_new(info);
+	if (cur->uc.hash_join == NULL)
+		goto abort_due_to_error;
+	cur->key_def = sql_hash_join_key_def(cur->uc.hash_join);
+	cur->nullRow = 1;
+	break;
+}
+
+/**
+ * Opcode: HashJoinInsert P1 P2 * * *
+ * Synopsis: hash_join[P1].insert(r[P2])
+ *
+ * Insert the record made by OP_MakeRecord in register P2 into the hash
+ * table of cursor P1.
+ */
+case OP_HashJoinInsert: {      /* in2 */
+	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	pIn2 = &aMem[pOp->p2];
+	assert(mem_is_bin(pIn2));
+	if (sql_hash_join_insert(cur->uc.hash_join, pIn2->z, pIn2->n) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
+/**
+ * Opcode: HashJoinProbe P1 P2 P3 P4 *
+ * Synopsis: key=r[P3@P4]
+ *
+ * Position cursor P1 at the first record of its hash table with the key
+ * made of P4 registers starting at P3. If there is no such record, jump
+ * to P2. The key values are converted to the types of the key parts the
+ * same way OP_SeekGE does it for an equality search.
+ */
+case OP_HashJoinProbe: {       /* jump, in3 */
+	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	assert(pOp->p4type == P4_INT32);
+	uint32_t len = pOp->p4.i;
+	assert(len == cur->key_def->part_count);
+	cur->nullRow = 1;
+	cur->cacheStatus = CACHE_STALE;
+	struct Mem *mems = &aMem[pOp->p3];
+	for (uint32_t i = 0; i < len; ++i) {
+		enum field_type type = cur->key_def->parts[i].type;
+		struct Mem *mem = &mems[i];
+		if (mem_is_field_compatible(mem, type))
+			continue;
+		if (!sql_type_is_numeric(type) || !mem_is_num(mem)) {
+			diag_set(ClientError, ER_SQL_TYPE_MISMATCH,
+				 mem_str(mem), field_type_strs[type]);
+			goto abort_due_to_error;
+		}
+		/* Nothing is equal to a value that can't be cast precisely. */
+		if (mem_cast_implicit_number(mem, type) != 0)
+			goto jump_to_p2;
+	}
+	bool found;
+	if (sql_hash_join_probe(cur->uc.hash_join, mems, len, &found) != 0)
+		goto abort_due_to_error;
+	if (!found)
+		goto jump_to_p2;
+	cur->nullRow = 0;
+	break;
+}
+
+/**
+ * Opcode: HashJoinNext P1 P2 * * *
+ *
+ * Advance cursor P1 to the next record of its hash table with the same
+ * key as the current one and jump to P2. If there are no more such
+ * records, fall through.
+ */
+case OP_HashJoinNext: {        /* jump */
+	assert(pOp->p1 >= 0 && pOp->p1 < p->nCursor);
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	assert(cur->nullRow == 0);
+	cur->cacheStatus = CACHE_STALE;
+	if (sql_hash_join_next(cur->uc.hash_join))
+		goto jump_to_p2;
+	cur->nullRow = 1;
 	break;
 }
 
@@ -4294,6 +4524,45 @@ case OP_AggFinal: {
 	break;
 }
 
+/* Opcode: BatchAggregate P1 P2 P3 P4 *
+ * Synopsis: index=P1 args=r[P3]
+ *
+ * Compute the aggregate functions described by P4 over the tuples of
+ * the index with ID P1 of the space given in P4, skipping tuples that
+ * don't pass the filters of P4. The constants the fields are compared
+ * with by the filters are stored in registers starting from P3.
+ *
+ * Tuples are processed in batches: the fields used by the query are
+ * decoded into typed arrays and the filters and the functions are
+ * evaluated by tight loops over them. On success, the final values of
+ * the functions are stored to their accumulators and the execution
+ * jumps to P2. If the query can't be executed this way, e.g. a
+ * constant is not a number or an integer sum overflows, fall through
+ * to the row-by-row code of the query.
+ */
+case OP_BatchAggregate: {       /* jump */
+	const struct sql_batch_agg *agg = pOp->p4.p;
+	if (box_schema_version() != p->schema_ver) {
+		p->expired = 1;
+		diag_set(ClientError, ER_SQL_EXECUTE, "schema version has "\
+			 "changed: need to re-compile SQL statement");
+		goto abort_due_to_error;
+	}
+	struct space *space = space_by_id(agg->space_id);
+	assert(space != NULL);
+	if (access_check_space(space, PRIV_R) != 0)
+		goto abort_due_to_error;
+	struct index *index = space_index(space, pOp->p1);
+	assert(index != NULL);
+	bool is_done;
+	if (sql_batch_agg_run(agg, index, &aMem[pOp->p3], aMem,
+			      &is_done) != 0)
+		goto abort_due_to_error;
+	if (is_done)
+		goto jump_to_p2;
+	break;
+}
+
 /* Opcode: Expire P1 * * * *
  *
  * Cause precompiled statements to expire.
@@ -4371,6 +4640,10 @@ case OP_Init: {          /* jump */
 	if (pOp->p1>=sqlGlobalConfig.iOnceResetThreshold) {
 		for(i=1; i<p->nOp; i++) {
 			if (p->aOp[i].opcode==OP_Once) p->aOp[i].p1 = 0;
+			if (p->aOp[i].opcode == OP_Filter) {
+				struct sql_filter *filter = p->aOp[i].p4.p;
+				filter->run = 0;
+			}
 		}
 		pOp->p1 = 0;
 	}
@@ -4463,6 +4736,19 @@ case OP_ShowCreateTable: {
 	break;
 }
 
+/**
+ * Opcode: Analyze P1 * * * *
+ * Synopsis: analyze space with ID == r[P1]
+ *
+ * Collect the statistics of the indexes of the space with the identifier
+ * from register P1 for the query planner.
+ */
+case OP_Analyze: {
+	if (sql_analyze_space(aMem[pOp->p1].u.i) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
 /* Opcode: Noop * * * * *
  *
  * Do nothing.  This instruction is often useful as a jump
@@ -47,6 +47,7 @@
 typedef struct VdbeOp Op;
 
 struct func;
+struct sql_hash_join;
 
 /*
  * Boolean values
@@ -60,6 +61,7 @@ typedef struct VdbeSorter VdbeSorter;
 #define CURTYPE_TARANTOOL   0
 #define CURTYPE_SORTER      1
 #define CURTYPE_PSEUDO      2
+#define CURTYPE_HASH_JOIN   3
 
 /*
  * A VdbeCursor is an superclass (a wrapper) for various cursor objects:
@@ -68,6 +70,7 @@ typedef struct VdbeSorter VdbeSorter;
  *          -  On either an ephemeral or ordinary space
  *      * A sorter
  *      * A one-row "pseudotable" stored in a single register
+ *      * A hash table built for a hash join
  */
 typedef struct VdbeCursor VdbeCursor;
 struct VdbeCursor {
@@ -99,6 +102,8 @@ struct VdbeCursor {
 		BtCursor *pCursor;	/* CURTYPE_TARANTOOL */
 		int pseudoTableReg;	/* CURTYPE_PSEUDO. Reg holding content. */
 		VdbeSorter *pSorter;	/* CURTYPE_SORTER. Sorter object */
+		/** CURTYPE_HASH_JOIN. Hash table of the build side. */
+		struct sql_hash_join *hash_join;
 	} uc;
 	/** Info about keys needed by index cursors. */
 	struct key_def *key_def;
@@ -375,7 +380,7 @@ int
 sqlVdbeSorterNext(const struct VdbeCursor *pCsr, int *pbEof);
 
 int sqlVdbeSorterRewind(const VdbeCursor *, int *);
-int sqlVdbeSorterWrite(const VdbeCursor *, Mem *);
+int sqlVdbeSorterWrite(const VdbeCursor *, Mem *, uint64_t);
 int sqlVdbeSorterCompare(const VdbeCursor *, Mem *, int, int *);
 
 int sqlVdbeMemTranslate(Mem *, u8);
@@ -43,6 +43,9 @@
 #include "sqlInt.h"
 #include "mem.h"
 #include "vdbeInt.h"
+#include "hash_join.h"
+#include "batch_agg.h"
+#include "filter.h"
 #include "tarantoolInt.h"
 #include "box/execute.h"
 
@@ -940,6 +943,16 @@ displayP4(Op * pOp, char *zTemp, int nTemp)
 		mp_snprint(zTemp, nTemp, pOp->p4.z);
 		return zTemp;
 	}
+	if (pOp->opcode == OP_BatchAggregate) {
+		const struct sql_batch_agg *agg = pOp->p4.p;
+		sql_snprintf(nTemp, zTemp, "space=%u", agg->space_id);
+		return zTemp;
+	}
+	if (pOp->opcode == OP_Filter) {
+		const struct sql_filter *filter = pOp->p4.p;
+		sql_snprintf(nTemp, zTemp, "terms=%u", filter->term_count);
+		return zTemp;
+	}
 	char *zP4 = zTemp;
 	StrAccum x;
 	assert(nTemp >= 20);
@@ -1482,6 +1495,9 @@ sqlVdbeFreeCursor(struct VdbeCursor *pCx)
 		sql_cursor_close(pCx->uc.pCursor);
 			break;
 		}
+	case CURTYPE_HASH_JOIN:
+		sql_hash_join_delete(pCx->uc.hash_join);
+		break;
 	}
 }
 
@@ -154,6 +154,9 @@
 #include "sqlInt.h"
 #include "mem.h"
 #include "vdbeInt.h"
+#include "box/txn.h"
+#include "tt_sort.h"
+#include "tweaks.h"
 
 /*
  * Hard-coded maximum amount of data to accumulate in memory before flushing
@@ -162,6 +165,32 @@
  */
 #define SQL_MAX_PMASZ    (1<<29)
 
+/**
+ * Amount of memory in bytes a sorter accumulates records in before they
+ * are sorted and flushed to a PMA in a temporary file. Capped by
+ * SQL_MAX_PMASZ.
+ */
+static uint64_t sql_sorter_memory_limit = 2048000;
+TWEAK_UINT(sql_sorter_memory_limit);
+
+/**
+ * Number of threads a big run of records is sorted in, see tt_sort().
+ * The value 1 disables the parallel sort.
+ */
+static uint64_t sql_sorter_thread_count = 4;
+TWEAK_UINT(sql_sorter_thread_count);
+
+/** Minimal number of records in a run sorted in multiple threads. */
+static uint64_t sql_sorter_parallel_min_records = 10000;
+TWEAK_UINT(sql_sorter_parallel_min_records);
+
+/**
+ * Maximal LIMIT a sorter keeps only the top records for, see
+ * sqlVdbeSorterWrite(). Sorters with a bigger LIMIT sort all records.
+ */
+static uint64_t sql_sorter_top_n_max = 10000;
+TWEAK_UINT(sql_sorter_top_n_max);
+
 /*
  * Private objects used by the sorter
  */
@@ -317,6 +346,14 @@ struct VdbeSorter {
 	int nMemory;		/* Size of list.aMemory allocation in bytes */
 	u8 bUsePMA;		/* True if one or more PMAs created */
 	SortSubtask aTask;	/* A single subtask */
+	/**
+	 * Records of a sorter bounded by a LIMIT: a binary heap with
+	 * the record sorted last on the top. NULL if the sorter is not
+	 * bounded.
+	 */
+	SorterRecord **aHeap;
+	int nHeap;		/* Number of records in aHeap */
+	int mxHeap;		/* Maximal number of records in aHeap */
 };
 
 /*
@@ -441,6 +478,7 @@ struct SorterRecord {
 
 static int vdbeIncrSwap(IncrMerger *);
 static void vdbeIncrFree(IncrMerger *);
+static void vdbeSorterHeapFree(VdbeSorter *);
 
 /*
  * Free all memory belonging to the PmaReader object passed as the
@@ -792,15 +830,10 @@ sqlVdbeSorterInit(struct VdbeCursor *pCsr)
 	pSorter->pgsz = pgsz = 1024;
 	pSorter->aTask.pSorter = pSorter;
 
-	/* Cache size in bytes */
-	i64 mxCache;
 	u32 szPma = sqlGlobalConfig.szPma;
 	pSorter->mnPmaSize = szPma * pgsz;
-
-	mxCache = SQL_DEFAULT_CACHE_SIZE;
-	mxCache = mxCache * -1024;
-	mxCache = MIN(mxCache, SQL_MAX_PMASZ);
-	pSorter->mxPmaSize = MAX(pSorter->mnPmaSize, (int)mxCache);
+	uint64_t mxCache = MIN(sql_sorter_memory_limit, SQL_MAX_PMASZ);
+	pSorter->mxPmaSize = MAX(pgsz, (int)mxCache);
 	assert(pSorter->iMemory == 0);
 	pSorter->nMemory = pgsz;
 	pSorter->list.aMemory = xmalloc(pgsz);
@@ -917,6 +950,7 @@ sqlVdbeSorterReset(struct VdbeSorter *pSorter)
 	pSorter->bUsePMA = 0;
 	pSorter->iMemory = 0;
 	pSorter->mxKeysize = 0;
+	vdbeSorterHeapFree(pSorter);
 	sql_xfree(pSorter->pUnpacked);
 	pSorter->pUnpacked = 0;
 }
@@ -1055,6 +1089,93 @@ vdbeSorterGetCompare(VdbeSorter * p)
 	return vdbeSorterCompare;
 }
 
+/**
+ * Return the record following @a p in the in-memory list of records
+ * that hasn't been sorted yet.
+ */
+static SorterRecord *
+vdbeSorterNextRecord(SorterList *pList, SorterRecord *p)
+{
+	if (pList->aMemory == NULL)
+		return p->u.pNext;
+	if ((u8 *)p == pList->aMemory)
+		return NULL;
+	return (SorterRecord *)&pList->aMemory[p->u.iNext];
+}
+
+/**
+ * Compare two keys of the sorter in the order of the sorting. Unlike
+ * vdbeSorterCompare() it does not use the unpacked record of the
+ * sub-task, so it can be called from several threads at once.
+ */
+static int
+vdbeSorterCompareKeys(struct key_def *key_def, const char *key1,
+		      const char *key2)
+{
+	uint32_t n1 = mp_decode_array(&key1);
+	uint32_t n2 = mp_decode_array(&key2);
+	uint32_t n = MIN(MIN(n1, n2), key_def->part_count);
+	for (uint32_t i = 0; i < n; i++) {
+		struct key_part *part = &key_def->parts[i];
+		struct Mem mem;
+		mem_create(&mem);
+		uint32_t len = 0;
+		mem_from_mp_ephemeral(&mem, key2, &len);
+		key2 += len;
+		int rc = 0;
+		if (mem_cmp_msgpack(&mem, &key1, &rc, part->coll) != 0)
+			rc = 0;
+		if (rc != 0)
+			return part->sort_order != SORT_ORDER_ASC ? rc : -rc;
+	}
+	return 0;
+}
+
+/**
+ * Compare two records of the sorter passed as pointers to SorterRecord,
+ * see vdbeSorterCompareKeys().
+ */
+static int
+vdbeSorterCompareRecords(const void *a, const void *b, void *arg)
+{
+	return vdbeSorterCompareKeys(arg, SRVAL(*(SorterRecord **)a),
+				     SRVAL(*(SorterRecord **)b));
+}
+
+/**
+ * Sort the list of records in several threads if it is big enough. The
+ * calling fiber yields while the threads sort the records, so the list
+ * is sorted in parallel only outside of transactions: a yield aborts
+ * a memtx transaction.
+ *
+ * @retval true if the list is sorted.
+ */
+static bool
+vdbeSorterSortParallel(SortSubtask *pTask, SorterList *pList)
+{
+	if (sql_sorter_thread_count <= 1 || in_txn() != NULL)
+		return false;
+	size_t count = 0;
+	SorterRecord *p;
+	for (p = pList->pList; p != NULL; p = vdbeSorterNextRecord(pList, p))
+		count++;
+	if (count < sql_sorter_parallel_min_records || count < 2)
+		return false;
+	SorterRecord **records = xmalloc(count * sizeof(*records));
+	size_t i = 0;
+	for (p = pList->pList; p != NULL; p = vdbeSorterNextRecord(pList, p))
+		records[i++] = p;
+	int thread_count = MIN(sql_sorter_thread_count, TT_SORT_THREADS_MAX);
+	tt_sort(records, count, sizeof(records[0]), vdbeSorterCompareRecords,
+		pTask->pSorter->key_def, thread_count);
+	for (i = 0; i < count - 1; i++)
+		records[i]->u.pNext = records[i + 1];
+	records[count - 1]->u.pNext = NULL;
+	pList->pList = records[0];
+	free(records);
+	return true;
+}
+
 /*
  * Sort the linked list of records headed at pTask->pList. Return
  * 0 if successful, or an sql error code (i.e. -1) if
@@ -1074,6 +1195,8 @@ vdbeSorterSort(SortSubtask * pTask, SorterList * pList)
 
 	p = pList->pList;
 	pTask->xCompare = vdbeSorterGetCompare(pTask->pSorter);
+	if (vdbeSorterSortParallel(pTask, pList))
+		return 0;
 
 	aSlot = xcalloc(64, sizeof(SorterRecord *));
 
@@ -1368,12 +1491,115 @@ vdbeSorterFlushPMA(VdbeSorter * pSorter)
 	return vdbeSorterListToPMA(&pSorter->aTask, &pSorter->list);
 }
 
+/**
+ * Make an empty sorter keep at most @a limit records sorted first. The
+ * records are allocated separately from then on.
+ */
+static void
+vdbeSorterHeapInit(VdbeSorter *pSorter, int limit)
+{
+	assert(pSorter->list.pList == NULL && pSorter->bUsePMA == 0);
+	free(pSorter->list.aMemory);
+	pSorter->list.aMemory = NULL;
+	pSorter->nMemory = 0;
+	pSorter->iMemory = 0;
+	pSorter->aHeap = xmalloc(limit * sizeof(SorterRecord *));
+	pSorter->nHeap = 0;
+	pSorter->mxHeap = limit;
+}
+
+/** Free the records of a bounded sorter. */
+static void
+vdbeSorterHeapFree(VdbeSorter *pSorter)
+{
+	for (int i = 0; i < pSorter->nHeap; i++)
+		sql_xfree(pSorter->aHeap[i]);
+	free(pSorter->aHeap);
+	pSorter->aHeap = NULL;
+	pSorter->nHeap = 0;
+	pSorter->mxHeap = 0;
+}
+
+/** Compare the records at positions @a i and @a j of the heap. */
+static int
+vdbeSorterHeapCompare(VdbeSorter *pSorter, int i, int j)
+{
+	return vdbeSorterCompareKeys(pSorter->key_def,
+				     SRVAL(pSorter->aHeap[i]),
+				     SRVAL(pSorter->aHeap[j]));
+}
+
+/**
+ * Add a record to a bounded sorter. If the sorter is full, the record
+ * replaces the one sorted last, or is dropped if it is sorted after
+ * all the records of the sorter.
+ */
+static void
+vdbeSorterHeapInsert(VdbeSorter *pSorter, Mem *pVal)
+{
+	SorterRecord **aHeap = pSorter->aHeap;
+	int i;
+	if (pSorter->nHeap == pSorter->mxHeap) {
+		if (vdbeSorterCompareKeys(pSorter->key_def, pVal->z,
+					  SRVAL(aHeap[0])) >= 0)
+			return;
+		sql_xfree(aHeap[0]);
+		i = 0;
+	} else {
+		i = pSorter->nHeap++;
+	}
+	SorterRecord *pNew = xmalloc(pVal->n + sizeof(SorterRecord));
+	memcpy(SRVAL(pNew), pVal->z, pVal->n);
+	pNew->nVal = pVal->n;
+	pNew->u.pNext = NULL;
+	aHeap[i] = pNew;
+	/* Sift the record up if it was appended... */
+	while (i > 0 && vdbeSorterHeapCompare(pSorter, (i - 1) / 2, i) < 0) {
+		SWAP(aHeap[(i - 1) / 2], aHeap[i]);
+		i = (i - 1) / 2;
+	}
+	/* ...or down if it replaced the top. */
+	while (true) {
+		int j = 2 * i + 1;
+		if (j >= pSorter->nHeap)
+			break;
+		if (j + 1 < pSorter->nHeap &&
+		    vdbeSorterHeapCompare(pSorter, j + 1, j) > 0)
+			j++;
+		if (vdbeSorterHeapCompare(pSorter, i, j) >= 0)
+			break;
+		SWAP(aHeap[i], aHeap[j]);
+		i = j;
+	}
+}
+
+/**
+ * Move the records of a bounded sorter to the in-memory list of records
+ * to be sorted.
+ */
+static void
+vdbeSorterHeapToList(VdbeSorter *pSorter)
+{
+	assert(pSorter->list.aMemory == NULL && pSorter->list.pList == NULL);
+	for (int i = pSorter->nHeap - 1; i >= 0; i--) {
+		pSorter->aHeap[i]->u.pNext = pSorter->list.pList;
+		pSorter->list.pList = pSorter->aHeap[i];
+	}
+	pSorter->nHeap = 0;
+	vdbeSorterHeapFree(pSorter);
+}
+
 /*
- * Add a record to the sorter.
+ * Add a record to the sorter. If @a limit is not zero and not greater
+ * than sql_sorter_top_n_max, the sorter keeps only @a limit records
+ * sorted first: the ones that can't be returned within the LIMIT are
+ * dropped as soon as they are added, so the records are never spilled
+ * to temporary files.
  */
 int
 sqlVdbeSorterWrite(const VdbeCursor * pCsr,	/* Sorter cursor */
-		       Mem * pVal	/* Memory cell containing record */
+		       Mem * pVal,	/* Memory cell containing record */
+		       uint64_t limit	/* LIMIT of the sorter, 0 if none */
     )
 {
 	VdbeSorter *pSorter;
@@ -1387,6 +1613,15 @@ sqlVdbeSorterWrite(const VdbeCursor * pCsr,	/* Sorter cursor */
 	pSorter = pCsr->uc.pSorter;
 	assert(pSorter);
 
+	if (pSorter->aHeap == NULL && limit > 0 &&
+	    limit <= sql_sorter_top_n_max && pSorter->list.pList == NULL &&
+	    pSorter->bUsePMA == 0)
+		vdbeSorterHeapInit(pSorter, (int)limit);
+	if (pSorter->aHeap != NULL) {
+		vdbeSorterHeapInsert(pSorter, pVal);
+		return 0;
+	}
+
 	/* Figure out whether or not the current contents of memory should be
 	 * flushed to a PMA before continuing. If so, do so.
 	 *
@@ -1964,6 +2199,9 @@ sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
 	pSorter = pCsr->uc.pSorter;
 	assert(pSorter);
 
+	if (pSorter->aHeap != NULL)
+		vdbeSorterHeapToList(pSorter);
+
 	/* If no data has been written to disk, then do not do so now. Instead,
 	 * sort the VdbeSorter.pRecord list. The vdbe layer will read data directly
 	 * from the in-memory list.
@@ -43,6 +43,8 @@
 #include "mem.h"
 #include "vdbeInt.h"
 #include "whereInt.h"
+#include "hash_join.h"
+#include "analyze.h"
 #include "box/coll_id_cache.h"
 #include "box/schema.h"
 
@@ -84,6 +86,33 @@ sqlWhereIsOrdered(WhereInfo * pWInfo)
 	return pWInfo->nOBSat;
 }
 
+int
+sql_where_full_scan_index_id(struct WhereInfo *where_info)
+{
+	if (where_info->nLevel != 1 || where_info->revMask != 0)
+		return -1;
+	const struct WhereLoop *loop = where_info->a[0].pWLoop;
+	uint32_t excluded = WHERE_CONSTRAINT | WHERE_ONEROW | WHERE_MULTI_OR |
+			    WHERE_AUTO_INDEX | WHERE_SKIPSCAN;
+	if ((loop->wsFlags & WHERE_INDEXED) == 0 ||
+	    (loop->wsFlags & excluded) != 0 || loop->nEq != 0 ||
+	    loop->nBtm != 0 || loop->nTop != 0 || loop->index_def == NULL)
+		return -1;
+	return loop->index_def->iid;
+}
+
+int
+sql_where_full_scan_addr(struct WhereInfo *where_info)
+{
+	if (where_info->nLevel != 1 || where_info->a[0].addrScan == 0)
+		return -1;
+	int addr = where_info->a[0].addrScan;
+	struct Vdbe *v = where_info->pParse->pVdbe;
+	if (sqlVdbeGetOp(v, addr)->opcode != OP_Rewind)
+		return -1;
+	return addr;
+}
+
 /*
  * Return TRUE if the innermost loop of the WHERE clause implementation
  * returns rows in ORDER BY order for complete run of the inner loop.
@@ -712,6 +741,67 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
 	return 1;
 }
 
+/*
+ * Return TRUE if the WHERE clause term pTerm can drive an automatic index
+ * on table pSrc and the automatic index can be implemented as a hash table.
+ */
+static bool
+termCanDriveHashJoin(WhereTerm * pTerm, struct SrcList_item *pSrc,
+		     Bitmask notReady)
+{
+	if (!termCanDriveIndex(pTerm, pSrc, notReady))
+		return false;
+	struct field_def *field =
+		&pSrc->space->def->fields[pTerm->u.leftColumn];
+	return sql_hash_join_type_is_supported(field->type);
+}
+
+/**
+ * Generate code to fill the hash table of a hash join with the content of
+ * the table the level iterates over. The rows of the hash table consist of
+ * the fields of the ephemeral index definition, and the first key_count of
+ * them, the equality columns, form the key of the hash table.
+ *
+ * @param parse Parsing context.
+ * @param level The where level to build the hash table for.
+ * @param idx_def The ephemeral index definition.
+ * @param key_count Number of equality columns.
+ */
+static void
+vdbe_emit_hash_join_build(struct Parse *parse, struct WhereLevel *level,
+			  const struct index_def *idx_def, uint32_t key_count)
+{
+	struct Vdbe *v = parse->pVdbe;
+	struct key_def *key_def = idx_def->key_def;
+	uint32_t field_count = key_def->part_count;
+	struct sql_space_info *info = sql_space_info_new(field_count,
+							 key_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		info->types[i] = key_def->parts[i].type;
+		info->coll_ids[i] = key_def->parts[i].coll_id;
+	}
+	sqlVdbeAddOp4(v, OP_HashJoinOpen, level->iIdxCur, 0, 0, (char *)info,
+		      P4_DYNAMIC);
+	VdbeComment((v, "for %s", idx_def->space_name));
+
+	sqlExprCachePush(parse);
+	int cursor = level->iTabCur;
+	int addr_top = sqlVdbeAddOp1(v, OP_Rewind, cursor);
+	int reg_base = sqlGetTempRange(parse, field_count + 1);
+	int reg_record = reg_base + field_count;
+	for (uint32_t i = 0; i < field_count; i++) {
+		sqlVdbeAddOp3(v, OP_Column, cursor, key_def->parts[i].fieldno,
+			      reg_base + i);
+	}
+	sqlVdbeAddOp3(v, OP_MakeRecord, reg_base, field_count, reg_record);
+	sqlVdbeAddOp2(v, OP_HashJoinInsert, level->iIdxCur, reg_record);
+	sqlVdbeAddOp2(v, OP_Next, cursor, addr_top + 1);
+	sqlVdbeChangeP5(v, SQL_STMTSTATUS_AUTOINDEX);
+	sqlVdbeJumpHere(v, addr_top);
+	sqlReleaseTempRange(parse, reg_base, field_count + 1);
+	sqlExprCachePop(parse);
+}
+
 /**
  * Generate a code that will create a tuple, which is supposed to be inserted
  * in the ephemeral index space. The created tuple consists of rowid and
@@ -799,7 +889,7 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	assert(nKeyCol > 0);
 	pLoop->nEq = pLoop->nLTerm = nKeyCol;
 	pLoop->wsFlags = WHERE_COLUMN_EQ | WHERE_IDX_ONLY | WHERE_INDEXED
-	    | WHERE_AUTO_INDEX;
+	    | WHERE_AUTO_INDEX | (pLoop->wsFlags & WHERE_HASH_JOIN);
 
 	/* Count the number of additional columns needed to create a
 	 * covering index.  A "covering index" is an index that contains all
@@ -905,6 +995,11 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	/* Create the automatic index */
 	assert(pLevel->iIdxCur >= 0);
 	pLevel->iIdxCur = pParse->nTab++;
+	if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+		vdbe_emit_hash_join_build(pParse, pLevel, idx_def, pLoop->nEq);
+		sqlVdbeJumpHere(v, addrInit);
+		return;
+	}
 	struct sql_space_info *info = sql_space_info_new_from_index_def(idx_def,
 									true);
 	int reg_eph = sqlGetTempReg(pParse);
@@ -959,6 +1054,21 @@ whereRangeAdjust(WhereTerm * pTerm, LogEst nNew)
 	return nRet;
 }
 
+/**
+ * Return the constant the column is compared with by the term if the
+ * statistics collected by ANALYZE can be used to estimate the number of
+ * rows selected by the term, NULL otherwise.
+ */
+static struct Expr *
+whereTermStatValue(struct WhereTerm *pTerm)
+{
+	struct Expr *pExpr = pTerm->pExpr;
+	if (pTerm->truthProb <= 0 || (pTerm->wtFlags & TERM_VNULL) != 0 ||
+	    pExpr->pLeft == NULL || pExpr->pLeft->op != TK_COLUMN_REF)
+		return NULL;
+	return pExpr->pRight;
+}
+
 /*
  * This function is used to estimate the number of rows that will be visited
  * by scanning an index for a range of values. The range may have an upper
@@ -994,8 +1104,9 @@ whereRangeAdjust(WhereTerm * pTerm, LogEst nNew)
  * rows in the index. Assuming no error occurs, *pnOut is adjusted (reduced)
  * to account for the range constraints pLower and pUpper.
  *
- * In the absence of _sql_stat4 ANALYZE data, or if such data cannot be
- * used, a single range inequality reduces the search space by a factor of 4.
+ * If the first key part is restricted by constants and the index has been
+ * analyzed, the histogram collected by ANALYZE is used. Otherwise,
+ * a single range inequality reduces the search space by a factor of 4.
  * and a pair of constraints (x>? AND x<?) reduces the expected number of
  * rows visited by a factor of 64.
  */
@@ -1007,6 +1118,20 @@ whereRangeScanEst(struct WhereTerm *pLower, struct WhereTerm *pUpper,
 	int nOut = pLoop->nOut;
 	LogEst nNew;
 	assert(pUpper == 0 || (pUpper->wtFlags & TERM_VNULL) == 0);
+	if (pLoop->nEq == 0 && pLoop->nBtm <= 1 && pLoop->nTop <= 1 &&
+	    (pLower == NULL || whereTermStatValue(pLower) != NULL) &&
+	    (pUpper == NULL || whereTermStatValue(pUpper) != NULL) &&
+	    sql_index_stat_range_est(pLoop->index_def,
+				     pLower != NULL ? pLower->pExpr->pRight :
+				     NULL, pLower != NULL &&
+				     (pLower->eOperator & WO_GT) != 0,
+				     pUpper != NULL ? pUpper->pExpr->pRight :
+				     NULL, pUpper != NULL &&
+				     (pUpper->eOperator & WO_LT) != 0, &nNew)) {
+		if (nNew < nOut)
+			pLoop->nOut = nNew;
+		return rc;
+	}
 	nNew = whereRangeAdjust(pLower, nOut);
 	nNew = whereRangeAdjust(pUpper, nNew);
 
@@ -1768,6 +1893,7 @@ whereLoopAddBtreeIndex(WhereLoopBuilder * pBuilder,	/* The WhereLoop factory */
 		u16 eOp = pTerm->eOperator;	/* Shorthand for pTerm->eOperator */
 		LogEst rCostIdx;
 		LogEst nOutUnadjusted;	/* nOut before IN() and WHERE adjustments */
+		LogEst nStat;		/* Estimate from ANALYZE statistics */
 		int nIn = 0;
 		int nRecValid = pBuilder->nRecValid;
 		uint32_t j = probe->key_def->parts[saved_nEq].fieldno;
@@ -1913,6 +2039,19 @@ whereLoopAddBtreeIndex(WhereLoopBuilder * pBuilder,	/* The WhereLoop factory */
 				assert((eOp & WO_IN) || nIn == 0);
 				pNew->nOut += pTerm->truthProb;
 				pNew->nOut -= nIn;
+			} else if (nEq == 1 && (eOp & WO_ISNULL) != 0 &&
+				   sql_index_stat_null_est(probe, &nStat)) {
+				pNew->nOut += nStat - rSize;
+			} else if (nEq == 1 && (eOp & WO_EQ) != 0 &&
+				   whereTermStatValue(pTerm) != NULL &&
+				   sql_index_stat_eq_est(probe,
+							 pTerm->pExpr->pRight,
+							 &nStat)) {
+				/*
+				 * The histogram tells how many rows have
+				 * a frequent value of the first key part.
+				 */
+				pNew->nOut += nStat - rSize;
 			} else {
 				pNew->nOut +=
 					(index_field_tuple_est(probe, nEq) -
@@ -2143,11 +2282,13 @@ whereLoopAddBtree(WhereLoopBuilder * pBuilder,	/* WHERE clause information */
 
 	/* Automatic indexes */
 	rSize = DEFAULT_TUPLE_LOG_COUNT;
+	bool is_small_space = !space->def->opts.is_view &&
+			      sql_space_tuple_log_count(space) < 133;
 	/*
 	 * Increase cost of ephemeral index if number of tuples in space is less
 	 * then 10240.
 	 */
-	if (!space->def->opts.is_view && sql_space_tuple_log_count(space) < 133)
+	if (is_small_space)
 		rSize += DEFAULT_TUPLE_LOG_COUNT;
 	LogEst rLogSize = estLog(rSize);
 	if (!pBuilder->pOrSet && /* Not pqart of an OR optimization */
@@ -2161,6 +2302,23 @@ whereLoopAddBtree(WhereLoopBuilder * pBuilder,	/* WHERE clause information */
 		/* Generate auto-index WhereLoops */
 		WhereTerm *pTerm;
 		WhereTerm *pWCEnd = pWC->a + pWC->nTerm;
+		/*
+		 * The ephemeral index on a space of at least 10240 tuples
+		 * is built as a hash table: it is filled in linear time
+		 * instead of NlogN and probed in constant time. It is
+		 * possible only if all columns the index may be built on
+		 * can be hashed. All automatic index loops of a space must
+		 * have the same setup cost, so the choice is made for the
+		 * space rather than for each term.
+		 */
+		bool is_hash_join = !is_small_space &&
+				    !space->def->opts.is_view;
+		for (pTerm = pWC->a; is_hash_join && pTerm < pWCEnd; pTerm++) {
+			if ((pTerm->prereqRight & pNew->maskSelf) == 0 &&
+			    termCanDriveIndex(pTerm, pSrc, 0) &&
+			    !termCanDriveHashJoin(pTerm, pSrc, 0))
+				is_hash_join = false;
+		}
 		for (pTerm = pWC->a; rc == 0 && pTerm < pWCEnd; pTerm++) {
 			if (pTerm->prereqRight & pNew->maskSelf)
 				continue;
@@ -2186,6 +2344,17 @@ whereLoopAddBtree(WhereLoopBuilder * pBuilder,	/* WHERE clause information */
 				pNew->rRun =
 				    sqlLogEstAdd(rLogSize, pNew->nOut);
 				pNew->wsFlags = WHERE_AUTO_INDEX;
+				if (is_hash_join) {
+					/*
+					 * TUNING: Hashing a row costs about
+					 * as much as two comparisons.
+					 */
+					assert(10 == sqlLogEst(2));
+					pNew->rSetup = rSize + 10;
+					pNew->rRun = sqlLogEstAdd(10,
+								  pNew->nOut);
+					pNew->wsFlags |= WHERE_HASH_JOIN;
+				}
 				pNew->prereq = mPrereq | pTerm->prereqRight;
 				rc = whereLoopInsert(pBuilder, pNew);
 			}
@@ -2204,7 +2373,9 @@ whereLoopAddBtree(WhereLoopBuilder * pBuilder,	/* WHERE clause information */
 		if (i > 0)
 			probe = space->index[i]->def;
 		/* Such index may possibly contain not all tuples, so skip it */
-		if (pSrc->pIBIndex == NULL && probe->key_def->has_exclude_null)
+		if (pSrc->pIBIndex == NULL &&
+		    (probe->key_def->has_exclude_null ||
+		     probe->opts.filter_func_id != 0))
 			continue;
 		rSize = index_field_tuple_est(probe, 0);
 		pNew->nEq = 0;
@@ -3423,6 +3594,19 @@ where_loop_builder_shortcut(struct WhereLoopBuilder *builder)
 	return 0;
 }
 
+/**
+ * Pass the mask of the columns of the space used by the statement to the
+ * cursor, so that only these columns are located when tuples are decoded.
+ */
+static void
+where_emit_columns_used(struct Vdbe *v, int cursor, Bitmask col_used)
+{
+	if (col_used == 0)
+		return;
+	sqlVdbeAddOp4Dup8(v, OP_ColumnsUsed, cursor, 0, 0,
+			  (const u8 *)&col_used, P4_UINT64);
+}
+
 /*
  * Generate the beginning of the loop used for WHERE clause processing.
  * The return value is a pointer to an opaque structure that contains
@@ -3836,6 +4020,8 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 			VdbeComment((v, "%s", space->def->name));
 			assert(pTabItem->iCursor == pLevel->iTabCur);
 			sqlVdbeChangeP5(v, bFordelete);
+			where_emit_columns_used(v, pTabItem->iCursor,
+						pTabItem->colUsed);
 		}
 		if (pLoop->wsFlags & WHERE_INDEXED) {
 			struct index_def *idx_def = pLoop->index_def;
@@ -3910,6 +4096,12 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 					sqlVdbeChangeP5(v, OPFLAG_SEEKEQ);	/* Hint to COMDB2 */
 				}
 				VdbeComment((v, "%s", idx_def->name));
+				/*
+				 * Index cursors return whole tuples, so
+				 * columns of the space are read from them.
+				 */
+				where_emit_columns_used(v, iIndexCur,
+							pTabItem->colUsed);
 			}
 		}
 	}
@@ -4067,6 +4259,17 @@ sqlWhereEnd(WhereInfo * pWInfo)
 			for (; k < last; k++, pOp++) {
 				if (pOp->p1 != pLevel->iTabCur)
 					continue;
+				/*
+				 * Filters are not generated for loops over
+				 * ephemeral indexes, so their fields are
+				 * never renumbered.
+				 */
+				if (pOp->opcode == OP_Filter) {
+					assert((pLoop->wsFlags &
+						WHERE_AUTO_INDEX) == 0);
+					pOp->p1 = pLevel->iIdxCur;
+					continue;
+				}
 				if (pOp->opcode != OP_Column)
 					continue;
 				assert(def == NULL || def->space_id ==
@@ -86,6 +86,7 @@ struct WhereLevel {
 	int addrCont;		/* Jump here to continue with the next loop cycle */
 	int addrFirst;		/* First instruction of interior of the loop */
 	int addrBody;		/* Beginning of the body of this loop */
+	int addrScan;		/* OP_Rewind or OP_Last of a full scan or 0 */
 	u8 iFrom;		/* Which entry in the FROM clause */
 	u8 op, p3, p5;		/* Opcode, P3 & P5 of the opcode that ends the loop */
 	int p1, p2;		/* Operands of the opcode used to ends the loop */
@@ -521,3 +522,4 @@ void sqlWhereTabFuncArgs(Parse *, struct SrcList_item *, WhereClause *);
 #define WHERE_AUTO_INDEX   0x00004000	/* Uses an ephemeral index */
 #define WHERE_SKIPSCAN     0x00008000	/* Uses the skip-scan algorithm */
 #define WHERE_UNQ_WANTED   0x00010000	/* WHERE_ONEROW would have been helpful */
+#define WHERE_HASH_JOIN    0x00020000	/* Ephemeral index is a hash table */
@@ -38,9 +38,11 @@
  * that actually generate the bulk of the WHERE loop code.  The original where.c
  * file retains the code that does query planning and analysis.
  */
+#include "box/coll_id.h"
 #include "box/schema.h"
 #include "sqlInt.h"
 #include "whereInt.h"
+#include "filter.h"
 
 /*
  * Return the name of the i-th column of the pIdx index.
@@ -217,7 +219,9 @@ sqlWhereExplainOneScan(Parse * pParse,	/* Parse context */
 
 			assert(!(flags & WHERE_AUTO_INDEX)
 			       || (flags & WHERE_IDX_ONLY));
-			if ((flags & WHERE_AUTO_INDEX) != 0) {
+			if ((flags & WHERE_HASH_JOIN) != 0) {
+				zFmt = "HASH JOIN";
+			} else if ((flags & WHERE_AUTO_INDEX) != 0) {
 				zFmt = "EPHEMERAL INDEX";
 			} else if (idx_def->iid == 0) {
 				if (is_search)
@@ -658,6 +662,244 @@ codeExprOrVector(Parse * pParse, Expr * p, int iReg, int nReg)
 	}
 }
 
+/** Check if the expression is a constant a filter term can use. */
+static bool
+where_filter_expr_is_const(const struct Expr *expr)
+{
+	if (expr->op == TK_UMINUS)
+		return expr->pLeft->op == TK_INTEGER ||
+		       expr->pLeft->op == TK_FLOAT;
+	return expr->op == TK_INTEGER || expr->op == TK_FLOAT ||
+	       expr->op == TK_STRING || expr->op == TK_VARIABLE ||
+	       expr->op == TK_NULL;
+}
+
+/** Check if the expression is a field of the space with the cursor. */
+static bool
+where_filter_expr_is_field(const struct Expr *expr, int cursor,
+			   const struct space_def *def)
+{
+	return expr->op == TK_COLUMN_REF && expr->iTable == cursor &&
+	       expr->iColumn >= 0 && (uint32_t)expr->iColumn < def->field_count;
+}
+
+/**
+ * Convert the comparison operator to the filter operation. If
+ * @a is_swapped is set, the operands of the comparison are swapped.
+ * Return -1 if the operator is not a comparison.
+ */
+static int
+where_filter_cmp_op(int op, bool is_swapped)
+{
+	switch (op) {
+	case TK_EQ:
+		return SQL_FILTER_EQ;
+	case TK_NE:
+		return SQL_FILTER_NE;
+	case TK_LT:
+		return is_swapped ? SQL_FILTER_GT : SQL_FILTER_LT;
+	case TK_LE:
+		return is_swapped ? SQL_FILTER_GE : SQL_FILTER_LE;
+	case TK_GT:
+		return is_swapped ? SQL_FILTER_LT : SQL_FILTER_GT;
+	case TK_GE:
+		return is_swapped ? SQL_FILTER_LE : SQL_FILTER_GE;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * Check if the expression is a field or an arithmetic operation of the
+ * form "field <op> const" or "const <op> field" and fill in the field
+ * and the operation of the filter term.
+ */
+static bool
+where_filter_term_set_field(struct sql_filter_term *term, struct Expr *expr,
+			    int cursor, const struct space_def *def,
+			    struct Expr **operand)
+{
+	*operand = NULL;
+	term->arith_op = SQL_FILTER_ARITH_NONE;
+	switch (expr->op) {
+	case TK_PLUS:
+		term->arith_op = SQL_FILTER_ARITH_ADD;
+		break;
+	case TK_MINUS:
+		term->arith_op = SQL_FILTER_ARITH_SUB;
+		break;
+	case TK_STAR:
+		term->arith_op = SQL_FILTER_ARITH_MUL;
+		break;
+	default:
+		break;
+	}
+	if (term->arith_op != SQL_FILTER_ARITH_NONE) {
+		bool is_commutative = term->arith_op != SQL_FILTER_ARITH_SUB;
+		if (is_commutative &&
+		    where_filter_expr_is_field(expr->pRight, cursor, def) &&
+		    where_filter_expr_is_const(expr->pLeft)) {
+			*operand = expr->pLeft;
+			expr = expr->pRight;
+		} else {
+			*operand = expr->pRight;
+			expr = expr->pLeft;
+		}
+		if (!where_filter_expr_is_const(*operand))
+			return false;
+	}
+	if (!where_filter_expr_is_field(expr, cursor, def))
+		return false;
+	term->fieldno = expr->iColumn;
+	term->type = def->fields[expr->iColumn].type;
+	return true;
+}
+
+/**
+ * Check if the term of the WHERE clause can be evaluated by a filter
+ * and fill in the filter term. The constants of the term are returned
+ * in @a value and @a operand.
+ */
+static bool
+where_filter_term_init(struct sql_filter_term *term, struct Expr *expr,
+		       int cursor, const struct space_def *def,
+		       struct Expr **value, struct Expr **operand)
+{
+	memset(term, 0, sizeof(*term));
+	*value = NULL;
+	*operand = NULL;
+	if (expr->op == TK_ISNULL || expr->op == TK_NOTNULL) {
+		if (!where_filter_expr_is_field(expr->pLeft, cursor, def))
+			return false;
+		term->op = expr->op == TK_ISNULL ? SQL_FILTER_IS_NULL :
+			   SQL_FILTER_NOT_NULL;
+		term->fieldno = expr->pLeft->iColumn;
+		term->type = def->fields[term->fieldno].type;
+		return true;
+	}
+	if (sql_is_like_func(expr)) {
+		/* "A LIKE B" is implemented as like(B, A). */
+		struct Expr *field = expr->x.pList->a[1].pExpr;
+		*value = expr->x.pList->a[0].pExpr;
+		if (!where_filter_expr_is_field(field, cursor, def) ||
+		    !where_filter_expr_is_const(*value))
+			return false;
+		term->op = SQL_FILTER_LIKE;
+		term->fieldno = field->iColumn;
+		term->type = def->fields[term->fieldno].type;
+	} else {
+		if (where_filter_cmp_op(expr->op, false) < 0)
+			return false;
+		bool is_swapped = where_filter_expr_is_const(expr->pLeft);
+		term->op = where_filter_cmp_op(expr->op, is_swapped);
+		*value = is_swapped ? expr->pLeft : expr->pRight;
+		struct Expr *field = is_swapped ? expr->pRight : expr->pLeft;
+		if (!where_filter_expr_is_const(*value) ||
+		    !where_filter_term_set_field(term, field, cursor, def,
+						 operand))
+			return false;
+	}
+	/* Strings are compared by the filter with the binary collation. */
+	if (term->type == FIELD_TYPE_STRING &&
+	    def->fields[term->fieldno].coll_id != COLL_NONE)
+		return false;
+	return sql_filter_type_is_supported(term->type, term->op,
+					    term->arith_op);
+}
+
+/**
+ * Check if the term of the WHERE clause is to be tested in the body of
+ * the loop.
+ */
+static bool
+where_filter_term_is_usable(const struct WhereLevel *level,
+			    const struct WhereTerm *term)
+{
+	if ((term->wtFlags & (TERM_VIRTUAL | TERM_CODED | TERM_LIKECOND)) != 0)
+		return false;
+	if ((term->prereqAll & level->notReady) != 0)
+		return false;
+	return level->iLeftJoin == 0 ||
+	       ExprHasProperty(term->pExpr, EP_FromJoin);
+}
+
+/**
+ * Generate the OP_Filter instruction that tests the terms of the
+ * WHERE clause comparing fields of the table of the loop with
+ * constants, instead of the byte code of these terms. The byte code
+ * of the terms follows the instruction and is executed only if the
+ * filter can't evaluate some of the terms exactly.
+ */
+static void
+where_emit_filter(struct WhereInfo *where_info, struct WhereLevel *level,
+		  int addr_cont)
+{
+	struct Parse *parse = where_info->pParse;
+	struct Vdbe *v = parse->pVdbe;
+	struct WhereClause *wc = &where_info->sWC;
+	struct SrcList_item *item = &where_info->pTabList->a[level->iFrom];
+	uint32_t excluded = WHERE_MULTI_OR | WHERE_AUTO_INDEX |
+			    WHERE_HASH_JOIN;
+	if (!ConstFactorOk(parse) || item->space == NULL ||
+	    item->pSelect != NULL || item->fg.viaCoroutine ||
+	    item->fg.isRecursive || item->space->def->opts.is_ephemeral ||
+	    (level->pWLoop->wsFlags & excluded) != 0 ||
+	    (where_info->wctrlFlags & WHERE_OR_SUBCLAUSE) != 0)
+		return;
+	const struct space_def *def = item->space->def;
+	int cursor = level->iTabCur;
+	struct sql_filter_term unused;
+	struct Expr *value;
+	struct Expr *operand;
+	uint32_t count = 0;
+	for (int i = 0; i < wc->nTerm; i++) {
+		if (where_filter_term_is_usable(level, &wc->a[i]) &&
+		    where_filter_term_init(&unused, wc->a[i].pExpr, cursor,
+					   def, &value, &operand))
+			count++;
+	}
+	if (count == 0)
+		return;
+	struct sql_filter *filter = sql_filter_new(count);
+	count = 0;
+	for (int i = 0; i < wc->nTerm; i++) {
+		struct sql_filter_term *term = &filter->terms[count];
+		if (!where_filter_term_is_usable(level, &wc->a[i]) ||
+		    !where_filter_term_init(term, wc->a[i].pExpr, cursor, def,
+					    &value, &operand))
+			continue;
+		if (value != NULL) {
+			term->reg_value = ++parse->nMem;
+			sqlExprCodeAtInit(parse, value, term->reg_value, 0);
+		}
+		if (operand != NULL) {
+			term->reg_operand = ++parse->nMem;
+			sqlExprCodeAtInit(parse, operand, term->reg_operand, 0);
+		}
+		count++;
+	}
+	assert(count == filter->term_count);
+	int addr = sqlVdbeAddOp4(v, OP_Filter, cursor, addr_cont, 0,
+				 (char *)filter, P4_DYNAMIC);
+	/*
+	 * Registers loaded by the byte code of the terms are not
+	 * available after the filter jumps over it.
+	 */
+	sqlExprCachePush(parse);
+	for (int i = 0; i < wc->nTerm; i++) {
+		struct WhereTerm *where_term = &wc->a[i];
+		if (!where_filter_term_is_usable(level, where_term) ||
+		    !where_filter_term_init(&unused, where_term->pExpr, cursor,
+					    def, &value, &operand))
+			continue;
+		sqlExprIfFalse(parse, where_term->pExpr, addr_cont,
+			       SQL_JUMPIFNULL);
+		where_term->wtFlags |= TERM_CODED;
+	}
+	sqlExprCachePop(parse);
+	sqlVdbeChangeP3(v, addr, sqlVdbeCurrentAddr(v));
+}
+
 /*
  * Generate code for the start of the iLevel-th loop in the WHERE clause
  * implementation described by pWInfo.
@@ -727,6 +969,20 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		pLevel->p2 = sqlVdbeAddOp2(v, OP_Yield, regYield, addrBrk);
 		VdbeComment((v, "next row of \"%s\"", pTabItem->space->def->name));
 		pLevel->op = OP_Goto;
+	} else if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+		/* A lookup in the hash table of a hash join. The hash
+		 * table built by constructAutomaticIndex() is keyed by all
+		 * the == terms, so the loop only iterates over the rows
+		 * matching the key.
+		 */
+		int iIdxCur = pLevel->iIdxCur;
+		int regBase = codeAllEqualityTerms(pParse, pLevel, 0, 0);
+		addrNxt = pLevel->addrNxt;
+		sqlVdbeAddOp4Int(v, OP_HashJoinProbe, iIdxCur, addrNxt,
+				 regBase, pLoop->nEq);
+		pLevel->p2 = sqlVdbeCurrentAddr(v);
+		pLevel->op = OP_HashJoinNext;
+		pLevel->p1 = iIdxCur;
 	} else if (pLoop->wsFlags & WHERE_INDEXED) {
 		/* Case 4: A scan using an index.
 		 *
@@ -913,8 +1169,13 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 			op = aStartOp[(start_constraints << 2) +
 				      (startEq << 1) + bRev];
 			assert(op != 0);
-			sqlVdbeAddOp4Int(v, op, iIdxCur, addrNxt, regBase,
-					     nConstraint);
+			if (op == OP_Rewind || op == OP_Last) {
+				pLevel->addrScan =
+					sqlVdbeAddOp2(v, op, iIdxCur, addrNxt);
+			} else {
+				sqlVdbeAddOp4Int(v, op, iIdxCur, addrNxt,
+						 regBase, nConstraint);
+			}
 		}
 
 		/* Load the value for the inequality constraint at the end of the
@@ -1293,9 +1554,9 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		} else {
 			pLevel->op = aStep[bRev];
 			pLevel->p1 = iCur;
-			pLevel->p2 =
-			    1 + sqlVdbeAddOp2(v, aStart[bRev], iCur,
-						  addrBrk);
+			pLevel->addrScan = sqlVdbeAddOp2(v, aStart[bRev], iCur,
+							 addrBrk);
+			pLevel->p2 = 1 + pLevel->addrScan;
 			pLevel->p5 = SQL_STMTSTATUS_FULLSCAN_STEP;
 		}
 	}
@@ -1303,6 +1564,7 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 	/* Insert code to test every subexpression that can be completely
 	 * computed using the current set of tables.
 	 */
+	where_emit_filter(pWInfo, pLevel, addrCont);
 	for (pTerm = pWC->a, j = pWC->nTerm; j > 0; j--, pTerm++) {
 		Expr *pE;
 		int skipLikeAddr = 0;
@@ -30,14 +30,22 @@
  */
 #include "sql_stmt_cache.h"
 
+#include <stdio.h>
+
 #include "assoc.h"
 #include "error.h"
 #include "execute.h"
 #include "diag.h"
+#include "fiber.h"
 #include "info/info.h"
 
 static struct sql_stmt_cache sql_stmt_cache;
 
+static struct sql_plan_cache sql_plan_cache;
+
+/** Max memory size that can be used for the plan cache. */
+static size_t sql_plan_cache_size = 5 * 1024 * 1024;
+
 void
 sql_stmt_cache_init(void)
 {
@@ -45,6 +53,11 @@ sql_stmt_cache_init(void)
 	sql_stmt_cache.mem_quota = 0;
 	sql_stmt_cache.mem_used = 0;
 	rlist_create(&sql_stmt_cache.gc_queue);
+	sql_plan_cache.hash = mh_strnptr_new();
+	sql_plan_cache.mem_used = 0;
+	rlist_create(&sql_plan_cache.lru);
+	sql_plan_cache.hit_count = 0;
+	sql_plan_cache.miss_count = 0;
 }
 
 void
@@ -59,6 +72,12 @@ sql_stmt_cache_stat(struct info_handler *h)
 		entry_count++;
 	info_append_int(h, "stmt_count", entry_count);
 	info_table_end(h);
+	info_table_begin(h, "plan_cache");
+	info_append_int(h, "size", sql_plan_cache.mem_used);
+	info_append_int(h, "stmt_count", mh_size(sql_plan_cache.hash));
+	info_append_int(h, "hits", sql_plan_cache.hit_count);
+	info_append_int(h, "misses", sql_plan_cache.miss_count);
+	info_table_end(h);
 	info_end(h);
 }
 
@@ -286,3 +305,154 @@ sql_stmt_cache_set_size(size_t size)
 	sql_stmt_cache.mem_quota = size;
 	return 0;
 }
+
+/** Size of memory occupied by the plan cache entry. */
+static size_t
+sql_plan_cache_entry_sizeof(struct Vdbe *stmt)
+{
+	return sql_stmt_est_size(stmt) + sizeof(struct sql_plan_cache_entry);
+}
+
+enum {
+	/**
+	 * Size of the SQL options prefix of a plan cache key. The options
+	 * are printed in hex because the keys are compared as strings.
+	 */
+	SQL_PLAN_CACHE_KEY_PREFIX_SIZE = 9,
+};
+
+/**
+ * Build the key of a plan cache entry: the SQL options followed by the
+ * SQL text. The key buffer must fit SQL_PLAN_CACHE_KEY_PREFIX_SIZE + len
+ * bytes and a terminating zero. Returns the key size.
+ */
+static uint32_t
+sql_plan_cache_key(char *key, const char *sql, uint32_t len,
+		   uint32_t sql_flags)
+{
+	snprintf(key, SQL_PLAN_CACHE_KEY_PREFIX_SIZE + 1, "%08x:",
+		 (unsigned)sql_flags);
+	memcpy(key + SQL_PLAN_CACHE_KEY_PREFIX_SIZE, sql, len);
+	key[SQL_PLAN_CACHE_KEY_PREFIX_SIZE + len] = '\0';
+	return SQL_PLAN_CACHE_KEY_PREFIX_SIZE + len;
+}
+
+/** Remove the entry from the plan cache and finalize its statement. */
+static void
+sql_plan_cache_delete(struct sql_plan_cache_entry *entry)
+{
+	assert(!sql_stmt_busy(entry->stmt));
+	mh_int_t i = mh_strnptr_find_str(sql_plan_cache.hash, entry->key,
+					 entry->key_len);
+	assert(i != mh_end(sql_plan_cache.hash));
+	mh_strnptr_del(sql_plan_cache.hash, i, NULL);
+	rlist_del(&entry->in_lru);
+	sql_plan_cache.mem_used -= sql_plan_cache_entry_sizeof(entry->stmt);
+	sql_stmt_finalize(entry->stmt);
+	TRASH(entry);
+	free(entry);
+}
+
+/**
+ * Evict the least recently used statements that are not being executed
+ * until the plan cache occupies no more than @a size bytes.
+ */
+static void
+sql_plan_cache_evict(size_t size)
+{
+	struct sql_plan_cache_entry *entry, *tmp;
+	rlist_foreach_entry_safe_reverse(entry, &sql_plan_cache.lru, in_lru,
+					 tmp) {
+		if (sql_plan_cache.mem_used <= size)
+			break;
+		if (!sql_stmt_busy(entry->stmt))
+			sql_plan_cache_delete(entry);
+	}
+}
+
+/**
+ * Return the plan cache entry with the given SQL text compiled with the
+ * given SQL options or NULL.
+ */
+static struct sql_plan_cache_entry *
+sql_plan_cache_find_entry(const char *sql, uint32_t len, uint32_t sql_flags)
+{
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	char *key = xregion_alloc(region,
+				  SQL_PLAN_CACHE_KEY_PREFIX_SIZE + len + 1);
+	uint32_t key_len = sql_plan_cache_key(key, sql, len, sql_flags);
+	struct mh_strnptr_t *hash = sql_plan_cache.hash;
+	mh_int_t i = mh_strnptr_find_str(hash, key, key_len);
+	region_truncate(region, svp);
+	if (i == mh_end(hash))
+		return NULL;
+	return mh_strnptr_node(hash, i)->val;
+}
+
+void
+sql_plan_cache_set_size(size_t size)
+{
+	sql_plan_cache_evict(size);
+	sql_plan_cache_size = size;
+}
+
+bool
+sql_plan_cache_is_enabled(void)
+{
+	return sql_plan_cache_size > 0;
+}
+
+struct Vdbe *
+sql_plan_cache_find(const char *sql, uint32_t len, uint32_t sql_flags)
+{
+	struct sql_plan_cache_entry *entry =
+		sql_plan_cache_find_entry(sql, len, sql_flags);
+	if (entry == NULL) {
+		sql_plan_cache.miss_count++;
+		return NULL;
+	}
+	if (!sql_stmt_schema_version_is_valid(entry->stmt)) {
+		if (!sql_stmt_busy(entry->stmt))
+			sql_plan_cache_delete(entry);
+		sql_plan_cache.miss_count++;
+		return NULL;
+	}
+	rlist_move(&sql_plan_cache.lru, &entry->in_lru);
+	sql_plan_cache.hit_count++;
+	return entry->stmt;
+}
+
+int
+sql_plan_cache_insert(struct Vdbe *stmt, uint32_t sql_flags)
+{
+	const char *sql_str = sql_stmt_query_str(stmt);
+	uint32_t len = strlen(sql_str);
+	struct sql_plan_cache_entry *old =
+		sql_plan_cache_find_entry(sql_str, len, sql_flags);
+	if (old != NULL) {
+		/* The old statement may be executed by another fiber. */
+		if (sql_stmt_busy(old->stmt))
+			return -1;
+		sql_plan_cache_delete(old);
+	}
+	size_t size = sql_plan_cache_entry_sizeof(stmt);
+	if (size > sql_plan_cache_size)
+		return -1;
+	sql_plan_cache_evict(sql_plan_cache_size - size);
+	if (sql_plan_cache.mem_used + size > sql_plan_cache_size)
+		return -1;
+	struct sql_plan_cache_entry *entry = xmalloc(sizeof(*entry) + SQL_PLAN_CACHE_KEY_PREFIX_SIZE +
+			len + 1);
+	entry->stmt = stmt;
+	entry->key_len = sql_plan_cache_key(entry->key, sql_str, len,
+					    sql_flags);
+	rlist_add(&sql_plan_cache.lru, &entry->in_lru);
+	const struct mh_strnptr_node_t node = {
+		entry->key, entry->key_len,
+		mh_strn_hash(entry->key, entry->key_len), entry
+	};
+	mh_strnptr_put(sql_plan_cache.hash, &node, NULL, NULL);
+	sql_plan_cache.mem_used += size;
+	return 0;
+}
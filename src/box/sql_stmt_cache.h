@@ -40,7 +40,9 @@ extern "C" {
 #endif
 
 struct mh_i64ptr_t;
+struct mh_strnptr_t;
 struct info_handler;
+struct Vdbe;
 
 struct stmt_cache_entry {
 	/** Prepared statement itself. */
@@ -146,6 +148,73 @@ sql_stmt_cache_find(uint32_t stmt_id);
 int
 sql_stmt_cache_set_size(size_t size);
 
+/** An entry of the global plan cache. */
+struct sql_plan_cache_entry {
+	/** Compiled statement. */
+	struct Vdbe *stmt;
+	/** Link in the LRU list of the cache. */
+	struct rlist in_lru;
+	/** Size of the key. */
+	uint32_t key_len;
+	/**
+	 * Key of the entry in the cache: the SQL options of the session
+	 * the statement was compiled with followed by the SQL text.
+	 */
+	char key[0];
+};
+
+/**
+ * Global cache of statements executed without explicit preparation.
+ * Statements are keyed by their (normalized) SQL text and the SQL options
+ * they were compiled with, so sessions that execute the same text with
+ * the same options share one compiled program. Unlike the prepared
+ * statement cache, entries are not referenced by sessions: the least
+ * recently used ones are evicted when the memory limit is reached.
+ */
+struct sql_plan_cache {
+	/** Size of memory currently occupied by the statements. */
+	size_t mem_used;
+	/** SQL options and text -> struct sql_plan_cache_entry hash. */
+	struct mh_strnptr_t *hash;
+	/** Entries, the most recently used first. */
+	struct rlist lru;
+	/** Number of lookups that found a valid statement. */
+	uint64_t hit_count;
+	/** Number of lookups that didn't find a valid statement. */
+	uint64_t miss_count;
+};
+
+/**
+ * Set the plan cache size limit. The least recently used statements that
+ * are not being executed are evicted if the cache doesn't fit in it.
+ */
+void
+sql_plan_cache_set_size(size_t size);
+
+/** Check if the plan cache is enabled, i.e. has a non-zero size limit. */
+bool
+sql_plan_cache_is_enabled(void);
+
+/**
+ * Find a statement compiled from the SQL text with the given SQL options.
+ * Statements compiled for an old schema are evicted.
+ *
+ * @retval NULL if the statement is not found.
+ */
+struct Vdbe *
+sql_plan_cache_find(const char *sql, uint32_t len, uint32_t sql_flags);
+
+/**
+ * Add a statement compiled with the given SQL options to the plan cache.
+ * The least recently used statements that are not being executed are
+ * evicted if the memory limit is exceeded.
+ *
+ * @retval 0 if the statement is added and now belongs to the cache.
+ * @retval -1 if the statement doesn't fit in the cache, diag is not set.
+ */
+int
+sql_plan_cache_insert(struct Vdbe *stmt, uint32_t sql_flags);
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
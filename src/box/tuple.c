@@ -30,6 +30,13 @@
  */
 #include "tuple.h"
 
+#include <limits.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
+
 #include "trivia/util.h"
 #include "memory.h"
 #include "fiber.h"
@@ -422,6 +429,60 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 	}
 }
 
+void
+tuple_arena_set_placement(struct slab_arena *arena, bool huge_pages,
+			  int numa_node, const char *arena_name)
+{
+	if (arena->arena == NULL || arena->prealloc == 0)
+		return;
+	if (huge_pages) {
+#if defined(MADV_HUGEPAGE)
+		if (madvise(arena->arena, arena->prealloc,
+			    MADV_HUGEPAGE) != 0) {
+			say_syserror("failed to enable huge pages for %s "
+				     "tuple arena", arena_name);
+		} else {
+			say_info("using huge pages for %s tuple arena",
+				 arena_name);
+		}
+#else
+		say_warn("huge pages are not supported on this platform, "
+			 "ignoring for %s tuple arena", arena_name);
+#endif
+	}
+	if (numa_node >= 0) {
+		assert(numa_node <= TUPLE_ARENA_NUMA_NODE_MAX);
+#if defined(__linux__) && defined(SYS_mbind)
+		/*
+		 * Use the preferred policy rather than the strict one so
+		 * that the kernel falls back on other nodes instead of
+		 * failing page faults when the node runs out of memory.
+		 */
+		const int mpol_preferred = 1; /* see numaif.h */
+		const int bits_per_long = sizeof(unsigned long) * CHAR_BIT;
+		unsigned long nodemask[(TUPLE_ARENA_NUMA_NODE_MAX + 1) /
+				       (sizeof(unsigned long) * CHAR_BIT)];
+		memset(nodemask, 0, sizeof(nodemask));
+		nodemask[numa_node / bits_per_long] |=
+			1UL << (numa_node % bits_per_long);
+		/* The kernel ignores the last bit of the mask, hence + 1. */
+		if (syscall(SYS_mbind, arena->arena, arena->prealloc,
+			    mpol_preferred, nodemask,
+			    (unsigned long)TUPLE_ARENA_NUMA_NODE_MAX + 2,
+			    0) != 0) {
+			say_syserror("failed to bind %s tuple arena to "
+				     "NUMA node %d", arena_name, numa_node);
+		} else {
+			say_info("bound %s tuple arena to NUMA node %d",
+				 arena_name, numa_node);
+		}
+#else
+		say_warn("NUMA is not supported on this platform, "
+			 "ignoring for %s tuple arena", arena_name);
+#endif
+	}
+}
+
 void
 tuple_arena_destroy(struct slab_arena *arena)
 {
@@ -72,6 +72,24 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
 		   bool dontdump, const char *arena_name);
 
+/** Max NUMA node number accepted by tuple_arena_set_placement(). */
+enum { TUPLE_ARENA_NUMA_NODE_MAX = 1023 };
+
+/**
+ * Sets memory placement policy for the memory preallocated for a tuples
+ * arena. Must be called before the arena is used.
+ * @param arena Arena to set up.
+ * @param huge_pages Back the arena with transparent huge pages.
+ * @param numa_node NUMA node to allocate the arena memory from, if
+ *                  possible, or -1 to use the default policy.
+ * @param arena_name Name of @arena for logs.
+ *
+ * Failures are not fatal: they are logged and the default policy is used.
+ */
+void
+tuple_arena_set_placement(struct slab_arena *arena, bool huge_pages,
+			  int numa_node, const char *arena_name);
+
 void
 tuple_arena_destroy(struct slab_arena *arena);
 
@@ -305,6 +305,8 @@ txn_stmt_new(struct txn *txn, uint16_t type)
 	stmt->new_tuple = NULL;
 	stmt->rollback_info.old_tuple = NULL;
 	stmt->rollback_info.new_tuple = NULL;
+	memset(stmt->rollback_info.partial_index_mask, 0,
+	       sizeof(stmt->rollback_info.partial_index_mask));
 	stmt->add_story = NULL;
 	stmt->del_story = NULL;
 	stmt->next_in_del_list = NULL;
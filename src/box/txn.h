@@ -285,6 +285,13 @@ enum txn_status {
 struct txn_stmt_rollback_info {
 	struct tuple *old_tuple;
 	struct tuple *new_tuple;
+	/**
+	 * Bitmap of the partial indexes (by position in the space index
+	 * array) that stored old_tuple before the statement. It's filled
+	 * when the statement is executed so that the filter functions of
+	 * the indexes aren't called on rollback.
+	 */
+	char partial_index_mask[BITMAP_SIZE(BOX_INDEX_MAX)];
 };
 
 /**
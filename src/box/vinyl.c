@@ -704,6 +704,11 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "'layout' option");
 		return -1;
 	}
+	if (index_def->opts.filter_func_id != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "vinyl",
+			 "partial index");
+		return -1;
+	}
 	return 0;
 }
 
@@ -4836,6 +4841,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .count = */ generic_index_count,
 	/* .get_internal = */ generic_index_get_internal,
 	/* .get = */ vinyl_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_iterator_with_offset = */
@@ -48,6 +48,7 @@
 #include "mpstream/mpstream.h"
 #include "errinj.h"
 #include "core/tweaks.h"
+#include "zstd.h"
 
 /**
  * Controls whether `IPROTO_FEATURE_CALL_RET_TUPLE_EXTENSION` feature bit is set
@@ -242,6 +243,15 @@ xrow_decode(struct xrow_header *header, const char **pos,
 		case IPROTO_STREAM_ID:
 			header->stream_id = mp_decode_uint(pos);
 			break;
+		case IPROTO_COMPRESSION:
+			header->compression = mp_decode_uint(pos);
+			break;
+		case IPROTO_SCHED_CLASS: {
+			uint64_t sched_class = mp_decode_uint(pos);
+			if (sched_class <= UINT8_MAX)
+				header->sched_class = sched_class;
+			break;
+		}
 		default:
 			/* unknown header */
 			mp_next(pos);
@@ -289,6 +299,146 @@ xrow_decode(struct xrow_header *header, const char **pos,
 	return -1;
 }
 
+/**
+ * zstd contexts used for compression of IPROTO packets, created on
+ * demand for each thread.
+ */
+static __thread ZSTD_CCtx *iproto_zstd_cctx;
+static __thread ZSTD_DCtx *iproto_zstd_dctx;
+
+/** Compression level of IPROTO packets: favor speed over ratio. */
+enum { IPROTO_ZSTD_LEVEL = 1 };
+
+const char *
+iproto_packet_compress(const char *packet, size_t size,
+		       size_t *compressed_size)
+{
+	const char *pos = packet;
+	const char *end = packet + size;
+	if (size == 0 || mp_typeof(*pos) != MP_UINT)
+		return NULL;
+	if (mp_decode_uint(&pos) != (uint64_t)(end - pos) ||
+	    mp_typeof(*pos) != MP_MAP)
+		return NULL;
+	uint32_t map_size = mp_decode_map(&pos);
+	const char *keys = pos;
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*pos) == MP_UINT &&
+		    mp_decode_uint(&pos) == IPROTO_COMPRESSION)
+			return NULL;
+		mp_next(&pos);
+	}
+	const char *body = pos;
+	size_t keys_size = body - keys;
+	size_t body_size = end - body;
+	if (body_size == 0)
+		return NULL;
+	if (iproto_zstd_cctx == NULL) {
+		iproto_zstd_cctx = ZSTD_createCCtx();
+		if (iproto_zstd_cctx == NULL)
+			return NULL;
+	}
+	struct region *region = &fiber()->gc;
+	size_t bound = ZSTD_compressBound(body_size);
+	size_t max_size = mp_sizeof_uint(UINT32_MAX) +
+			  mp_sizeof_map(map_size + 1) + keys_size +
+			  mp_sizeof_uint(IPROTO_COMPRESSION) +
+			  mp_sizeof_uint(IPROTO_COMPRESSION_ZSTD) +
+			  mp_sizeof_binl(bound) + bound;
+	char *buf = region_alloc(region, max_size);
+	if (buf == NULL)
+		return NULL;
+	char *data = buf + max_size - bound;
+	size_t data_size = ZSTD_compressCCtx(iproto_zstd_cctx, data, bound,
+					     body, body_size,
+					     IPROTO_ZSTD_LEVEL);
+	if (ZSTD_isError(data_size))
+		return NULL;
+	char *p = buf + mp_sizeof_uint(UINT32_MAX);
+	p = mp_encode_map(p, map_size + 1);
+	memcpy(p, keys, keys_size);
+	p += keys_size;
+	p = mp_encode_uint(p, IPROTO_COMPRESSION);
+	p = mp_encode_uint(p, IPROTO_COMPRESSION_ZSTD);
+	p = mp_encode_binl(p, data_size);
+	memmove(p, data, data_size);
+	p += data_size;
+	if ((size_t)(p - buf) >= size)
+		return NULL;
+	*compressed_size = p - buf;
+	/* The packet length is always encoded as MP_UINT32. */
+	buf[0] = 0xce;
+	mp_store_u32(buf + 1, *compressed_size - mp_sizeof_uint(UINT32_MAX));
+	return buf;
+}
+
+int
+xrow_decompress_body(struct xrow_header *row, size_t max_size, char **buf)
+{
+	assert(row->compression != IPROTO_COMPRESSION_NONE);
+	if (row->compression != IPROTO_COMPRESSION_ZSTD) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 tt_sprintf("unknown compression %u",
+				    (unsigned)row->compression));
+		return -1;
+	}
+	const char *data = NULL;
+	uint32_t data_size = 0;
+	if (row->bodycnt == 1) {
+		data = (const char *)row->body[0].iov_base;
+		if (mp_typeof(*data) == MP_BIN)
+			data = mp_decode_bin(&data, &data_size);
+	}
+	if (data_size == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "compressed packet body");
+		return -1;
+	}
+	unsigned long long size = ZSTD_getFrameContentSize(data, data_size);
+	if (size == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    size == ZSTD_CONTENTSIZE_ERROR || size == 0) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 "invalid zstd frame");
+		return -1;
+	}
+	if (size > max_size) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 tt_sprintf("decompressed body size %llu exceeds "
+				    "the limit %zu", size, max_size));
+		return -1;
+	}
+	if (iproto_zstd_dctx == NULL) {
+		iproto_zstd_dctx = ZSTD_createDCtx();
+		if (iproto_zstd_dctx == NULL) {
+			diag_set(OutOfMemory, sizeof(ZSTD_DCtx *),
+				 "ZSTD_createDCtx", "iproto_zstd_dctx");
+			return -1;
+		}
+	}
+	char *new_buf = realloc(*buf, size);
+	if (new_buf == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "packet body");
+		return -1;
+	}
+	*buf = new_buf;
+	size_t rc = ZSTD_decompressDCtx(iproto_zstd_dctx, *buf, size,
+					data, data_size);
+	if (ZSTD_isError(rc) || rc != size) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 ZSTD_isError(rc) ? ZSTD_getErrorName(rc) :
+			 "invalid zstd frame");
+		return -1;
+	}
+	const char *pos = *buf;
+	if (mp_check_exact(&pos, *buf + size) != 0) {
+		diag_add(ClientError, ER_INVALID_MSGPACK, "packet body");
+		return -1;
+	}
+	row->body[0].iov_base = *buf;
+	row->body[0].iov_len = size;
+	return 0;
+}
+
 /**
  * @pre pos points at a valid msgpack
  */
@@ -722,6 +872,32 @@ iproto_reply_error(struct obuf *out, const struct error *e, uint64_t sync,
 			     schema_version, obuf_size(out) - used);
 }
 
+void
+iproto_reply_batch_error(struct obuf *out, const struct error *e,
+			 uint64_t sync, uint64_t schema_version,
+			 uint32_t applied_count)
+{
+	char *header = xobuf_alloc(out, IPROTO_HEADER_LEN);
+
+	struct mpstream stream;
+	mpstream_init(&stream, out, obuf_reserve_cb, obuf_alloc_cb,
+		      mpstream_panic_cb, NULL);
+
+	uint32_t used = obuf_size(out);
+	mpstream_encode_map(&stream, 3);
+	mpstream_encode_uint(&stream, IPROTO_ERROR_24);
+	mpstream_encode_str(&stream, e->errmsg);
+	mpstream_encode_uint(&stream, IPROTO_ERROR);
+	error_to_mpstream_noext(e, &stream);
+	mpstream_encode_uint(&stream, IPROTO_APPLIED_COUNT);
+	mpstream_encode_uint(&stream, applied_count);
+	mpstream_flush(&stream);
+
+	uint32_t errcode = box_error_code(e);
+	iproto_header_encode(header, iproto_encode_error(errcode), sync,
+			     schema_version, obuf_size(out) - used);
+}
+
 void
 iproto_do_write_error(struct iostream *io, const struct error *e,
 		      uint64_t schema_version, uint64_t sync)
@@ -786,6 +962,15 @@ iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
 }
 
+void
+iproto_reply_add_body_size(struct obuf *buf, struct obuf_svp *svp,
+			   uint32_t size)
+{
+	struct iproto_header_bin *header =
+		(struct iproto_header_bin *)obuf_svp_to_ptr(buf, svp);
+	header->v_len = mp_bswap_u32(mp_bswap_u32(header->v_len) + size);
+}
+
 /** Reply select with IPROTO_DATA and IPROTO_POSITION. */
 void
 iproto_reply_select_with_position(struct obuf *buf, struct obuf_svp *svp,
@@ -1023,6 +1208,10 @@ xrow_decode_dml_internal(struct xrow_header *row, struct request *request,
 			request->after_tuple = value;
 			request->after_tuple_end = data;
 			break;
+		case IPROTO_FIELDS:
+			request->fields = value;
+			request->fields_end = data;
+			break;
 		case IPROTO_SPACE_NAME:
 			request->space_name =
 				mp_decode_str(&value, &request->space_name_len);
@@ -1100,6 +1289,10 @@ request_snprint(char *buf, int size, const struct request *request)
 		SNPRINT(total, snprintf, buf, size, ", after_tuple: ");
 		SNPRINT(total, mp_snprint, buf, size, request->after_tuple);
 	}
+	if (request->fields != NULL) {
+		SNPRINT(total, snprintf, buf, size, ", fields: ");
+		SNPRINT(total, mp_snprint, buf, size, request->fields);
+	}
 	SNPRINT(total, snprintf, buf, size, "}");
 	return total;
 }
@@ -1123,6 +1316,7 @@ xrow_encode_dml(const struct request *request, struct region *region,
 	       request->header->type != IPROTO_SELECT);
 	assert(request->after_position == NULL);
 	assert(request->after_tuple == NULL);
+	assert(request->fields == NULL);
 	assert(!request->fetch_position);
 	const int MAP_LEN_MAX = 40;
 	uint32_t key_len = request->key_end - request->key;
@@ -1804,6 +1998,8 @@ xrow_decode_error(const struct xrow_header *row)
 		goto error;
 	map_size = mp_decode_map(&pos);
 	bool is_stack_parsed = false;
+	bool has_applied_count = false;
+	uint64_t applied_count = 0;
 	for (uint32_t i = 0; i < map_size; i++) {
 		if (mp_typeof(*pos) != MP_UINT) {
 			mp_next(&pos); /* key */
@@ -1829,11 +2025,19 @@ xrow_decode_error(const struct xrow_header *row)
 				goto error;
 			is_stack_parsed = true;
 			diag_set_error(diag_get(), e);
+		} else if (key == IPROTO_APPLIED_COUNT &&
+			   mp_typeof(*pos) == MP_UINT) {
+			applied_count = mp_decode_uint(&pos);
+			has_applied_count = true;
 		} else {
 			mp_next(&pos);
 			continue;
 		}
 	}
+	if (has_applied_count && !diag_is_empty(diag_get())) {
+		error_set_uint(diag_last_error(diag_get()), "applied_count",
+			       applied_count);
+	}
 	return;
 
 error:
@@ -1938,6 +2142,177 @@ xrow_decode_commit(const struct xrow_header *row, struct commit_request *request
 	return -1;
 }
 
+int
+xrow_decode_batch(struct xrow_header *row, struct batch_request *request)
+{
+	memset(request, 0, sizeof(*request));
+	if (row->bodycnt == 0) {
+		xrow_on_decode_err(row, ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_REQUESTS));
+		return -1;
+	}
+	const char *d = row->body[0].iov_base;
+	if (mp_typeof(*d) != MP_MAP)
+		goto bad_msgpack;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*d) != MP_UINT)
+			goto bad_msgpack;
+		uint64_t key = mp_decode_uint(&d);
+		if (key < iproto_key_MAX &&
+		    mp_typeof(*d) != iproto_key_type[key])
+			goto bad_msgpack;
+		switch (key) {
+		case IPROTO_REQUESTS:
+			request->requests = d;
+			request->request_count = mp_decode_array(&d);
+			for (uint32_t j = 0; j < request->request_count; j++)
+				mp_next(&d);
+			break;
+		case IPROTO_IS_ATOMIC:
+			request->is_atomic = mp_decode_bool(&d);
+			break;
+		default:
+			mp_next(&d);
+			break;
+		}
+	}
+	if (request->requests == NULL) {
+		xrow_on_decode_err(row, ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_REQUESTS));
+		return -1;
+	}
+	d = request->requests;
+	mp_decode_array(&d);
+	for (uint32_t i = 0; i < request->request_count; i++) {
+		struct xrow_header sub_row;
+		struct request sub_request;
+		if (xrow_decode_batch_next(&d, &sub_row, &sub_request) != 0)
+			return -1;
+	}
+	return 0;
+
+bad_msgpack:
+	xrow_on_decode_err(row, ER_INVALID_MSGPACK, "request body");
+	return -1;
+}
+
+int
+xrow_decode_batch_next(const char **data, struct xrow_header *row,
+		       struct request *request)
+{
+	memset(row, 0, sizeof(*row));
+	const char *body = *data;
+	const char *d = body;
+	mp_next(data);
+	row->bodycnt = 1;
+	row->body[0].iov_base = (void *)body;
+	row->body[0].iov_len = *data - body;
+	if (mp_typeof(*d) != MP_MAP) {
+		xrow_on_decode_err(row, ER_INVALID_MSGPACK, "batch request");
+		return -1;
+	}
+	bool has_type = false;
+	uint64_t type = 0;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size && !has_type; ++i) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d);
+			mp_next(&d);
+			continue;
+		}
+		if (mp_decode_uint(&d) != IPROTO_REQUEST_TYPE) {
+			mp_next(&d);
+			continue;
+		}
+		if (mp_typeof(*d) != MP_UINT) {
+			xrow_on_decode_err(row, ER_INVALID_MSGPACK,
+					   "batch request");
+			return -1;
+		}
+		type = mp_decode_uint(&d);
+		has_type = true;
+	}
+	if (!has_type) {
+		xrow_on_decode_err(row, ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_REQUEST_TYPE));
+		return -1;
+	}
+	switch (type) {
+	case IPROTO_SELECT:
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+		break;
+	default:
+		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE, (uint32_t)type);
+		return -1;
+	}
+	row->type = type;
+	if (xrow_decode_dml_iproto(row, request, dml_request_key_map(type)) != 0)
+		return -1;
+	/* The xrow header is set by WAL as for a standalone request. */
+	request->header = NULL;
+	return 0;
+}
+
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request)
+{
+	memset(request, 0, sizeof(*request));
+	bool has_cursor_id = false;
+	bool has_limit = false;
+	if (row->bodycnt == 0)
+		goto missing_cursor_id;
+	const char *d;
+	d = row->body[0].iov_base;
+	if (mp_typeof(*d) != MP_MAP)
+		goto bad_msgpack;
+	uint32_t map_size;
+	map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*d) != MP_UINT)
+			goto bad_msgpack;
+		uint64_t key = mp_decode_uint(&d);
+		if (key < iproto_key_MAX &&
+		    mp_typeof(*d) != iproto_key_type[key])
+			goto bad_msgpack;
+		switch (key) {
+		case IPROTO_CURSOR_ID:
+			request->cursor_id = mp_decode_uint(&d);
+			has_cursor_id = true;
+			break;
+		case IPROTO_LIMIT:
+			request->limit = mp_decode_uint(&d);
+			has_limit = true;
+			break;
+		default:
+			mp_next(&d);
+			break;
+		}
+	}
+	if (!has_cursor_id)
+		goto missing_cursor_id;
+	/* Fetching the whole result at once isn't what cursors are for. */
+	if (row->type == IPROTO_CURSOR_FETCH && !has_limit) {
+		xrow_on_decode_err(row, ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_LIMIT));
+		return -1;
+	}
+	return 0;
+
+missing_cursor_id:
+	xrow_on_decode_err(row, ER_MISSING_REQUEST_FIELD,
+			   iproto_key_name(IPROTO_CURSOR_ID));
+	return -1;
+bad_msgpack:
+	xrow_on_decode_err(row, ER_INVALID_MSGPACK, "request body");
+	return -1;
+}
+
 void
 xrow_encode_vote(struct xrow_header *row)
 {
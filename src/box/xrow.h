@@ -90,6 +90,16 @@ struct xrow_header {
 	 * Zero if stream is not used.
 	 */
 	uint64_t stream_id;
+	/**
+	 * Compression algorithm of the body, see enum iproto_compression.
+	 * Set only by IPROTO clients and servers.
+	 */
+	uint8_t compression;
+	/**
+	 * Scheduling class requested by the client, see enum
+	 * iproto_sched_class. Zero if not set or invalid.
+	 */
+	uint8_t sched_class;
 	/** Transaction meta flags set only in the last transaction row. */
 	union {
 		uint8_t flags;
@@ -187,6 +197,36 @@ int
 xrow_decode(struct xrow_header *header, const char **pos,
 	    const char *end, bool end_is_exact);
 
+/**
+ * Compress the body of an encoded IPROTO packet with zstd. The packet
+ * starts with the packet length encoded as MP_UINT32. The compressed
+ * packet has the IPROTO_COMPRESSION header key and the body encoded as
+ * MP_BIN. It is allocated on the fiber region.
+ *
+ * @param packet the packet to compress
+ * @param size the size of the packet
+ * @param[out] compressed_size the size of the compressed packet
+ * @retval the compressed packet
+ * @retval NULL if the packet can't be compressed, memory allocation
+ *         fails or compression doesn't reduce its size
+ */
+const char *
+iproto_packet_compress(const char *packet, size_t size,
+		       size_t *compressed_size);
+
+/**
+ * Decompress the body of a decoded packet with the IPROTO_COMPRESSION
+ * header key. The decompressed body is stored in @a buf, which is
+ * reallocated with realloc() and must be freed by the caller, and the
+ * body of @a row is pointed at it. Bodies bigger than @a max_size
+ * bytes are rejected without decompression.
+ *
+ * @retval 0 on success
+ * @retval -1 on error (check diag)
+ */
+int
+xrow_decompress_body(struct xrow_header *row, size_t max_size, char **buf);
+
 /**
  * DML request.
  */
@@ -242,6 +282,10 @@ struct request {
 	const char *after_tuple;
 	/** End of @after_tuple. */
 	const char *after_tuple_end;
+	/** Array of 0-based numbers of the fields to select. */
+	const char *fields;
+	/** End of @fields. */
+	const char *fields_end;
 	/** Base field offset for UPDATE/UPSERT, e.g. 0 for C and 1 for Lua. */
 	int index_base;
 	/** Send position of last selected tuple in response if true. */
@@ -870,6 +914,15 @@ iproto_reply_select_with_position(struct obuf *buf, struct obuf_svp *svp,
 				  const char *packed_pos_end,
 				  bool box_tuple_as_ext);
 
+/**
+ * Add @a size to the body length of a reply written at @a svp to
+ * account for data sent after the reply header but not stored in the
+ * buffer.
+ */
+void
+iproto_reply_add_body_size(struct obuf *buf, struct obuf_svp *svp,
+			   uint32_t size);
+
 /**
  * Encode iproto header with IPROTO_OK response code.
  * @param out Encode to.
@@ -919,6 +972,16 @@ void
 iproto_reply_error(struct obuf *out, const struct error *e, uint64_t sync,
 		   uint64_t schema_version);
 
+/**
+ * Write an error packet of a failed non-atomic IPROTO_BATCH request
+ * into output buffer. Besides the error, the packet body contains the
+ * number of the requests applied before the failed one.
+ */
+void
+iproto_reply_batch_error(struct obuf *out, const struct error *e,
+			 uint64_t sync, uint64_t schema_version,
+			 uint32_t applied_count);
+
 /** EXECUTE/PREPARE request. */
 struct sql_request {
 	/** True for EXECUTE, false for PREPARE. */
@@ -1054,7 +1117,8 @@ void
 xrow_to_iovec(const struct xrow_header *row, struct iovec *out, int *iovcnt);
 
 /**
- * Decode ERROR and set it to diagnostics area.
+ * Decode ERROR and set it to diagnostics area. IPROTO_APPLIED_COUNT,
+ * if present, is stored in the "applied_count" error payload field.
  * @param row Encoded error.
  */
 void
@@ -1113,6 +1177,68 @@ int
 xrow_decode_commit(const struct xrow_header *row,
 		   struct commit_request *request);
 
+/**
+ * BATCH request.
+ */
+struct batch_request {
+	/** MsgPack array of the requests. */
+	const char *requests;
+	/** Number of the requests. */
+	uint32_t request_count;
+	/** Whether the requests are executed in one transaction. */
+	bool is_atomic;
+};
+
+/**
+ * Parse the BATCH request. Every request of the batch is decoded to
+ * check it, so that a malformed request doesn't abort the batch in
+ * the middle.
+ * @param row Encoded data.
+ * @param[out] request Request to decode to.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_batch(struct xrow_header *row, struct batch_request *request);
+
+/**
+ * Decode the next request of a BATCH request and advance @a data to
+ * the request following it. Only SELECT, INSERT, REPLACE, UPDATE,
+ * DELETE and UPSERT requests are allowed in a batch.
+ * @param[in, out] data Encoded request.
+ * @param row Header used for decoding, referenced by @a request.
+ * @param[out] request Request to decode to.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_batch_next(const char **data, struct xrow_header *row,
+		       struct request *request);
+
+/**
+ * CURSOR_FETCH and CURSOR_CLOSE requests.
+ */
+struct cursor_request {
+	/** ID of the cursor. */
+	uint64_t cursor_id;
+	/** Max number of tuples to fetch, mandatory for CURSOR_FETCH. */
+	uint32_t limit;
+};
+
+/**
+ * Parse the CURSOR_FETCH or CURSOR_CLOSE request.
+ * @param row Encoded data.
+ * @param[out] request Request to decode to.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request);
+
 /**
  * Update vclock with the next LSN value for given replica id.
  * The function will cause panic if the next LSN happens to be
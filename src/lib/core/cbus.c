@@ -135,6 +135,32 @@ cbus_endpoint_poison_f(struct cmsg *msg)
 	free(msg);
 }
 
+/**
+ * Push a batch of messages to the endpoint. Returns true if the
+ * endpoint had no incoming messages so the consumer must be woken up.
+ */
+static bool
+cbus_endpoint_push(struct cbus_endpoint *endpoint, struct stailq *batch)
+{
+	assert(!stailq_empty(batch));
+	/*
+	 * The consumer reverses the whole stack on fetch so push the
+	 * batch reversed to keep the order of messages.
+	 */
+	struct stailq_entry *oldest = stailq_first(batch);
+	stailq_reverse(batch);
+	struct stailq_entry *newest = stailq_first(batch);
+	stailq_create(batch);
+	struct stailq_entry *head = __atomic_load_n(&endpoint->output,
+						    __ATOMIC_RELAXED);
+	do {
+		oldest->next.value = head;
+	} while (!__atomic_compare_exchange_n(&endpoint->output, &head, newest,
+					      true, __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+	return head == NULL;
+}
+
 void
 cpipe_destroy(struct cpipe *pipe)
 {
@@ -155,11 +181,10 @@ cpipe_destroy(struct cpipe *pipe)
 	 * delivered.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
-	/* Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	pipe->n_input = 0;
 	/* Add the pipe shutdown message as the last one. */
-	stailq_add_tail_entry(&endpoint->output, poison, msg.fifo);
+	stailq_add_tail_entry(&pipe->input, poison, msg.fifo);
+	cbus_endpoint_push(endpoint, &pipe->input);
+	pipe->n_input = 0;
 	/* Count statistics */
 	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 	/*
@@ -221,7 +246,7 @@ cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 	endpoint->n_pipes = 0;
 	fiber_cond_create(&endpoint->cond);
 	tt_pthread_mutex_init(&endpoint->mutex, NULL);
-	stailq_create(&endpoint->output);
+	endpoint->output = NULL;
 	ev_async_init(&endpoint->async,
 		      (void (*)(ev_loop *, struct ev_async *, int)) fetch_cb);
 	endpoint->async.data = fetch_data;
@@ -255,13 +280,14 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 	while (true) {
 		if (process_cb)
 			process_cb(endpoint);
-		if (endpoint->n_pipes == 0 && stailq_empty(&endpoint->output))
+		if (endpoint->n_pipes == 0 &&
+		    __atomic_load_n(&endpoint->output, __ATOMIC_ACQUIRE) == NULL)
 			break;
 		 fiber_cond_wait(&endpoint->cond);
 	}
 
 	/*
-	 * Pipe flush func can still lock mutex, so just lock and unlock
+	 * Pipe destroy func can still lock mutex, so just lock and unlock
 	 * it.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
@@ -280,15 +306,12 @@ cpipe_flush(struct cpipe *pipe)
 		return;
 	struct cbus_endpoint *endpoint = pipe->endpoint;
 	trigger_run(&pipe->on_flush, pipe);
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool output_was_empty;
-
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	output_was_empty = stailq_empty(&endpoint->output);
-	/** Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-
+	/*
+	 * Trigger task processing when the queue becomes non-empty.
+	 * Wakeups of a busy consumer are coalesced: it fetches all
+	 * the messages pushed before it gets to the queue.
+	 */
+	bool output_was_empty = cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
 	if (output_was_empty) {
 		/* Count statistics */
@@ -88,6 +88,12 @@ struct cmsg {
 	const struct cmsg_hop *route;
 	/** The current hop the message is at. */
 	const struct cmsg_hop *hop;
+	/**
+	 * Scheduling class of the message. Used by consumers that
+	 * queue messages of different classes separately, see
+	 * fiber_pool. 0 by default.
+	 */
+	uint8_t sched_class;
 };
 
 static inline struct cmsg *cmsg(void *ptr) { return (struct cmsg *) ptr; }
@@ -101,6 +107,7 @@ cmsg_init(struct cmsg *msg, const struct cmsg_hop *route)
 	 * msg->hop thus points to the second hop.
 	 */
 	msg->hop = msg->route = route;
+	msg->sched_class = 0;
 }
 
 /**
@@ -118,7 +125,7 @@ struct cpipe {
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
-	 * latency, while still keeping the bus mutex cold enough).
+	 * latency, while still keeping the endpoint wakeups rare).
 	 */
 	int max_input;
 	/**
@@ -241,10 +248,18 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * The lock taken by a pipe to deliver its last message,
+	 * see cpipe_destroy().
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
+	/**
+	 * Incoming messages linked by cmsg::fifo, the newest first.
+	 * It's a lock-free stack: producers push whole batches of
+	 * messages with compare-and-swap and the consumer takes all
+	 * of them at once with exchange and restores the FIFO order.
+	 */
+	struct stailq_entry *output;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -261,9 +276,17 @@ struct cbus_endpoint {
 static inline void
 cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
 {
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
+	struct stailq_entry *item = __atomic_exchange_n(&endpoint->output,
+							NULL, __ATOMIC_ACQUIRE);
+	/* Reverse the stack to restore the order of messages. */
+	struct stailq input;
+	stailq_create(&input);
+	while (item != NULL) {
+		struct stailq_entry *next = stailq_next(item);
+		stailq_add(&input, item);
+		item = next;
+	}
+	stailq_concat(output, &input);
 }
 
 /** Initialize the global singleton bus. */
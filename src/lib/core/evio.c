@@ -57,6 +57,12 @@ struct evio_service_entry {
 	struct ev_io ev;
 	/** Pointer to the root evio_service, which contains this object */
 	struct evio_service *service;
+	/**
+	 * Set if the acceptor socket was bound by this entry with
+	 * SO_REUSEPORT on attach rather than shared with the source
+	 * entry. Such a socket is closed on detach.
+	 */
+	bool is_own_socket;
 };
 
 static int
@@ -148,6 +154,22 @@ evio_setsockopt_server(int fd, int family, int type)
 	return 0;
 }
 
+/** Allow other sockets to bind to the same address and port. */
+static int
+evio_setsockopt_reuseport(int fd)
+{
+#ifdef SO_REUSEPORT
+	int on = 1;
+	if (sio_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)))
+		return -1;
+	return 0;
+#else
+	diag_set(SocketError, sio_socketname(fd),
+		 "SO_REUSEPORT is not supported");
+	return -1;
+#endif
+}
+
 static inline const char *
 evio_service_name(struct evio_service *service)
 {
@@ -254,6 +276,10 @@ evio_service_entry_bind_addr(struct evio_service_entry *entry)
 				   SOCK_STREAM) != 0)
 		goto error;
 
+	if (entry->service->reuseport && entry->addr.sa_family != AF_UNIX &&
+	    evio_setsockopt_reuseport(fd) != 0)
+		goto error;
+
 	if (sio_bind(fd, &entry->addr, entry->addr_len) != 0)
 		goto error;
 
@@ -312,6 +338,7 @@ evio_service_entry_create(struct evio_service_entry *entry,
 	ev_io_set(&entry->ev, -1, 0);
 	entry->ev.data = entry;
 	entry->service = service;
+	entry->is_own_socket = false;
 }
 
 /**
@@ -377,6 +404,10 @@ evio_service_entry_detach(struct evio_service_entry *entry)
 		ev_io_stop(entry->service->loop, &entry->ev);
 		entry->addr_len = 0;
 	}
+	if (entry->is_own_socket && entry->ev.fd >= 0 &&
+	    close(entry->ev.fd) < 0)
+		say_error("Failed to close socket: %s", tt_strerror(errno));
+	entry->is_own_socket = false;
 	ev_io_set(&entry->ev, -1, 0);
 	uri_destroy(&entry->uri);
 }
@@ -385,6 +416,7 @@ evio_service_entry_detach(struct evio_service_entry *entry)
 static void
 evio_service_entry_stop(struct evio_service_entry *entry)
 {
+	assert(!entry->is_own_socket);
 	int service_fd = entry->ev.fd;
 	evio_service_entry_detach(entry);
 	if (service_fd < 0)
@@ -416,6 +448,31 @@ evio_service_entry_attach(struct evio_service_entry *dst,
 	ev_io_start(dst->service->loop, &dst->ev);
 }
 
+/**
+ * Bind an own socket with SO_REUSEPORT to the address of @a src and
+ * listen on it. UNIX sockets and sockets of services without the
+ * reuseport flag are shared as by evio_service_entry_attach().
+ */
+static int
+evio_service_entry_attach_reuseport(struct evio_service_entry *dst,
+				    const struct evio_service_entry *src)
+{
+	assert(!ev_is_active(&dst->ev));
+	if (!src->service->reuseport || src->addr.sa_family == AF_UNIX) {
+		evio_service_entry_attach(dst, src);
+		return 0;
+	}
+	uri_destroy(&dst->uri);
+	uri_copy(&dst->uri, &src->uri);
+	dst->addrstorage = src->addrstorage;
+	dst->addr_len = src->addr_len;
+	iostream_ctx_copy(&dst->io_ctx, &src->io_ctx);
+	if (evio_service_entry_bind_addr(dst) != 0)
+		return -1;
+	dst->is_own_socket = true;
+	return evio_service_entry_listen(dst);
+}
+
 /** Recreate the IO stream contexts from the service entry URI. */
 static int
 evio_service_entry_reload_uri(struct evio_service_entry *entry)
@@ -485,6 +542,21 @@ evio_service_attach(struct evio_service *dst, const struct evio_service *src)
 		evio_service_entry_attach(&dst->entries[i], &src->entries[i]);
 }
 
+int
+evio_service_attach_reuseport(struct evio_service *dst,
+			      const struct evio_service *src)
+{
+	assert(dst->entry_count == 0);
+	dst->reuseport = src->reuseport;
+	evio_service_create_entries(dst, src->entry_count);
+	for (int i = 0; i < src->entry_count; i++) {
+		if (evio_service_entry_attach_reuseport(&dst->entries[i],
+							&src->entries[i]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 void
 evio_service_detach(struct evio_service *service)
 {
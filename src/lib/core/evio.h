@@ -88,6 +88,12 @@ struct evio_service {
         evio_accept_f on_accept;
         void *on_accept_param;
         ev_loop *loop;
+        /**
+         * Bind TCP sockets with SO_REUSEPORT so that other services
+         * can listen on the same addresses, see
+         * evio_service_attach_reuseport().
+         */
+        bool reuseport;
 };
 
 /**
@@ -127,6 +133,18 @@ evio_service_stop(struct evio_service *service);
 void
 evio_service_attach(struct evio_service *dst, const struct evio_service *src);
 
+/**
+ * Same as evio_service_attach(), but if @a src was started with the
+ * reuseport flag, bind own sockets to its TCP addresses and listen on
+ * them so that the kernel distributes incoming connections between
+ * the services. The sockets are closed by evio_service_detach().
+ *
+ * Returns -1 on failure. The service must be detached in this case.
+ */
+int
+evio_service_attach_reuseport(struct evio_service *dst,
+			      const struct evio_service *src);
+
 /**
  * Reload service URIs.
  *
@@ -29,6 +29,73 @@
  * SUCH DAMAGE.
  */
 #include "fiber_pool.h"
+#include "clock.h"
+
+/**
+ * Account the time the messages of a class have waited in the queue
+ * since the last update. The total wait time of all messages equals
+ * the integral of the queue length over time so there's no need to
+ * remember when each message was queued.
+ */
+static void
+fiber_pool_class_update_wait_time(struct fiber_pool_class *c, double now)
+{
+	c->wait_time += c->queue_len * (now - c->wait_time_updated);
+	c->wait_time_updated = now;
+}
+
+/** Queue messages fetched from the endpoint by their classes. */
+static void
+fiber_pool_push(struct fiber_pool *pool, struct stailq *input)
+{
+	double now = clock_monotonic();
+	for (int i = 0; i < FIBER_POOL_CLASS_MAX; i++)
+		fiber_pool_class_update_wait_time(&pool->classes[i], now);
+	struct cmsg *msg;
+	while (!stailq_empty(input)) {
+		msg = stailq_shift_entry(input, struct cmsg, fifo);
+		assert(msg->sched_class < FIBER_POOL_CLASS_MAX);
+		struct fiber_pool_class *c = &pool->classes[msg->sched_class];
+		stailq_add_tail_entry(&c->queue, msg, fifo);
+		c->queue_len++;
+		pool->queue_len++;
+	}
+}
+
+/**
+ * Take the next message to process. If messages of several classes
+ * are queued, the class is chosen with the smooth weighted round
+ * robin: each class earns its weight in credits on every pick, the
+ * class with the most credits is picked and pays the total weight of
+ * the competing classes. This way the classes are served in proportion
+ * to their weights and picks of the same class are spread evenly.
+ */
+static struct cmsg *
+fiber_pool_shift(struct fiber_pool *pool)
+{
+	assert(pool->queue_len > 0);
+	struct fiber_pool_class *next = NULL;
+	int total_weight = 0;
+	for (int i = 0; i < FIBER_POOL_CLASS_MAX; i++) {
+		struct fiber_pool_class *c = &pool->classes[i];
+		if (c->queue_len == 0)
+			continue;
+		c->credit += c->weight;
+		total_weight += c->weight;
+		if (next == NULL || c->credit > next->credit)
+			next = c;
+	}
+	assert(next != NULL);
+	next->credit -= total_weight;
+	fiber_pool_class_update_wait_time(next, clock_monotonic());
+	next->queue_len--;
+	next->processed++;
+	pool->queue_len--;
+	if (next->queue_len == 0)
+		next->credit = 0;
+	return stailq_shift_entry(&next->queue, struct cmsg, fifo);
+}
+
 /**
  * Main function of the fiber invoked to handle all outstanding
  * tasks in a queue.
@@ -40,16 +107,15 @@ fiber_pool_f(va_list ap)
 	struct cord *cord = cord();
 	struct fiber *f = fiber();
 	struct ev_loop *loop = pool->consumer;
-	struct stailq *output = &pool->output;
 	struct cmsg *msg;
 	ev_tstamp last_active_at = ev_monotonic_now(loop);
 	pool->size++;
 restart:
 	msg = NULL;
-	while (!stailq_empty(output) && !fiber_is_cancelled()) {
-		 msg = stailq_shift_entry(output, struct cmsg, fifo);
+	while (pool->queue_len > 0 && !fiber_is_cancelled()) {
+		msg = fiber_pool_shift(pool);
 
-		if (f->caller == &cord->sched && ! stailq_empty(output) &&
+		if (f->caller == &cord->sched && pool->queue_len > 0 &&
 		    ! rlist_empty(&pool->idle)) {
 			/*
 			 * Activate a "backup" fiber for the next
@@ -124,10 +190,12 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	(void) events;
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
 	/** Fetch messages */
-	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
+	struct stailq input;
+	stailq_create(&input);
+	cbus_endpoint_fetch(&pool->endpoint, &input);
+	fiber_pool_push(pool, &input);
 
-	struct stailq *output = &pool->output;
-	while (! stailq_empty(output)) {
+	while (pool->queue_len > 0) {
 		struct fiber *f;
 		if (! rlist_empty(&pool->idle)) {
 			f = rlist_shift_entry(&pool->idle, struct fiber, state);
@@ -168,6 +236,15 @@ fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size)
 	pool->max_size = new_max_size;
 }
 
+void
+fiber_pool_set_class_weight(struct fiber_pool *pool, int sched_class,
+			    int weight)
+{
+	assert(sched_class >= 0 && sched_class < FIBER_POOL_CLASS_MAX);
+	assert(weight > 0);
+	pool->classes[sched_class].weight = weight;
+}
+
 void
 fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 		  float idle_timeout)
@@ -181,7 +258,18 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 	ev_timer_again(loop(), &pool->idle_timer);
 	pool->size = 0;
 	pool->max_size = max_pool_size;
-	stailq_create(&pool->output);
+	pool->queue_len = 0;
+	double now = clock_monotonic();
+	for (int i = 0; i < FIBER_POOL_CLASS_MAX; i++) {
+		struct fiber_pool_class *c = &pool->classes[i];
+		stailq_create(&c->queue);
+		c->queue_len = 0;
+		c->weight = 1;
+		c->credit = 0;
+		c->processed = 0;
+		c->wait_time = 0;
+		c->wait_time_updated = now;
+	}
 	fiber_cond_create(&pool->worker_cond);
 	/* Join fiber pool to cbus */
 	cbus_endpoint_create(&pool->endpoint, name, fiber_pool_cb, pool);
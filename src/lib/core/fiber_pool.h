@@ -44,6 +44,33 @@ extern "C" {
 /** Period after which an idle fiber in the pool is shut down. */
 enum { FIBER_POOL_IDLE_TIMEOUT = 1 };
 
+/** Max number of message scheduling classes in a fiber pool. */
+enum { FIBER_POOL_CLASS_MAX = 4 };
+
+/**
+ * A queue of messages of the same scheduling class (see
+ * cmsg::sched_class) waiting for a worker fiber.
+ */
+struct fiber_pool_class {
+	/** Staged messages of the class. */
+	struct stailq queue;
+	/** Number of messages in the queue. */
+	int64_t queue_len;
+	/**
+	 * Share of messages taken from the queue when all classes
+	 * have messages to process.
+	 */
+	int weight;
+	/** Current credit of the class in the weighted round robin. */
+	int credit;
+	/** Number of messages taken from the queue. */
+	int64_t processed;
+	/** Total time the messages of the class waited in the queue. */
+	double wait_time;
+	/** Last time the queue length or wait time was updated. */
+	double wait_time_updated;
+};
+
 /**
  * A pool of worker fibers to handle messages,
  * so that each message is handled in its own fiber.
@@ -61,8 +88,13 @@ struct fiber_pool {
 		 * for longer than this.
 		 */
 		float idle_timeout;
-		/** Staged messages (for fibers to work on) */
-		struct stailq output;
+		/**
+		 * Staged messages (for fibers to work on) queued
+		 * by scheduling class.
+		 */
+		struct fiber_pool_class classes[FIBER_POOL_CLASS_MAX];
+		/** Number of staged messages in all classes. */
+		int64_t queue_len;
 		/** Timer for idle workers */
 		struct ev_timer idle_timer;
 		/** Condition for worker exit signaling */
@@ -92,6 +124,15 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 void
 fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size);
 
+/**
+ * Set the weight of a message scheduling class. When messages of
+ * several classes are queued, they are taken in proportion to the
+ * weights of their classes.
+ */
+void
+fiber_pool_set_class_weight(struct fiber_pool *pool, int sched_class,
+			    int weight);
+
 /** Shutdown fiber pool. Finish all idle fibers left. */
 void
 fiber_pool_shutdown(struct fiber_pool *pool);
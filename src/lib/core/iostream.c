@@ -14,6 +14,7 @@
 #include <unistd.h>
 
 #include "diag.h"
+#include "shm_iostream.h"
 #include "sio.h"
 #include "ssl.h"
 #include "uri/uri.h"
@@ -99,12 +100,23 @@ iostream_ctx_create(struct iostream_ctx *ctx, enum iostream_mode mode,
 	assert(mode == IOSTREAM_SERVER || mode == IOSTREAM_CLIENT);
 	ctx->mode = mode;
 	ctx->ssl = NULL;
+	ctx->is_shm = false;
 	const char *transport = uri_param(uri, "transport", 0);
 	if (transport != NULL) {
 		if (strcmp(transport, "ssl") == 0) {
 			ctx->ssl = ssl_iostream_ctx_new(mode, uri);
 			if (ctx->ssl == NULL)
 				goto err;
+		} else if (strcmp(transport, "shm") == 0) {
+			if (uri->host == NULL ||
+			    strcmp(uri->host, URI_HOST_UNIX) != 0) {
+				diag_set(IllegalParams, "Transport shm "
+					 "requires a Unix socket");
+				goto err;
+			}
+			if (shm_iostream_check_mode(mode) != 0)
+				goto err;
+			ctx->is_shm = true;
 		} else if (strcmp(transport, "plain") != 0) {
 			diag_set(IllegalParams, "Invalid transport: %s",
 				 transport);
@@ -131,6 +143,7 @@ iostream_ctx_copy(struct iostream_ctx *dst, const struct iostream_ctx *src)
 	assert(src->mode == IOSTREAM_CLIENT || src->mode == IOSTREAM_SERVER);
 	dst->mode = src->mode;
 	dst->ssl = ssl_iostream_ctx_dup(src->ssl);
+	dst->is_shm = src->is_shm;
 }
 
 int
@@ -140,6 +153,9 @@ iostream_create(struct iostream *io, int fd, const struct iostream_ctx *ctx)
 	if (ctx->ssl != NULL) {
 		if (ssl_iostream_create(io, fd, ctx->mode, ctx->ssl) != 0)
 			goto err;
+	} else if (ctx->is_shm) {
+		if (shm_iostream_create(io, fd, ctx->mode) != 0)
+			goto err;
 	} else {
 		plain_iostream_create(io, fd);
 	}
@@ -251,6 +251,11 @@ struct iostream_ctx {
 	 * streams created with this context will be unencrypted.
 	 */
 	struct ssl_iostream_ctx *ssl;
+	/**
+	 * Set if streams created with this context transfer data through
+	 * shared memory (see shm_iostream.h).
+	 */
+	bool is_shm;
 };
 
 /**
@@ -263,6 +268,7 @@ iostream_ctx_clear(struct iostream_ctx *ctx)
 {
 	ctx->mode = IOSTREAM_MODE_UNINITIALIZED;
 	ctx->ssl = NULL;
+	ctx->is_shm = false;
 }
 
 /**
@@ -0,0 +1,624 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "shm_iostream.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "diag.h"
+#include "sio.h"
+#include "trivia/config.h"
+#include "trivia/util.h"
+
+/** Identifies the shared memory of a stream ("SHMI"). */
+enum { SHM_IOSTREAM_MAGIC = 0x53484d49 };
+/** Version of the shared memory layout. */
+enum { SHM_IOSTREAM_VERSION = 1 };
+/** Size of the header preceding the ring data in the shared memory. */
+enum { SHM_IOSTREAM_HEADER_SIZE = 4096 };
+/** Byte sent over the socket with the shared memory descriptor. */
+enum { SHM_IOSTREAM_HELLO = 'S' };
+
+/**
+ * A ring of bytes in shared memory written by one side of the stream
+ * and read by the other one.
+ */
+struct shm_ring {
+	/** Number of bytes written to the ring. Updated by the writer. */
+	alignas(CACHELINE_SIZE) uint64_t head;
+	/** Number of bytes read from the ring. Updated by the reader. */
+	alignas(CACHELINE_SIZE) uint64_t tail;
+	/** Set by the reader before waiting for data. */
+	alignas(CACHELINE_SIZE) uint32_t reader_waiting;
+	/** Set by the writer before waiting for space. */
+	uint32_t writer_waiting;
+	/** Set by the writer when it closes the stream. */
+	uint32_t is_closed;
+};
+
+/** Index of the client to server ring. */
+enum { SHM_RING_TO_SERVER = 0 };
+/** Index of the server to client ring. */
+enum { SHM_RING_TO_CLIENT = 1 };
+
+/** Header of the shared memory of a stream. */
+struct shm_header {
+	uint32_t magic;
+	uint32_t version;
+	/** Size of the data of each ring. A power of 2. */
+	uint64_t ring_size;
+	/** Rings indexed by SHM_RING_TO_SERVER and SHM_RING_TO_CLIENT. */
+	struct shm_ring rings[2];
+};
+
+static_assert(sizeof(struct shm_header) <= SHM_IOSTREAM_HEADER_SIZE,
+	      "Shared memory stream header doesn't fit in the header size");
+
+/** Shared memory stream data. */
+struct shm_iostream {
+	/** Stream mode: client or server. */
+	enum iostream_mode mode;
+	/** Mapped shared memory or NULL if not received yet. */
+	struct shm_header *header;
+	/** Size of the mapped shared memory. */
+	size_t map_size;
+	/** Ring to read from. */
+	struct shm_ring *rx;
+	/** Ring to write to. */
+	struct shm_ring *tx;
+	/** Data of the ring to read from. */
+	char *rx_data;
+	/** Data of the ring to write to. */
+	char *tx_data;
+	/** Size of the data of each ring. */
+	size_t ring_size;
+	/**
+	 * Read position in the ring to read from. Never loaded from
+	 * the shared memory so as not to trust the peer.
+	 */
+	uint64_t rx_tail;
+	/** Write position in the ring to write to. */
+	uint64_t tx_head;
+	/** Set if the end of the socket stream was read. */
+	bool is_peer_closed;
+	/**
+	 * Set if the last read returned IOSTREAM_WANT_READ, i.e. the
+	 * reader waits for a wakeup on the socket.
+	 */
+	bool is_reader_waiting;
+};
+
+/** Returns the total size of the shared memory of a stream. */
+static inline size_t
+shm_iostream_map_size(size_t ring_size)
+{
+	return SHM_IOSTREAM_HEADER_SIZE + 2 * ring_size;
+}
+
+/** Sets diag about shared memory corrupted by the peer. */
+static void
+shm_iostream_set_corrupted(struct iostream *io)
+{
+	diag_set(SocketError, sio_socketname(io->fd),
+		 "shared memory stream corrupted");
+}
+
+/** Maps the shared memory and sets up the rings for the stream mode. */
+static int
+shm_iostream_map(struct shm_iostream *shm, int shm_fd, size_t map_size)
+{
+	void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			 shm_fd, 0);
+	if (map == MAP_FAILED) {
+		diag_set(SystemError, "failed to map shared memory");
+		return -1;
+	}
+	shm->header = map;
+	shm->map_size = map_size;
+	return 0;
+}
+
+/** Sets up the rings of a stream with mapped and checked memory. */
+static void
+shm_iostream_attach(struct shm_iostream *shm, size_t ring_size)
+{
+	struct shm_header *header = shm->header;
+	char *data = (char *)header + SHM_IOSTREAM_HEADER_SIZE;
+	char *data_to_server = data;
+	char *data_to_client = data + ring_size;
+	if (shm->mode == IOSTREAM_CLIENT) {
+		shm->rx = &header->rings[SHM_RING_TO_CLIENT];
+		shm->tx = &header->rings[SHM_RING_TO_SERVER];
+		shm->rx_data = data_to_client;
+		shm->tx_data = data_to_server;
+	} else {
+		shm->rx = &header->rings[SHM_RING_TO_SERVER];
+		shm->tx = &header->rings[SHM_RING_TO_CLIENT];
+		shm->rx_data = data_to_server;
+		shm->tx_data = data_to_client;
+	}
+	shm->ring_size = ring_size;
+	shm->rx_tail = 0;
+	shm->tx_head = 0;
+}
+
+/**
+ * Creates the shared memory of a stream. Returns its descriptor on
+ * success, -1 on failure.
+ */
+static int
+shm_iostream_alloc(size_t map_size)
+{
+#if defined(HAVE_MEMFD_CREATE)
+	int shm_fd = memfd_create("iostream", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (shm_fd < 0) {
+		diag_set(SystemError, "failed to create shared memory");
+		return -1;
+	}
+#else
+	/* POSIX shared memory names are limited to 31 bytes on macOS. */
+	char name[32];
+	snprintf(name, sizeof(name), "/tnt-shm-%x-%lx",
+		 (unsigned)getpid(), (unsigned long)random());
+	int shm_fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (shm_fd < 0) {
+		diag_set(SystemError, "failed to create shared memory");
+		return -1;
+	}
+	shm_unlink(name);
+#endif
+	if (ftruncate(shm_fd, map_size) != 0) {
+		diag_set(SystemError, "failed to resize shared memory");
+		goto fail;
+	}
+#if defined(HAVE_MEMFD_CREATE)
+	/* Don't let the memory shrink under the server's feet. */
+	if (fcntl(shm_fd, F_ADD_SEALS,
+		  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+		diag_set(SystemError, "failed to seal shared memory");
+		goto fail;
+	}
+#endif
+	return shm_fd;
+fail:
+	close(shm_fd);
+	return -1;
+}
+
+/** Sends the shared memory descriptor to the server. */
+static int
+shm_iostream_send_fd(int fd, int shm_fd)
+{
+	char hello = SHM_IOSTREAM_HELLO;
+	struct iovec iov = {.iov_base = &hello, .iov_len = 1};
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(control, 0, sizeof(control));
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &shm_fd, sizeof(int));
+	if (sendmsg(fd, &msg, 0) != 1) {
+		diag_set(SocketError, sio_socketname(fd), "sendmsg");
+		return -1;
+	}
+	return 0;
+}
+
+/** Allocates the shared memory and sends it to the server. */
+static int
+shm_iostream_connect(struct iostream *io)
+{
+	struct shm_iostream *shm = io->data;
+	size_t ring_size = SHM_IOSTREAM_RING_SIZE;
+	size_t map_size = shm_iostream_map_size(ring_size);
+	int shm_fd = shm_iostream_alloc(map_size);
+	if (shm_fd < 0)
+		return -1;
+	if (shm_iostream_map(shm, shm_fd, map_size) != 0)
+		goto fail;
+	struct shm_header *header = shm->header;
+	header->magic = SHM_IOSTREAM_MAGIC;
+	header->version = SHM_IOSTREAM_VERSION;
+	header->ring_size = ring_size;
+	shm_iostream_attach(shm, ring_size);
+	if (shm_iostream_send_fd(io->fd, shm_fd) != 0)
+		goto fail;
+	close(shm_fd);
+	return 0;
+fail:
+	close(shm_fd);
+	return -1;
+}
+
+/**
+ * Receives the shared memory from the client. Returns 0 on success,
+ * IOSTREAM_WANT_READ if the client hasn't sent it yet, IOSTREAM_ERROR
+ * on failure.
+ */
+static ssize_t
+shm_iostream_accept(struct iostream *io)
+{
+	struct shm_iostream *shm = io->data;
+	assert(shm->mode == IOSTREAM_SERVER);
+	assert(shm->header == NULL);
+	char hello;
+	struct iovec iov = {.iov_base = &hello, .iov_len = 1};
+	char control[CMSG_SPACE(sizeof(int))];
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	int flags = 0;
+#if defined(MSG_CMSG_CLOEXEC)
+	flags |= MSG_CMSG_CLOEXEC;
+#endif
+	ssize_t rc = recvmsg(io->fd, &msg, flags);
+	if (rc < 0) {
+		if (sio_wouldblock(errno))
+			return IOSTREAM_WANT_READ;
+		diag_set(SocketError, sio_socketname(io->fd), "recvmsg");
+		return IOSTREAM_ERROR;
+	}
+	if (rc == 0) {
+		shm->is_peer_closed = true;
+		errno = EPIPE;
+		diag_set(SocketError, sio_socketname(io->fd), "recvmsg");
+		return IOSTREAM_ERROR;
+	}
+	int shm_fd = -1;
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+	    cmsg->cmsg_type == SCM_RIGHTS &&
+	    cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+		memcpy(&shm_fd, CMSG_DATA(cmsg), sizeof(int));
+	if (rc != 1 || hello != SHM_IOSTREAM_HELLO || shm_fd < 0 ||
+	    (msg.msg_flags & MSG_CTRUNC) != 0) {
+		diag_set(SocketError, sio_socketname(io->fd),
+			 "invalid shared memory stream handshake");
+		goto fail;
+	}
+	struct stat st;
+	if (fstat(shm_fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat shared memory");
+		goto fail;
+	}
+#if defined(HAVE_MEMFD_CREATE)
+	int seals = fcntl(shm_fd, F_GET_SEALS);
+	if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+		diag_set(SocketError, sio_socketname(io->fd),
+			 "shared memory isn't sealed");
+		goto fail;
+	}
+#else
+	/* Rejected by shm_iostream_check_mode. */
+	unreachable();
+#endif
+	if (st.st_size <= SHM_IOSTREAM_HEADER_SIZE) {
+		shm_iostream_set_corrupted(io);
+		goto fail;
+	}
+	if (shm_iostream_map(shm, shm_fd, st.st_size) != 0)
+		goto fail;
+	close(shm_fd);
+	shm_fd = -1;
+	struct shm_header *header = shm->header;
+	uint64_t ring_size = header->ring_size;
+	if (header->magic != SHM_IOSTREAM_MAGIC ||
+	    header->version != SHM_IOSTREAM_VERSION ||
+	    ring_size == 0 || (ring_size & (ring_size - 1)) != 0 ||
+	    ring_size > SIZE_MAX / 4 ||
+	    shm_iostream_map_size(ring_size) != shm->map_size) {
+		shm_iostream_set_corrupted(io);
+		munmap(shm->header, shm->map_size);
+		shm->header = NULL;
+		return IOSTREAM_ERROR;
+	}
+	shm_iostream_attach(shm, ring_size);
+	return 0;
+fail:
+	if (shm_fd >= 0)
+		close(shm_fd);
+	return IOSTREAM_ERROR;
+}
+
+/** Wakes up the peer waiting on the socket. */
+static void
+shm_iostream_ring_doorbell(struct iostream *io)
+{
+	char c = 0;
+	/*
+	 * Errors are ignored: if the socket buffer is full, the peer
+	 * will be woken up anyway, and if the peer is gone, the error
+	 * will be detected by the next read.
+	 */
+	ssize_t rc = write(io->fd, &c, 1);
+	(void)rc;
+}
+
+/**
+ * Reads all wakeup bytes sent by the peer. Returns 0 on success,
+ * IOSTREAM_ERROR on failure. Sets shm_iostream::is_peer_closed if
+ * the socket is closed by the peer.
+ */
+static ssize_t
+shm_iostream_drain(struct iostream *io)
+{
+	struct shm_iostream *shm = io->data;
+	char buf[64];
+	while (!shm->is_peer_closed) {
+		ssize_t rc = sio_read(io->fd, buf, sizeof(buf));
+		if (rc == 0) {
+			shm->is_peer_closed = true;
+		} else if (rc < 0) {
+			if (sio_wouldblock(errno))
+				break;
+			return IOSTREAM_ERROR;
+		} else if ((size_t)rc < sizeof(buf)) {
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Wakes up the peer waiting on the given flag in a ring after it was
+ * updated. Paired with the check done by shm_iostream_wait.
+ */
+static void
+shm_iostream_notify(struct iostream *io, uint32_t *waiting)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(waiting, __ATOMIC_RELAXED) != 0 &&
+	    __atomic_exchange_n(waiting, 0, __ATOMIC_RELAXED) != 0)
+		shm_iostream_ring_doorbell(io);
+}
+
+/**
+ * Asks the peer for a wakeup on update of a ring. The ring must be
+ * checked once again after calling this function so as not to miss
+ * an update made before the flag is set.
+ */
+static void
+shm_iostream_wait(uint32_t *waiting)
+{
+	__atomic_store_n(waiting, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * Copies up to count bytes from the ring to read from. Returns the
+ * number of bytes read or IOSTREAM_ERROR if the ring is corrupted.
+ */
+static ssize_t
+shm_iostream_read_ring(struct iostream *io, void *buf, size_t count)
+{
+	struct shm_iostream *shm = io->data;
+	uint64_t head = __atomic_load_n(&shm->rx->head, __ATOMIC_ACQUIRE);
+	uint64_t tail = shm->rx_tail;
+	if (head - tail > shm->ring_size) {
+		shm_iostream_set_corrupted(io);
+		return IOSTREAM_ERROR;
+	}
+	size_t n = MIN(count, head - tail);
+	if (n == 0)
+		return 0;
+	size_t offset = tail & (shm->ring_size - 1);
+	size_t chunk = MIN(n, shm->ring_size - offset);
+	memcpy(buf, shm->rx_data + offset, chunk);
+	memcpy((char *)buf + chunk, shm->rx_data, n - chunk);
+	shm->rx_tail = tail + n;
+	__atomic_store_n(&shm->rx->tail, shm->rx_tail, __ATOMIC_RELEASE);
+	shm_iostream_notify(io, &shm->rx->writer_waiting);
+	return n;
+}
+
+/**
+ * Copies as much data as fits from the given buffers to the ring to
+ * write to. Returns the number of bytes written or IOSTREAM_ERROR if
+ * the ring is corrupted.
+ */
+static ssize_t
+shm_iostream_write_ring(struct iostream *io, const struct iovec *iov,
+			int iovcnt)
+{
+	struct shm_iostream *shm = io->data;
+	uint64_t head = shm->tx_head;
+	uint64_t tail = __atomic_load_n(&shm->tx->tail, __ATOMIC_ACQUIRE);
+	if (head - tail > shm->ring_size) {
+		shm_iostream_set_corrupted(io);
+		return IOSTREAM_ERROR;
+	}
+	size_t space = shm->ring_size - (head - tail);
+	size_t total = 0;
+	for (int i = 0; i < iovcnt && space > 0; i++) {
+		size_t n = MIN(iov[i].iov_len, space);
+		const char *src = iov[i].iov_base;
+		size_t offset = (head + total) & (shm->ring_size - 1);
+		size_t chunk = MIN(n, shm->ring_size - offset);
+		memcpy(shm->tx_data + offset, src, chunk);
+		memcpy(shm->tx_data, src + chunk, n - chunk);
+		total += n;
+		space -= n;
+	}
+	if (total == 0)
+		return 0;
+	shm->tx_head = head + total;
+	__atomic_store_n(&shm->tx->head, shm->tx_head, __ATOMIC_RELEASE);
+	shm_iostream_notify(io, &shm->tx->reader_waiting);
+	return total;
+}
+
+static void
+shm_iostream_destroy(struct iostream *io)
+{
+	struct shm_iostream *shm = io->data;
+	if (shm->header != NULL) {
+		assert(shm->tx != NULL);
+		__atomic_store_n(&shm->tx->is_closed, 1, __ATOMIC_RELEASE);
+		shm_iostream_notify(io, &shm->tx->reader_waiting);
+		munmap(shm->header, shm->map_size);
+	}
+	free(shm);
+}
+
+static ssize_t
+shm_iostream_read(struct iostream *io, void *buf, size_t count)
+{
+	struct shm_iostream *shm = io->data;
+	shm->is_reader_waiting = false;
+	if (shm->header == NULL) {
+		ssize_t rc = shm_iostream_accept(io);
+		if (rc != 0)
+			return shm->is_peer_closed ? 0 : rc;
+	}
+	ssize_t rc = shm_iostream_read_ring(io, buf, count);
+	if (rc != 0 || count == 0)
+		return rc;
+	/*
+	 * The ring is empty. Consume the wakeups that have been sent
+	 * already and ask the peer for a new one. A writer waiting for
+	 * space is woken up by the same wakeups, so it retries and goes
+	 * back to waiting if the wakeup was meant for the reader.
+	 */
+	if (shm_iostream_drain(io) != 0)
+		return IOSTREAM_ERROR;
+	shm_iostream_wait(&shm->rx->reader_waiting);
+	rc = shm_iostream_read_ring(io, buf, count);
+	if (rc != 0)
+		return rc;
+	if (shm->is_peer_closed ||
+	    __atomic_load_n(&shm->rx->is_closed, __ATOMIC_ACQUIRE) != 0) {
+		/* Recheck the ring: the peer could write before closing. */
+		return shm_iostream_read_ring(io, buf, count);
+	}
+	shm->is_reader_waiting = true;
+	return IOSTREAM_WANT_READ;
+}
+
+static ssize_t
+shm_iostream_writev(struct iostream *io, const struct iovec *iov, int iovcnt)
+{
+	struct shm_iostream *shm = io->data;
+	if (shm->header == NULL) {
+		ssize_t rc = shm_iostream_accept(io);
+		if (rc != 0)
+			return rc;
+	}
+	if (__atomic_load_n(&shm->rx->is_closed, __ATOMIC_ACQUIRE) != 0)
+		goto closed;
+	ssize_t rc = shm_iostream_write_ring(io, iov, iovcnt);
+	if (rc != 0)
+		return rc;
+	shm_iostream_wait(&shm->tx->writer_waiting);
+	rc = shm_iostream_write_ring(io, iov, iovcnt);
+	if (rc != 0)
+		return rc;
+	/*
+	 * The ring is full. Consume the wakeups that have been sent
+	 * already, otherwise the socket stays readable and the writer
+	 * spins until the peer frees the ring. This also checks that
+	 * the peer is still there, because a dead peer won't free it.
+	 *
+	 * The wakeups are left for the reader if it's waiting on the
+	 * socket, because it wouldn't notice the data otherwise. It's
+	 * woken up by the same wakeups and consumes them. A reader
+	 * that isn't waiting checks the ring before waiting so it
+	 * doesn't need the consumed wakeups.
+	 */
+	if (!shm->is_reader_waiting) {
+		if (shm_iostream_drain(io) != 0)
+			return IOSTREAM_ERROR;
+		if (shm->is_peer_closed)
+			goto closed;
+		/* Recheck the ring: the wakeup could have been consumed. */
+		rc = shm_iostream_write_ring(io, iov, iovcnt);
+		if (rc != 0)
+			return rc;
+	} else {
+		char c;
+		rc = recv(io->fd, &c, 1, MSG_PEEK);
+		if (rc == 0 || (rc < 0 && !sio_wouldblock(errno)))
+			goto closed;
+	}
+	/* Wakeups are sent over the socket so wait for it to be readable. */
+	return IOSTREAM_WANT_READ;
+closed:
+	errno = EPIPE;
+	diag_set(SocketError, sio_socketname(io->fd), "writev(%d)", iovcnt);
+	return IOSTREAM_ERROR;
+}
+
+static ssize_t
+shm_iostream_write(struct iostream *io, const void *buf, size_t count)
+{
+	struct iovec iov = {.iov_base = (void *)buf, .iov_len = count};
+	return shm_iostream_writev(io, &iov, 1);
+}
+
+int
+shm_iostream_check_mode(enum iostream_mode mode)
+{
+	assert(mode == IOSTREAM_CLIENT || mode == IOSTREAM_SERVER);
+#if !defined(HAVE_MEMFD_CREATE)
+	/*
+	 * Without memfd sealing the client may shrink the shared memory
+	 * and crash the server with SIGBUS on access.
+	 */
+	if (mode == IOSTREAM_SERVER) {
+		diag_set(IllegalParams, "Transport shm is not supported "
+			 "by the server on this platform");
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+static const struct iostream_vtab shm_iostream_vtab = {
+	/* .destroy = */ shm_iostream_destroy,
+	/* .read = */ shm_iostream_read,
+	/* .write = */ shm_iostream_write,
+	/* .writev = */ shm_iostream_writev,
+};
+
+int
+shm_iostream_create(struct iostream *io, int fd, enum iostream_mode mode)
+{
+	assert(mode == IOSTREAM_CLIENT || mode == IOSTREAM_SERVER);
+	iostream_clear(io);
+	struct shm_iostream *shm = xcalloc(1, sizeof(*shm));
+	shm->mode = mode;
+	io->vtab = &shm_iostream_vtab;
+	io->data = shm;
+	io->fd = fd;
+	if (mode == IOSTREAM_CLIENT && shm_iostream_connect(io) != 0) {
+		if (shm->header != NULL)
+			munmap(shm->header, shm->map_size);
+		free(shm);
+		iostream_clear(io);
+		return -1;
+	}
+	return 0;
+}
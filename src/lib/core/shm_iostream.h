@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2024, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include "iostream.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * An IO stream that transfers data between processes on the same host
+ * through a pair of rings in shared memory.
+ *
+ * The stream is created over a connected Unix socket. The client
+ * allocates the shared memory and passes it to the server over the
+ * socket. After that the data are copied to and from the rings while
+ * the socket is only used for wakeups: one byte is sent to the peer if
+ * it's waiting for data or space in a ring. Closing of the socket also
+ * signals the end of the stream so the peer notices if the process dies.
+ */
+
+/** Size of each ring of a shared memory stream. */
+enum { SHM_IOSTREAM_RING_SIZE = 1024 * 1024 };
+
+/**
+ * Checks if a shared memory stream can be created in the given mode.
+ * The server mode requires memfd sealing, otherwise the client could
+ * resize the shared memory under the server's feet.
+ *
+ * On success returns 0. On failure returns -1 and sets diag.
+ */
+int
+shm_iostream_check_mode(enum iostream_mode mode);
+
+/**
+ * Creates a shared memory stream over the given Unix socket.
+ *
+ * In the client mode, allocates the shared memory and sends it to
+ * the server. In the server mode, the shared memory is received on
+ * the first IO operation.
+ *
+ * On success returns 0. On failure returns -1 and sets diag.
+ */
+int
+shm_iostream_create(struct iostream *io, int fd, enum iostream_mode mode);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -334,6 +334,15 @@
 #error "Only one of BPS_INNER_CHILD_CARDS and BPS_INNER_CARD supported"
 #endif
 
+/**
+ * Number of keys that are looked up simultaneously by
+ * bps_tree_find_batch(). Larger groups hide more memory latency
+ * at the cost of more blocks kept in cache at the same time.
+ */
+#ifndef BPS_TREE_FIND_BATCH_SIZE
+#define BPS_TREE_FIND_BATCH_SIZE 16
+#endif
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -411,6 +420,7 @@ typedef int64_t bps_tree_block_card_t;
 #define bps_tree_find_impl _bps_tree(find)
 #define bps_tree_find _api_name(find)
 #define bps_tree_view_find _api_name(view_find)
+#define bps_tree_find_batch _api_name(find_batch)
 #define bps_tree_find_get_offset _api_name(find_get_offset)
 #define bps_tree_view_find_get_offset _api_name(view_find_get_offset)
 #define bps_tree_insert_impl _bps_tree(insert)
@@ -495,6 +505,7 @@ typedef int64_t bps_tree_block_card_t;
 
 #define bps_tree_restore_block _bps_tree(restore_block)
 #define bps_tree_root _bps_tree(root)
+#define bps_tree_prefetch_block _bps_tree(prefetch_block)
 #define bps_tree_touch_block _bps_tree(touch_block)
 #define bps_tree_touch_leaf _bps_tree(touch_leaf)
 #define bps_tree_touch_inner _bps_tree(touch_inner)
@@ -754,6 +765,21 @@ bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key);
 static inline bps_tree_elem_t *
 bps_tree_view_find(const struct bps_tree_view *view, bps_tree_key_t key);
 
+/**
+ * @brief Find the first elements that are equal to each of the given keys.
+ * Equivalent to calling bps_tree_find() for every key, but descends the
+ * tree for a group of keys level by level, prefetching the next block of
+ * each key while the other keys of the group are processed, so that the
+ * cache misses of different lookups overlap.
+ * @param tree - pointer to a tree
+ * @param keys - array of keys
+ * @param count - number of keys
+ * @param[out] results - array of pointers to the found elements or NULLs
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, const bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results);
+
 #if defined(BPS_INNER_CHILD_CARDS) || defined(BPS_INNER_CARD)
 
 /**
@@ -3131,6 +3157,62 @@ bps_tree_view_find(const struct bps_tree_view *view, bps_tree_key_t key)
 	return bps_tree_find_impl(&view->common, key, NULL);
 }
 
+/**
+ * @brief Prefetch the part of a block that is accessed first by binary
+ * search: the header and the middle of the block.
+ */
+static inline void
+bps_tree_prefetch_block(struct bps_block *block)
+{
+	prefetch(block, 0);
+	prefetch((char *)block + BPS_TREE_BLOCK_SIZE / 2, 0);
+}
+
+static inline void
+bps_tree_find_batch(const struct bps_tree *t, const bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results)
+{
+	const struct bps_tree_common *tree = &t->common;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		for (size_t i = 0; i < count; i++)
+			results[i] = NULL;
+		return;
+	}
+	struct bps_block *root = bps_tree_root(tree);
+	struct bps_block *blocks[BPS_TREE_FIND_BATCH_SIZE];
+	for (size_t first = 0; first < count;
+	     first += BPS_TREE_FIND_BATCH_SIZE) {
+		size_t n = MIN(count - first, (size_t)BPS_TREE_FIND_BATCH_SIZE);
+		const bps_tree_key_t *group = keys + first;
+		for (size_t j = 0; j < n; j++)
+			blocks[j] = root;
+		bool exact;
+		for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+			for (size_t j = 0; j < n; j++) {
+				struct bps_inner *inner =
+					(struct bps_inner *)blocks[j];
+				bps_tree_pos_t pos;
+				pos = bps_tree_find_ins_point_key(
+					tree, inner->elems,
+					inner->header.size - 1,
+					group[j], &exact);
+				blocks[j] = bps_tree_restore_block(
+					tree, inner->child_ids[pos]);
+				bps_tree_prefetch_block(blocks[j]);
+			}
+		}
+		for (size_t j = 0; j < n; j++) {
+			struct bps_leaf *leaf = (struct bps_leaf *)blocks[j];
+			bps_tree_pos_t pos;
+			exact = false;
+			pos = bps_tree_find_ins_point_key(tree, leaf->elems,
+							  leaf->header.size,
+							  group[j], &exact);
+			results[first + j] = exact ? leaf->elems + pos : NULL;
+		}
+	}
+}
+
 #if defined(BPS_INNER_CHILD_CARDS) || defined(BPS_INNER_CARD)
 
 static inline bps_tree_elem_t *
@@ -7629,6 +7711,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_find_impl
 #undef bps_tree_find
 #undef bps_tree_view_find
+#undef bps_tree_find_batch
 #undef bps_tree_find_get_offset
 #undef bps_tree_view_find_get_offset
 #undef bps_tree_insert_impl
@@ -7706,6 +7789,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef bps_tree_restore_block
 #undef bps_tree_root
+#undef bps_tree_prefetch_block
 #undef bps_tree_touch_block
 #undef bps_tree_touch_leaf
 #undef bps_tree_touch_inner
@@ -44,6 +44,7 @@ g.test_autocomplete = function()
                               'conn1:close(',
                               'conn1:on_connect(',
                               'conn1:new_stream(',
+                              'conn1:pipeline(',
                               'conn1:is_connected(',
                               'conn1:eval(',
                               'conn1:on_schema_reload(',
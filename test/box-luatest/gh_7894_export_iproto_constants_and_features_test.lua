@@ -37,6 +37,8 @@ local reference_table = {
         TSN = 0x08,
         FLAGS = 0x09,
         STREAM_ID = 0x0a,
+        COMPRESSION = 0x0b,
+        SCHED_CLASS = 0x0c,
         SPACE_ID = 0x10,
         INDEX_ID = 0x11,
         LIMIT = 0x12,
@@ -92,6 +94,11 @@ local reference_table = {
         IS_CHECKPOINT_JOIN = 0x62,
         CHECKPOINT_VCLOCK = 0x63,
         CHECKPOINT_LSN = 0x64,
+        REQUESTS = 0x65,
+        IS_ATOMIC = 0x66,
+        CURSOR_ID = 0x67,
+        FIELDS = 0x68,
+        APPLIED_COUNT = 0x69,
     },
 
     -- `iproto_metadata_key` enumeration.
@@ -138,6 +145,10 @@ local reference_table = {
         COMMIT = 15,
         ROLLBACK = 16,
         INSERT_ARROW = 17,
+        BATCH = 18,
+        CURSOR_OPEN = 19,
+        CURSOR_FETCH = 20,
+        CURSOR_CLOSE = 21,
         RAFT = 30,
         RAFT_PROMOTE = 31,
         RAFT_DEMOTE = 32,
@@ -173,7 +184,7 @@ local reference_table = {
     },
 
     -- `IPROTO_CURRENT_VERSION` constant
-    protocol_version = 10,
+    protocol_version = 14,
 
     -- `feature_id` enumeration
     protocol_features = {
@@ -190,6 +201,10 @@ local reference_table = {
         fetch_snapshot_cursor = is_enterprise and true or nil,
         is_sync = true,
         insert_arrow = true,
+        compression = true,
+        cursors = true,
+        select_fields = true,
+        batch = true,
     },
     feature = {
         streams = 0,
@@ -205,6 +220,10 @@ local reference_table = {
         fetch_snapshot_cursor = 10,
         is_sync = 11,
         insert_arrow = 12,
+        compression = 13,
+        cursors = 14,
+        select_fields = 15,
+        batch = 16,
     },
 }
 
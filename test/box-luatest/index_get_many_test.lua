@@ -0,0 +1,76 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group('index_get_many', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+    index_type = {'tree', 'hash'},
+}))
+
+g.before_all(function(cg)
+    t.skip_if(cg.params.engine == 'vinyl' and cg.params.index_type == 'hash')
+    cg.server = server:new()
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    if cg.server ~= nil then
+        cg.server:drop()
+    end
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+-- Checks that index:get_many() returns the same tuples as index:get().
+g.test_get_many = function(cg)
+    cg.server:exec(function(engine, index_type)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk', {type = index_type})
+        s:create_index('sk', {type = index_type, parts = {2, 'string'}})
+        for i = 1, 100 do
+            s:insert({i, 'v' .. i})
+        end
+
+        t.assert_equals(s:get_many({}), {})
+        t.assert_equals(s:get_many({{3}, 1, {2}}), {{3, 'v3'}, {1, 'v1'},
+                                                  {2, 'v2'}})
+        -- Missing keys are skipped.
+        t.assert_equals(s:get_many({1000, 5, 0}), {{5, 'v5'}})
+        t.assert_equals(s.index.sk:get_many({'v7', 'x', 'v8'}),
+                        {{7, 'v7'}, {8, 'v8'}})
+
+        -- More keys than a single lookup batch.
+        local keys = {}
+        local expected = {}
+        for i = 100, 1, -3 do
+            table.insert(keys, i)
+            table.insert(expected, s:get(i))
+        end
+        t.assert_equals(s:get_many(keys), expected)
+    end, {cg.params.engine, cg.params.index_type})
+end
+
+-- Checks index:get_many() argument validation.
+g.test_get_many_errors = function(cg)
+    cg.server:exec(function(engine, index_type)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk', {type = index_type,
+                              parts = {{1, 'unsigned'}, {2, 'unsigned'}}})
+        s:create_index('sk', {type = 'tree', unique = false,
+                              parts = {3, 'unsigned'}})
+        t.assert_error_msg_equals('Usage: index:get_many(keys)',
+                                  s.index.pk.get_many, s.index.pk, 1)
+        t.assert_error_msg_contains('Invalid key part count',
+                                    s.get_many, s, {{1}})
+        t.assert_error_msg_contains('Supplied key type',
+                                    s.get_many, s, {{1, 'x'}})
+        t.assert_error_msg_contains('Get() doesn\'t support partial keys ' ..
+                                    'and non-unique indexes',
+                                    s.index.sk.get_many, s.index.sk, {1})
+    end, {cg.params.engine, cg.params.index_type})
+end
@@ -0,0 +1,104 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:insert({1})
+        -- Blocks the tx thread without yielding.
+        rawset(_G, 'busy', function(timeout)
+            local clock = require('clock')
+            local deadline = clock.monotonic() + timeout
+            while clock.monotonic() < deadline do end
+        end)
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.cfg{
+            iproto_admission_target = 0.05,
+            iproto_admission_interval = 1,
+        }
+    end)
+end)
+
+-- Sends a burst of requests keeping the tx thread busy and returns the
+-- number of rejected SELECT and PING requests.
+local function overload(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    local selects = {}
+    local pings = {}
+    for _ = 1, 10 do
+        c:call('busy', {0.02}, {is_async = true})
+        for _ = 1, 50 do
+            table.insert(selects, c.space.test:select({}, {is_async = true}))
+            table.insert(pings, c:ping({is_async = true}))
+        end
+    end
+    local function count_rejected(futures)
+        local count = 0
+        for _, future in ipairs(futures) do
+            local res, err = future:wait_result()
+            if res == nil then
+                t.assert_equals(err.code, box.error.OVERLOADED)
+                count = count + 1
+            end
+        end
+        return count
+    end
+    local rejected_selects = count_rejected(selects)
+    local rejected_pings = count_rejected(pings)
+    c:close()
+    return rejected_selects, rejected_pings
+end
+
+-- Checks that requests that waited too long in the queue are rejected
+-- when the tx thread is overloaded.
+g.test_admission = function(cg)
+    local function rejected_total()
+        return cg.server:exec(function()
+            return box.stat.net().REQUESTS_REJECTED.total
+        end)
+    end
+    -- Admission control is enabled by default.
+    t.assert_equals(cg.server:exec(function()
+        local res = box.cfg.iproto_admission_target
+        box.cfg{iproto_admission_target = 0}
+        return res
+    end), 0.05)
+    local total = rejected_total()
+    local selects, pings = overload(cg)
+    t.assert_equals(selects, 0)
+    t.assert_equals(pings, 0)
+    t.assert_equals(rejected_total(), total)
+
+    cg.server:exec(function()
+        box.cfg{
+            iproto_admission_target = 0.001,
+            iproto_admission_interval = 0.01,
+        }
+    end)
+    selects, pings = overload(cg)
+    t.assert_gt(selects, 0)
+    -- PING is never rejected.
+    t.assert_equals(pings, 0)
+    t.assert_ge(rejected_total(), total + selects)
+
+    -- Requests are accepted once the overload is over.
+    local c = net.connect(cg.server.net_box_uri)
+    t.helpers.retrying({}, function()
+        t.assert_equals(c.space.test:select(), {{1}})
+    end)
+    c:close()
+end
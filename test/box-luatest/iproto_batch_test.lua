@@ -0,0 +1,231 @@
+local server = require('luatest.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function(net_box_uri)
+        rawset(_G, 'iproto_batch', function(body)
+            local uri = require('uri')
+            local socket = require('socket')
+            -- Connect to the server.
+            local u = uri.parse(net_box_uri)
+            local s = socket.tcp_connect(u.host, u.service)
+            local greeting = s:read(box.iproto.GREETING_SIZE)
+            greeting = box.iproto.decode_greeting(greeting)
+            t.assert_covers(greeting, {protocol = 'Binary'})
+            -- Send the request.
+            local request = box.iproto.encode_packet(
+                {request_type = box.iproto.type.BATCH, sync = 123},
+                setmetatable(body, {__serialize = 'map'}))
+            t.assert_equals(s:write(request), #request)
+            -- Read the response.
+            local response = ''
+            local header
+            repeat
+                header, body = box.iproto.decode_packet(response)
+                if header == nil then
+                    local size = body
+                    local data = s:read(size)
+                    t.assert_is_not(data)
+                    response = response .. data
+                end
+            until header ~= nil
+            s:close()
+            return body
+        end)
+        rawset(_G, 'batch_request', function(type, body)
+            body[box.iproto.key.REQUEST_TYPE] = box.iproto.type[type]
+            return setmetatable(body, {__serialize = 'map'})
+        end)
+    end, {cg.server.net_box_uri})
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function()
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+    end)
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.space.test:drop()
+    end)
+end)
+
+-- Checks that the requests of a batch are executed in order and their
+-- results are returned in one reply.
+g.test_iproto_batch = function(cg)
+    cg.server:exec(function()
+        local key = box.iproto.key
+        local rq = _G.batch_request
+        local space_id = box.space.test.id
+        for _, is_atomic in ipairs({false, true}) do
+            box.space.test:truncate()
+            local r = _G.iproto_batch({
+                [key.IS_ATOMIC] = is_atomic,
+                [key.REQUESTS] = {
+                    rq('INSERT', {[key.SPACE_ID] = space_id,
+                                  [key.TUPLE] = {1, 'a'}}),
+                    rq('REPLACE', {[key.SPACE_ID] = space_id,
+                                   [key.TUPLE] = {2, 'b'}}),
+                    rq('SELECT', {[key.SPACE_ID] = space_id,
+                                  [key.INDEX_ID] = 0,
+                                  [key.LIMIT] = 10,
+                                  [key.KEY] = {}}),
+                    rq('UPDATE', {[key.SPACE_ID] = space_id,
+                                  [key.INDEX_ID] = 0,
+                                  [key.KEY] = {1},
+                                  [key.TUPLE] = {{'=', 2, 'c'}}}),
+                    rq('DELETE', {[key.SPACE_ID] = space_id,
+                                  [key.INDEX_ID] = 0,
+                                  [key.KEY] = {2}}),
+                    rq('DELETE', {[key.SPACE_ID] = space_id,
+                                  [key.INDEX_ID] = 0,
+                                  [key.KEY] = {3}}),
+                    rq('UPSERT', {[key.SPACE_ID] = space_id,
+                                  [key.TUPLE] = {3, 'd'},
+                                  [key.OPS] = {}}),
+                    rq('SELECT', {[key.SPACE_ID] = space_id,
+                                  [key.INDEX_ID] = 0,
+                                  [key.LIMIT] = 1,
+                                  [key.ITERATOR] = box.index.GT,
+                                  [key.KEY] = {1}}),
+                },
+            })
+            t.assert_equals(r[key.ERROR_24], nil)
+            t.assert_equals(r[key.DATA], {
+                {{1, 'a'}},
+                {{2, 'b'}},
+                {{1, 'a'}, {2, 'b'}},
+                {{1, 'c'}},
+                {{2, 'b'}},
+                {},
+                {},
+                {{3, 'd'}},
+            })
+            t.assert_equals(box.space.test:select(), {{1, 'c'}, {3, 'd'}})
+        end
+    end)
+end
+
+-- Checks that a failed request stops the batch and rolls back the whole
+-- batch if it's atomic.
+g.test_iproto_batch_error = function(cg)
+    cg.server:exec(function()
+        local key = box.iproto.key
+        local rq = _G.batch_request
+        local space_id = box.space.test.id
+        local requests = {
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {1}}),
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {2}}),
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {1}}),
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {3}}),
+        }
+        local r = _G.iproto_batch({
+            [key.IS_ATOMIC] = true,
+            [key.REQUESTS] = requests,
+        })
+        t.assert_str_contains(r[key.ERROR_24], 'Duplicate key exists')
+        t.assert_equals(r[key.APPLIED_COUNT], nil)
+        t.assert_equals(box.space.test:select(), {})
+
+        r = _G.iproto_batch({[key.REQUESTS] = requests})
+        t.assert_str_contains(r[key.ERROR_24], 'Duplicate key exists')
+        t.assert_equals(r[key.APPLIED_COUNT], 2)
+        t.assert_equals(box.space.test:select(), {{1}, {2}})
+    end)
+end
+
+-- Checks the net.box API for batches.
+g.test_net_box_batch = function(cg)
+    local conn = require('net.box').connect(cg.server.net_box_uri)
+    t.assert(conn.peer_protocol_features.batch)
+    local res = conn:batch({
+        {'insert', 'test', {1, 'a'}},
+        {'replace', 'test', {2, 'b'}},
+        {'select', 'test', {}},
+        {'update', 'test', {1}, {{'=', 2, 'c'}}},
+        {'delete', 'test', {2}, 'pk'},
+        {'upsert', 'test', {3, 'd'}, {}},
+        {'select', 'test', {1}, {iterator = 'GT', limit = 1}},
+    }, {is_atomic = true})
+    t.assert_equals(res, {
+        {{1, 'a'}},
+        {{2, 'b'}},
+        {{1, 'a'}, {2, 'b'}},
+        {{1, 'c'}},
+        {{2, 'b'}},
+        {},
+        {{3, 'd'}},
+    })
+
+    -- A failed non-atomic batch reports the number of applied requests.
+    local requests = {
+        {'insert', 'test', {4}},
+        {'insert', 'test', {1}},
+        {'insert', 'test', {5}},
+    }
+    local ok, err = pcall(conn.batch, conn, requests)
+    t.assert_not(ok)
+    t.assert_equals(err.code, box.error.TUPLE_FOUND)
+    t.assert_equals(err.applied_count, 1)
+    ok, err = pcall(conn.batch, conn, requests, {is_atomic = true})
+    t.assert_not(ok)
+    t.assert_equals(err.code, box.error.TUPLE_FOUND)
+    t.assert_equals(err.applied_count, nil)
+    t.assert_equals(conn.space.test:select(), {{1, 'c'}, {3, 'd'}, {4}})
+
+    -- A batch may be sent asynchronously and added to a pipeline.
+    local future = conn:batch({{'select', 'test', {4}}}, nil,
+                              {is_async = true})
+    t.assert_equals(future:wait_result(), {{{4}}})
+    local p = conn:pipeline()
+    future = p:batch({{'delete', 'test', {4}}})
+    t.assert(p:wait(10))
+    t.assert_equals(future:result(), {{{4}}})
+
+    t.assert_error_msg_equals("unknown batch request type 'call'",
+                              conn.batch, conn, {{'call', 'test'}})
+    conn:close()
+end
+
+-- Checks that malformed batches are rejected before any of their
+-- requests is executed.
+g.test_iproto_batch_invalid = function(cg)
+    cg.server:exec(function()
+        local key = box.iproto.key
+        local rq = _G.batch_request
+        local space_id = box.space.test.id
+        local r = _G.iproto_batch({})
+        t.assert_equals(r[key.ERROR_24],
+                        "Missing mandatory field 'REQUESTS' in request")
+        r = _G.iproto_batch({[key.REQUESTS] = {
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {1}}),
+            rq('CALL', {[key.FUNCTION_NAME] = 'box.info'}),
+        }})
+        t.assert_equals(r[key.ERROR_24], 'Unknown request type 10')
+        r = _G.iproto_batch({[key.REQUESTS] = {
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {1}}),
+            rq('INSERT', {[key.SPACE_ID] = space_id}),
+        }})
+        t.assert_equals(r[key.ERROR_24],
+                        "Missing mandatory field 'TUPLE' in request")
+        r = _G.iproto_batch({[key.REQUESTS] = {
+            rq('INSERT', {[key.SPACE_ID] = space_id, [key.TUPLE] = {1}}),
+            setmetatable({[key.SPACE_ID] = space_id},
+                         {__serialize = 'map'}),
+        }})
+        t.assert_equals(r[key.ERROR_24],
+                        "Missing mandatory field 'REQUEST_TYPE' in request")
+        r = _G.iproto_batch({[key.REQUESTS] = {{1, 2, 3}}})
+        t.assert_equals(r[key.ERROR_24], 'Invalid MsgPack - batch request')
+        t.assert_equals(box.space.test:select(), {})
+    end)
+end
@@ -0,0 +1,151 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for id = 1, 100 do
+            s:insert({id, string.rep('x', id * 100)})
+        end
+        rawset(_G, 'echo', function(...) return ... end)
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.cfg{iproto_compression_min_size = 1024}
+        box.space.test:truncate()
+        for id = 1, 100 do
+            box.space.test:insert({id, string.rep('x', id * 100)})
+        end
+    end)
+end)
+
+local function net_stat(cg)
+    return cg.server:exec(function()
+        local stat = box.stat.net()
+        return {sent = stat.SENT.total, received = stat.RECEIVED.total}
+    end)
+end
+
+-- Checks that big requests and replies are compressed and the results
+-- are the same as the ones of the uncompressed requests.
+g.test_compression = function(cg)
+    local plain = net.connect(cg.server.net_box_uri)
+    local c = net.connect(cg.server.net_box_uri, {compression = true})
+    t.assert(c.peer_protocol_features.compression)
+    local expected = plain.space.test:select()
+    t.assert_equals(#expected, 100)
+
+    local stat = net_stat(cg)
+    t.assert_equals(plain.space.test:select(), expected)
+    local plain_sent = net_stat(cg).sent - stat.sent
+    stat = net_stat(cg)
+    t.assert_equals(c.space.test:select(), expected)
+    local sent = net_stat(cg).sent - stat.sent
+    t.assert_lt(sent * 10, plain_sent)
+
+    local arg = string.rep('abcdef', 10000)
+    stat = net_stat(cg)
+    t.assert_equals(plain:call('echo', {arg}), arg)
+    local plain_received = net_stat(cg).received - stat.received
+    stat = net_stat(cg)
+    t.assert_equals(c:call('echo', {arg}), arg)
+    local received = net_stat(cg).received - stat.received
+    t.assert_lt(received * 10, plain_received)
+
+    -- Small requests and replies are sent as is.
+    t.assert_equals(c.space.test:get(1), expected[1])
+    t.assert_equals(c:call('echo', {1, 2, 3}), {1, 2, 3})
+
+    local tuple = {1000, string.rep('y', 100000)}
+    t.assert_equals(c.space.test:insert(tuple), tuple)
+    t.assert_equals(plain.space.test:get(1000), tuple)
+    t.assert_equals(c.space.test:delete(1000), tuple)
+
+    -- Interleave replies of concurrent requests.
+    local futures = {}
+    for i = 1, 100 do
+        table.insert(futures, c.space.test:select({i}, {
+            iterator = 'ge', limit = 10, is_async = true}))
+    end
+    for i, future in ipairs(futures) do
+        t.assert_equals(future:wait_result(),
+                        {unpack(expected, i, math.min(i + 9, 100))})
+    end
+    plain:close()
+    c:close()
+end
+
+-- Checks that compression of replies can be disabled.
+g.test_compression_disabled = function(cg)
+    cg.server:exec(function()
+        box.cfg{iproto_compression_min_size = 0}
+    end)
+    local c = net.connect(cg.server.net_box_uri, {compression = true})
+    local expected = c.space.test:select()
+    local stat = net_stat(cg)
+    t.assert_equals(c.space.test:select(), expected)
+    local sent = net_stat(cg).sent - stat.sent
+    t.assert_gt(sent, 100 * 101 * 50)
+    c:close()
+end
+
+-- Checks that compressed requests are accepted only if compression is
+-- negotiated and that the size of their decompressed bodies is limited.
+g.test_compressed_request_checks = function(cg)
+    cg.server:exec(function(net_box_uri)
+        local socket = require('socket')
+        local u = require('uri').parse(net_box_uri)
+        local s = socket.tcp_connect(u.host, u.service)
+        box.iproto.decode_greeting(s:read(box.iproto.GREETING_SIZE))
+        local sync = 0
+        local function request(header, body)
+            sync = sync + 1
+            header.sync = sync
+            local packet = box.iproto.encode_packet(header, body)
+            t.assert_equals(s:write(packet), #packet)
+            local response = ''
+            local reply_header, reply_body
+            repeat
+                reply_header, reply_body = box.iproto.decode_packet(response)
+                if reply_header == nil then
+                    local data = s:read(reply_body)
+                    t.assert_is_not(data)
+                    response = response .. data
+                end
+            until reply_header ~= nil
+            t.assert_equals(reply_header.sync, sync)
+            return reply_body
+        end
+        -- <MP_BIN> with a zstd frame header with the content size of 1 GB.
+        local body = string.fromhex('c40d28b52ffde00000004000000000')
+        local ping = {
+            request_type = box.iproto.type.PING,
+            [box.iproto.key.COMPRESSION] = 1,
+        }
+        local r = request(ping, body)
+        t.assert_equals(r[box.iproto.key.ERROR_24],
+                        'Compression is not negotiated by IPROTO_ID')
+        r = request({request_type = box.iproto.type.ID}, {
+            [box.iproto.key.VERSION] = box.iproto.protocol_version,
+            [box.iproto.key.FEATURES] = {box.iproto.feature.compression},
+        })
+        t.assert_equals(r[box.iproto.key.ERROR_24], nil)
+        r = request(ping, body)
+        t.assert_str_contains(r[box.iproto.key.ERROR_24],
+                              'Decompression error: decompressed body ' ..
+                              'size 1073741824 exceeds the limit')
+        s:close()
+    end, {cg.server.net_box_uri})
+end
@@ -0,0 +1,139 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for id = 1, 100 do
+            s:insert({id, string.rep('x', id)})
+        end
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that tuples are fetched from a cursor in batches until it's
+-- exhausted.
+g.test_cursor = function(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    t.assert(c.peer_protocol_features.cursors)
+    local expected = c.space.test:select()
+    local cursor = c.space.test:cursor()
+    local res = {}
+    repeat
+        local tuples = cursor:fetch(7)
+        t.assert_le(#tuples, 7)
+        for _, tuple in ipairs(tuples) do
+            table.insert(res, tuple)
+        end
+    until #tuples == 0
+    t.assert_equals(res, expected)
+    t.assert_equals(cursor:fetch(), {})
+    cursor:close()
+
+    -- Cursors are independent of each other.
+    local cursor1 = c.space.test.index.pk:cursor({50}, {iterator = 'le'})
+    local cursor2 = c.space.test:cursor({}, {offset = 95})
+    t.assert_equals(cursor1:fetch(2), {expected[50], expected[49]})
+    t.assert_equals(cursor2:fetch(), {unpack(expected, 96, 100)})
+    t.assert_equals(cursor1:fetch(1), {expected[48]})
+    local cursor3 = c.space.test:cursor({}, {after = {90}})
+    t.assert_equals(cursor3:fetch(), {unpack(expected, 91, 100)})
+    cursor1:close()
+    cursor2:close()
+    cursor3:close()
+    c:close()
+end
+
+-- Checks errors of requests to closed and unknown cursors.
+g.test_cursor_errors = function(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    local cursor = c.space.test:cursor()
+    cursor:close()
+    local msg = string.format('Cursor %d does not exist', cursor._id)
+    t.assert_error_msg_equals(msg, cursor.fetch, cursor)
+    t.assert_error_msg_equals(msg, cursor.close, cursor)
+    t.assert_error_msg_contains('Use cursor:fetch(...)', cursor.fetch)
+    t.assert_error_msg_contains('Invalid key part count',
+                                c.space.test.cursor, c.space.test,
+                                {1, 2}, {iterator = 'ge'})
+    c:close()
+end
+
+-- Checks that cursors are closed with the connection.
+g.test_cursor_disconnect = function(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    for i = 1, 10 do
+        c.space.test:cursor({i * 10}, {iterator = 'ge'})
+    end
+    local cursor = c.space.test:cursor({42})
+    t.assert_equals(cursor:fetch(), {{42, string.rep('x', 42)}})
+    c:close()
+    -- Cursor IDs are local to the connection.
+    c = net.connect(cg.server.net_box_uri)
+    cursor = c.space.test:cursor({42})
+    t.assert_equals(cursor._id, 1)
+    t.assert_equals(cursor:fetch(), {{42, string.rep('x', 42)}})
+    c:close()
+end
+
+-- Checks that the number of cursors open by a connection is limited.
+g.test_cursor_limit = function(cg)
+    cg.server:exec(function()
+        box.cfg{iproto_cursor_max = 3}
+    end)
+    local c = net.connect(cg.server.net_box_uri)
+    local cursors = {}
+    for i = 1, 3 do
+        cursors[i] = c.space.test:cursor({i}, {iterator = 'ge'})
+    end
+    t.assert_error_msg_equals('Too many open cursors, the limit is 3',
+                              c.space.test.cursor, c.space.test)
+    cursors[2]:close()
+    local cursor = c.space.test:cursor({42})
+    t.assert_equals(cursor:fetch(), {{42, string.rep('x', 42)}})
+    -- The limit is per connection.
+    local c2 = net.connect(cg.server.net_box_uri)
+    t.assert_equals(c2.space.test:cursor({7}):fetch(),
+                    {{7, string.rep('x', 7)}})
+    c2:close()
+    c:close()
+    cg.server:exec(function()
+        box.cfg{iproto_cursor_max = 64}
+    end)
+end
+
+-- Checks that a fetch request must have a limit.
+g.test_cursor_fetch_without_limit = function(cg)
+    cg.server:exec(function(net_box_uri)
+        local socket = require('socket')
+        local u = require('uri').parse(net_box_uri)
+        local s = socket.tcp_connect(u.host, u.service)
+        box.iproto.decode_greeting(s:read(box.iproto.GREETING_SIZE))
+        local request = box.iproto.encode_packet({
+            request_type = box.iproto.type.CURSOR_FETCH, sync = 1,
+        }, {[box.iproto.key.CURSOR_ID] = 1})
+        t.assert_equals(s:write(request), #request)
+        local response = ''
+        local header, body
+        repeat
+            header, body = box.iproto.decode_packet(response)
+            if header == nil then
+                local data = s:read(body)
+                t.assert_is_not(data)
+                response = response .. data
+            end
+        until header ~= nil
+        s:close()
+        t.assert_equals(body[box.iproto.key.ERROR_24],
+                        "Missing mandatory field 'LIMIT' in request")
+    end, {cg.server.net_box_uri})
+end
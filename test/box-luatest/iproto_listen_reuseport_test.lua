@@ -0,0 +1,83 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new({
+        box_cfg = {iproto_threads = 4, iproto_listen_reuseport = true},
+    })
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function(uri)
+        box.cfg{listen = uri}
+    end, {cg.server.net_box_uri})
+end)
+
+local function thread_connections(cg)
+    return cg.server:exec(function()
+        local connections = {}
+        for i = 1, box.cfg.iproto_threads do
+            connections[i] = box.stat.net.thread[i].CONNECTIONS.current
+        end
+        return connections
+    end)
+end
+
+-- Checks that connections are accepted by all threads when every
+-- thread listens on its own socket.
+local function check_connections(cg, uri)
+    local COUNT = 100
+    local before = thread_connections(cg)
+    local conns = {}
+    for i = 1, COUNT do
+        conns[i] = net.connect(uri)
+        t.assert_equals(conns[i].state, 'active')
+        t.assert(conns[i]:ping())
+    end
+    local after = thread_connections(cg)
+    local total = 0
+    for i = 1, #after do
+        local count = after[i] - before[i]
+        t.assert_gt(count, 0)
+        total = total + count
+    end
+    t.assert_equals(total, COUNT)
+    for i = 1, COUNT do
+        conns[i]:close()
+    end
+end
+
+g.test_reuseport = function(cg)
+    local uri = cg.server:exec(function()
+        t.assert_error_msg_contains(
+            "Can't set option 'iproto_listen_reuseport' dynamically",
+            box.cfg, {iproto_listen_reuseport = false})
+        box.cfg{listen = 'localhost:0'}
+        return box.info.listen
+    end)
+    check_connections(cg, uri)
+
+    -- The threads close their own sockets when listening is stopped.
+    cg.server:exec(function()
+        box.cfg{listen = ''}
+    end)
+    local c = net.connect(uri)
+    t.assert_not_equals(c.state, 'active')
+    c:close()
+
+    -- The threads rebind their sockets when listening is restarted
+    -- with the same URI.
+    t.assert_equals(cg.server:exec(function(uri)
+        box.cfg{listen = uri}
+        return box.info.listen
+    end, {uri}), uri)
+    check_connections(cg, uri)
+end
@@ -29,6 +29,10 @@ local basic_rq_types = {
     VOTE = box.iproto.type.VOTE,
     AUTH = box.iproto.type.AUTH,
     INSERT_ARROW = box.iproto.type.INSERT_ARROW,
+    BATCH = box.iproto.type.BATCH,
+    CURSOR_OPEN = box.iproto.type.CURSOR_OPEN,
+    CURSOR_FETCH = box.iproto.type.CURSOR_FETCH,
+    CURSOR_CLOSE = box.iproto.type.CURSOR_CLOSE,
 }
 
 -- Grep server logs for error messages about unsupported request types.
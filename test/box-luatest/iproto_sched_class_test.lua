@@ -0,0 +1,350 @@
+local digest = require('digest')
+local fiber = require('fiber')
+local net = require('net.box')
+local server = require('luatest.server')
+local socket = require('socket')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.schema.space.create('log')
+        box.space.log:create_index('pk', {sequence = true})
+        box.schema.user.create('alice', {password = 'secret'})
+        box.schema.user.grant('alice', 'super')
+        rawset(_G, 'log', function(name)
+            return box.space.log:insert({box.NULL, name})
+        end)
+        rawset(_G, 'last', function()
+            return box.space.log.index.pk:max()
+        end)
+        rawset(_G, 'user', function()
+            return box.session.user()
+        end)
+        -- Blocks the tx thread so that the requests sent meanwhile
+        -- are fetched by it at once.
+        rawset(_G, 'block', function()
+            local clock = require('clock')
+            local deadline = clock.monotonic() + 0.2
+            while clock.monotonic() < deadline do end
+            return true
+        end)
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.cfg({
+            iproto_sched_classes = false,
+            iproto_sched_weight_system = 8,
+            iproto_sched_weight_interactive = 4,
+            iproto_sched_weight_batch = 1,
+            iproto_sched_batch_users = box.NULL,
+        })
+        box.space.log:truncate()
+    end)
+end)
+
+-- Returns the rows logged so far and clears the log.
+local function fetch_log(cg)
+    return cg.server:exec(function()
+        local order = box.space.log:pairs():map(function(tuple)
+            return tuple[2]
+        end):totable()
+        box.space.log:truncate()
+        return order
+    end)
+end
+
+-- Blocks tx, sends a burst of CALL requests over one connection and
+-- a burst of INSERT requests over another one (or the same if
+-- same_connection is set) and returns the order in which they were
+-- executed.
+local function execute_burst(cg, same_connection)
+    local c0 = net.connect(cg.server.net_box_uri)
+    local c1 = net.connect(cg.server.net_box_uri)
+    local c2 = same_connection and c1 or net.connect(cg.server.net_box_uri)
+    local block = c0:call('block', {}, {is_async = true})
+    fiber.sleep(0.05)
+    local futures = {}
+    for _ = 1, 20 do
+        table.insert(futures, c1:call('log', {'call'}, {is_async = true}))
+    end
+    for _ = 1, 20 do
+        table.insert(futures, c2.space.log:insert({box.NULL, 'insert'},
+                                                  {is_async = true}))
+    end
+    t.assert(block:wait_result())
+    for _, future in ipairs(futures) do
+        t.assert(future:wait_result())
+    end
+    c0:close()
+    c1:close()
+    c2:close()
+    return fetch_log(cg)
+end
+
+local function tx_queue_stat(cg)
+    return cg.server:exec(function()
+        return box.stat.tx_queue()
+    end)
+end
+
+-- Checks that cheap requests aren't delayed by a burst of heavy ones
+-- if requests are queued by scheduling class.
+g.test_sched_classes = function(cg)
+    local expected = {}
+    for i = 1, 20 do
+        expected[i] = 'call'
+        expected[i + 20] = 'insert'
+    end
+    -- Requests are executed in order by default.
+    t.assert_equals(execute_burst(cg), expected)
+
+    local old_stat = tx_queue_stat(cg)
+    cg.server:exec(function()
+        box.cfg({
+            iproto_sched_classes = true,
+            iproto_sched_weight_interactive = 1000,
+        })
+    end)
+    local order = execute_burst(cg)
+    t.assert_equals(#order, 40)
+    -- Inserts overtake calls sent over another connection.
+    t.assert_equals(order[#order], 'call')
+    local new_stat = tx_queue_stat(cg)
+    t.assert_ge(new_stat.batch.total - old_stat.batch.total, 20)
+    t.assert_ge(new_stat.interactive.total - old_stat.interactive.total, 20)
+    t.assert_equals(new_stat.batch.current, 0)
+    t.assert_ge(new_stat.batch.wait_time, old_stat.batch.wait_time)
+end
+
+-- Checks that requests of one connection are executed in the order
+-- they were sent even if they belong to different classes.
+g.test_connection_fifo = function(cg)
+    cg.server:exec(function()
+        box.cfg({
+            iproto_sched_classes = true,
+            iproto_sched_weight_interactive = 1000,
+        })
+    end)
+    local expected = {}
+    for i = 1, 20 do
+        expected[i] = 'call'
+        expected[i + 20] = 'insert'
+    end
+    t.assert_equals(execute_burst(cg, true), expected)
+
+    -- A call sees the result of an insert sent before it.
+    local c = net.connect(cg.server.net_box_uri)
+    local futures = {}
+    for _ = 1, 10 do
+        table.insert(futures, {
+            c.space.log:insert({box.NULL, 'insert'}, {is_async = true}),
+            c:call('last', {}, {is_async = true}),
+        })
+    end
+    for _, f in ipairs(futures) do
+        local tuple = f[1]:wait_result()
+        t.assert_equals(f[2]:wait_result(), tuple)
+    end
+    c:close()
+end
+
+-- Returns an AUTH request packet for the given user.
+local function auth_request(sync, salt, user, password)
+    local function xor(a, b)
+        local res = {}
+        for i = 1, #a do
+            res[i] = string.char(bit.bxor(a:byte(i), b:byte(i)))
+        end
+        return table.concat(res)
+    end
+    local hash1 = digest.sha1(password)
+    local hash2 = digest.sha1(hash1)
+    local scramble = xor(hash1, digest.sha1(salt:sub(1, 20) .. hash2))
+    return box.iproto.encode_packet({
+        request_type = box.iproto.type.AUTH,
+        sync = sync,
+    }, {
+        [box.iproto.key.USER_NAME] = user,
+        [box.iproto.key.TUPLE] = {'chap-sha1', scramble},
+    })
+end
+
+-- Returns a CALL request packet.
+local function call_request(sync, name, args, header)
+    header = header or {}
+    header.request_type = box.iproto.type.CALL
+    header.sync = sync
+    return box.iproto.encode_packet(header, {
+        [box.iproto.key.FUNCTION_NAME] = name,
+        [box.iproto.key.TUPLE] = args,
+    })
+end
+
+-- Reads replies from a socket until the one with the given sync.
+local function read_reply(s, sync)
+    local buf = ''
+    local pos = 1
+    while true do
+        local header, body, next_pos = box.iproto.decode_packet(buf, pos)
+        if header == nil then
+            local data = s:read(body)
+            t.assert(data ~= nil and data ~= '')
+            buf = buf .. data
+        elseif header.sync == sync then
+            return header, body
+        else
+            pos = next_pos
+        end
+    end
+end
+
+-- Checks that a call sent after an AUTH request without waiting for
+-- the reply is executed on behalf of the authenticated user.
+g.test_auth_fifo = function(cg)
+    cg.server:exec(function()
+        box.cfg({iproto_sched_classes = true})
+    end)
+    local s = socket.tcp_connect('unix/', cg.server.net_box_uri)
+    t.assert(s)
+    local greeting = box.iproto.decode_greeting(
+        s:read(box.iproto.GREETING_SIZE))
+    s:write(auth_request(1, greeting.salt, 'alice', 'secret') ..
+            call_request(2, 'user', {}))
+    local header, body = read_reply(s, 2)
+    t.assert_equals(header.request_type, box.iproto.type.OK)
+    t.assert_equals(body.data[1], 'alice')
+    s:close()
+end
+
+-- Checks that the scheduling class can be set in the request header.
+g.test_header_class = function(cg)
+    cg.server:exec(function()
+        box.cfg({iproto_sched_classes = true})
+    end)
+    local s = socket.tcp_connect('unix/', cg.server.net_box_uri)
+    t.assert(s)
+    box.iproto.decode_greeting(s:read(box.iproto.GREETING_SIZE))
+    local function run(header)
+        local requests = {}
+        for i = 1, 10 do
+            table.insert(requests, call_request(i, 'log', {'call'}, header))
+        end
+        s:write(table.concat(requests))
+        read_reply(s, 10)
+    end
+    local old_stat = tx_queue_stat(cg)
+    run({sched_class = 1})
+    local new_stat = tx_queue_stat(cg)
+    t.assert_ge(new_stat.interactive.total - old_stat.interactive.total, 10)
+    t.assert_lt(new_stat.batch.total - old_stat.batch.total, 10)
+    old_stat = new_stat
+    -- An invalid class is ignored.
+    run({sched_class = 100})
+    new_stat = tx_queue_stat(cg)
+    t.assert_ge(new_stat.batch.total - old_stat.batch.total, 10)
+    s:close()
+end
+
+-- Checks that requests of the listed users go to the batch class.
+g.test_batch_users = function(cg)
+    cg.server:exec(function()
+        box.cfg({
+            iproto_sched_classes = true,
+            iproto_sched_batch_users = {'alice'},
+        })
+    end)
+    local c = net.connect(cg.server.net_box_uri, {
+        user = 'alice', password = 'secret',
+    })
+    local old_stat = tx_queue_stat(cg)
+    for _ = 1, 10 do
+        c.space.log:select()
+    end
+    local new_stat = tx_queue_stat(cg)
+    t.assert_ge(new_stat.batch.total - old_stat.batch.total, 10)
+    t.assert_lt(new_stat.interactive.total - old_stat.interactive.total, 10)
+    t.assert_equals(c:call('user'), 'alice')
+    c:close()
+end
+
+-- Checks that invalid scheduling options are rejected.
+g.test_invalid_cfg = function(cg)
+    cg.server:exec(function()
+        for _, name in ipairs({'iproto_sched_weight_system',
+                               'iproto_sched_weight_interactive',
+                               'iproto_sched_weight_batch'}) do
+            local msg = "Incorrect value for option '" .. name ..
+                        "': must be in range [1, 1000]"
+            t.assert_error_msg_equals(msg, box.cfg, {[name] = 0})
+            t.assert_error_msg_equals(msg, box.cfg, {[name] = 1001})
+        end
+        t.assert_error_msg_equals(
+            "Incorrect value for option 'iproto_sched_batch_users': " ..
+            "must be an array of user names",
+            box.cfg, {iproto_sched_batch_users = {''}})
+        t.assert_equals(box.cfg.iproto_sched_weight_batch, 1)
+    end)
+end
+
+-- Checks that disconnect triggers run after all requests received
+-- before the connection was closed.
+g.test_disconnect_with_queued_requests = function(cg)
+    cg.server:exec(function()
+        box.cfg({iproto_sched_classes = true})
+        rawset(_G, 'log_disconnect', function()
+            _G.log('disconnect')
+        end)
+        box.session.on_disconnect(_G.log_disconnect)
+    end)
+    local space_id = cg.server:exec(function()
+        return box.space.log.id
+    end)
+    local s = socket.tcp_connect('unix/', cg.server.net_box_uri)
+    t.assert(s)
+    box.iproto.decode_greeting(s:read(box.iproto.GREETING_SIZE))
+    -- Block tx so that the requests and the disconnect are fetched
+    -- by it at once.
+    s:write(call_request(1, 'block', {}))
+    fiber.sleep(0.05)
+    local requests = {}
+    for i = 1, 10 do
+        table.insert(requests, call_request(i + 1, 'log', {'call'}))
+        table.insert(requests, box.iproto.encode_packet({
+            request_type = box.iproto.type.INSERT,
+            sync = i + 100,
+        }, {
+            [box.iproto.key.SPACE_ID] = space_id,
+            [box.iproto.key.TUPLE] = {box.NULL, 'insert'},
+        }))
+    end
+    s:write(table.concat(requests))
+    s:close()
+    t.helpers.retrying({}, function()
+        cg.server:exec(function()
+            t.assert_equals(box.space.log:count(), 21)
+        end)
+    end)
+    local order = cg.server:exec(function()
+        box.session.on_disconnect(nil, _G.log_disconnect)
+        return box.space.log:pairs():map(function(tuple)
+            return tuple[2]
+        end):totable()
+    end)
+    local expected = {}
+    for _ = 1, 10 do
+        table.insert(expected, 'call')
+        table.insert(expected, 'insert')
+    end
+    table.insert(expected, 'disconnect')
+    t.assert_equals(order, expected)
+end
@@ -0,0 +1,70 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        local sizes = {0, 10, 100, 4000, 4096, 10000, 100000, 300000}
+        box.begin()
+        for id = 1, 500 do
+            s:insert({id, string.rep('x', sizes[id % #sizes + 1])})
+        end
+        box.commit()
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.cfg{iproto_tuple_ref_min_size = 4096}
+    end)
+end)
+
+-- Checks that SELECT replies with tuples sent right from the tuple
+-- memory are the same as the ones with copied tuples.
+g.test_tuple_ref = function(cg)
+    local function check(min_size)
+        cg.server:exec(function(min_size)
+            box.cfg{iproto_tuple_ref_min_size = min_size}
+        end, {min_size})
+        local c = net.connect(cg.server.net_box_uri)
+        local s = c.space.test
+        local expected = cg.server:exec(function()
+            return box.space.test:select()
+        end)
+        t.assert_equals(s:select(), expected)
+        t.assert_equals(s:select({100}, {iterator = 'le', limit = 10}),
+                        cg.server:exec(function()
+                            return box.space.test:select({100}, {
+                                iterator = 'le', limit = 10})
+                        end))
+        local res, pos = s:select({}, {limit = 7, fetch_pos = true})
+        t.assert_equals(res, {unpack(expected, 1, 7)})
+        res = s:select({}, {limit = 7, after = pos})
+        t.assert_equals(res, {unpack(expected, 8, 14)})
+        -- Interleave replies of concurrent requests.
+        local futures = {}
+        for i = 1, 50 do
+            table.insert(futures, s:select({i * 10}, {
+                iterator = 'ge', limit = 10, is_async = true}))
+        end
+        for i, future in ipairs(futures) do
+            t.assert_equals(future:wait_result(),
+                            {unpack(expected, i * 10, i * 10 + 9)})
+        end
+        c:close()
+    end
+    check(0)
+    check(1)
+    check(4096)
+    check(400000)
+end
@@ -0,0 +1,46 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new({
+        box_cfg = {
+            memtx_huge_pages = true,
+            memtx_numa_node = 0,
+        },
+    })
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that memtx works with huge pages and NUMA placement enabled.
+g.test_memtx_arena_placement = function(cg)
+    cg.server:exec(function()
+        t.assert_equals(box.cfg.memtx_huge_pages, true)
+        t.assert_equals(box.cfg.memtx_numa_node, 0)
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for i = 1, 1000 do
+            s:insert({i, string.rep('x', 1000)})
+        end
+        t.assert_equals(s:count(), 1000)
+        t.assert_equals(s:get(500)[1], 500)
+        s:drop()
+    end)
+end
+
+-- Checks that the options can't be changed dynamically.
+g.test_memtx_arena_placement_nondynamic = function(cg)
+    cg.server:exec(function()
+        t.assert_error_msg_content_equals(
+            "Can't set option 'memtx_huge_pages' dynamically",
+            box.cfg, {memtx_huge_pages = false})
+        t.assert_error_msg_content_equals(
+            "Can't set option 'memtx_numa_node' dynamically",
+            box.cfg, {memtx_numa_node = 1})
+    end)
+end
@@ -0,0 +1,161 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:stop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+-- Checks that index:compact() relocates memtx tuples in the background
+-- and keeps all indexes consistent.
+g.test_memtx_defrag = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+        s:create_index('hash', {type = 'hash', parts = {3, 'string'}})
+        box.begin()
+        for i = 1, 1000 do
+            s:insert({i, i % 10, tostring(i), string.rep('x', 100)})
+        end
+        box.commit()
+        box.begin()
+        for i = 1, 1000 do
+            if i % 10 ~= 0 then
+                s:delete(i)
+            end
+        end
+        box.commit()
+        local data = s:select()
+        local relocated = box.stat.memtx().defrag.relocated
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.memtx().defrag.queue, 0)
+        end)
+        t.assert_equals(box.stat.memtx().defrag.relocated - relocated, 100)
+        t.assert_equals(s:select(), data)
+        t.assert_equals(s.index.sk:select({0}), data)
+        for _, tuple in ipairs(data) do
+            t.assert_equals(s.index.hash:get(tuple[3]), tuple)
+        end
+        t.assert_equals(s:len(), 100)
+    end)
+end
+
+-- Checks that spaces with functional indexes are not defragmented.
+g.test_memtx_defrag_func_index = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.schema.func.create('test_func', {
+            body = 'function(t) return {t[1]} end',
+            is_deterministic = true, is_sandboxed = true,
+        })
+        s:create_index('func', {func = 'test_func',
+                                parts = {{1, 'unsigned'}}})
+        for i = 1, 10 do
+            s:insert({i})
+        end
+        local relocated = box.stat.memtx().defrag.relocated
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.memtx().defrag.queue, 0)
+        end)
+        t.assert_equals(box.stat.memtx().defrag.relocated, relocated)
+        t.assert_equals(s.index.func:select(), s:select())
+        s:drop()
+        box.schema.func.drop('test_func')
+    end)
+end
+
+-- Checks that tuples aren't relocated while an index is being built.
+g.test_memtx_defrag_index_build = function(cg)
+    t.tarantool.skip_if_not_debug()
+    cg.server:exec(function()
+        local fiber = require('fiber')
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        for i = 1, 100 do
+            s:insert({i, i})
+        end
+        box.error.injection.set('ERRINJ_BUILD_INDEX_DELAY', true)
+        local f = fiber.create(function()
+            s:create_index('sk', {parts = {2, 'unsigned'}})
+        end)
+        f:set_joinable(true)
+        local relocated = box.stat.memtx().defrag.relocated
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.memtx().defrag.queue, 0)
+        end)
+        t.assert_equals(box.stat.memtx().defrag.relocated, relocated)
+        box.error.injection.set('ERRINJ_BUILD_INDEX_DELAY', false)
+        t.assert_equals({f:join()}, {true})
+        t.assert_equals(s.index.sk:select(), s:select())
+    end)
+end
+
+-- Checks that user on_replace triggers don't prevent defragmentation.
+g.test_memtx_defrag_user_trigger = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        local count = 0
+        s:on_replace(function() count = count + 1 end)
+        box.begin()
+        for i = 1, 1000 do
+            s:insert({i, string.rep('x', 100)})
+        end
+        box.commit()
+        box.begin()
+        for i = 1, 1000 do
+            if i % 10 ~= 0 then
+                s:delete(i)
+            end
+        end
+        box.commit()
+        count = 0
+        local relocated = box.stat.memtx().defrag.relocated
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.memtx().defrag.queue, 0)
+        end)
+        t.assert_equals(box.stat.memtx().defrag.relocated - relocated, 100)
+        t.assert_equals(count, 0)
+        t.assert_equals(s:len(), 100)
+    end)
+end
+
+-- Checks that tuples of size classes that aren't fragmented are not
+-- relocated.
+g.test_memtx_defrag_dense = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.begin()
+        for i = 1, 100 do
+            s:insert({i, string.rep('x', 3000)})
+        end
+        box.commit()
+        local relocated = box.stat.memtx().defrag.relocated
+        s.index.pk:compact()
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.stat.memtx().defrag.queue, 0)
+        end)
+        t.assert_equals(box.stat.memtx().defrag.relocated, relocated)
+    end)
+end
@@ -0,0 +1,193 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.schema.func.create('is_active', {
+            is_deterministic = true,
+            is_sandboxed = true,
+            body = 'function(t) return t[3] == "active" end',
+        })
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:stop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end)
+
+-- Checks that a partial index stores only tuples matching the filter.
+g.test_partial_index = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:insert({1, 10, 'active'})
+        s:insert({2, 20, 'inactive'})
+        local sk = s:create_index('sk', {
+            parts = {2, 'unsigned'}, filter = 'is_active',
+        })
+        local fid = box.func.is_active.id
+        t.assert_equals(sk.filter, {fid = fid, name = 'is_active'})
+        t.assert_equals(sk:select(), {{1, 10, 'active'}})
+
+        s:insert({3, 30, 'active'})
+        s:insert({4, 40, 'inactive'})
+        t.assert_equals(sk:select(), {{1, 10, 'active'}, {3, 30, 'active'}})
+        t.assert_equals(sk:count(), 2)
+
+        -- Tuples enter and leave the index on update.
+        s:update(2, {{'=', 3, 'active'}})
+        s:update(1, {{'=', 3, 'inactive'}})
+        t.assert_equals(sk:select(), {{2, 20, 'active'}, {3, 30, 'active'}})
+        s:delete(3)
+        t.assert_equals(sk:select(), {{2, 20, 'active'}})
+
+        -- Uniqueness is checked only among matching tuples.
+        s:insert({5, 20, 'inactive'})
+        t.assert_error_msg_contains('Duplicate key exists',
+                                    s.insert, s, {6, 20, 'active'})
+        -- Deleting a filtered out tuple keeps a matching one with
+        -- the same key.
+        s:delete(5)
+        t.assert_equals(sk:get(20), {2, 20, 'active'})
+
+        -- The filter function is pinned by the index.
+        t.assert_error_msg_contains('function is referenced by index filter',
+                                    box.schema.func.drop, 'is_active')
+    end)
+end
+
+-- Checks that a partial index survives restart.
+g.test_partial_index_recovery = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}, filter = 'is_active'})
+        for i = 1, 10 do
+            s:insert({i, i, i % 2 == 0 and 'active' or 'inactive'})
+        end
+        box.snapshot()
+        s:insert({11, 11, 'active'})
+    end)
+    cg.server:restart()
+    cg.server:exec(function()
+        local sk = box.space.test.index.sk
+        t.assert_equals(sk:select({}, {iterator = 'ge'}), {
+            {2, 2, 'active'}, {4, 4, 'active'}, {6, 6, 'active'},
+            {8, 8, 'active'}, {10, 10, 'active'}, {11, 11, 'active'},
+        })
+        t.assert_error_msg_contains('function is referenced by index filter',
+                                    box.schema.func.drop, 'is_active')
+    end)
+end
+
+-- Checks invalid partial index definitions.
+g.test_partial_index_errors = function(cg)
+    cg.server:exec(function()
+        box.schema.func.create('not_deterministic', {
+            body = 'function(t) return true end',
+        })
+        box.schema.func.create('not_bool', {
+            is_deterministic = true,
+            is_sandboxed = true,
+            body = 'function(t) return t[2] end',
+        })
+        local s = box.schema.space.create('test')
+        t.assert_error_msg_equals(
+            'Wrong index options: filter is allowed only for secondary index',
+            s.create_index, s, 'pk', {filter = 'is_active'})
+        s:create_index('pk')
+        t.assert_error_msg_equals(
+            "Function 'no_such_func' does not exist",
+            s.create_index, s, 'sk', {filter = 'no_such_func'})
+        t.assert_error_msg_equals(
+            "Wrong index options: function 'not_deterministic' doesn't " ..
+            "meet index filter function criteria (stored, deterministic, " ..
+            "written in Lua)",
+            s.create_index, s, 'sk', {filter = 'not_deterministic'})
+        t.assert_error_msg_equals(
+            "HASH does not support partial indexes",
+            s.create_index, s, 'sk',
+            {type = 'hash', filter = 'is_active'})
+
+        s:create_index('sk', {parts = {2, 'unsigned'}, filter = 'not_bool'})
+        t.assert_error_msg_equals(
+            "Failed to evaluate filter function of partial index 'sk' " ..
+            "of space 'test': function must return a boolean",
+            s.insert, s, {1, 1})
+        t.assert_equals(s:select(), {})
+        box.space.test.index.sk:drop()
+        box.schema.func.drop('not_deterministic')
+        box.schema.func.drop('not_bool')
+    end)
+end
+
+-- Checks that rollback doesn't call the filter function.
+g.test_partial_index_rollback = function(cg)
+    cg.server:exec(function()
+        box.schema.func.create('is_active_counted', {
+            is_deterministic = true,
+            body = [[function(t)
+                rawset(_G, 'filter_calls', (rawget(_G, 'filter_calls') or 0) + 1)
+                return t[3] == 'active'
+            end]],
+        })
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        local sk = s:create_index('sk', {
+            parts = {2, 'unsigned'}, filter = 'is_active_counted',
+        })
+        s:create_index('uk', {parts = {4, 'unsigned'}})
+        s:insert({1, 10, 'active', 1})
+        s:insert({2, 20, 'inactive', 2})
+        s:insert({3, 30, 'active', 3})
+
+        box.begin()
+        s:update(1, {{'=', 3, 'inactive'}})
+        s:update(2, {{'=', 3, 'active'}})
+        s:delete(3)
+        local calls = rawget(_G, 'filter_calls')
+        box.rollback()
+        t.assert_equals(rawget(_G, 'filter_calls'), calls)
+        t.assert_equals(sk:select(), {{1, 10, 'active', 1},
+                                      {3, 30, 'active', 3}})
+
+        -- A failure in the next index rolls back the partial one.
+        t.assert_error_msg_contains('Duplicate key exists',
+                                    s.replace, s, {1, 15, 'active', 3})
+        t.assert_equals(sk:select(), {{1, 10, 'active', 1},
+                                      {3, 30, 'active', 3}})
+        s:drop()
+        box.schema.func.drop('is_active_counted')
+    end)
+end
+
+-- Checks that a partial index can't be forced in SQL.
+g.test_partial_index_sql_indexed_by = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.space.create('test', {format = {
+            {'id', 'unsigned'}, {'v', 'unsigned'}, {'status', 'string'},
+        }})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {'v'}, filter = 'is_active'})
+        s:insert({1, 10, 'active'})
+        s:insert({2, 20, 'inactive'})
+        local _, err = box.execute([[SELECT "id" FROM "test"
+                                     INDEXED BY "sk" WHERE "v" > 0;]])
+        t.assert_equals(err.message,
+                        "SQL does not support INDEXED BY a partial index")
+        local res = box.execute([[SELECT "id" FROM "test" WHERE "v" > 0;]])
+        t.assert_equals(res.rows, {{1}, {2}})
+    end)
+end
@@ -0,0 +1,161 @@
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        rawset(_G, 'echo', function(...) return ... end)
+        rawset(_G, 'cond', require('fiber').cond())
+        rawset(_G, 'block', function() _G.cond:wait() end)
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.conn = net.connect(cg.server.net_box_uri)
+end)
+
+g.after_each(function(cg)
+    cg.conn:close()
+    cg.server:exec(function()
+        _G.cond:broadcast()
+        box.space.test:truncate()
+    end)
+end)
+
+-- Checks that requests of a pipeline are completed together.
+g.test_pipeline = function(cg)
+    local c = cg.conn
+    local p = c:pipeline()
+    t.assert_equals(tostring(p), 'net.box.pipeline')
+    t.assert(p:is_ready())
+    t.assert(p:wait(0))
+    local futures = {}
+    for i = 1, 100 do
+        table.insert(futures, p:call('echo', {i}))
+        table.insert(futures, c.space.test:insert(
+            {i}, {is_async = true, pipeline = p}))
+    end
+    table.insert(futures, p:eval('return ...', {'foo'}))
+    table.insert(futures, p:execute('SELECT 1 AS x'))
+    t.assert(p:wait(10))
+    t.assert(p:is_ready())
+    for i = 1, 100 do
+        t.assert_equals(futures[2 * i - 1]:result(), {i})
+        t.assert_equals(futures[2 * i]:result(), {i})
+    end
+    t.assert_equals(futures[201]:result(), {'foo'})
+    t.assert_equals(futures[202]:result().rows, {{1}})
+    t.assert_equals(c.space.test:count(), 100)
+
+    -- A pipeline can be reused after all its requests are completed.
+    local future = p:call('echo', {'bar'}, {return_raw = true})
+    t.assert(p:wait(10))
+    t.assert_equals(future:result():decode(), {'bar'})
+end
+
+-- Checks that the completion callback is invoked once per batch.
+g.test_on_complete = function(cg)
+    local c = cg.conn
+    local results = {}
+    local p = c:pipeline({on_complete = function(p)
+        t.assert(p:is_ready())
+        table.insert(results, 'done')
+    end})
+    local futures = {}
+    for i = 1, 10 do
+        table.insert(futures, p:call('echo', {i}))
+    end
+    t.assert(p:wait(10))
+    t.helpers.retrying({}, function()
+        t.assert_equals(results, {'done'})
+    end)
+    for i, future in ipairs(futures) do
+        t.assert_equals(future:result(), {i})
+    end
+    p:call('echo', {})
+    p:call('echo', {})
+    t.helpers.retrying({}, function()
+        t.assert_equals(results, {'done', 'done'})
+    end)
+end
+
+-- Checks that waiting for a pipeline respects the timeout.
+g.test_timeout = function(cg)
+    local c = cg.conn
+    local p = c:pipeline()
+    local future1 = p:call('echo', {1})
+    local future2 = p:call('block')
+    t.assert_not(p:wait(0.01))
+    t.assert_not(p:is_ready())
+    t.assert_equals(future1:wait_result(10), {1})
+    t.assert_not(future2:is_ready())
+    cg.server:exec(function() _G.cond:broadcast() end)
+    t.assert(p:wait(10))
+    t.assert_equals(future2:result(), {})
+    t.assert_error_msg_contains('Usage: pipeline:wait(timeout)',
+                                p.wait, p, -1)
+end
+
+-- Checks that a pipeline is completed if its requests are discarded
+-- or the connection is closed.
+g.test_abort = function(cg)
+    local c = cg.conn
+    local p = c:pipeline()
+    p:call('block'):discard()
+    t.assert(p:wait(0))
+
+    -- Futures collected by GC.
+    local function call()
+        for _ = 1, 10 do
+            p:call('block')
+        end
+    end
+    call()
+    t.assert_not(p:is_ready())
+    collectgarbage()
+    collectgarbage()
+    t.assert(p:wait(0))
+
+    local future = p:call('block')
+    c:close()
+    t.assert(p:wait(0))
+    local _, err = future:result()
+    t.assert_equals(err.message, 'Connection closed')
+end
+
+-- Checks invalid usage of pipelines.
+g.test_errors = function(cg)
+    local c = cg.conn
+    local p = c:pipeline()
+    t.assert_error_msg_equals(
+        "Illegal parameters, unexpected option 'foo'",
+        c.pipeline, c, {foo = 1})
+    t.assert_error_msg_equals(
+        "Illegal parameters, options parameter 'on_complete' should be of " ..
+        "type function", c.pipeline, c, {on_complete = 1})
+    t.assert_error_msg_equals(
+        "Illegal parameters, options parameter 'pipeline' should be of " ..
+        "type net.box.pipeline", c.call, c, 'echo', {}, {pipeline = {}})
+    t.assert_error_msg_contains(
+        'Only async requests can be added to a pipeline',
+        c.call, c, 'echo', {}, {pipeline = p})
+    local c2 = net.connect(cg.server.net_box_uri)
+    t.assert_error_msg_contains(
+        'The pipeline belongs to another connection',
+        c2.call, c2, 'echo', {}, {is_async = true, pipeline = p})
+    c2:close()
+    t.assert_error_msg_equals(
+        'Use pipeline:call(...) instead of pipeline.call(...)',
+        p.call, 'echo')
+    t.assert(p:is_ready())
+end
@@ -0,0 +1,112 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group('select_fields', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function(engine)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}})
+        for i = 1, 5 do
+            s:insert({i, 10 - i, 'x' .. i, {i}})
+        end
+    end, {cg.params.engine})
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.space.test:drop()
+    end)
+end)
+
+-- Checks that select returns only the requested fields.
+g.test_select_fields = function(cg)
+    cg.server:exec(function()
+        local s = box.space.test
+        t.assert_equals(s:select({}, {fields = {1, 3}}), {
+            {1, 'x1'}, {2, 'x2'}, {3, 'x3'}, {4, 'x4'}, {5, 'x5'},
+        })
+        t.assert_equals(s.index.sk:select({7}, {iterator = 'le',
+                                                fields = {4, 2}}), {
+            {{3}, 7}, {{4}, 6}, {{5}, 5},
+        })
+        t.assert_equals(s:select({2}, {fields = {5, 1}}), {{box.NULL, 2}})
+        t.assert_equals(s:select({2}, {fields = {}}), {{}})
+        t.assert_equals(type(s:select({1}, {fields = {1}})[1]), 'table')
+        local res, pos = s:select({}, {limit = 2, fetch_pos = true,
+                                       fields = {3}})
+        t.assert_equals(res, {{'x1'}, {'x2'}})
+        t.assert_equals(s:select({}, {after = pos, fields = {3}}),
+                        {{'x3'}, {'x4'}, {'x5'}})
+    end)
+end
+
+-- Checks that invalid field lists are rejected.
+g.test_select_fields_invalid = function(cg)
+    cg.server:exec(function()
+        local s = box.space.test
+        local msg = "Illegal parameters, options parameter 'fields' " ..
+                    "should be a table of field numbers"
+        t.assert_error_msg_equals(msg, s.select, s, {}, {fields = 1})
+        t.assert_error_msg_equals(msg, s.select, s, {}, {fields = {0}})
+        t.assert_error_msg_equals(msg, s.select, s, {}, {fields = {'a'}})
+        t.assert_error_msg_equals(msg, s.select, s, {}, {fields = {1.5}})
+    end)
+end
+
+local g_net = t.group('select_fields_net_box')
+
+g_net.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test', {
+            format = {{'a', 'unsigned'}, {'b', 'unsigned'}, {'c', 'string'}},
+        })
+        s:create_index('pk')
+        for i = 1, 3 do
+            s:insert({i, 10 - i, 'x' .. i})
+        end
+    end)
+end)
+
+g_net.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that select over net.box returns only the requested fields.
+g_net.test_select_fields = function(cg)
+    local net = require('net.box')
+    local c = net.connect(cg.server.net_box_uri)
+    t.assert(c.peer_protocol_features.select_fields)
+    local s = c.space.test
+    t.assert_equals(s:select({}, {fields = {3, 1}}),
+                    {{'x1', 1}, {'x2', 2}, {'x3', 3}})
+    t.assert_equals(s:select({2}, {fields = {4, 2}}), {{box.NULL, 8}})
+    -- Projected tuples don't have the space format.
+    t.assert_equals(s:select({1}, {fields = {3}})[1].c, nil)
+    local res, pos = s:select({}, {limit = 1, fetch_pos = true,
+                                   fields = {2}})
+    t.assert_equals(res, {{9}})
+    t.assert_equals(s:select({}, {after = pos, fields = {2}}), {{8}, {7}})
+    local f = s:select({}, {fields = {1}, is_async = true})
+    t.assert_equals(f:wait_result(), {{1}, {2}, {3}})
+    local msg = "Illegal parameters, options parameter 'fields' " ..
+                "should be a table of field numbers"
+    t.assert_error_msg_equals(msg, s.select, s, {}, {fields = {0}})
+    t.assert_error_msg_contains("doesn't support `fields` argument",
+                                s.cursor, s, {}, {fields = {1}})
+    c:close()
+end
@@ -0,0 +1,115 @@
+local fio = require('fio')
+local net = require('net.box')
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+-- The server side requires memfd sealing.
+local is_server_supported = jit.os ~= 'OSX'
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.shm_uri = 'unix/:' .. fio.pathjoin(cg.server.workdir, 'shm.sock') ..
+                 '?transport=shm'
+    cg.server:exec(function(shm_uri, is_server_supported)
+        if is_server_supported then
+            box.cfg({listen = {box.cfg.listen, shm_uri}})
+        end
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        rawset(_G, 'echo', function(...) return ... end)
+    end, {cg.shm_uri, is_server_supported})
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that requests and replies are transferred correctly over
+-- shared memory, including ones that don't fit in a ring at once.
+g.test_shm_transport = function(cg)
+    t.skip_if(not is_server_supported, 'memfd sealing is unavailable')
+    local c = net.connect(cg.shm_uri)
+    t.assert_equals(c.state, 'active')
+    t.assert(c:ping())
+    t.assert_equals(c:call('echo', {1, 2, 3}), {1, 2, 3})
+    t.assert_equals(c.space.test:insert({1, 'a'}), {1, 'a'})
+    t.assert_equals(c.space.test:select(), {{1, 'a'}})
+
+    -- Bigger than a ring.
+    local arg = string.rep('x', 3 * 1024 * 1024)
+    t.assert_equals(c:call('echo', {arg}), arg)
+
+    -- Many concurrent requests.
+    local futures = {}
+    for i = 1, 1000 do
+        table.insert(futures, c:call('echo', {i, string.rep('y', i * 10)},
+                                     {is_async = true}))
+    end
+    for i, future in ipairs(futures) do
+        t.assert_equals(future:wait_result(), {i, string.rep('y', i * 10)})
+    end
+
+    -- The server notices when the client closes the connection.
+    local count = cg.server:exec(function()
+        return box.stat.net().CONNECTIONS.current
+    end)
+    c:close()
+    t.helpers.retrying({}, function()
+        t.assert_equals(cg.server:exec(function()
+            return box.stat.net().CONNECTIONS.current
+        end), count - 1)
+    end)
+end
+
+-- Checks that the server closes the connection if the client dies.
+g.test_client_exit = function(cg)
+    t.skip_if(not is_server_supported, 'memfd sealing is unavailable')
+    local client = server:new({alias = 'client'})
+    client:start()
+    local count = cg.server:exec(function()
+        return box.stat.net().CONNECTIONS.current
+    end)
+    client:exec(function(shm_uri)
+        local c = require('net.box').connect(shm_uri)
+        t.assert_equals(c.state, 'active')
+        rawset(_G, 'conn', c)
+    end, {cg.shm_uri})
+    t.helpers.retrying({}, function()
+        t.assert_equals(cg.server:exec(function()
+            return box.stat.net().CONNECTIONS.current
+        end), count + 1)
+    end)
+    client:drop()
+    t.helpers.retrying({}, function()
+        t.assert_equals(cg.server:exec(function()
+            return box.stat.net().CONNECTIONS.current
+        end), count)
+    end)
+end
+
+-- Checks that the shared memory transport can only be used with Unix
+-- sockets.
+g.test_invalid_uri = function(cg)
+    cg.server:exec(function()
+        t.assert_error_msg_equals(
+            'Transport shm requires a Unix socket',
+            box.cfg, {listen = 'localhost:0?transport=shm'})
+    end)
+    t.assert_error_msg_equals(
+        'Transport shm requires a Unix socket',
+        net.connect, {'localhost:3301', params = {transport = 'shm'}})
+end
+
+-- Checks that the server side of the shared memory transport is
+-- rejected if memfd sealing is unavailable.
+g.test_server_unsupported = function(cg)
+    t.skip_if(is_server_supported, 'memfd sealing is available')
+    cg.server:exec(function(shm_uri)
+        t.assert_error_msg_equals(
+            'Transport shm is not supported by the server on this platform',
+            box.cfg, {listen = shm_uri})
+    end, {cg.shm_uri})
+end
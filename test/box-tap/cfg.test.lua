@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(113)
+test:plan(131)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -53,8 +53,26 @@ invalid('memtx_sort_threads', 'all')
 invalid('memtx_sort_threads', -1)
 invalid('memtx_sort_threads', 0)
 invalid('memtx_sort_threads', 257)
+invalid('memtx_numa_node', -1)
+invalid('memtx_numa_node', 1024)
 invalid('replication_synchro_queue_max_size', -1)
 invalid('replication_reconnect_timeout', -1)
+invalid('iproto_admission_target', -1)
+invalid('iproto_admission_interval', 0)
+invalid('iproto_listen_reuseport', 'yes')
+invalid('iproto_cursor_max', -1)
+invalid('iproto_compression_min_size', -1)
+invalid('iproto_tuple_ref_min_size', -1)
+invalid('iproto_sched_classes', 'yes')
+invalid('iproto_sched_weight_system', 0)
+invalid('iproto_sched_weight_system', 1001)
+invalid('iproto_sched_weight_interactive', 0)
+invalid('iproto_sched_weight_interactive', 1001)
+invalid('iproto_sched_weight_batch', 0)
+invalid('iproto_sched_weight_batch', 1001)
+invalid('iproto_sched_batch_users', '')
+invalid('iproto_sched_batch_users', {''})
+invalid('sql_plan_cache_size', -1)
 
 local function invalid_combinations(name, val)
     local status, result = pcall(box.cfg, val)
@@ -445,8 +445,19 @@ g.test_iproto = function()
                 },
             },
             threads = 1,
+            listen_reuseport = true,
             net_msg_max = 1,
             readahead = 1,
+            admission_target = 1,
+            admission_interval = 1,
+            cursor_max = 1,
+            compression_min_size = 1,
+            tuple_ref_min_size = 1,
+            sched_classes = true,
+            sched_weight_system = 1,
+            sched_weight_interactive = 1,
+            sched_weight_batch = 1,
+            sched_batch_users = {'eleven'},
         },
     }
     instance_config:validate(iconfig)
@@ -457,8 +468,18 @@ g.test_iproto = function()
             client = box.NULL,
         },
         threads = 1,
+        listen_reuseport = false,
         net_msg_max = 768,
         readahead = 16320,
+        admission_target = 0.05,
+        admission_interval = 1,
+        cursor_max = 64,
+        compression_min_size = 1024,
+        tuple_ref_min_size = 4096,
+        sched_classes = false,
+        sched_weight_system = 8,
+        sched_weight_interactive = 4,
+        sched_weight_batch = 1,
     }
     local res = instance_config:apply_default({}).iproto
     t.assert_equals(res, exp)
@@ -512,8 +533,19 @@ g.test_iproto_enterprise = function()
                 },
             },
             threads = 1,
+            listen_reuseport = true,
             net_msg_max = 1,
             readahead = 1,
+            admission_target = 1,
+            admission_interval = 1,
+            cursor_max = 1,
+            compression_min_size = 1,
+            tuple_ref_min_size = 1,
+            sched_classes = true,
+            sched_weight_system = 1,
+            sched_weight_interactive = 1,
+            sched_weight_batch = 1,
+            sched_batch_users = {'eleven'},
         },
     }
     instance_config:validate(iconfig)
@@ -524,8 +556,18 @@ g.test_iproto_enterprise = function()
             client = box.NULL,
         },
         threads = 1,
+        listen_reuseport = false,
         net_msg_max = 768,
         readahead = 16320,
+        admission_target = 0.05,
+        admission_interval = 1,
+        cursor_max = 64,
+        compression_min_size = 1024,
+        tuple_ref_min_size = 4096,
+        sched_classes = false,
+        sched_weight_system = 8,
+        sched_weight_interactive = 4,
+        sched_weight_batch = 1,
     }
     local res = instance_config:apply_default({}).iproto
     t.assert_equals(res, exp)
@@ -962,6 +1004,7 @@ g.test_sql = function()
     local iconfig = {
         sql = {
             cache_size = 1,
+            plan_cache_size = 1,
         },
     }
     instance_config:validate(iconfig)
@@ -969,6 +1012,7 @@ g.test_sql = function()
 
     local exp = {
         cache_size = 5242880,
+        plan_cache_size = 5242880,
     }
     local res = instance_config:apply_default({}).sql
     t.assert_equals(res, exp)
@@ -984,6 +1028,8 @@ g.test_memtx = function()
             min_tuple_size = 1,
             max_tuple_size = 1,
             sort_threads = 1,
+            huge_pages = true,
+            numa_node = 1,
         },
     }
     instance_config:validate(iconfig)
@@ -997,6 +1043,8 @@ g.test_memtx = function()
         min_tuple_size = 16,
         max_tuple_size = 1048576,
         sort_threads = box.NULL,
+        huge_pages = false,
+        numa_node = box.NULL,
     }
     local res = instance_config:apply_default({}).memtx
     t.assert_equals(res, exp)
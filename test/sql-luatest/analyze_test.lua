@@ -0,0 +1,63 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group('analyze', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function(engine)
+        box.execute(([[CREATE TABLE t (id INT PRIMARY KEY, a INT, b INT)
+                       WITH ENGINE = '%s';]]):format(engine))
+        box.execute([[CREATE INDEX ia ON t(a);]])
+        box.execute([[CREATE INDEX ib ON t(b);]])
+        -- The value 1 of the column A is stored in 90% of the rows, the
+        -- rest of the values are unique.
+        box.begin()
+        for id = 1, 1000 do
+            box.space.T:insert({id, id % 10 == 0 and id or 1, id})
+        end
+        box.commit()
+    end, {cg.params.engine})
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that the statistics collected by ANALYZE are used to choose
+-- the index.
+g.test_analyze = function(cg)
+    cg.server:exec(function()
+        local function plan(sql)
+            local res = box.execute('EXPLAIN QUERY PLAN ' .. sql)
+            return res.rows[1][4]
+        end
+        local sql1 = 'SELECT * FROM t WHERE a = 1 AND b < 50'
+        local sql2 = 'SELECT * FROM t WHERE a = 20 AND b < 50'
+        local rows1 = box.execute(sql1).rows
+        local rows2 = box.execute(sql2).rows
+        -- Without the statistics the equality is considered to be more
+        -- selective than the range.
+        t.assert_str_contains(plan(sql1), 'INDEX IA')
+        t.assert_str_contains(plan(sql2), 'INDEX IA')
+
+        local _, err = box.execute('ANALYZE t')
+        t.assert_equals(err, nil)
+        t.assert_str_contains(plan(sql1), 'INDEX IB')
+        t.assert_str_contains(plan(sql2), 'INDEX IA')
+        t.assert_equals(box.execute(sql1).rows, rows1)
+        t.assert_equals(box.execute(sql2).rows, rows2)
+
+        -- The statistics are refreshed by ANALYZE of all spaces.
+        box.space.T:update({500}, {{'=', 2, 1}})
+        _, err = box.execute('ANALYZE')
+        t.assert_equals(err, nil)
+        t.assert_str_contains(plan(sql1), 'INDEX IB')
+
+        _, err = box.execute('ANALYZE unknown')
+        t.assert_equals(err.message, "Space 'UNKNOWN' does not exist")
+    end)
+end
@@ -0,0 +1,223 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        -- The same data is stored in a memtx space, which is aggregated
+        -- in batches, and in a vinyl space, which is aggregated row by row.
+        for _, name in ipairs({'T', 'V'}) do
+            local engine = name == 'T' and 'memtx' or 'vinyl'
+            box.execute(([[CREATE TABLE %s (id INT PRIMARY KEY, i INT,
+                                            u UNSIGNED, d DOUBLE, s STRING)
+                           WITH ENGINE = '%s';]]):format(name, engine))
+            box.execute(([[CREATE INDEX %s_U ON %s(u);]]):format(name, name))
+            local space = box.space[name]
+            box.begin()
+            for id = 1, 1000 do
+                local i = id % 7 == 0 and box.NULL or id % 100 - 50
+                local d = id % 11 == 0 and box.NULL or id % 60 - 25.5
+                space:insert({id, i, id % 300, d, tostring(id)})
+            end
+            box.commit()
+        end
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that simple aggregate queries over memtx spaces are executed in
+-- batches and return the same result as row-by-row execution.
+g.test_batch_aggregate = function(cg)
+    cg.server:exec(function()
+        local function uses_batch(sql, ...)
+            local res = box.execute('EXPLAIN ' .. sql, ...)
+            for _, row in ipairs(res.rows) do
+                if row[2] == 'BatchAggregate' then
+                    return true
+                end
+            end
+            return false
+        end
+        local function check(sql, ...)
+            local memtx_sql = sql:gsub('%$', 'T')
+            local vinyl_sql = sql:gsub('%$', 'V')
+            t.assert(uses_batch(memtx_sql, ...), sql)
+            t.assert_not(uses_batch(vinyl_sql, ...), sql)
+            local res, err = box.execute(memtx_sql, ...)
+            t.assert_equals(err, nil, sql)
+            t.assert_equals(res, box.execute(vinyl_sql, ...), sql)
+            return res.rows
+        end
+        for _, col in ipairs({'i', 'u', 'd'}) do
+            local sql = ([[SELECT COUNT(*), COUNT(%s), SUM(%s), TOTAL(%s),
+                                  AVG(%s), MIN(%s), MAX(%s) FROM $]])
+            sql = sql:gsub('%%s', col)
+            check(sql)
+            check(sql .. ' WHERE i > 10')
+            check(sql .. ' WHERE i >= -5 AND i < 20 AND d <> 4.5')
+            check(sql .. ' WHERE 10 < i AND i < 20')
+            check(sql .. ' WHERE d > 10 AND i = 0')
+            check(sql .. ' WHERE d <= ?', {-3})
+            check(sql .. ' WHERE i <= ?', {-20})
+            check(sql .. ' WHERE i > 1000')
+        end
+        local count, sum = 0, 0
+        for id = 1, 1000 do
+            if id % 7 ~= 0 and id % 100 - 50 > 45 then
+                count = count + 1
+                sum = sum + id % 100 - 50
+            end
+        end
+        local rows = check('SELECT COUNT(*), SUM(i) + 1 FROM $ WHERE i > 45')
+        t.assert_equals(rows, {{count, sum + 1}})
+
+        -- Constants that can't be compared in batches are handled by the
+        -- row-by-row code of the query.
+        check('SELECT COUNT(*), SUM(d) FROM $ WHERE i > 10.5')
+        check('SELECT COUNT(*), SUM(d) FROM $ WHERE i > ?', {box.NULL})
+        check('SELECT COUNT(*), SUM(i) FROM $ WHERE d > ?',
+              {9007199254740993LL})
+        local _, memtx_err = box.execute('SELECT SUM(i) FROM t WHERE i > ?',
+                                         {'a'})
+        local _, vinyl_err = box.execute('SELECT SUM(i) FROM v WHERE i > ?',
+                                         {'a'})
+        t.assert_not_equals(memtx_err, nil)
+        t.assert_equals(memtx_err.message, vinyl_err.message)
+    end)
+end
+
+-- Checks that the batch scan is a read statement of the transaction,
+-- so the engine compatibility is checked like for any other read.
+g.test_batch_aggregate_in_txn = function(cg)
+    cg.server:exec(function()
+        box.begin()
+        box.space.V:replace({1001, 1, 1, 1, '1001'})
+        local _, err = box.execute('SELECT COUNT(*) FROM t')
+        box.rollback()
+        t.assert_not_equals(err, nil)
+        t.assert_equals(err.name, 'MVCC_UNAVAILABLE')
+        t.assert_equals(box.execute('SELECT COUNT(*) FROM t').rows, {{1000}})
+    end)
+end
+
+-- Checks queries that are not executed in batches.
+g.test_batch_aggregate_not_applicable = function(cg)
+    cg.server:exec(function()
+        local function uses_batch(sql)
+            local res = box.execute('EXPLAIN ' .. sql)
+            for _, row in ipairs(res.rows) do
+                if row[2] == 'BatchAggregate' then
+                    return true
+                end
+            end
+            return false
+        end
+        t.assert_not(uses_batch('SELECT SUM(i) FROM t WHERE u = 5'))
+        t.assert_not(uses_batch('SELECT SUM(i) FROM t WHERE i + 1 > 5'))
+        t.assert_not(uses_batch('SELECT SUM(i) FROM t WHERE s = \'1\''))
+        t.assert_not(uses_batch('SELECT COUNT(s) FROM t'))
+        t.assert_not(uses_batch('SELECT SUM(DISTINCT i) FROM t'))
+        t.assert_not(uses_batch('SELECT i, SUM(i) FROM t'))
+        t.assert_not(uses_batch('SELECT SUM(i) FROM t GROUP BY u'))
+        t.assert_not(uses_batch('SELECT MAX(u) FROM t'))
+        t.assert_equals(box.execute('SELECT SUM(i) FROM t WHERE u = 5').rows,
+                        {{-180}})
+    end)
+end
+
+-- Checks that overflows and values that don't fit the batches fall back
+-- to row-by-row execution.
+g.test_batch_aggregate_fallback = function(cg)
+    cg.server:exec(function()
+        box.execute([[CREATE TABLE big (id INT PRIMARY KEY, i INT,
+                                        u UNSIGNED);]])
+        box.space.BIG:insert({1, 9223372036854775807LL, 1})
+        box.space.BIG:insert({2, 1, 18446744073709551615ULL})
+        t.assert_equals(box.execute('SELECT SUM(i), MAX(u) FROM big').rows,
+                        {{9223372036854775808ULL, 18446744073709551615ULL}})
+        box.space.BIG:insert({3, 9223372036854775807LL, 1})
+        box.space.BIG:insert({4, 2, 1})
+        local _, err = box.execute('SELECT SUM(i) FROM big')
+        t.assert_equals(err.message,
+                        'Failed to execute SQL statement: ' ..
+                        'integer is overflowed')
+        box.execute('DROP TABLE big;')
+    end)
+end
+
+-- Checks that big spaces are aggregated in parallel over a read view
+-- and the result is the same as the one of the sequential scan.
+g.test_batch_aggregate_parallel = function(cg)
+    cg.server:exec(function()
+        local tweaks = require('internal.tweaks')
+        local min_part_size = tweaks.sql_batch_agg_parallel_min_part_size
+        local function execute(sql, ...)
+            tweaks.sql_batch_agg_parallel_min_part_size = 100
+            local res, err = box.execute(sql, ...)
+            tweaks.sql_batch_agg_parallel_min_part_size = min_part_size
+            t.assert_equals(err, nil, sql)
+            t.assert_equals(res, box.execute(sql, ...), sql)
+            return res.rows
+        end
+        for _, col in ipairs({'i', 'u', 'd'}) do
+            local sql = ([[SELECT COUNT(*), COUNT(%s), MIN(%s), MAX(%s)
+                           FROM t]]):gsub('%%s', col)
+            execute(sql)
+            execute(sql .. ' WHERE i > 10')
+            execute(sql .. ' WHERE d <= ?', {-3})
+            execute(sql .. ' WHERE i > 1000')
+        end
+        execute('SELECT SUM(i), AVG(i), SUM(u), AVG(u) FROM t')
+        execute('SELECT SUM(i), AVG(u) FROM t WHERE i > ?', {-20})
+        execute('SELECT SUM(d), TOTAL(i) FROM t')
+
+        -- Results of transactions are the same as well.
+        tweaks.sql_batch_agg_parallel_min_part_size = 100
+        box.begin()
+        box.space.T:insert({1001, 1000, 1, 1.5, '1001'})
+        local rows = box.execute('SELECT COUNT(*), MAX(i) FROM t').rows
+        box.rollback()
+        tweaks.sql_batch_agg_parallel_min_part_size = min_part_size
+        t.assert_equals(rows, {{1001, 1000}})
+
+        -- Partial sums that fit in the integer range while the sequential
+        -- sum doesn't are not merged.
+        box.execute([[CREATE TABLE big (id INT PRIMARY KEY, i INT);]])
+        box.begin()
+        for id = 1, 400 do
+            local i = id == 1 and -9223372036854775807LL or
+                      (id == 201 and -2 or (id == 202 and 2 or 0))
+            box.space.BIG:insert({id, i})
+        end
+        box.commit()
+        tweaks.sql_batch_agg_parallel_min_part_size = 100
+        local _, err = box.execute('SELECT SUM(i) FROM big')
+        tweaks.sql_batch_agg_parallel_min_part_size = min_part_size
+        t.assert_equals(err.message, 'Failed to execute SQL statement: ' ..
+                                     'integer is overflowed')
+        box.execute('DROP TABLE big;')
+
+        -- Same for a positive intermediate sum.
+        box.execute([[CREATE TABLE big (id INT PRIMARY KEY, i INT);]])
+        box.begin()
+        for id = 1, 400 do
+            local i = id == 1 and 9223372036854775797LL or
+                      (id == 201 and 20 or (id == 202 and -20 or 0))
+            box.space.BIG:insert({id, i})
+        end
+        box.commit()
+        tweaks.sql_batch_agg_parallel_min_part_size = 100
+        _, err = box.execute('SELECT SUM(i) FROM big')
+        tweaks.sql_batch_agg_parallel_min_part_size = min_part_size
+        t.assert_equals(err.message, 'Failed to execute SQL statement: ' ..
+                                     'integer is overflowed')
+        box.execute('DROP TABLE big;')
+    end)
+end
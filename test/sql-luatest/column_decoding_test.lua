@@ -0,0 +1,96 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        local format = {}
+        for i = 1, 100 do
+            table.insert(format, {'C' .. i, 'integer', is_nullable = i > 1})
+        end
+        local s = box.schema.space.create('T', {format = format})
+        s:create_index('pk')
+        -- Offsets of indexed fields are stored in the tuple field map.
+        s:create_index('i50', {parts = {'C50'}, unique = false})
+        s:create_index('i90', {parts = {'C90'}, unique = false})
+        for id = 1, 10 do
+            local tuple = {}
+            for i = 1, 100 do
+                tuple[i] = id * 1000 + i
+            end
+            -- Trailing fields may be missing.
+            if id % 3 == 0 then
+                for i = 71, 100 do
+                    tuple[i] = nil
+                end
+            end
+            s:insert(tuple)
+        end
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that columns used by a statement are passed to the cursor.
+g.test_columns_used = function(cg)
+    cg.server:exec(function()
+        local res = box.execute('EXPLAIN SELECT c2, c70 FROM t')
+        local mask
+        for _, row in ipairs(res.rows) do
+            if row[2] == 'ColumnsUsed' then
+                mask = row[6]
+            end
+        end
+        -- C70 is beyond the 63rd column, so the last bit is set.
+        t.assert_equals(mask, '9223372036854775810')
+    end)
+end
+
+-- Checks that the fields of wide tuples are fetched correctly whatever
+-- the order of the columns is.
+g.test_column_decoding = function(cg)
+    cg.server:exec(function()
+        local function value(id, i)
+            if id % 3 == 0 and i > 70 then
+                return box.NULL
+            end
+            return id * 1000 + i
+        end
+        local cols = {
+            {2, 3, 4},
+            {100, 1, 50},
+            {99, 90, 70, 64, 63, 62, 10},
+            {50, 51, 49, 91, 89, 90},
+            {30, 80, 30, 80},
+        }
+        for _, list in ipairs(cols) do
+            local names = {}
+            for i, col in ipairs(list) do
+                names[i] = 'c' .. col
+            end
+            local sql = 'SELECT ' .. table.concat(names, ', ') .. ' FROM t'
+            local rows = box.execute(sql).rows
+            t.assert_equals(#rows, 10, sql)
+            for id, row in ipairs(rows) do
+                for i, col in ipairs(list) do
+                    t.assert_equals(row[i], value(id, col), sql)
+                end
+            end
+        end
+        -- A column that isn't used by the query output is still fetched
+        -- correctly by the filter.
+        local sql = 'SELECT c95 FROM t WHERE c60 > 5000 AND c1 < 9000'
+        t.assert_equals(box.execute(sql).rows,
+                        {{5095}, {box.NULL}, {7095}, {8095}})
+        sql = 'SELECT c1 FROM t WHERE c90 = 4090'
+        t.assert_equals(box.execute(sql).rows, {{4001}})
+        sql = 'SELECT c91 FROM t INDEXED BY i90 WHERE c90 > 8000'
+        t.assert_equals(box.execute(sql).rows, {{8091}, {10091}})
+    end)
+end
@@ -0,0 +1,124 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group('filter', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function(engine)
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        box.execute(([[CREATE TABLE t (id INT PRIMARY KEY, i INT, u UNSIGNED,
+                                       d DOUBLE, s STRING,
+                                       c STRING COLLATE "unicode_ci")
+                       WITH ENGINE = '%s';]]):format(engine))
+        box.execute([[CREATE INDEX t_u ON t(u);]])
+        local strings = {'a', 'ab', 'abc', 'abd', 'b', 'ABC', 'a%c', 'абв'}
+        for id = 1, 40 do
+            local i = id % 7 == 0 and box.NULL or id % 11 - 5
+            local d = id % 5 == 0 and box.NULL or id / 4
+            local s = id % 9 == 0 and box.NULL or strings[id % 8 + 1]
+            box.space.T:insert({id, i, id % 6, d, s, strings[id % 8 + 1]})
+        end
+    end, {cg.params.engine})
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that terms of the WHERE clause comparing fields with constants
+-- are evaluated by the filter instruction.
+g.test_filter_explain = function(cg)
+    cg.server:exec(function()
+        local function has_filter(sql)
+            local res = box.execute('EXPLAIN ' .. sql)
+            for _, row in ipairs(res.rows) do
+                if row[2] == 'Filter' then
+                    return true
+                end
+            end
+            return false
+        end
+        t.assert(has_filter('SELECT id FROM t WHERE i > 1'))
+        t.assert(has_filter('SELECT id FROM t WHERE i + 1 > ?'))
+        t.assert(has_filter('SELECT id FROM t WHERE s LIKE \'ab%\''))
+        t.assert(has_filter('SELECT id FROM t WHERE d IS NULL'))
+        t.assert(has_filter('SELECT id FROM t WHERE u = 1 AND i < 0'))
+        t.assert_not(has_filter('SELECT id FROM t WHERE i > id'))
+        t.assert_not(has_filter('SELECT id FROM t WHERE c = \'abc\''))
+        t.assert_not(has_filter('SELECT id FROM t WHERE ABS(i) > 1'))
+    end)
+end
+
+-- Checks that the results of the filter are the same as the ones of
+-- the byte code.
+g.test_filter_results = function(cg)
+    cg.server:exec(function()
+        local tuples = box.space.T:select()
+        local function check(where, pred, ...)
+            local res, err = box.execute('SELECT id FROM t WHERE ' .. where ..
+                                         ' ORDER BY id', {...})
+            t.assert_equals(err, nil, where)
+            local expected = {}
+            for _, tuple in ipairs(tuples) do
+                if pred(tuple) then
+                    table.insert(expected, {tuple[1]})
+                end
+            end
+            t.assert_equals(res.rows, expected, where)
+        end
+        local null = box.NULL
+        check('i > 1', function(x) return x[2] ~= null and x[2] > 1 end)
+        check('1 > i', function(x) return x[2] ~= null and x[2] < 1 end)
+        check('i + 3 < 5', function(x) return x[2] ~= null and x[2] < 2 end)
+        check('2 * i = -4', function(x) return x[2] == -2 end)
+        check('i - 1 <> ?', function(x) return x[2] ~= null and x[2] ~= 1 end,
+              0)
+        check('i >= ?', function() return false end, null)
+        check('u <= 2 AND i < 0', function(x)
+            return x[3] <= 2 and x[2] ~= null and x[2] < 0
+        end)
+        check('d > 2.5', function(x) return x[4] ~= null and x[4] > 2.5 end)
+        check('d * 2 <= 3', function(x)
+            return x[4] ~= null and x[4] * 2 <= 3
+        end)
+        check('d = ?', function(x) return x[4] == 2 end, 2)
+        check('s = \'abc\'', function(x) return x[5] == 'abc' end)
+        check('s < ?', function(x)
+            return x[5] == 'a' or x[5] == 'ABC' or x[5] == 'a%c'
+        end, 'ab')
+        check('s LIKE \'ab%\'', function(x)
+            return x[5] ~= null and x[5]:sub(1, 2) == 'ab'
+        end)
+        check('s LIKE \'abc\'', function(x) return x[5] == 'abc' end)
+        check('s LIKE \'a_c\'', function(x)
+            return x[5] == 'abc' or x[5] == 'a%c'
+        end)
+        check('s LIKE \'%\'', function(x) return x[5] ~= null end)
+        check('s LIKE \'аб%\'', function(x) return x[5] == 'абв' end)
+        check('c = \'abc\'', function(x) return x[6]:lower() == 'abc' end)
+        check('s IS NULL', function(x) return x[5] == null end)
+        check('d IS NOT NULL AND i IS NULL', function(x)
+            return x[4] ~= null and x[2] == null
+        end)
+    end)
+end
+
+-- Checks that terms the filter can't evaluate exactly are evaluated by
+-- the byte code.
+g.test_filter_fallback = function(cg)
+    cg.server:exec(function()
+        local _, err = box.execute('SELECT id FROM t WHERE i > ?', {'a'})
+        t.assert_str_contains(err.message, 'Type mismatch')
+        _, err = box.execute([[SELECT id FROM t
+                               WHERE i * 4611686018427387904 > 0]])
+        t.assert_equals(err.message, 'Failed to execute SQL statement: ' ..
+                        'integer is overflowed')
+        local res = box.execute([[SELECT id FROM t
+                                  WHERE i < 18446744073709551615]])
+        t.assert_equals(#res.rows, 35)
+    end)
+end
@@ -0,0 +1,86 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        box.execute([[CREATE TABLE t1 (id INT PRIMARY KEY, a INT,
+                                       s STRING COLLATE "unicode_ci");]])
+        box.execute([[CREATE TABLE t2 (id INT PRIMARY KEY, b INT,
+                                       s STRING COLLATE "unicode_ci");]])
+        box.execute([[CREATE TABLE small (id INT PRIMARY KEY, b INT);]])
+        box.begin()
+        for i = 1, 20000 do
+            box.space.T1:insert({i, i % 3000, 'k' .. i % 5000})
+            box.space.T2:insert({i, i % 2000 + 1500, 'K' .. i % 5000})
+        end
+        for i = 1, 100 do
+            box.space.SMALL:insert({i, i})
+        end
+        box.commit()
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that a join of big spaces on non-indexed columns uses a hash
+-- join and returns the same result as a nested loop.
+g.test_hash_join = function(cg)
+    cg.server:exec(function()
+        local function plan(sql)
+            local res = box.execute('EXPLAIN QUERY PLAN ' .. sql)
+            local details = {}
+            for _, row in ipairs(res.rows) do
+                table.insert(details, row[4])
+            end
+            return table.concat(details, '\n')
+        end
+        local sql = [[SELECT COUNT(*), SUM(t1.id), SUM(t2.id) FROM t1, t2
+                      WHERE t1.a = t2.b;]]
+        t.assert_str_contains(plan(sql), 'USING HASH JOIN')
+        local count, sum1, sum2 = 0, 0, 0
+        local by_b = {}
+        for _, tuple in box.space.T2:pairs() do
+            by_b[tuple[2]] = by_b[tuple[2]] or {}
+            table.insert(by_b[tuple[2]], tuple[1])
+        end
+        for _, tuple in box.space.T1:pairs() do
+            for _, id in ipairs(by_b[tuple[2]] or {}) do
+                count = count + 1
+                sum1 = sum1 + tuple[1]
+                sum2 = sum2 + id
+            end
+        end
+        t.assert_equals(box.execute(sql).rows, {{count, sum1, sum2}})
+
+        -- Rows without a match are kept by LEFT JOIN.
+        sql = [[SELECT COUNT(*), COUNT(t2.id) FROM t1 LEFT JOIN t2
+                ON t1.a = t2.b;]]
+        t.assert_str_contains(plan(sql), 'USING HASH JOIN')
+        local unmatched = 0
+        for _, tuple in box.space.T1:pairs() do
+            if by_b[tuple[2]] == nil then
+                unmatched = unmatched + 1
+            end
+        end
+        t.assert_equals(box.execute(sql).rows,
+                        {{count + unmatched, count}})
+
+        -- The hash table respects collations.
+        sql = [[SELECT COUNT(*) FROM t1, t2 WHERE t1.s = t2.s;]]
+        t.assert_str_contains(plan(sql), 'USING HASH JOIN')
+        t.assert_equals(box.execute(sql).rows, {{20000 * 4}})
+
+        -- A small space still uses an ordered ephemeral index.
+        sql = [[SELECT COUNT(*) FROM small AS x, small AS y
+                WHERE x.b = y.b;]]
+        t.assert_str_contains(plan(sql), 'USING EPHEMERAL INDEX')
+        t.assert_equals(box.execute(sql).rows, {{100}})
+    end)
+end
@@ -0,0 +1,200 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        box.execute([[CREATE TABLE t (id INT PRIMARY KEY, g INT NOT NULL,
+                                      s STRING COLLATE "unicode_ci" NOT NULL,
+                                      i INT, d DOUBLE);]])
+        box.execute([[CREATE INDEX t_g ON t(g);]])
+        for id = 1, 100 do
+            local i = id % 7 == 0 and box.NULL or id % 13 - 6
+            box.space.T:insert({id, id % 5, id % 3 == 0 and 'a' or 'B', i,
+                                id / 4})
+        end
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that materialized views are created from supported queries
+-- only.
+g.test_materialized_view_create = function(cg)
+    cg.server:exec(function()
+        local function check(sql, err)
+            local _, e = box.execute('CREATE MATERIALIZED VIEW v AS ' .. sql)
+            t.assert_equals(e.message, "Failed to create space 'V': " ..
+                            "materialized view: " .. err)
+        end
+        check('SELECT COUNT(*) FROM t',
+              'GROUP BY clause is required')
+        check('SELECT g, COUNT(*) FROM t WHERE i > 0 GROUP BY g',
+              'only GROUP BY SELECT without WHERE, HAVING, ORDER BY, ' ..
+              'LIMIT, DISTINCT and compound parts is supported')
+        check('SELECT g, AVG(i) FROM t GROUP BY g',
+              'only columns and COUNT, SUM, MIN and MAX are allowed')
+        check('SELECT g, SUM(d) FROM t GROUP BY g',
+              'SUM is allowed only for integer columns')
+        check('SELECT g, SUM(i + 1) FROM t GROUP BY g',
+              'arguments of aggregate functions must be columns')
+        check('SELECT i, COUNT(*) FROM t GROUP BY i',
+              'GROUP BY columns must be NOT NULL')
+        check('SELECT COUNT(*) FROM t GROUP BY g',
+              'all GROUP BY columns must be selected')
+        check('SELECT g, s, COUNT(*) FROM t GROUP BY g',
+              'selected columns must be in GROUP BY')
+        t.assert_equals(box.space.V, nil)
+    end)
+end
+
+-- Checks that the rows of materialized views are the same as the
+-- results of their queries after changes of the base space.
+g.test_materialized_view_results = function(cg)
+    cg.server:exec(function()
+        local views = {
+            V1 = 'SELECT g, COUNT(*), COUNT(i), SUM(i), MIN(i), MAX(i) ' ..
+                 'FROM t GROUP BY g',
+            V2 = 'SELECT SUM(id), s, MAX(d), g FROM t GROUP BY s, g',
+            V3 = 'SELECT s AS str, MIN(id) AS min_id FROM t GROUP BY s',
+        }
+        for name, sql in pairs(views) do
+            local _, err = box.execute(('CREATE MATERIALIZED VIEW %s AS %s')
+                                       :format(name, sql))
+            t.assert_equals(err, nil, name)
+        end
+        local function check()
+            for name, sql in pairs(views) do
+                local n = #box.execute(sql).metadata
+                local cols = {}
+                for i = 1, n do
+                    table.insert(cols, i)
+                end
+                local order = ' ORDER BY ' .. table.concat(cols, ', ')
+                local expected = box.execute(sql .. order).rows
+                local rows = box.execute('SELECT * FROM ' .. name ..
+                                         order).rows
+                t.assert_equals(rows, expected, name)
+            end
+        end
+        check()
+        box.execute([[UPDATE t SET i = 100 WHERE id = 3;]])
+        box.execute([[UPDATE t SET i = NULL, d = 0.5 WHERE g = 2;]])
+        box.execute([[UPDATE t SET g = 7, s = 'B' WHERE id % 11 = 0;]])
+        box.execute([[DELETE FROM t WHERE i = -6 OR id % 9 = 0;]])
+        box.space.T:insert({101, 8, 'a', 1, 1.5})
+        box.space.T:replace({101, 8, 'c', box.NULL, 2.5})
+        check()
+        -- The extremum of a group is recomputed when it is deleted.
+        local max = box.execute([[SELECT MAX(i) FROM t WHERE g = 3]]).rows
+        box.execute(([[DELETE FROM t WHERE g = 3 AND i = %d]])
+                    :format(max[1][1]))
+        check()
+        -- Changes are rolled back along with the base space.
+        box.begin()
+        box.execute([[DELETE FROM t WHERE g = 1;]])
+        box.space.T:insert({102, 9, 'x', 5, 1.25})
+        box.rollback()
+        check()
+        -- The view is read by an index lookup.
+        t.assert_equals(box.execute([[SELECT * FROM v1 WHERE g = 4]]).rows,
+                        box.execute(views.V1 .. ' HAVING g = 4').rows)
+        -- Deleting the last tuples of a group deletes its row.
+        box.execute([[DELETE FROM t WHERE g = 7;]])
+        t.assert_equals(box.execute([[SELECT * FROM v1 WHERE g = 7]]).rows,
+                        {})
+        check()
+        for name in pairs(views) do
+            box.execute('DROP VIEW ' .. name)
+        end
+    end)
+end
+
+-- Checks that the base space of a materialized view can't be dropped
+-- or truncated.
+g.test_materialized_view_base = function(cg)
+    cg.server:exec(function()
+        box.execute([[CREATE TABLE b (id INT PRIMARY KEY, g INT NOT NULL);]])
+        box.execute([[INSERT INTO b VALUES (1, 1), (2, 1), (3, 2);]])
+        local _, err = box.execute([[CREATE MATERIALIZED VIEW bv AS
+                                     SELECT g, COUNT(*) AS c FROM b
+                                     GROUP BY g;]])
+        t.assert_equals(err, nil)
+        t.assert_equals(box.execute([[SELECT * FROM bv;]]).rows,
+                        {{1, 2}, {2, 1}})
+        _, err = box.execute([[DROP TABLE b;]])
+        t.assert_equals(err.message, "Can't drop space 'B': other views " ..
+                        "depend on this space")
+        _, err = box.execute([[TRUNCATE TABLE b;]])
+        t.assert_equals(err.message, "Can't modify space 'B': can not " ..
+                        "truncate a space read by a materialized view")
+        _, err = box.execute([[DROP TABLE bv;]])
+        t.assert_equals(err.message, "Can't drop space 'BV': use DROP VIEW")
+        box.execute([[DROP VIEW bv;]])
+        box.execute([[INSERT INTO b VALUES (4, 3);]])
+        box.execute([[TRUNCATE TABLE b;]])
+        box.execute([[DROP TABLE b;]])
+    end)
+end
+
+-- Checks that a materialized view can be created only by a user who
+-- can read its base space.
+g.test_materialized_view_access = function(cg)
+    cg.server:exec(function()
+        box.schema.user.create('matview_user')
+        box.schema.user.grant('matview_user', 'create', 'space')
+        local _, err = box.session.su('matview_user', box.execute,
+                                      [[CREATE MATERIALIZED VIEW av AS
+                                        SELECT g, COUNT(*) FROM t
+                                        GROUP BY g;]])
+        t.assert_equals(err.message, "Read access to space 'T' is " ..
+                        "denied for user 'matview_user'")
+        t.assert_equals(box.space.AV, nil)
+        box.schema.user.drop('matview_user')
+    end)
+end
+
+-- Checks that the rows of a materialized view can't be changed directly.
+g.test_materialized_view_read_only = function(cg)
+    cg.server:exec(function()
+        box.execute([[CREATE TABLE r (id INT PRIMARY KEY, g INT NOT NULL);]])
+        box.execute([[INSERT INTO r VALUES (1, 1), (2, 1), (3, 2);]])
+        local _, err = box.execute([[CREATE MATERIALIZED VIEW rv AS
+                                     SELECT g, COUNT(*) AS c FROM r
+                                     GROUP BY g;]])
+        t.assert_equals(err, nil)
+        local rows = {{1, 2}, {2, 1}}
+        local msg = "View 'RV' is read-only"
+        local s = box.space.RV
+        t.assert_error_msg_equals(msg, s.replace, s, {3, 1, 1})
+        t.assert_error_msg_equals(msg, s.insert, s, {3, 1, 1})
+        t.assert_error_msg_equals(msg, s.update, s, {1}, {{'=', 2, 5}})
+        t.assert_error_msg_equals(msg, s.upsert, s, {1, 5, 5},
+                                  {{'=', 2, 5}})
+        t.assert_error_msg_equals(msg, s.delete, s, {1})
+        t.assert_error_msg_equals(msg, s.truncate, s)
+        for _, sql in pairs({
+            [[INSERT INTO rv VALUES (3, 1);]],
+            [[UPDATE rv SET c = 5 WHERE g = 1;]],
+            [[DELETE FROM rv WHERE g = 1;]],
+            [[DELETE FROM rv;]],
+            [[TRUNCATE TABLE rv;]],
+        }) do
+            _, err = box.execute(sql)
+            t.assert_equals(err ~= nil and err.message, msg, sql)
+        end
+        t.assert_equals(box.execute([[SELECT * FROM rv;]]).rows, rows)
+        -- The view is still maintained by changes of the base space.
+        box.execute([[INSERT INTO r VALUES (4, 2);]])
+        t.assert_equals(box.execute([[SELECT * FROM rv;]]).rows,
+                        {{1, 2}, {2, 2}})
+        box.execute([[DROP VIEW rv;]])
+        box.execute([[DROP TABLE r;]])
+    end)
+end
@@ -0,0 +1,80 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group('offset', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function(engine)
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        box.execute(([[CREATE TABLE t (id INT PRIMARY KEY, a INT)
+                       WITH ENGINE = '%s';]]):format(engine))
+        box.execute([[CREATE INDEX t_a ON t(a);]])
+        for id = 1, 100 do
+            box.space.T:insert({id, id * 37 % 101})
+        end
+    end, {cg.params.engine})
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that OFFSET of a full scan is skipped by the index iterator.
+g.test_offset_pushdown = function(cg)
+    cg.server:exec(function()
+        local function is_pushed(sql)
+            local res = box.execute('EXPLAIN ' .. sql)
+            for _, row in ipairs(res.rows) do
+                if row[2] == 'Rewind' and row[5] ~= 0 then
+                    return true
+                end
+            end
+            return false
+        end
+        t.assert(is_pushed('SELECT id FROM t LIMIT 5 OFFSET 10'))
+        t.assert(is_pushed('SELECT id FROM t ORDER BY id LIMIT 5 OFFSET ?'))
+        t.assert_not(is_pushed('SELECT id FROM t LIMIT 5'))
+        t.assert_not(is_pushed('SELECT id FROM t WHERE a > 1 ' ..
+                               'LIMIT 5 OFFSET 10'))
+        t.assert_not(is_pushed('SELECT DISTINCT a FROM t LIMIT 5 OFFSET 10'))
+        t.assert_not(is_pushed('SELECT id FROM t ORDER BY id DESC ' ..
+                               'LIMIT 5 OFFSET 10'))
+        t.assert_not(is_pushed('SELECT id FROM t ORDER BY a + 1 ' ..
+                               'LIMIT 5 OFFSET 10'))
+    end)
+end
+
+-- Checks that the results with OFFSET skipped by the index iterator
+-- are the same as the ones with OFFSET skipped by the byte code.
+g.test_offset_results = function(cg)
+    cg.server:exec(function()
+        local function check(columns, tail, ...)
+            local sql = 'SELECT ' .. columns .. ' FROM t '
+            local res, err = box.execute(sql .. tail, {...})
+            t.assert_equals(err, nil, tail)
+            local expected = box.execute(sql .. 'WHERE TRUE ' .. tail, {...})
+            t.assert_equals(res, expected, tail)
+            return res.rows
+        end
+        t.assert_equals(check('id', 'LIMIT 3 OFFSET 10'), {{11}, {12}, {13}})
+        t.assert_equals(check('id', 'LIMIT 5 OFFSET 98'), {{99}, {100}})
+        t.assert_equals(check('id', 'LIMIT 5 OFFSET 100'), {})
+        t.assert_equals(check('id', 'LIMIT 5 OFFSET ?', 1000), {})
+        t.assert_equals(check('id', 'LIMIT 2 OFFSET ?', 0), {{1}, {2}})
+        check('*', 'ORDER BY id LIMIT 3 OFFSET 50')
+        check('a, id', 'ORDER BY a LIMIT 4 OFFSET 60')
+        t.assert_equals(#check('id', 'LIMIT 100 OFFSET 30'), 70)
+
+        -- The OFFSET counter is shared by SELECTs of a compound one.
+        local res = box.execute([[SELECT id FROM t UNION ALL SELECT id FROM t
+                                  LIMIT 5 OFFSET 98]])
+        t.assert_equals(res.rows, {{99}, {100}, {1}, {2}, {3}})
+        res = box.execute([[SELECT id FROM t UNION ALL SELECT id FROM t
+                            LIMIT 3 OFFSET 110]])
+        t.assert_equals(res.rows, {{11}, {12}, {13}})
+    end)
+end
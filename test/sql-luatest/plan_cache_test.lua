@@ -0,0 +1,150 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[CREATE TABLE t (id INT PRIMARY KEY, s STRING);]])
+        box.space.T:insert({1, 'a'})
+        box.space.T:insert({2, "it's"})
+        box.space.T:insert({3, 'c'})
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that statements that differ only in literals and spaces share
+-- one cached plan.
+g.test_plan_cache = function(cg)
+    cg.server:exec(function()
+        local function stat()
+            return box.info.sql().plan_cache
+        end
+        local old = stat()
+        local res, err = box.execute('SELECT s FROM t WHERE id = 1')
+        t.assert_equals(err, nil)
+        t.assert_equals(res.rows, {{'a'}})
+        t.assert_equals(stat().misses, old.misses + 1)
+        t.assert_equals(stat().stmt_count, old.stmt_count + 1)
+        t.assert(stat().size > old.size)
+
+        res = box.execute('SELECT  s FROM t\n WHERE id=3 -- comment')
+        t.assert_equals(res.rows, {{'c'}})
+        t.assert_equals(stat().hits, old.hits + 1)
+        t.assert_equals(stat().stmt_count, old.stmt_count + 1)
+
+        res = box.execute([[SELECT id FROM t WHERE s = 'it''s']])
+        t.assert_equals(res.rows, {{2}})
+        res = box.execute([[SELECT id FROM t WHERE s = 'c']])
+        t.assert_equals(res.rows, {{3}})
+        t.assert_equals(stat().hits, old.hits + 2)
+
+        -- Statements with parameters are cached as is.
+        res = box.execute('SELECT s FROM t WHERE id > ?', {1})
+        t.assert_equals(res.rows, {{"it's"}, {'c'}})
+        res = box.execute('SELECT s FROM t WHERE id > ?', {2})
+        t.assert_equals(res.rows, {{'c'}})
+        t.assert_equals(stat().hits, old.hits + 3)
+
+        -- DML statements are cached too.
+        box.execute('INSERT INTO t VALUES (4, ?)', {'d'})
+        box.execute('INSERT INTO t VALUES (5, ?)', {'e'})
+        t.assert_equals(stat().hits, old.hits + 4)
+        box.execute('DELETE FROM t WHERE id >= 4')
+        t.assert_equals(box.space.T:count(), 3)
+
+        -- Other statements are not cached.
+        local count = stat().stmt_count
+        box.execute('CREATE TABLE t1 (id INT PRIMARY KEY);')
+        box.execute('DROP TABLE t1;')
+        t.assert_equals(stat().stmt_count, count)
+    end)
+end
+
+-- Checks that cached plans are recompiled after a schema change.
+g.test_plan_cache_schema_change = function(cg)
+    cg.server:exec(function()
+        local sql = 'SELECT * FROM t WHERE id = 1'
+        t.assert_equals(box.execute(sql).rows, {{1, 'a'}})
+        box.execute('ALTER TABLE t ADD COLUMN i INT;')
+        local misses = box.info.sql().plan_cache.misses
+        t.assert_equals(box.execute(sql).rows, {{1, 'a', box.NULL}})
+        t.assert_equals(box.info.sql().plan_cache.misses, misses + 1)
+        box.space.T:format({{'ID', 'integer'}, {'S', 'string'}})
+        t.assert_equals(box.execute(sql).rows, {{1, 'a'}})
+    end)
+end
+
+-- Checks that the results of statements are the same with and without
+-- the plan cache.
+g.test_plan_cache_same_results = function(cg)
+    cg.server:exec(function()
+        local function check(sql)
+            local res1, err1 = box.execute(sql)
+            local size = box.cfg.sql_plan_cache_size
+            box.cfg{sql_plan_cache_size = 0}
+            local hits = box.info.sql().plan_cache.hits
+            local res2, err2 = box.execute(sql)
+            t.assert_equals(box.info.sql().plan_cache.hits, hits)
+            box.cfg{sql_plan_cache_size = size}
+            t.assert_equals(res1, res2, sql)
+            t.assert_equals(err1 ~= nil and err1.message,
+                            err2 ~= nil and err2.message, sql)
+        end
+        check('SELECT id, s = \'a\' FROM t WHERE id < 3')
+        check('SELECT COUNT(*) FROM t WHERE s <> \'a\' AND id <= 2')
+        check('SELECT * FROM t WHERE id = 18446744073709551615')
+        check('SELECT * FROM t WHERE id = -1')
+        check('SELECT * FROM t WHERE id = \'a\'')
+        check('SELECT * FROM t WHERE unknown = 1')
+        check('SELECT * FROM t WHERE id = 1 ORDER BY 1')
+        box.execute([[SET SESSION "sql_full_metadata" = true;]])
+        check('SELECT id = 1 FROM t WHERE id = 1')
+        box.execute([[SET SESSION "sql_full_metadata" = false;]])
+    end)
+end
+
+-- Checks that a statement executed with different session options has a
+-- cached plan per each set of options.
+g.test_plan_cache_session_options = function(cg)
+    cg.server:exec(function()
+        local function stat()
+            return box.info.sql().plan_cache
+        end
+        local sql = 'SELECT s FROM t WHERE id = 2'
+        local old = stat()
+        for _ = 1, 3 do
+            box.execute([[SET SESSION "sql_seq_scan" = false;]])
+            t.assert_equals(box.execute(sql).rows, {{"it's"}})
+            box.execute([[SET SESSION "sql_seq_scan" = true;]])
+            t.assert_equals(box.execute(sql).rows, {{"it's"}})
+        end
+        t.assert_equals(stat().stmt_count, old.stmt_count + 2)
+        t.assert_equals(stat().misses, old.misses + 2)
+        t.assert_equals(stat().hits, old.hits + 4)
+    end)
+end
+
+-- Checks that the cached statements are evicted when the cache size is
+-- reduced.
+g.test_plan_cache_size = function(cg)
+    cg.server:exec(function()
+        t.assert_equals(box.cfg.sql_plan_cache_size, 5 * 1024 * 1024)
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'sql_plan_cache_size': " ..
+            "must be non-negative",
+            box.cfg, {sql_plan_cache_size = -1})
+        box.execute('SELECT s FROM t WHERE id = 1')
+        t.assert_not_equals(box.info.sql().plan_cache.stmt_count, 0)
+        box.cfg{sql_plan_cache_size = 0}
+        t.assert_equals(box.info.sql().plan_cache.stmt_count, 0)
+        box.execute('SELECT s FROM t WHERE id = 1')
+        t.assert_equals(box.info.sql().plan_cache.stmt_count, 0)
+        box.cfg{sql_plan_cache_size = 5 * 1024 * 1024}
+    end)
+end
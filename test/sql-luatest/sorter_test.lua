@@ -0,0 +1,103 @@
+local server = require('luatest.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new()
+    cg.server:start()
+    cg.server:exec(function()
+        box.execute([[SET SESSION "sql_seq_scan" = true;]])
+        box.execute([[CREATE TABLE t (id INT PRIMARY KEY, i INT, s STRING,
+                                      d DOUBLE);]])
+        box.begin()
+        for id = 1, 5000 do
+            local i = id % 13 == 0 and box.NULL or (id * 7919) % 1000
+            box.space.T:insert({id, i, tostring(id * 31 % 977), id % 17 / 3})
+        end
+        box.commit()
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- Checks that big runs of records are sorted in multiple threads and
+-- records that don't fit in memory are spilled to temporary files, and
+-- the results are the same as the ones of the in-memory sort.
+g.test_sorter = function(cg)
+    cg.server:exec(function()
+        local tweaks = require('internal.tweaks')
+        local function execute(sql)
+            local memory_limit = tweaks.sql_sorter_memory_limit
+            local min_records = tweaks.sql_sorter_parallel_min_records
+            local thread_count = tweaks.sql_sorter_thread_count
+            tweaks.sql_sorter_thread_count = 1
+            local expected = box.execute(sql)
+            tweaks.sql_sorter_thread_count = thread_count
+            local results = {}
+            tweaks.sql_sorter_parallel_min_records = 100
+            table.insert(results, box.execute(sql))
+            tweaks.sql_sorter_memory_limit = 10000
+            table.insert(results, box.execute(sql))
+            tweaks.sql_sorter_thread_count = 1
+            table.insert(results, box.execute(sql))
+            tweaks.sql_sorter_memory_limit = memory_limit
+            tweaks.sql_sorter_parallel_min_records = min_records
+            tweaks.sql_sorter_thread_count = thread_count
+            for _, res in ipairs(results) do
+                t.assert_equals(res, expected, sql)
+            end
+            return expected.rows
+        end
+        local rows = execute('SELECT i, id FROM t ORDER BY i, id')
+        t.assert_equals(#rows, 5000)
+        t.assert_equals(rows[1], {box.NULL, 13})
+        execute('SELECT s, id FROM t ORDER BY s DESC, id')
+        execute('SELECT d, i, id FROM t ORDER BY d, i DESC, id')
+        execute('SELECT s COLLATE "unicode_ci", id FROM t ORDER BY 1, 2')
+        execute('SELECT i, COUNT(*), MAX(s) FROM t GROUP BY i')
+        execute('SELECT s, SUM(i) FROM t GROUP BY s ORDER BY 2, 1')
+    end)
+end
+
+-- Checks that the sorter keeps only LIMIT+OFFSET records sorted first
+-- and the results are the same as the ones of the full sort.
+g.test_sorter_top_n = function(cg)
+    cg.server:exec(function()
+        local tweaks = require('internal.tweaks')
+        local function execute(sql)
+            local top_n_max = tweaks.sql_sorter_top_n_max
+            tweaks.sql_sorter_top_n_max = 0
+            local expected = box.execute(sql)
+            tweaks.sql_sorter_top_n_max = top_n_max
+            local res, err = box.execute(sql)
+            t.assert_equals(err, nil, sql)
+            t.assert_equals(res, expected, sql)
+            return res.rows
+        end
+        local res = box.execute([[EXPLAIN SELECT i, id FROM t
+                                  ORDER BY i DESC, id LIMIT 5]])
+        local limited = false
+        for _, row in ipairs(res.rows) do
+            if row[2] == 'SorterInsert' and row[5] ~= 0 then
+                limited = true
+            end
+        end
+        t.assert(limited)
+        local rows = execute('SELECT i, id FROM t ORDER BY i DESC, id LIMIT 5')
+        t.assert_equals(rows, {{999, 321}, {999, 1321}, {999, 2321},
+                               {999, 3321}, {999, 4321}})
+        rows = execute([[SELECT s, d, id FROM t ORDER BY s DESC, d, id
+                         LIMIT 10 OFFSET 100]])
+        t.assert_equals(#rows, 10)
+        execute('SELECT i, id FROM t ORDER BY i, id DESC LIMIT 1')
+        execute('SELECT d, s, id FROM t ORDER BY d DESC, id LIMIT 4999')
+        rows = execute([[SELECT i, id FROM t ORDER BY i DESC, id
+                         LIMIT 20000 OFFSET 10]])
+        t.assert_equals(#rows, 4990)
+        execute([[SELECT s COLLATE "unicode_ci", id FROM t
+                  ORDER BY 1 DESC, 2 LIMIT 7]])
+    end)
+end
@@ -923,6 +923,41 @@ insert_successor_test()
 	ok(true, "successor test");
 }
 
+static void
+find_batch_test()
+{
+	test tree;
+	test_create(&tree, 0, &allocator, NULL);
+
+	const size_t max_count = 100;
+	type_t keys[max_count];
+	type_t *results[max_count];
+
+	/* Empty tree. */
+	for (size_t i = 0; i < max_count; i++)
+		keys[i] = i;
+	test_find_batch(&tree, keys, max_count, results);
+	for (size_t i = 0; i < max_count; i++)
+		fail_unless(results[i] == NULL);
+
+	const size_t limit = 10000;
+	for (size_t i = 0; i < limit; i++)
+		test_insert(&tree, (type_t)(i * 2), NULL, NULL);
+
+	for (size_t i = 0; i < 1000; i++) {
+		size_t count = 1 + rand() % max_count;
+		for (size_t j = 0; j < count; j++)
+			keys[j] = rand() % (limit * 2 + 2);
+		test_find_batch(&tree, keys, count, results);
+		for (size_t j = 0; j < count; j++)
+			fail_unless(results[j] == test_find(&tree, keys[j]));
+	}
+
+	test_destroy(&tree);
+
+	ok(true, "find batch test");
+}
+
 static void
 gh_11326_oom_on_insertion_test()
 {
@@ -960,7 +995,7 @@ gh_11326_oom_on_insertion_test()
 int
 main(void)
 {
-	plan(13);
+	plan(14);
 	header();
 
 	matras_allocator_create(&allocator, BPS_TREE_EXTENT_SIZE,
@@ -978,6 +1013,7 @@ main(void)
 	insert_get_iterator();
 	delete_value_check();
 	insert_successor_test();
+	find_batch_test();
 
 	matras_allocator_destroy(&allocator);
 
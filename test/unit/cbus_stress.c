@@ -27,6 +27,18 @@ static const int connect_prob = 30;
 /* Chance of disconnecting from a random neighbor in a loop iteration. */
 static const int disconnect_prob = 20;
 
+/*
+ * Number of threads sending messages to the main thread in the
+ * many-to-one test run after the stress test.
+ */
+static const int sender_count = 4;
+
+/* Number of messages sent by each sender thread. */
+static const int sender_msg_count = 1000;
+
+/* Number of messages pushed by a sender thread between yields. */
+static const int sender_batch_size = 16;
+
 /* This structure represents a connection to a test thread. */
 struct conn {
 	bool active;
@@ -363,6 +375,115 @@ main_func(va_list ap)
 	return 0;
 }
 
+/* Thread sending messages to the main thread. */
+struct sender {
+	/* Sender id (between 0 and sender_count - 1, inclusive). */
+	int id;
+	/* Name of the cord. */
+	char name[32];
+	/* Cord corresponding to this thread. */
+	struct cord cord;
+	/*
+	 * Messages sent by this thread. Freed by the main thread
+	 * after all of them are delivered.
+	 */
+	struct sender_msg *msgs;
+	/* Sequence number of the next message expected from this thread. */
+	int next_seq;
+};
+
+struct sender_msg {
+	struct cmsg cmsg;
+	/* Sending thread. */
+	struct sender *sender;
+	/* Sequence number of the message in the sending thread. */
+	int seq;
+};
+
+/* Number of messages received by the main thread in the many-to-one test. */
+static int sender_received;
+
+static void
+sender_msg_received_cb(struct cmsg *cmsg)
+{
+	struct sender_msg *msg = container_of(cmsg, struct sender_msg, cmsg);
+	/* Messages sent by one thread must be delivered in order. */
+	assert(msg->seq == msg->sender->next_seq);
+	msg->sender->next_seq++;
+	sender_received++;
+}
+
+static int
+sender_func(va_list ap)
+{
+	struct sender *s = va_arg(ap, struct sender *);
+	static struct cmsg_hop route[] = {
+		{ sender_msg_received_cb, NULL }
+	};
+	struct cpipe pipe;
+	cpipe_create(&pipe, "main");
+	cpipe_set_max_input(&pipe, sender_batch_size);
+	for (int i = 0; i < sender_msg_count; i++) {
+		struct sender_msg *msg = &s->msgs[i];
+		cmsg_init(&msg->cmsg, route);
+		msg->sender = s;
+		msg->seq = i;
+		cpipe_push(&pipe, &msg->cmsg);
+		if ((i + 1) % sender_batch_size == 0)
+			fiber_sleep(0);
+	}
+	cpipe_destroy(&pipe);
+	return 0;
+}
+
+/*
+ * Check that messages sent concurrently by many threads to one endpoint,
+ * like iproto threads and relays sending requests to tx, are all
+ * delivered, in order for each thread.
+ */
+static int
+many_to_one_func(va_list ap)
+{
+	(void)ap;
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "main", fiber_schedule_cb, fiber());
+
+	struct sender *senders = calloc(sender_count, sizeof(*senders));
+	assert(senders != NULL);
+
+	for (int i = 0; i < sender_count; i++) {
+		struct sender *s = &senders[i];
+		s->id = i;
+		snprintf(s->name, sizeof(s->name), "sender_%d", i);
+		s->msgs = calloc(sender_msg_count, sizeof(*s->msgs));
+		assert(s->msgs != NULL);
+		if (cord_costart(&s->cord, s->name, sender_func, s) != 0)
+			unreachable();
+	}
+	int total = sender_count * sender_msg_count;
+	while (sender_received < total) {
+		cbus_process(&endpoint);
+		if (sender_received < total)
+			fiber_yield();
+	}
+	for (int i = 0; i < sender_count; i++) {
+		struct sender *s = &senders[i];
+		if (cord_join(&s->cord) != 0)
+			unreachable();
+	}
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	assert(sender_received == total);
+	for (int i = 0; i < sender_count; i++) {
+		assert(senders[i].next_seq == sender_msg_count);
+		free(senders[i].msgs);
+	}
+	free(senders);
+
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
 int
 main()
 {
@@ -379,6 +500,12 @@ main()
 	fiber_wakeup(main_fiber);
 	ev_run(loop(), 0);
 
+	struct fiber *many_to_one_fiber = fiber_new("many_to_one",
+						    many_to_one_func);
+	assert(many_to_one_fiber != NULL);
+	fiber_wakeup(many_to_one_fiber);
+	ev_run(loop(), 0);
+
 	footer();
 
 	cbus_free();
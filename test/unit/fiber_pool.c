@@ -0,0 +1,178 @@
+#include <string.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "fiber_pool.h"
+#include "cbus.h"
+
+#define UNIT_TAP_COMPATIBLE 1
+#include "unit.h"
+
+/** The pool under test. */
+static struct fiber_pool pool;
+/** Queue of messages to the pool. */
+static struct cpipe pipe_to_pool;
+
+/** Order in which the messages are processed. */
+static char processed[64];
+/** Number of processed messages. */
+static int processed_count;
+/** Signaled when a message is processed. */
+static struct fiber_cond processed_cond;
+
+struct test_msg {
+	struct cmsg base;
+	/** Name of the message recorded when it's processed. */
+	char name;
+};
+
+static void
+record_msg(struct cmsg *m)
+{
+	struct test_msg *msg = (struct test_msg *)m;
+	fail_unless(processed_count < (int)sizeof(processed) - 1);
+	processed[processed_count++] = msg->name;
+	fiber_cond_signal(&processed_cond);
+}
+
+static const struct cmsg_hop route[] = {
+	{ record_msg, NULL },
+};
+
+/**
+ * Pushes the given number of messages of each class to the pool in
+ * one batch, waits for them to be processed, and returns the order in
+ * which they were processed. Messages of class i are named 'a' + i.
+ */
+static const char *
+process_msgs(const int *counts, int class_count)
+{
+	static struct test_msg msgs[64];
+	int total = 0;
+	for (int i = 0; i < class_count; i++) {
+		for (int j = 0; j < counts[i]; j++) {
+			fail_unless(total < (int)lengthof(msgs));
+			struct test_msg *msg = &msgs[total++];
+			cmsg_init(&msg->base, route);
+			msg->base.sched_class = i;
+			msg->name = 'a' + i;
+			cpipe_push(&pipe_to_pool, &msg->base);
+		}
+	}
+	processed_count = 0;
+	cpipe_flush(&pipe_to_pool);
+	while (processed_count < total)
+		fiber_cond_wait(&processed_cond);
+	processed[processed_count] = '\0';
+	return processed;
+}
+
+static void
+test_fifo(void)
+{
+	header();
+	plan(2);
+
+	int counts[] = {5};
+	is(strcmp(process_msgs(counts, lengthof(counts)), "aaaaa"), 0,
+	   "messages of one class are processed in order");
+	is(pool.classes[0].processed, 5, "processed count");
+
+	check_plan();
+	footer();
+}
+
+static void
+test_equal_weights(void)
+{
+	header();
+	plan(2);
+
+	int counts[] = {4, 4, 4};
+	is(strcmp(process_msgs(counts, lengthof(counts)), "abcabcabcabc"), 0,
+	   "classes with equal weights are served in turn");
+	is(pool.queue_len, 0, "queue is empty");
+
+	check_plan();
+	footer();
+}
+
+static void
+test_weights(void)
+{
+	header();
+	plan(5);
+
+	fiber_pool_set_class_weight(&pool, 1, 2);
+	fiber_pool_set_class_weight(&pool, 2, 4);
+	int counts[] = {8, 8, 2};
+	is(strcmp(process_msgs(counts, lengthof(counts)),
+		  "cbcababbabbabbaaaa"), 0,
+	   "classes are served in proportion to their weights");
+
+	fiber_pool_set_class_weight(&pool, 0, 3);
+	fiber_pool_set_class_weight(&pool, 1, 1);
+	int counts2[] = {8, 8};
+	is(strcmp(process_msgs(counts2, lengthof(counts2)),
+		  "aabaaabaaabbbbbb"), 0,
+	   "picks of a class are spread evenly");
+	is(pool.classes[0].queue_len, 0, "class queue is empty");
+	is(pool.classes[1].processed, 16, "processed count");
+	ok(pool.classes[1].wait_time >= 0, "wait time");
+
+	check_plan();
+	footer();
+}
+
+static int
+main_f(va_list ap)
+{
+	(void)ap;
+	header();
+	plan(3);
+
+	fiber_cond_create(&processed_cond);
+	/*
+	 * A single worker fiber processes all the queued messages
+	 * in the scheduling order.
+	 */
+	fiber_pool_create(&pool, "pool", 1, FIBER_POOL_IDLE_TIMEOUT);
+	cpipe_create(&pipe_to_pool, "pool");
+
+	test_fifo();
+	test_equal_weights();
+	test_weights();
+
+	cpipe_destroy(&pipe_to_pool);
+	fiber_pool_shutdown(&pool);
+	fiber_pool_destroy(&pool);
+	fiber_cond_destroy(&processed_cond);
+	ev_break(loop(), EVBREAK_ALL);
+
+	check_plan();
+	footer();
+	return 0;
+}
+
+int
+main(void)
+{
+	header();
+	plan(1);
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	cbus_init();
+	struct fiber *main_fiber = fiber_new("main", main_f);
+	assert(main_fiber != NULL);
+	fiber_wakeup(main_fiber);
+	ev_run(loop(), 0);
+
+	cbus_free();
+	fiber_free();
+	memory_free();
+
+	int rc = check_plan();
+	footer();
+	return rc;
+}